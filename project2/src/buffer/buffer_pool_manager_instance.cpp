@@ -12,8 +12,14 @@
 
 #include "buffer/buffer_pool_manager_instance.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <future>  // NOLINT
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 #include "common/config.h"
 #include "common/exception.h"
 #include "common/logger.h"
@@ -22,12 +28,41 @@
 namespace bustub {
 
 BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, size_t replacer_k,
-                                                     LogManager *log_manager)
-    : pool_size_(pool_size), disk_manager_(disk_manager), log_manager_(log_manager) {
-  // we allocate a consecutive memory space for the buffer pool
+                                                     LogManager *log_manager, ReplacerType replacer_type)
+    : BufferPoolManagerInstance(pool_size, 1, 0, disk_manager, replacer_k, log_manager, replacer_type) {}
+
+BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
+                                                     DiskManager *disk_manager, size_t replacer_k,
+                                                     LogManager *log_manager, ReplacerType replacer_type)
+    : pool_size_(pool_size),
+      num_instances_(num_instances),
+      instance_index_(instance_index),
+      disk_manager_(disk_manager),
+      log_manager_(log_manager),
+      io_in_progress_(pool_size, false),
+      io_cv_(pool_size),
+      cleaning_(pool_size, false) {
+  BUSTUB_ASSERT(num_instances > 0, "If BPI is not part of a pool, then the pool size should just be 1");
+  BUSTUB_ASSERT(
+      instance_index < num_instances,
+      "BPI index cannot be greater than the number of BPIs in the pool. In non-parallel case, index should just be 0.");
+  // we allocate a consecutive memory space for the buffer pool, page-aligned so that O_DIRECT can read into it
+  page_data_ = static_cast<char *>(std::aligned_alloc(BUSTUB_PAGE_SIZE, pool_size_ * BUSTUB_PAGE_SIZE));
+  if (page_data_ == nullptr) {
+    throw std::bad_alloc();
+  }
   pages_ = new Page[pool_size_];
-  page_table_ = new ExtendibleHashTable<page_id_t, frame_id_t>(bucket_size_);
-  replacer_ = new LRUKReplacer(pool_size, replacer_k);
+  for (size_t i = 0; i < pool_size_; ++i) {
+    pages_[i].data_ = page_data_ + i * BUSTUB_PAGE_SIZE;
+    pages_[i].ResetMemory();
+  }
+  // a frame whose dirty victim is being written back stays mapped under both page ids until the write finishes
+  page_table_ = new PageTable(2 * pool_size_);
+  if (replacer_type == ReplacerType::CLOCK) {
+    replacer_ = new ClockReplacer(pool_size);
+  } else {
+    replacer_ = new LRUKReplacer(pool_size, replacer_k);
+  }
 
   // Initially, every page is in the free list.
   for (size_t i = 0; i < pool_size_; ++i) {
@@ -43,137 +78,391 @@ BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, DiskManag
 }
 
 BufferPoolManagerInstance::~BufferPoolManagerInstance() {
+  StopPrefetcher();
+  StopPageCleaner();
   delete[] pages_;
+  std::free(page_data_);
   delete page_table_;
   delete replacer_;
 }
 
-auto BufferPoolManagerInstance::NewPgImp(page_id_t *page_id) -> Page * {
-  std::scoped_lock<std::mutex> locker(latch_);
-
-  // whether free space
-  if (free_list_.empty() && replacer_->Size() == 0) {
-    page_id = nullptr;
-    return nullptr;
-  }
-
-  frame_id_t tmp_frame_id = -1;
+auto BufferPoolManagerInstance::GetVictimFrame(frame_id_t *frame_id) -> bool {
   // free_list_ first
   if (!free_list_.empty()) {
-    tmp_frame_id = free_list_.front();
+    *frame_id = free_list_.front();
     free_list_.pop_front();
-  } else {
-    bool success = replacer_->Evict(&tmp_frame_id);
-    if (!success) {
-      LOG_ERROR("replacer_->Evict faild");
-      page_id = nullptr;
-      return nullptr;
+    return true;
+  }
+  return replacer_->Evict(frame_id);
+}
+
+auto BufferPoolManagerInstance::FindFrame(std::unique_lock<std::mutex> &lock, page_id_t page_id, frame_id_t *frame_id,
+                                          bool wait_for_cleaner) -> bool {
+  auto busy = [&](frame_id_t frame) { return io_in_progress_[frame] || (wait_for_cleaner && cleaning_[frame]); };
+  while (page_table_->Find(page_id, *frame_id)) {
+    if (!busy(*frame_id)) {
+      return true;
     }
+    // The frame is being written back or filled by another thread. Wait for that I/O and look the page up again,
+    // because the frame may now hold a different page.
+    frame_id_t io_frame_id = *frame_id;
+    io_cv_[io_frame_id].wait(lock, [&] { return !busy(io_frame_id); });
   }
+  return false;
+}
 
-  *page_id = AllocatePage();
+auto BufferPoolManagerInstance::ClaimFrame(frame_id_t frame_id, page_id_t page_id, AccessType access_type)
+    -> page_id_t {
+  Page *page = &pages_[frame_id];
+  page_id_t old_page_id = page->page_id_;
+  bool write_back = page->IsDirty() && old_page_id != INVALID_PAGE_ID;
 
-  // if replacement frame dirty
-  if (pages_[tmp_frame_id].IsDirty()) {
-    bool success = DoFlushPgImp(pages_[tmp_frame_id].page_id_);
-    if (!success) {
-      LOG_ERROR("NewPgImp DoFlushPgImp page_id=%d 未能成功", pages_[tmp_frame_id].page_id_);
-      return nullptr;
+  // A clean victim can be forgotten right away. A dirty victim keeps its page table entry until its write-back has
+  // reached the disk, so that a concurrent fetch of it waits for the write instead of reading a stale copy.
+  if (!write_back && old_page_id != INVALID_PAGE_ID) {
+    page_table_->Remove(old_page_id);
+  }
+  page_table_->Insert(page_id, frame_id);
+
+  page->page_id_ = page_id;
+  page->pin_count_ = 1;
+  page->is_dirty_ = false;
+
+  // replacer
+  replacer_->RecordAccess(frame_id, access_type);
+  replacer_->SetEvictable(frame_id, false);
+
+  return write_back ? old_page_id : INVALID_PAGE_ID;
+}
+
+void BufferPoolManagerInstance::FinishIo(frame_id_t frame_id, page_id_t written_page_id) {
+  if (written_page_id != INVALID_PAGE_ID) {
+    page_table_->Remove(written_page_id);
+  }
+  io_in_progress_[frame_id] = false;
+  io_cv_[frame_id].notify_all();
+}
+
+void BufferPoolManagerInstance::RunPageCleaner(size_t num_clean_victims) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (cleaner_thread_ != nullptr) {
+    return;
+  }
+  num_clean_victims_ = num_clean_victims;
+  cleaner_stop_ = false;
+  cleaner_thread_ = new std::thread(&BufferPoolManagerInstance::PageCleanerLoop, this);
+}
+
+void BufferPoolManagerInstance::StopPageCleaner() {
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    if (cleaner_thread_ == nullptr) {
+      return;
     }
+    cleaner_stop_ = true;
+    cleaner_cv_.notify_one();
   }
+  cleaner_thread_->join();
+  delete cleaner_thread_;
+  cleaner_thread_ = nullptr;
+}
 
-  // page_table_删除这一页在索引中的信息
-  bool success = page_table_->Remove(pages_[tmp_frame_id].page_id_);
-  if (!success) {
-    // LOG_INFO("NewPgImp 索引key %d 未能成功删除",
-    // pages_[tmp_frame_id].page_id_);
+void BufferPoolManagerInstance::PageCleanerLoop() {
+  std::unique_lock<std::mutex> lock(latch_);
+  while (!cleaner_stop_) {
+    cleaner_cv_.wait_for(lock, page_cleaner_interval);
+    if (!cleaner_stop_) {
+      CleanVictims(lock);
+    }
   }
+}
 
-  // reset metadata
-  pages_[tmp_frame_id].page_id_ = *page_id;
-  pages_[tmp_frame_id].ResetMemory();
-  pages_[tmp_frame_id].pin_count_ = 1;
-  pages_[tmp_frame_id].is_dirty_ = false;
+void BufferPoolManagerInstance::CleanVictims(std::unique_lock<std::mutex> &lock) {
+  std::vector<frame_id_t> victims;
+  replacer_->PeekVictims(num_clean_victims_, &victims);
+
+  // Pin the dirty victims so they are neither evicted nor deleted while being written, and mark them clean now: a
+  // thread that modifies one of them meanwhile has to pin it and unpin it as dirty again.
+  std::vector<frame_id_t> dirty_frames;
+  for (auto frame_id : victims) {
+    Page *page = &pages_[frame_id];
+    if (!page->IsDirty() || page->GetPinCount() > 0 || io_in_progress_[frame_id]) {
+      continue;
+    }
+    page->pin_count_++;
+    page->is_dirty_ = false;
+    cleaning_[frame_id] = true;
+    replacer_->SetEvictable(frame_id, false);
+    dirty_frames.push_back(frame_id);
+  }
+  if (dirty_frames.empty()) {
+    return;
+  }
+
+  lock.unlock();
+  // The pages are written as one batch, so that a disk manager that syncs every write, like the double-write buffer
+  // of ChecksumDiskManager, syncs once for all of them. They are copied out one at a time: holding the read latches of
+  // all of them at once could deadlock with a thread that latches pages in another order.
+  std::vector<char> images(dirty_frames.size() * BUSTUB_PAGE_SIZE);
+  std::vector<std::pair<page_id_t, const char *>> batch;
+  batch.reserve(dirty_frames.size());
+  for (size_t i = 0; i < dirty_frames.size(); i++) {
+    Page *page = &pages_[dirty_frames[i]];
+    char *image = images.data() + i * BUSTUB_PAGE_SIZE;
+    // the read latch keeps writers that fetched the page in the meantime from changing it in the middle of the copy
+    page->RLatch();
+    memcpy(image, page->GetData(), BUSTUB_PAGE_SIZE);
+    page->RUnlatch();
+    batch.emplace_back(page->GetPageId(), image);
+  }
+  disk_manager_->WritePages(batch);
+  background_flushes_ += dirty_frames.size();
+  lock.lock();
+
+  for (auto frame_id : dirty_frames) {
+    Page *page = &pages_[frame_id];
+    page->pin_count_--;
+    if (page->pin_count_ == 0) {
+      // no RecordAccess: being cleaned does not make the page any younger
+      replacer_->SetEvictable(frame_id, true);
+    }
+    cleaning_[frame_id] = false;
+    io_cv_[frame_id].notify_all();
+  }
+}
 
-  // page_table_增加这一页在索引中的信息
-  page_table_->Insert(*page_id, tmp_frame_id);
+void BufferPoolManagerInstance::PrefetchPgsImp(const std::vector<page_id_t> &page_ids, size_t chain_length,
+                                               const next_page_fn &next_page) {
+  std::scoped_lock<std::mutex> lock(prefetch_latch_);
+  if (prefetch_stop_) {
+    return;
+  }
+  for (auto page_id : page_ids) {
+    if (page_id == INVALID_PAGE_ID || prefetch_queue_.size() >= pool_size_) {
+      continue;
+    }
+    prefetch_queue_.push_back({page_id, chain_length, next_page});
+  }
+  if (prefetch_thread_ == nullptr) {
+    prefetch_thread_ = new std::thread(&BufferPoolManagerInstance::PrefetchLoop, this);
+  }
+  prefetch_cv_.notify_one();
+}
 
-  // replacer
-  replacer_->RecordAccess(tmp_frame_id);
-  replacer_->SetEvictable(tmp_frame_id, false);
+void BufferPoolManagerInstance::StopPrefetcher() {
+  {
+    std::scoped_lock<std::mutex> lock(prefetch_latch_);
+    prefetch_stop_ = true;
+    prefetch_queue_.clear();
+    prefetch_cv_.notify_one();
+    if (prefetch_thread_ == nullptr) {
+      return;
+    }
+  }
+  prefetch_thread_->join();
+  delete prefetch_thread_;
+  prefetch_thread_ = nullptr;
+}
 
-  return &pages_[tmp_frame_id];
+void BufferPoolManagerInstance::PrefetchLoop() {
+  // at most an eighth of the pool is claimed by a batch, so foreground fetches still find victims meanwhile
+  size_t max_batch = std::max<size_t>(1, pool_size_ / 8);
+  std::vector<PrefetchRequest> batch;
+  std::unique_lock<std::mutex> lock(prefetch_latch_);
+  while (true) {
+    prefetch_cv_.wait(lock, [&] { return prefetch_stop_ || !prefetch_queue_.empty(); });
+    if (prefetch_stop_) {
+      return;
+    }
+    batch.clear();
+    while (!prefetch_queue_.empty() && batch.size() < max_batch) {
+      batch.push_back(std::move(prefetch_queue_.front()));
+      prefetch_queue_.pop_front();
+    }
+    lock.unlock();
+    Prefetch(batch);
+    lock.lock();
+  }
 }
 
-auto BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) -> Page * {
-  std::scoped_lock<std::mutex> locker(latch_);
+void BufferPoolManagerInstance::Prefetch(const std::vector<PrefetchRequest> &requests) {
+  // A page of the batch pinned by the prefetcher: a resident page of a chain, or a frame claimed to read the page into.
+  struct PinnedPage {
+    const PrefetchRequest *request_;
+    frame_id_t frame_id_;
+    bool read_;
+    page_id_t written_page_id_;
+  };
+  std::vector<PinnedPage> pinned;
+  pinned.reserve(requests.size());
+  auto follow_chain = [](const PrefetchRequest &request) {
+    return request.chain_length_ > 0 && request.next_page_ != nullptr;
+  };
+
+  {
+    std::unique_lock<std::mutex> lock(latch_);
+    for (const auto &request : requests) {
+      frame_id_t frame_id = -1;
+      // A page that lives in a frame claimed earlier in this batch, as the page read or as the victim written back, is
+      // skipped: waiting for the frame's I/O would wait for ourselves.
+      if (page_table_->Find(request.page_id_, frame_id) &&
+          std::any_of(pinned.begin(), pinned.end(), [&](const PinnedPage &p) { return p.frame_id_ == frame_id; })) {
+        continue;
+      }
+      if (FindFrame(lock, request.page_id_, &frame_id)) {
+        if (follow_chain(request)) {
+          // Pin the resident page to read its next page id, but record no access: the prefetcher only walks over it.
+          pages_[frame_id].pin_count_++;
+          replacer_->SetEvictable(frame_id, false);
+          pinned.push_back({&request, frame_id, false, INVALID_PAGE_ID});
+        }
+        continue;
+      }
+      if (!GetVictimFrame(&frame_id)) {
+        // every frame is pinned, the scan will have to read the rest of the pages itself
+        break;
+      }
+      page_id_t written_page_id = ClaimFrame(frame_id, request.page_id_, AccessType::Scan);
+      io_in_progress_[frame_id] = true;
+      if (written_page_id != INVALID_PAGE_ID) {
+        foreground_flushes_++;
+        cleaner_cv_.notify_one();
+      }
+      pinned.push_back({&request, frame_id, true, written_page_id});
+    }
+  }
 
-  frame_id_t tmp_frame_id = -1;
-  bool success = page_table_->Find(page_id, tmp_frame_id);
-  // 如果找到直接返回
-  if (success) {
-    // replacer
-    replacer_->RecordAccess(tmp_frame_id);
-    replacer_->SetEvictable(tmp_frame_id, false);
+  // Put the write-backs of the dirty victims in flight together, then all the reads, so that a disk manager that
+  // supports asynchronous I/O works on the whole batch at once.
+  std::vector<std::future<void>> ios;
+  for (const auto &p : pinned) {
+    if (p.read_ && p.written_page_id_ != INVALID_PAGE_ID) {
+      ios.push_back(disk_manager_->WritePageAsync(p.written_page_id_, pages_[p.frame_id_].GetData()));
+    }
+  }
+  for (auto &io : ios) {
+    io.wait();
+  }
+  ios.clear();
+  for (const auto &p : pinned) {
+    if (p.read_) {
+      Page *page = &pages_[p.frame_id_];
+      page->ResetMemory();
+      ios.push_back(disk_manager_->ReadPageAsync(p.request_->page_id_, page->GetData()));
+    }
+  }
+  for (auto &io : ios) {
+    io.wait();
+  }
+  prefetched_pages_ += ios.size();
+  if (!ios.empty()) {
+    std::scoped_lock<std::mutex> lock(latch_);
+    for (const auto &p : pinned) {
+      if (p.read_) {
+        FinishIo(p.frame_id_, p.written_page_id_);
+      }
+    }
+  }
 
-    pages_[tmp_frame_id].pin_count_++;
+  for (const auto &p : pinned) {
+    const PrefetchRequest &request = *p.request_;
+    page_id_t next_page_id = INVALID_PAGE_ID;
+    if (follow_chain(request)) {
+      Page *page = &pages_[p.frame_id_];
+      page->RLatch();
+      next_page_id = request.next_page_(page);
+      page->RUnlatch();
+    }
+    UnpinPgImp(request.page_id_, false);
 
-    return &pages_[tmp_frame_id];
+    if (next_page_id != INVALID_PAGE_ID) {
+      // the next page may live in another shard of a parallel buffer pool
+      prefetch_router_->PrefetchChain(next_page_id, request.chain_length_, request.next_page_);
+    }
   }
+}
+
+auto BufferPoolManagerInstance::NewPgImp(page_id_t *page_id) -> Page * {
+  return NewPgNearImp(page_id, INVALID_PAGE_ID);
+}
 
-  if (free_list_.empty() && replacer_->Size() == 0) {
+auto BufferPoolManagerInstance::NewPgNearImp(page_id_t *page_id, page_id_t near_page_id) -> Page * {
+  std::unique_lock<std::mutex> lock(latch_);
+
+  frame_id_t frame_id = -1;
+  if (!GetVictimFrame(&frame_id)) {
     return nullptr;
   }
 
-  // free_list_ first
-  if (!free_list_.empty()) {
-    tmp_frame_id = free_list_.front();
-    free_list_.pop_front();
-  } else {
-    bool success = replacer_->Evict(&tmp_frame_id);
-    if (!success) {
-      LOG_ERROR("replacer_->Evict faild");
-      return nullptr;
-    }
+  *page_id = AllocatePage(near_page_id);
+  Page *page = &pages_[frame_id];
+  page_id_t written_page_id = ClaimFrame(frame_id, *page_id);
+  if (written_page_id == INVALID_PAGE_ID) {
+    page->ResetMemory();
+    return page;
   }
 
-  if (pages_[tmp_frame_id].IsDirty() && pages_[tmp_frame_id].page_id_ != INVALID_PAGE_ID) {
-    success = DoFlushPgImp(pages_[tmp_frame_id].page_id_);
-    if (!success) {
-      LOG_ERROR("FetchPgImp DoFlushPgImp page_id=%d 未能成功", page_id);
-      return nullptr;
-    }
+  // The victim is dirty: write it back without holding the latch. Nobody knows the new page id yet, so only the
+  // victim's fetchers can observe the frame while it is in I/O.
+  io_in_progress_[frame_id] = true;
+  foreground_flushes_++;
+  cleaner_cv_.notify_one();
+  lock.unlock();
+  disk_manager_->WritePage(written_page_id, page->GetData());
+  page->ResetMemory();
+  lock.lock();
+  FinishIo(frame_id, written_page_id);
+
+  return page;
+}
+
+auto BufferPoolManagerInstance::FetchPgImp(page_id_t page_id, AccessType access_type) -> Page * {
+  std::unique_lock<std::mutex> lock(latch_);
+
+  frame_id_t frame_id = -1;
+  // 如果找到直接返回
+  if (FindFrame(lock, page_id, &frame_id)) {
+    // replacer
+    replacer_->RecordAccess(frame_id, access_type);
+    replacer_->SetEvictable(frame_id, false);
+
+    pages_[frame_id].pin_count_++;
+
+    return &pages_[frame_id];
   }
 
-  // page_table_删除这一页在索引中的信息
-  success = page_table_->Remove(pages_[tmp_frame_id].page_id_);
-  if (!success) {
-    // LOG_INFO("FetchPgImp 索引key %d 未能成功删除",
-    //          pages_[tmp_frame_id].page_id_);
+  if (!GetVictimFrame(&frame_id)) {
+    return nullptr;
   }
-  // reset metadata
-  pages_[tmp_frame_id].page_id_ = page_id;
-  pages_[tmp_frame_id].ResetMemory();
-  pages_[tmp_frame_id].pin_count_ = 1;
-  pages_[tmp_frame_id].is_dirty_ = false;
 
-  // page_table_增加这一页在索引中的信息
-  page_table_->Insert(page_id, tmp_frame_id);
+  // Publish page_id -> frame_id and mark the frame as in I/O, then do the write-back and the read without the latch.
+  // Cache hits on other frames proceed meanwhile, and concurrent fetchers of page_id wait on this frame only.
+  Page *page = &pages_[frame_id];
+  page_id_t written_page_id = ClaimFrame(frame_id, page_id, access_type);
+  io_in_progress_[frame_id] = true;
+  if (written_page_id != INVALID_PAGE_ID) {
+    foreground_flushes_++;
+    cleaner_cv_.notify_one();
+  }
+  lock.unlock();
 
-  disk_manager_->ReadPage(page_id, pages_[tmp_frame_id].GetData());
+  if (written_page_id != INVALID_PAGE_ID) {
+    disk_manager_->WritePage(written_page_id, page->GetData());
+  }
+  page->ResetMemory();
+  disk_manager_->ReadPage(page_id, page->GetData());
 
-  // replacer
-  replacer_->RecordAccess(tmp_frame_id);
-  replacer_->SetEvictable(tmp_frame_id, false);
+  lock.lock();
+  FinishIo(frame_id, written_page_id);
 
-  return &pages_[tmp_frame_id];
+  return page;
 }
 
 auto BufferPoolManagerInstance::UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool {
-  std::scoped_lock<std::mutex> locker(latch_);
+  std::unique_lock<std::mutex> lock(latch_);
 
   frame_id_t tmp_frame_id = -1;
-  bool success = page_table_->Find(page_id, tmp_frame_id);
+  bool success = FindFrame(lock, page_id, &tmp_frame_id);
   if (!success) {
     return false;
   }
@@ -195,7 +484,8 @@ auto BufferPoolManagerInstance::UnpinPgImp(page_id_t page_id, bool is_dirty) ->
 auto BufferPoolManagerInstance::DoFlushPgImp(page_id_t page_id) -> bool {
   frame_id_t tmp_frame_id = -1;
   bool success = page_table_->Find(page_id, tmp_frame_id);
-  if (!success) {
+  // frames in I/O are written back (or filled) by the thread that owns the I/O
+  if (!success || io_in_progress_[tmp_frame_id]) {
     return false;
   }
 
@@ -206,10 +496,10 @@ auto BufferPoolManagerInstance::DoFlushPgImp(page_id_t page_id) -> bool {
 }
 
 auto BufferPoolManagerInstance::FlushPgImp(page_id_t page_id) -> bool {
-  std::scoped_lock<std::mutex> locker(latch_);
+  std::unique_lock<std::mutex> lock(latch_);
 
   frame_id_t tmp_frame_id = -1;
-  bool success = page_table_->Find(page_id, tmp_frame_id);
+  bool success = FindFrame(lock, page_id, &tmp_frame_id, true);
   if (!success) {
     return false;
   }
@@ -222,23 +512,41 @@ auto BufferPoolManagerInstance::FlushPgImp(page_id_t page_id) -> bool {
 
 // 只flush page_table_ 中有的
 void BufferPoolManagerInstance::FlushAllPgsImp() {
-  std::scoped_lock<std::mutex> locker(latch_);
+  std::unique_lock<std::mutex> lock(latch_);
+  // wait for the batch of the page cleaner, its images may be older than the ones written here
+  for (auto it = std::find(cleaning_.begin(), cleaning_.end(), true); it != cleaning_.end();
+       it = std::find(cleaning_.begin(), cleaning_.end(), true)) {
+    auto frame_id = static_cast<frame_id_t>(it - cleaning_.begin());
+    io_cv_[frame_id].wait(lock, [&] { return !cleaning_[frame_id]; });
+  }
 
+  // one batch for the whole pool, see CleanVictims
+  std::vector<std::pair<page_id_t, const char *>> batch;
+  std::vector<frame_id_t> frames;
   for (size_t index = 0; index < pool_size_; index++) {
-    bool success = DoFlushPgImp(pages_[index].GetPageId());
-    if (!success) {
-      // LOG_INFO("%s can not flush in page_table_, skip",
-      //          std::to_string(pages_[index].GetPageId()).c_str());
+    page_id_t page_id = pages_[index].GetPageId();
+    frame_id_t frame_id = -1;
+    // frames in I/O are written back (or filled) by the thread that owns the I/O
+    if (!page_table_->Find(page_id, frame_id) || io_in_progress_[frame_id]) {
+      continue;
     }
+    batch.emplace_back(page_id, pages_[frame_id].GetData());
+    frames.push_back(frame_id);
+  }
+  disk_manager_->WritePages(batch);
+  for (auto frame_id : frames) {
+    pages_[frame_id].is_dirty_ = false;
   }
 }
 
 auto BufferPoolManagerInstance::DeletePgImp(page_id_t page_id) -> bool {
-  std::scoped_lock<std::mutex> locker(latch_);
+  std::unique_lock<std::mutex> lock(latch_);
 
   frame_id_t tmp_frame_id = -1;
-  bool success = page_table_->Find(page_id, tmp_frame_id);
+  bool success = FindFrame(lock, page_id, &tmp_frame_id);
   if (!success) {
+    // the page is only on disk
+    DeallocatePage(page_id);
     return true;
   }
 
@@ -272,6 +580,16 @@ auto BufferPoolManagerInstance::DeletePgImp(page_id_t page_id) -> bool {
   return true;
 }
 
-auto BufferPoolManagerInstance::AllocatePage() -> page_id_t { return next_page_id_++; }
+auto BufferPoolManagerInstance::AllocatePage(page_id_t near_page_id) -> page_id_t {
+  // the page ids of this instance are the ones congruent to its index modulo the number of instances
+  const page_id_t next_page_id = disk_manager_->AllocatePage(near_page_id, num_instances_, instance_index_);
+  ValidatePageId(next_page_id);
+  return next_page_id;
+}
+
+void BufferPoolManagerInstance::ValidatePageId(const page_id_t page_id) const {
+  // allocated pages mod back to this BPI
+  BUSTUB_ASSERT(static_cast<uint32_t>(page_id) % num_instances_ == instance_index_, "page id belongs to another BPI");
+}
 
 }  // namespace bustub
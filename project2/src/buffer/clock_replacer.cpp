@@ -12,18 +12,112 @@
 
 #include "buffer/clock_replacer.h"
 
+#include <stdexcept>
+#include <string>
+
 namespace bustub {
 
-ClockReplacer::ClockReplacer(size_t num_pages) {}
+ClockReplacer::ClockReplacer(size_t num_pages) : num_frames_(num_pages), ref_bits_(num_pages), states_(num_pages) {
+  for (size_t i = 0; i < num_frames_; i++) {
+    ref_bits_[i].store(false, std::memory_order_relaxed);
+    states_[i].store(UNTRACKED, std::memory_order_relaxed);
+  }
+}
 
 ClockReplacer::~ClockReplacer() = default;
 
-auto ClockReplacer::Victim(frame_id_t *frame_id) -> bool { return false; }
+void ClockReplacer::CheckFrameId(frame_id_t frame_id) const {
+  if (frame_id < 0 || static_cast<size_t>(frame_id) >= num_frames_) {
+    throw std::invalid_argument("frame_id (" + std::to_string(frame_id) + ") larger than replace_size_");
+  }
+}
+
+auto ClockReplacer::Evict(frame_id_t *frame_id) -> bool {
+  std::lock_guard<std::mutex> lock(latch_);
+
+  // Two full sweeps are enough: the first one clears every reference bit it passes. More sweeps are only needed when
+  // other threads keep referencing the frames, in which case we give up once nothing is evictable.
+  while (curr_size_.load() > 0) {
+    for (size_t step = 0; step < 2 * num_frames_; step++) {
+      size_t candidate = clock_hand_;
+      clock_hand_ = (clock_hand_ + 1) % num_frames_;
+      if (states_[candidate].load(std::memory_order_relaxed) != EVICTABLE) {
+        continue;
+      }
+      if (ref_bits_[candidate].load(std::memory_order_relaxed)) {
+        ref_bits_[candidate].store(false, std::memory_order_relaxed);
+        continue;
+      }
+      uint8_t expected = EVICTABLE;
+      if (states_[candidate].compare_exchange_strong(expected, UNTRACKED)) {
+        curr_size_--;
+        *frame_id = static_cast<frame_id_t>(candidate);
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+void ClockReplacer::RecordAccess(frame_id_t frame_id, AccessType access_type) {
+  CheckFrameId(frame_id);
+
+  if (access_type != AccessType::Scan) {
+    ref_bits_[frame_id].store(true, std::memory_order_relaxed);
+  }
+  if (states_[frame_id].load(std::memory_order_relaxed) != UNTRACKED) {
+    return;
+  }
+  // first access of an untracked frame: start tracking it as evictable, like LRUKReplacer does
+  uint8_t expected = UNTRACKED;
+  if (states_[frame_id].compare_exchange_strong(expected, EVICTABLE)) {
+    curr_size_++;
+  }
+}
+
+void ClockReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
+  CheckFrameId(frame_id);
+
+  uint8_t expected = set_evictable ? PINNED : EVICTABLE;
+  if (states_[frame_id].compare_exchange_strong(expected, set_evictable ? EVICTABLE : PINNED)) {
+    if (set_evictable) {
+      curr_size_++;
+    } else {
+      curr_size_--;
+    }
+  }
+}
+
+void ClockReplacer::Remove(frame_id_t frame_id) {
+  if (frame_id < 0 || static_cast<size_t>(frame_id) >= num_frames_) {
+    return;
+  }
+  uint8_t expected = EVICTABLE;
+  if (states_[frame_id].compare_exchange_strong(expected, UNTRACKED)) {
+    curr_size_--;
+    return;
+  }
+  if (expected == PINNED) {
+    throw std::invalid_argument("frame_id (" + std::to_string(frame_id) + ") is not evitable_");
+  }
+}
 
-void ClockReplacer::Pin(frame_id_t frame_id) {}
+void ClockReplacer::PeekVictims(size_t max_victims, std::vector<frame_id_t> *victims) {
+  std::lock_guard<std::mutex> lock(latch_);
 
-void ClockReplacer::Unpin(frame_id_t frame_id) {}
+  victims->clear();
+  // first the frames the hand would evict on its first pass, then the ones it would only evict after clearing the bit
+  for (bool referenced : {false, true}) {
+    for (size_t step = 0; step < num_frames_ && victims->size() < max_victims; step++) {
+      size_t candidate = (clock_hand_ + step) % num_frames_;
+      if (states_[candidate].load(std::memory_order_relaxed) == EVICTABLE &&
+          ref_bits_[candidate].load(std::memory_order_relaxed) == referenced) {
+        victims->push_back(static_cast<frame_id_t>(candidate));
+      }
+    }
+  }
+}
 
-auto ClockReplacer::Size() -> size_t { return 0; }
+auto ClockReplacer::Size() -> size_t { return curr_size_.load(); }
 
 }  // namespace bustub
@@ -11,121 +11,88 @@
 //===----------------------------------------------------------------------===//
 
 #include "buffer/lru_k_replacer.h"
-#include <iostream>
-#include <memory>
+#include <queue>
 #include <stdexcept>
 #include <string>
 #include "common/logger.h"
 
 namespace bustub {
 
-LRUKReplacer::LRUKReplacer(size_t num_frames, size_t k) : curr_size_(0), replacer_size_(num_frames), k_(k) {}
+LRUKReplacer::LRUKReplacer(size_t num_frames, size_t k)
+    : curr_size_(0), replacer_size_(num_frames), k_(k), frames_(num_frames), history_(num_frames * k) {
+  BUSTUB_ASSERT(k > 0, "k should be positive");
+  heap_.reserve(num_frames);
+}
 
 auto LRUKReplacer::Evict(frame_id_t *frame_id) -> bool {
   std::lock_guard<std::mutex> lock(latch_);
 
-  // 先看history，然后再看cache
-  for (auto iter = history_list_.rbegin(); iter != history_list_.rend(); iter++) {
-    if ((*iter)->evitable_) {
-      std::shared_ptr<Node> tmp_it = (*iter);
-      *frame_id = tmp_it->frame_id_;
-      history_list_.erase(tmp_it->iter_);
-      history_access_.erase(tmp_it->frame_id_);
-      curr_size_--;
-      return true;
-    }
-  }
-
-  for (auto iter = cache_list_.rbegin(); iter != cache_list_.rend(); iter++) {
-    if ((*iter)->evitable_) {
-      std::shared_ptr<Node> tmp_it = (*iter);
-      *frame_id = tmp_it->frame_id_;
-      cache_list_.erase(tmp_it->iter_);
-      cache_access_.erase(tmp_it->frame_id_);
-      curr_size_--;
-      return true;
-    }
+  if (heap_.empty()) {
+    return false;
   }
-
-  return false;
+  *frame_id = heap_.front();
+  HeapErase(*frame_id);
+  ResetFrame(*frame_id);
+  curr_size_--;
+  return true;
 }
 
-void LRUKReplacer::RecordAccess(frame_id_t frame_id) {
+void LRUKReplacer::RecordAccess(frame_id_t frame_id, AccessType access_type) {
   std::lock_guard<std::mutex> lock(latch_);
 
-  if (static_cast<size_t>(frame_id) > replacer_size_) {
+  if (frame_id < 0 || static_cast<size_t>(frame_id) >= replacer_size_) {
     throw std::invalid_argument("frame_id (" + std::to_string(frame_id) + ") larger than replace_size_");
   }
-  current_timestamp_++;
-  std::shared_ptr<Node> tmp_it = nullptr;
-  if (history_access_.find(frame_id) != history_access_.end()) {
-    tmp_it = history_access_[frame_id];
-  }
-  if (cache_access_.find(frame_id) != cache_access_.end()) {
-    tmp_it = cache_access_[frame_id];
+  auto &entry = frames_[frame_id];
+  bool is_scan = access_type == AccessType::Scan;
+  if (is_scan && entry.tracked_) {
+    return;
   }
+  current_timestamp_++;
 
   // 如果还没有，那么需要新建一个
-  if (tmp_it == nullptr) {
-    tmp_it = std::make_shared<Node>(k_);
-    tmp_it->frame_id_ = frame_id;
-    history_list_.push_front(tmp_it);
-    tmp_it->iter_ = history_list_.begin();
-    history_access_[frame_id] = tmp_it;
+  bool is_new = !entry.tracked_;
+  if (is_new) {
+    entry.tracked_ = true;
+    entry.evictable_ = true;
+    entry.scan_only_ = is_scan;
     curr_size_++;
+  } else if (entry.scan_only_) {
+    // the scan accesses do not count towards the k accesses of a frame that turns out to be used elsewhere
+    entry.scan_only_ = false;
+    entry.access_count_ = 0;
   }
 
-  tmp_it->UpdateAccess(current_timestamp_);
-
-  // history list部分
-  if (tmp_it->access_count_ < k_) {
-    return;
-  }
-
-  // 先插入
-  if (tmp_it->access_count_ == k_) {
-    history_access_.erase(tmp_it->frame_id_);
-    history_list_.erase(tmp_it->iter_);
+  history_[frame_id * k_ + entry.access_count_ % k_] = current_timestamp_;
+  entry.access_count_++;
 
-    cache_list_.push_back(tmp_it);
-    tmp_it->iter_ = --cache_list_.end();
-    cache_access_[frame_id] = tmp_it;
-  }
-
-  // 然后看看要不要调整位置
-  cache_list_.erase(tmp_it->iter_);
-  auto iter = cache_list_.begin();
-  for (; iter != cache_list_.end(); iter++) {
-    if (tmp_it->timestamp_list_.back() >= (*iter)->timestamp_list_.back()) {
-      break;
-    }
+  if (is_new) {
+    HeapPush(frame_id);
+  } else if (entry.heap_index_ != NOT_IN_HEAP) {
+    // an access only ever makes the frame hotter, so it can only move down
+    HeapSiftDown(entry.heap_index_);
   }
-  tmp_it->iter_ = cache_list_.insert(iter, tmp_it);
 }
 
 void LRUKReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
   std::lock_guard<std::mutex> lock(latch_);
 
-  if (static_cast<size_t>(frame_id) > replacer_size_) {
+  if (frame_id < 0 || static_cast<size_t>(frame_id) >= replacer_size_) {
     throw std::invalid_argument("frame_id (" + std::to_string(frame_id) + ") larger than replace_size_");
   }
 
-  std::shared_ptr<Node> tmp_it = nullptr;
-  if (history_access_.find(frame_id) != history_access_.end()) {
-    tmp_it = history_access_[frame_id];
-  }
-  if (cache_access_.find(frame_id) != cache_access_.end()) {
-    tmp_it = cache_access_[frame_id];
-  }
+  auto &entry = frames_[frame_id];
   // 没找到，或者evitable_无需改变
-  if (tmp_it == nullptr || tmp_it->evitable_ == set_evictable) {
+  if (!entry.tracked_ || entry.evictable_ == set_evictable) {
     return;
   }
 
-  tmp_it->evitable_ = set_evictable;
+  entry.evictable_ = set_evictable;
   if (set_evictable) {
+    HeapPush(frame_id);
     curr_size_++;
   } else {
+    HeapErase(frame_id);
     curr_size_--;
   }
 }
@@ -133,26 +100,15 @@ void LRUKReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
 void LRUKReplacer::Remove(frame_id_t frame_id) {
   std::lock_guard<std::mutex> lock(latch_);
 
-  bool deleted = DoRemove(frame_id, history_access_, history_list_);
-  if (deleted) {
+  if (frame_id < 0 || static_cast<size_t>(frame_id) >= replacer_size_ || !frames_[frame_id].tracked_) {
     return;
   }
-  DoRemove(frame_id, cache_access_, cache_list_);
-}
-
-auto LRUKReplacer::DoRemove(frame_id_t frame_id, std::unordered_map<frame_id_t, std::shared_ptr<Node>> &access_,
-                            std::list<std::shared_ptr<Node>> &list_) -> bool {
-  if (access_.find(frame_id) == access_.end()) {
-    return false;
-  }
-  auto tmp_it = access_[frame_id];
-  if (!tmp_it->evitable_) {
+  if (!frames_[frame_id].evictable_) {
     throw std::invalid_argument("frame_id (" + std::to_string(frame_id) + ") is not evitable_");
   }
-  list_.erase(tmp_it->iter_);
-  access_.erase(tmp_it->frame_id_);
+  HeapErase(frame_id);
+  ResetFrame(frame_id);
   curr_size_--;
-  return true;
 }
 
 auto LRUKReplacer::Size() -> size_t {
@@ -160,4 +116,87 @@ auto LRUKReplacer::Size() -> size_t {
   return curr_size_;
 }
 
+void LRUKReplacer::PeekVictims(size_t max_victims, std::vector<frame_id_t> *victims) {
+  std::lock_guard<std::mutex> lock(latch_);
+
+  victims->clear();
+  // Walk the heap best-first: a frontier of heap positions ordered by EvictBefore, starting at the top. Every popped
+  // position is the next victim, its children join the frontier. Costs O(max_victims * log(max_victims)).
+  auto later = [this](size_t a, size_t b) { return EvictBefore(heap_[b], heap_[a]); };
+  std::priority_queue<size_t, std::vector<size_t>, decltype(later)> frontier(later);
+  if (!heap_.empty()) {
+    frontier.push(0);
+  }
+  while (!frontier.empty() && victims->size() < max_victims) {
+    size_t index = frontier.top();
+    frontier.pop();
+    victims->push_back(heap_[index]);
+    for (size_t child = 2 * index + 1; child <= 2 * index + 2 && child < heap_.size(); child++) {
+      frontier.push(child);
+    }
+  }
+}
+
+void LRUKReplacer::ResetFrame(frame_id_t frame_id) {
+  auto &entry = frames_[frame_id];
+  entry.access_count_ = 0;
+  entry.heap_index_ = NOT_IN_HEAP;
+  entry.tracked_ = false;
+  entry.evictable_ = false;
+  entry.scan_only_ = false;
+}
+
+void LRUKReplacer::HeapPush(frame_id_t frame_id) {
+  heap_.push_back(frame_id);
+  frames_[frame_id].heap_index_ = heap_.size() - 1;
+  HeapSiftUp(heap_.size() - 1);
+}
+
+void LRUKReplacer::HeapErase(frame_id_t frame_id) {
+  size_t index = frames_[frame_id].heap_index_;
+  frames_[frame_id].heap_index_ = NOT_IN_HEAP;
+  frame_id_t last = heap_.back();
+  heap_.pop_back();
+  if (index == heap_.size()) {
+    return;
+  }
+  // move the last frame into the hole and restore the heap property in whichever direction it is broken
+  HeapPlace(index, last);
+  HeapSiftUp(index);
+  HeapSiftDown(frames_[last].heap_index_);
+}
+
+void LRUKReplacer::HeapSiftUp(size_t index) {
+  frame_id_t frame_id = heap_[index];
+  while (index > 0) {
+    size_t parent = (index - 1) / 2;
+    if (!EvictBefore(frame_id, heap_[parent])) {
+      break;
+    }
+    HeapPlace(index, heap_[parent]);
+    index = parent;
+  }
+  HeapPlace(index, frame_id);
+}
+
+void LRUKReplacer::HeapSiftDown(size_t index) {
+  frame_id_t frame_id = heap_[index];
+  size_t size = heap_.size();
+  while (true) {
+    size_t child = index * 2 + 1;
+    if (child >= size) {
+      break;
+    }
+    if (child + 1 < size && EvictBefore(heap_[child + 1], heap_[child])) {
+      child++;
+    }
+    if (!EvictBefore(heap_[child], frame_id)) {
+      break;
+    }
+    HeapPlace(index, heap_[child]);
+    index = child;
+  }
+  HeapPlace(index, frame_id);
+}
+
 }  // namespace bustub
@@ -18,6 +18,14 @@ LRUReplacer::LRUReplacer(size_t num_pages) {}
 
 LRUReplacer::~LRUReplacer() = default;
 
+auto LRUReplacer::Evict(frame_id_t *frame_id) -> bool { return false; }
+
+void LRUReplacer::RecordAccess(frame_id_t frame_id, AccessType access_type) {}
+
+void LRUReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {}
+
+void LRUReplacer::Remove(frame_id_t frame_id) {}
+
 auto LRUReplacer::Victim(frame_id_t *frame_id) -> bool { return false; }
 
 void LRUReplacer::Pin(frame_id_t frame_id) {}
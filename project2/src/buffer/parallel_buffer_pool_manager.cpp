@@ -0,0 +1,159 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager.cpp
+//
+// Identification: src/buffer/parallel_buffer_pool_manager.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/parallel_buffer_pool_manager.h"
+
+#include "common/macros.h"
+
+namespace bustub {
+
+ParallelBufferPoolManager::ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
+                                                     size_t replacer_k, LogManager *log_manager,
+                                                     ReplacerType replacer_type) {
+  BUSTUB_ASSERT(num_instances > 0, "ParallelBufferPoolManager needs at least one instance");
+  // Instance i owns every page id that is congruent to i modulo num_instances.
+  instances_.reserve(num_instances);
+  for (size_t i = 0; i < num_instances; i++) {
+    instances_.emplace_back(std::make_unique<BufferPoolManagerInstance>(
+        pool_size, num_instances, i, disk_manager, replacer_k, log_manager, replacer_type));
+    instances_.back()->prefetch_router_ = this;
+  }
+}
+
+ParallelBufferPoolManager::~ParallelBufferPoolManager() {
+  // a prefetcher may hand a page to any instance, stop all of them before the first instance goes away
+  for (auto &instance : instances_) {
+    instance->StopPrefetcher();
+  }
+}
+
+auto ParallelBufferPoolManager::GetPoolSize() -> size_t {
+  size_t pool_size = 0;
+  for (auto &instance : instances_) {
+    pool_size += instance->GetPoolSize();
+  }
+  return pool_size;
+}
+
+void ParallelBufferPoolManager::RunPageCleaner(size_t num_clean_victims) {
+  for (auto &instance : instances_) {
+    instance->RunPageCleaner(num_clean_victims);
+  }
+}
+
+void ParallelBufferPoolManager::StopPageCleaner() {
+  for (auto &instance : instances_) {
+    instance->StopPageCleaner();
+  }
+}
+
+auto ParallelBufferPoolManager::GetForegroundFlushCount() const -> uint64_t {
+  uint64_t flushes = 0;
+  for (const auto &instance : instances_) {
+    flushes += instance->GetForegroundFlushCount();
+  }
+  return flushes;
+}
+
+auto ParallelBufferPoolManager::GetBackgroundFlushCount() const -> uint64_t {
+  uint64_t flushes = 0;
+  for (const auto &instance : instances_) {
+    flushes += instance->GetBackgroundFlushCount();
+  }
+  return flushes;
+}
+
+auto ParallelBufferPoolManager::GetPrefetchCount() const -> uint64_t {
+  uint64_t pages = 0;
+  for (const auto &instance : instances_) {
+    pages += instance->GetPrefetchCount();
+  }
+  return pages;
+}
+
+auto ParallelBufferPoolManager::GetBufferPoolManager(page_id_t page_id) -> BufferPoolManagerInstance * {
+  return instances_[static_cast<size_t>(page_id) % instances_.size()].get();
+}
+
+auto ParallelBufferPoolManager::FetchPgImp(page_id_t page_id, AccessType access_type) -> Page * {
+  if (page_id < 0) {
+    return nullptr;
+  }
+  return GetBufferPoolManager(page_id)->FetchPage(page_id, access_type);
+}
+
+auto ParallelBufferPoolManager::UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool {
+  if (page_id < 0) {
+    return false;
+  }
+  return GetBufferPoolManager(page_id)->UnpinPage(page_id, is_dirty);
+}
+
+auto ParallelBufferPoolManager::FlushPgImp(page_id_t page_id) -> bool {
+  if (page_id < 0) {
+    return false;
+  }
+  return GetBufferPoolManager(page_id)->FlushPage(page_id);
+}
+
+auto ParallelBufferPoolManager::NewPgImp(page_id_t *page_id) -> Page * {
+  // Bump the starting index on every call so that consecutive NewPage calls land on different instances, then
+  // probe every instance once until one of them has a frame to spare.
+  size_t num_instances = instances_.size();
+  size_t start = next_instance_.fetch_add(1, std::memory_order_relaxed) % num_instances;
+  for (size_t i = 0; i < num_instances; i++) {
+    Page *page = instances_[(start + i) % num_instances]->NewPage(page_id);
+    if (page != nullptr) {
+      return page;
+    }
+  }
+  return nullptr;
+}
+
+auto ParallelBufferPoolManager::NewPgNearImp(page_id_t *page_id, page_id_t near_page_id) -> Page * {
+  if (near_page_id < 0) {
+    return NewPgImp(page_id);
+  }
+  size_t num_instances = instances_.size();
+  size_t start = (static_cast<size_t>(near_page_id) + 1) % num_instances;
+  for (size_t i = 0; i < num_instances; i++) {
+    Page *page = instances_[(start + i) % num_instances]->NewPageNear(page_id, near_page_id);
+    if (page != nullptr) {
+      return page;
+    }
+  }
+  return nullptr;
+}
+
+auto ParallelBufferPoolManager::DeletePgImp(page_id_t page_id) -> bool {
+  if (page_id < 0) {
+    return true;
+  }
+  return GetBufferPoolManager(page_id)->DeletePage(page_id);
+}
+
+void ParallelBufferPoolManager::FlushAllPgsImp() {
+  for (auto &instance : instances_) {
+    instance->FlushAllPages();
+  }
+}
+
+void ParallelBufferPoolManager::PrefetchPgsImp(const std::vector<page_id_t> &page_ids, size_t chain_length,
+                                               const next_page_fn &next_page) {
+  for (auto page_id : page_ids) {
+    if (page_id >= 0) {
+      GetBufferPoolManager(page_id)->PrefetchPgsImp({page_id}, chain_length, next_page);
+    }
+  }
+}
+
+}  // namespace bustub
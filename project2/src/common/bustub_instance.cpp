@@ -12,6 +12,7 @@
 #include "binder/statement/select_statement.h"
 #include "binder/statement/set_show_statement.h"
 #include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/parallel_buffer_pool_manager.h"
 #include "catalog/schema.h"
 #include "catalog/table_generator.h"
 #include "common/bustub_instance.h"
@@ -51,9 +52,10 @@ BustubInstance::BustubInstance(const std::string &db_file_name) {
   log_manager_ = new LogManager(disk_manager_);
 
   // We need more frames for GenerateTestTable to work. Therefore, we use 128 instead of the default
-  // buffer pool size specified in `config.h`.
+  // buffer pool size specified in `config.h`. The frames are split evenly across BUFFER_POOL_INSTANCES shards.
   try {
-    buffer_pool_manager_ = new BufferPoolManagerInstance(128, disk_manager_, LRUK_REPLACER_K, log_manager_);
+    buffer_pool_manager_ = new ParallelBufferPoolManager(BUFFER_POOL_INSTANCES, 128 / BUFFER_POOL_INSTANCES,
+                                                         disk_manager_, LRUK_REPLACER_K, log_manager_);
   } catch (NotImplementedException &e) {
     std::cerr << "BufferPoolManager is not implemented, only mock tables are supported." << std::endl;
     buffer_pool_manager_ = nullptr;
@@ -83,9 +85,10 @@ BustubInstance::BustubInstance() {
   log_manager_ = new LogManager(disk_manager_);
 
   // We need more frames for GenerateTestTable to work. Therefore, we use 128 instead of the default
-  // buffer pool size specified in `config.h`.
+  // buffer pool size specified in `config.h`. The frames are split evenly across BUFFER_POOL_INSTANCES shards.
   try {
-    buffer_pool_manager_ = new BufferPoolManagerInstance(128, disk_manager_, LRUK_REPLACER_K, log_manager_);
+    buffer_pool_manager_ = new ParallelBufferPoolManager(BUFFER_POOL_INSTANCES, 128 / BUFFER_POOL_INSTANCES,
+                                                         disk_manager_, LRUK_REPLACER_K, log_manager_);
   } catch (NotImplementedException &e) {
     std::cerr << "BufferPoolManager is not implemented, only mock tables are supported." << std::endl;
     buffer_pool_manager_ = nullptr;
@@ -0,0 +1,145 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// crc32c.cpp
+//
+// Identification: src/common/util/crc32c.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/util/crc32c.h"
+
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#define BUSTUB_HAVE_SSE42_CRC 1
+#endif
+
+namespace bustub {
+
+namespace {
+
+/** The CRC-32C polynomial, bit-reversed. */
+constexpr uint32_t CRC32C_POLY = 0x82f63b78;
+
+constexpr auto MakeTable() -> std::array<uint32_t, 256> {
+  std::array<uint32_t, 256> table{};
+  for (uint32_t i = 0; i < 256; i++) {
+    uint32_t crc = i;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ ((crc & 1) != 0 ? CRC32C_POLY : 0);
+    }
+    table[i] = crc;
+  }
+  return table;
+}
+
+constexpr std::array<uint32_t, 256> CRC32C_TABLE = MakeTable();
+
+#ifdef BUSTUB_HAVE_SSE42_CRC
+
+/**
+ * Length of each of the three blocks that are checksummed at the same time. The crc32 instruction takes three cycles
+ * but a new one can start every cycle, so three independent streams run three times as fast as one.
+ */
+constexpr size_t STREAM_BLOCK = 1360;
+static_assert(STREAM_BLOCK % sizeof(uint64_t) == 0, "the blocks are checksummed a word at a time");
+
+/** Run the CRC register over the bytes with the crc32 instruction, without the inversions of the final checksum. */
+__attribute__((target("sse4.2"))) auto Extend(uint64_t crc, const char *data, size_t length) -> uint64_t {
+  for (; length >= sizeof(uint64_t); data += sizeof(uint64_t), length -= sizeof(uint64_t)) {
+    uint64_t word;
+    memcpy(&word, data, sizeof(word));
+    crc = _mm_crc32_u64(crc, word);
+  }
+  for (; length > 0; data++, length--) {
+    crc = _mm_crc32_u8(static_cast<uint32_t>(crc), static_cast<uint8_t>(*data));
+  }
+  return crc;
+}
+
+/**
+ * The CRC register is linear, so running it over `zeros` zero bytes is the sum (xor) of doing so for each of its four
+ * bytes on their own, which this table holds.
+ */
+struct ShiftTable {
+  uint32_t table_[4][256];
+
+  __attribute__((target("sse4.2"))) explicit ShiftTable(size_t zeros) {
+    static const char ZEROS[STREAM_BLOCK * 2] = {0};
+    for (int byte = 0; byte < 4; byte++) {
+      for (uint32_t value = 0; value < 256; value++) {
+        table_[byte][value] = static_cast<uint32_t>(Extend(value << (8 * byte), ZEROS, zeros));
+      }
+    }
+  }
+
+  auto Shift(uint32_t crc) const -> uint32_t {
+    return table_[0][crc & 0xff] ^ table_[1][(crc >> 8) & 0xff] ^ table_[2][(crc >> 16) & 0xff] ^
+           table_[3][crc >> 24];
+  }
+};
+
+__attribute__((target("sse4.2"))) auto ComputeHardware(const char *data, size_t length, uint32_t crc) -> uint32_t {
+  static const ShiftTable SHIFT_ONE(STREAM_BLOCK);
+  static const ShiftTable SHIFT_TWO(STREAM_BLOCK * 2);
+
+  uint64_t crc64 = ~crc;
+  for (; length >= 3 * STREAM_BLOCK; data += 3 * STREAM_BLOCK, length -= 3 * STREAM_BLOCK) {
+    // the second and third blocks start from a zero register, and are combined with the first one by shifting it
+    uint64_t crc_a = crc64;
+    uint64_t crc_b = 0;
+    uint64_t crc_c = 0;
+    for (size_t offset = 0; offset < STREAM_BLOCK; offset += sizeof(uint64_t)) {
+      uint64_t word_a;
+      uint64_t word_b;
+      uint64_t word_c;
+      memcpy(&word_a, data + offset, sizeof(uint64_t));
+      memcpy(&word_b, data + STREAM_BLOCK + offset, sizeof(uint64_t));
+      memcpy(&word_c, data + 2 * STREAM_BLOCK + offset, sizeof(uint64_t));
+      crc_a = _mm_crc32_u64(crc_a, word_a);
+      crc_b = _mm_crc32_u64(crc_b, word_b);
+      crc_c = _mm_crc32_u64(crc_c, word_c);
+    }
+    crc64 = SHIFT_TWO.Shift(static_cast<uint32_t>(crc_a)) ^ SHIFT_ONE.Shift(static_cast<uint32_t>(crc_b)) ^ crc_c;
+  }
+  return ~static_cast<uint32_t>(Extend(crc64, data, length));
+}
+
+const bool HAVE_SSE42 = __builtin_cpu_supports("sse4.2");
+
+#endif
+
+}  // namespace
+
+auto Crc32c::Compute(const char *data, size_t length, uint32_t crc) -> uint32_t {
+#ifdef BUSTUB_HAVE_SSE42_CRC
+  if (HAVE_SSE42) {
+    return ComputeHardware(data, length, crc);
+  }
+#endif
+  return ComputeSoftware(data, length, crc);
+}
+
+auto Crc32c::ComputeSoftware(const char *data, size_t length, uint32_t crc) -> uint32_t {
+  crc = ~crc;
+  for (size_t i = 0; i < length; i++) {
+    crc = (crc >> 8) ^ CRC32C_TABLE[(crc ^ static_cast<uint8_t>(data[i])) & 0xff];
+  }
+  return ~crc;
+}
+
+auto Crc32c::IsHardwareAccelerated() -> bool {
+#ifdef BUSTUB_HAVE_SSE42_CRC
+  return HAVE_SSE42;
+#else
+  return false;
+#endif
+}
+
+}  // namespace bustub
@@ -27,9 +27,9 @@ namespace bustub {
 
 template <typename K, typename V>
 ExtendibleHashTable<K, V>::ExtendibleHashTable(size_t bucket_size)
-    : global_depth_(0), bucket_size_(bucket_size), num_buckets_(1) {
-  std::scoped_lock<std::mutex> lock(latch_);
-  this->dir_.push_back(std::make_shared<Bucket>(bucket_size_));
+    : global_depth_(0), bucket_size_(bucket_size), num_buckets_(1), dir_(1) {
+  buckets_.push_back(std::make_unique<Bucket>(bucket_size_));
+  dir_[0].store(buckets_.back().get());
 }
 
 template <typename K, typename V>
@@ -40,7 +40,7 @@ auto ExtendibleHashTable<K, V>::IndexOf(const K &key) -> size_t {
 
 template <typename K, typename V>
 auto ExtendibleHashTable<K, V>::GetGlobalDepth() const -> int {
-  std::scoped_lock<std::mutex> lock(latch_);
+  std::shared_lock<std::shared_mutex> lock(dir_latch_);
   return GetGlobalDepthInternal();
 }
 
@@ -51,165 +51,215 @@ auto ExtendibleHashTable<K, V>::GetGlobalDepthInternal() const -> int {
 
 template <typename K, typename V>
 auto ExtendibleHashTable<K, V>::GetLocalDepth(int dir_index) const -> int {
-  std::scoped_lock<std::mutex> lock(latch_);
+  std::shared_lock<std::shared_mutex> lock(dir_latch_);
   return GetLocalDepthInternal(dir_index);
 }
 
 template <typename K, typename V>
 auto ExtendibleHashTable<K, V>::GetLocalDepthInternal(int dir_index) const -> int {
-  return dir_[dir_index]->GetDepth();
+  auto *bucket = dir_[dir_index].load();
+  bucket->RLatch();
+  int depth = bucket->GetDepth();
+  bucket->RUnlatch();
+  return depth;
 }
 
 template <typename K, typename V>
 auto ExtendibleHashTable<K, V>::GetNumBuckets() const -> int {
-  std::scoped_lock<std::mutex> lock(latch_);
   return GetNumBucketsInternal();
 }
 
 template <typename K, typename V>
 auto ExtendibleHashTable<K, V>::GetNumBucketsInternal() const -> int {
-  return num_buckets_;
+  return num_buckets_.load();
+}
+
+template <typename K, typename V>
+auto ExtendibleHashTable<K, V>::LatchBucket(const K &key, bool exclusive, size_t *index) -> Bucket * {
+  while (true) {
+    *index = IndexOf(key);
+    auto *bucket = dir_[*index].load();
+    if (exclusive) {
+      bucket->WLatch();
+    } else {
+      bucket->RLatch();
+    }
+    // 拿到latch之前bucket可能被分裂了，此时key可能已经属于新的bucket
+    if (dir_[*index].load() == bucket) {
+      return bucket;
+    }
+    if (exclusive) {
+      bucket->WUnlatch();
+    } else {
+      bucket->RUnlatch();
+    }
+  }
 }
 
 template <typename K, typename V>
 auto ExtendibleHashTable<K, V>::Find(const K &key, V &value) -> bool {
-  std::scoped_lock<std::mutex> lock(latch_);
+  std::shared_lock<std::shared_mutex> lock(dir_latch_);
 
-  auto index = IndexOf(key);
-  return dir_[index]->Find(key, value);
+  size_t index;
+  auto *bucket = LatchBucket(key, false, &index);
+  bool found = bucket->Find(key, value);
+  bucket->RUnlatch();
+  return found;
 }
 
 template <typename K, typename V>
 auto ExtendibleHashTable<K, V>::Remove(const K &key) -> bool {
-  std::scoped_lock<std::mutex> lock(latch_);
+  std::shared_lock<std::shared_mutex> lock(dir_latch_);
 
-  size_t index = IndexOf(key);
-  return dir_[index]->Remove(key);
+  size_t index;
+  auto *bucket = LatchBucket(key, true, &index);
+  bool removed = bucket->Remove(key);
+  bucket->WUnlatch();
+  return removed;
 }
 
 template <typename K, typename V>
 void ExtendibleHashTable<K, V>::Insert(const K &key, const V &value) {
-  std::scoped_lock<std::mutex> lock(latch_);
-  DoInsert(key, value);
-}
-
-template <typename K, typename V>
-void ExtendibleHashTable<K, V>::DoInsert(const K &key, const V &value) {
-  auto index = IndexOf(key);
-  if (!dir_[index]->IsFull()) {
-    auto success = dir_[index]->Insert(key, value);
-    if (!success) {
-      LOG_ERROR("Insert failed");
-    }
-    return;
-  }
-
-  // index 如果满了，就需要开始分裂了
-  // 如果是等于global_depth_，那么需要扩展一下
-  if (dir_[index]->GetDepth() == this->global_depth_) {
-    this->global_depth_++;
-    auto old_len = dir_.size();
-    auto tmp_bucket = std::vector<std::shared_ptr<Bucket>>(old_len * 2);
-    for (size_t i = 0; i < old_len; i++) {
-      tmp_bucket[i] = this->dir_[i];
-      tmp_bucket[i + old_len] = this->dir_[i];
+  while (true) {
+    {
+      std::shared_lock<std::shared_mutex> lock(dir_latch_);
+      size_t index;
+      auto *bucket = LatchBucket(key, true, &index);
+      if (bucket->Insert(key, value)) {
+        bucket->WUnlatch();
+        return;
+      }
+      // index 如果满了，就需要开始分裂了；local depth小于global depth时不用动directory的大小
+      bool need_grow = bucket->GetDepth() == global_depth_;
+      if (!need_grow) {
+        SplitBucket(bucket, index);
+      }
+      bucket->WUnlatch();
+      if (!need_grow) {
+        continue;
+      }
     }
 
-    // 在将tmpBucket分配给dir_之前释放旧的buckets
-    for (size_t i = 0; i < old_len; i++) {
-      this->dir_[i].reset();
+    // 如果是等于global_depth_，那么需要扩展一下。拿到exclusive latch之前别的线程可能已经扩展过了
+    std::unique_lock<std::shared_mutex> lock(dir_latch_);
+    auto *bucket = dir_[IndexOf(key)].load();
+    if (bucket->GetDepth() == global_depth_ && bucket->IsFull()) {
+      GrowDirectory();
     }
-
-    this->dir_ = tmp_bucket;
   }
+}
 
-  // 分裂第index个
-  std::vector<std::shared_ptr<Bucket>> tmp_dir(2);
-  for (auto &tmp : tmp_dir) {
-    tmp = std::make_shared<Bucket>(this->bucket_size_, this->dir_[index]->GetDepth() + 1);
+template <typename K, typename V>
+void ExtendibleHashTable<K, V>::GrowDirectory() {
+  auto old_len = dir_.size();
+  std::vector<std::atomic<Bucket *>> new_dir(old_len * 2);
+  for (size_t i = 0; i < old_len; i++) {
+    new_dir[i].store(dir_[i].load());
+    new_dir[i + old_len].store(dir_[i].load());
   }
-  auto local_item = this->dir_[index];
-  // bool flip = false;
-  auto local_mask = 1 << (local_item->GetDepth());
-  for (size_t i = 0; i < this->dir_.size(); i++) {
-    if (dir_[i] != local_item) {
-      continue;
-    }
-    // if (flip) {
-    //   this->dir_[i] = tmp_dir[0];
-    //   flip = !flip;
-    // } else {
-    //   this->dir_[i] = tmp_dir[1];
-    //   flip = !flip;
-    // }
-    if (local_mask & i) {
-      this->dir_[i] = tmp_dir[1];
+  dir_.swap(new_dir);
+  global_depth_++;
+}
+
+template <typename K, typename V>
+void ExtendibleHashTable<K, V>::SplitBucket(Bucket *bucket, size_t index) {
+  int depth = bucket->GetDepth();
+  size_t high_bit = static_cast<size_t>(1) << depth;
+
+  // 分裂：hash第depth位为1的item搬到新的bucket里，旧的bucket保留其余的item
+  auto new_bucket = std::make_unique<Bucket>(bucket_size_, depth + 1);
+  bucket->IncrementDepth();
+  for (size_t i = 0; i < bucket->GetNumItems();) {
+    if ((std::hash<K>()(bucket->KeyAt(i)) & high_bit) != 0) {
+      new_bucket->Insert(bucket->KeyAt(i), bucket->ValueAt(i));
+      bucket->RemoveAt(i);
     } else {
-      this->dir_[i] = tmp_dir[0];
+      i++;
     }
   }
-  this->num_buckets_++;
 
-  for (auto const &tmp_item : local_item->GetItems()) {
-    auto tmp_index = IndexOf(tmp_item.first);
-    auto success = this->dir_[tmp_index]->Insert(tmp_item.first, tmp_item.second);
-    if (!success) {
-      LOG_ERROR("Insert failed");
+  auto *new_bucket_ptr = new_bucket.get();
+  {
+    std::scoped_lock<std::mutex> lock(buckets_latch_);
+    buckets_.push_back(std::move(new_bucket));
+  }
+  // 只需要改指向这个bucket的那些slot：它们的低depth位都相同，间隔为high_bit
+  for (size_t i = index & (high_bit - 1); i < dir_.size(); i += high_bit) {
+    if ((i & high_bit) != 0) {
+      dir_[i].store(new_bucket_ptr);
     }
   }
-
-  // 最后做一次插入
-  // index = IndexOf(key);
-  // auto success = dir_[index]->Insert(key, value);
-  // if (!success) {
-  //   LOG_ERROR("Insert failed");
-  //   std::cout << "key is " << key << " index=" << index << "\n";
-  // }
-
-  // 漂亮，假设还需要继续扩容，可以使用同一套代码
-  DoInsert(key, value);
+  num_buckets_++;
 }
 
 //===--------------------------------------------------------------------===//
 // Bucket
 //===--------------------------------------------------------------------===//
 template <typename K, typename V>
-ExtendibleHashTable<K, V>::Bucket::Bucket(size_t array_size, int depth) : size_(array_size), depth_(depth) {}
+ExtendibleHashTable<K, V>::Bucket::Bucket(size_t array_size, int depth)
+    : size_(array_size), depth_(depth), fingerprints_(array_size), keys_(array_size), values_(array_size) {}
 
 template <typename K, typename V>
-auto ExtendibleHashTable<K, V>::Bucket::Find(const K &key, V &value) -> bool {
-  for (const auto &list_item : list_) {
-    if (key == list_item.first) {
-      value = list_item.second;
-      return true;
+auto ExtendibleHashTable<K, V>::Bucket::Fingerprint(const K &key) -> uint8_t {
+  // std::hash of an integer is the integer itself, mix it so that the high bits depend on every bit of the key
+  return static_cast<uint8_t>((static_cast<uint64_t>(std::hash<K>()(key)) * 0x9E3779B97F4A7C15ULL) >> 56);
+}
+
+template <typename K, typename V>
+auto ExtendibleHashTable<K, V>::Bucket::IndexOfKey(const K &key, uint8_t fingerprint) const -> size_t {
+  for (size_t i = 0; i < num_items_; i++) {
+    if (fingerprints_[i] == fingerprint && keys_[i] == key) {
+      return i;
     }
   }
-  return false;
+  return num_items_;
+}
+
+template <typename K, typename V>
+auto ExtendibleHashTable<K, V>::Bucket::Find(const K &key, V &value) -> bool {
+  size_t index = IndexOfKey(key, Fingerprint(key));
+  if (index == num_items_) {
+    return false;
+  }
+  value = values_[index];
+  return true;
+}
+
+template <typename K, typename V>
+void ExtendibleHashTable<K, V>::Bucket::RemoveAt(size_t index) {
+  num_items_--;
+  if (index != num_items_) {
+    fingerprints_[index] = fingerprints_[num_items_];
+    keys_[index] = std::move(keys_[num_items_]);
+    values_[index] = std::move(values_[num_items_]);
+  }
 }
 
 template <typename K, typename V>
 auto ExtendibleHashTable<K, V>::Bucket::Remove(const K &key) -> bool {
-  for (auto it = list_.begin(); it != list_.end(); ++it) {
-    if (it->first == key) {
-      it = list_.erase(it);  // 删除元素，并将迭代器更新为下一个有效位置
-      return true;
-    }
+  size_t index = IndexOfKey(key, Fingerprint(key));
+  if (index == num_items_) {
+    return false;
   }
-  return false;
+  RemoveAt(index);
+  return true;
 }
 
 template <typename K, typename V>
 auto ExtendibleHashTable<K, V>::Bucket::Insert(const K &key, const V &value) -> bool {
-  for (auto &list_item : list_) {
-    if (list_item.first == key) {
-      list_item.second = value;
-      return true;
-    }
+  uint8_t fingerprint = Fingerprint(key);
+  size_t index = IndexOfKey(key, fingerprint);
+  if (index != num_items_) {
+    values_[index] = value;
+    return true;
   }
   if (this->IsFull()) {
     return false;
   }
-  list_.push_back(std::pair<K, V>(key, value));
+  fingerprints_[num_items_] = fingerprint;
+  keys_[num_items_] = key;
+  values_[num_items_] = value;
+  num_items_++;
   return true;
 }
 
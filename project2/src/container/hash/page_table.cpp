@@ -0,0 +1,155 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table.cpp
+//
+// Identification: src/container/hash/page_table.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "container/hash/page_table.h"
+
+#include <algorithm>
+#include <string>
+
+#include "common/exception.h"
+
+namespace bustub {
+
+PageTable::PageTable(size_t max_entries) : max_entries_(max_entries) {
+  // keep the load factor at or below 1/2 so that probe sequences stay within a cache line or two
+  capacity_bits_ = 0;
+  while ((static_cast<size_t>(1) << capacity_bits_) < std::max<size_t>(2 * max_entries, SLOTS_PER_GROUP)) {
+    capacity_bits_++;
+  }
+  capacity_ = static_cast<size_t>(1) << capacity_bits_;
+  groups_ = std::vector<SlotGroup>(capacity_ / SLOTS_PER_GROUP);
+}
+
+auto PageTable::HomeIndex(page_id_t page_id) const -> size_t {
+  // Fibonacci hashing: page ids are small dense integers, the multiplication spreads them over the high bits
+  return static_cast<size_t>((static_cast<uint64_t>(static_cast<uint32_t>(page_id)) * 0x9E3779B97F4A7C15ULL) >>
+                             (64 - capacity_bits_));
+}
+
+auto PageTable::Find(const page_id_t &page_id, frame_id_t &frame_id) -> bool {
+  while (true) {
+    uint64_t begin = sequence_.load(std::memory_order_acquire);
+    if ((begin & 1) != 0) {
+      // a writer is in the middle of an update
+      continue;
+    }
+
+    bool found = false;
+    frame_id_t result = -1;
+    for (size_t i = HomeIndex(page_id), probes = 0; probes < capacity_; i = (i + 1) & (capacity_ - 1), probes++) {
+      auto &slot = GetSlot(i);
+      page_id_t slot_page_id = slot.page_id_.load(std::memory_order_relaxed);
+      if (slot_page_id == INVALID_PAGE_ID) {
+        break;
+      }
+      if (slot_page_id == page_id) {
+        result = slot.frame_id_.load(std::memory_order_relaxed);
+        found = true;
+        break;
+      }
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (sequence_.load(std::memory_order_relaxed) == begin) {
+      if (found) {
+        frame_id = result;
+      }
+      return found;
+    }
+  }
+}
+
+auto PageTable::FindIndex(page_id_t page_id) -> size_t {
+  for (size_t i = HomeIndex(page_id), probes = 0; probes < capacity_; i = (i + 1) & (capacity_ - 1), probes++) {
+    page_id_t slot_page_id = GetSlot(i).page_id_.load(std::memory_order_relaxed);
+    if (slot_page_id == INVALID_PAGE_ID) {
+      break;
+    }
+    if (slot_page_id == page_id) {
+      return i;
+    }
+  }
+  return capacity_;
+}
+
+void PageTable::BeginWrite() {
+  sequence_.store(sequence_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+}
+
+void PageTable::EndWrite() {
+  sequence_.store(sequence_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void PageTable::Insert(const page_id_t &page_id, const frame_id_t &frame_id) {
+  BUSTUB_ASSERT(page_id != INVALID_PAGE_ID, "cannot insert INVALID_PAGE_ID into the page table");
+  std::lock_guard<std::mutex> lock(write_latch_);
+
+  size_t index = FindIndex(page_id);
+  if (index != capacity_) {
+    // overwriting a value in place never moves a key, readers that race with it see either value
+    GetSlot(index).frame_id_.store(frame_id, std::memory_order_relaxed);
+    return;
+  }
+  if (num_entries_.load(std::memory_order_relaxed) >= max_entries_) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "page table is full, cannot insert page " + std::to_string(page_id));
+  }
+
+  index = HomeIndex(page_id);
+  while (GetSlot(index).page_id_.load(std::memory_order_relaxed) != INVALID_PAGE_ID) {
+    index = (index + 1) & (capacity_ - 1);
+  }
+  BeginWrite();
+  GetSlot(index).page_id_.store(page_id, std::memory_order_relaxed);
+  GetSlot(index).frame_id_.store(frame_id, std::memory_order_relaxed);
+  EndWrite();
+
+  num_entries_.fetch_add(1, std::memory_order_relaxed);
+}
+
+auto PageTable::Remove(const page_id_t &page_id) -> bool {
+  std::lock_guard<std::mutex> lock(write_latch_);
+
+  size_t hole = FindIndex(page_id);
+  if (hole == capacity_) {
+    return false;
+  }
+
+  BeginWrite();
+  // backward shift deletion: pull every following entry of the cluster that may live in the hole into it
+  size_t next = (hole + 1) & (capacity_ - 1);
+  while (true) {
+    auto &next_slot = GetSlot(next);
+    page_id_t next_page_id = next_slot.page_id_.load(std::memory_order_relaxed);
+    if (next_page_id == INVALID_PAGE_ID) {
+      break;
+    }
+    size_t home = HomeIndex(next_page_id);
+    // the entry may move into the hole unless its home lies cyclically in (hole, next]
+    bool home_after_hole = hole <= next ? (hole < home && home <= next) : (hole < home || home <= next);
+    if (!home_after_hole) {
+      auto &hole_slot = GetSlot(hole);
+      hole_slot.page_id_.store(next_page_id, std::memory_order_relaxed);
+      hole_slot.frame_id_.store(next_slot.frame_id_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+      hole = next;
+    }
+    next = (next + 1) & (capacity_ - 1);
+  }
+  GetSlot(hole).page_id_.store(INVALID_PAGE_ID, std::memory_order_relaxed);
+  GetSlot(hole).frame_id_.store(-1, std::memory_order_relaxed);
+  EndWrite();
+
+  num_entries_.fetch_sub(1, std::memory_order_relaxed);
+  return true;
+}
+
+}  // namespace bustub
@@ -12,9 +12,11 @@
 
 #pragma once
 
+#include <functional>
 #include <list>
 #include <mutex>  // NOLINT
 #include <unordered_map>
+#include <vector>
 
 #include "buffer/lru_replacer.h"
 #include "recovery/log_manager.h"
@@ -30,6 +32,8 @@ class BufferPoolManager {
  public:
   enum class CallbackType { BEFORE, AFTER };
   using bufferpool_callback_fn = void (*)(enum CallbackType, const page_id_t page_id);
+  /** Reads the id of the page that follows the given page in a chain of pages, e.g. the next page of a table heap. */
+  using next_page_fn = std::function<page_id_t(Page *page)>;
 
   BufferPoolManager() = default;
   /**
@@ -45,6 +49,22 @@ class BufferPoolManager {
     return result;
   }
 
+  /**
+   * Fetch a page, telling the buffer pool how it is going to be used. Pages fetched with AccessType::Scan are
+   * recycled before the rest of the buffer pool, so that sequential scans do not evict the working set of other
+   * queries.
+   * @param page_id id of page to be fetched
+   * @param access_type how the page is going to be used
+   * @param callback grading callback, as for FetchPage(page_id_t, bufferpool_callback_fn)
+   * @return the requested page
+   */
+  auto FetchPage(page_id_t page_id, AccessType access_type, bufferpool_callback_fn callback = nullptr) -> Page * {
+    GradingCallback(callback, CallbackType::BEFORE, page_id);
+    auto *result = FetchPgImp(page_id, access_type);
+    GradingCallback(callback, CallbackType::AFTER, page_id);
+    return result;
+  }
+
   /** Grading function. Do not modify! */
   auto UnpinPage(page_id_t page_id, bool is_dirty, bufferpool_callback_fn callback = nullptr) -> bool {
     GradingCallback(callback, CallbackType::BEFORE, page_id);
@@ -84,6 +104,35 @@ class BufferPoolManager {
     GradingCallback(callback, CallbackType::AFTER, INVALID_PAGE_ID);
   }
 
+  /**
+   * Create a new page whose id follows near_page_id if possible, so that the pages of a table or an index that are
+   * allocated one after the other stay in sequence on disk and scan sequentially.
+   * @param[out] page_id id of created page
+   * @param near_page_id id of the page the new page should follow, e.g. the last page of the table
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  auto NewPageNear(page_id_t *page_id, page_id_t near_page_id) -> Page * { return NewPgNearImp(page_id, near_page_id); }
+
+  /**
+   * Ask the buffer pool to read the given pages in the background, so that fetching them later does not wait for the
+   * disk. Prefetching is only a hint: requests may be dropped and pages that are already in the pool are left alone.
+   * @param page_ids ids of the pages to read, in the order they will be fetched
+   */
+  void PrefetchPages(const std::vector<page_id_t> &page_ids) { PrefetchPgsImp(page_ids, 0, nullptr); }
+
+  /**
+   * Ask the buffer pool to read a chain of pages in the background, starting at page_id and following next_page from
+   * every page it reads, until num_pages pages are read or the chain ends with INVALID_PAGE_ID.
+   * @param page_id id of the first page of the chain
+   * @param num_pages how many pages of the chain to read
+   * @param next_page reads the id of the following page, called with the page read latched
+   */
+  void PrefetchChain(page_id_t page_id, size_t num_pages, const next_page_fn &next_page) {
+    if (page_id != INVALID_PAGE_ID && num_pages > 0) {
+      PrefetchPgsImp({page_id}, num_pages - 1, next_page);
+    }
+  }
+
   /** @return size of the buffer pool */
   virtual auto GetPoolSize() -> size_t = 0;
 
@@ -104,9 +153,10 @@ class BufferPoolManager {
   /**
    * Fetch the requested page from the buffer pool.
    * @param page_id id of page to be fetched
+   * @param access_type how the page is going to be used, a hint for the replacement policy
    * @return the requested page
    */
-  virtual auto FetchPgImp(page_id_t page_id) -> Page * = 0;
+  virtual auto FetchPgImp(page_id_t page_id, AccessType access_type = AccessType::Unknown) -> Page * = 0;
 
   /**
    * Unpin the target page from the buffer pool.
@@ -130,6 +180,15 @@ class BufferPoolManager {
    */
   virtual auto NewPgImp(page_id_t *page_id) -> Page * = 0;
 
+  /**
+   * Creates a new page in the buffer pool, placed after near_page_id if possible. The default implementation ignores
+   * the hint.
+   * @param[out] page_id id of created page
+   * @param near_page_id id of the page the new page should follow
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  virtual auto NewPgNearImp(page_id_t *page_id, page_id_t near_page_id) -> Page * { return NewPgImp(page_id); }
+
   /**
    * Deletes a page from the buffer pool.
    * @param page_id id of page to be deleted
@@ -141,5 +200,14 @@ class BufferPoolManager {
    * Flushes all the pages in the buffer pool to disk.
    */
   virtual void FlushAllPgsImp() = 0;
+
+  /**
+   * Read pages in the background. The default implementation ignores the request.
+   * @param page_ids ids of the pages to read
+   * @param chain_length how many pages to follow after each of page_ids, using next_page
+   * @param next_page reads the id of the following page, may be nullptr if chain_length is 0
+   */
+  virtual void PrefetchPgsImp(const std::vector<page_id_t> &page_ids, size_t chain_length,
+                              const next_page_fn &next_page) {}
 };
 }  // namespace bustub
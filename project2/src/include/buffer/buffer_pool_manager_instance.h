@@ -12,14 +12,19 @@
 
 #pragma once
 
+#include <condition_variable>  // NOLINT
+#include <deque>
 #include <list>
-#include <mutex>  // NOLINT
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
 #include <unordered_map>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
+#include "buffer/clock_replacer.h"
 #include "buffer/lru_k_replacer.h"
 #include "common/config.h"
-#include "container/hash/extendible_hash_table.h"
+#include "container/hash/page_table.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/page.h"
@@ -30,6 +35,8 @@ namespace bustub {
  * BufferPoolManager reads disk pages to and from its internal buffer pool.
  */
 class BufferPoolManagerInstance : public BufferPoolManager {
+  friend class ParallelBufferPoolManager;
+
  public:
   /**
    * @brief Creates a new BufferPoolManagerInstance.
@@ -37,9 +44,24 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    * @param disk_manager the disk manager
    * @param replacer_k the lookback constant k for the LRU-K replacer
    * @param log_manager the log manager (for testing only: nullptr = disable logging). Please ignore this for P1.
+   * @param replacer_type the replacement policy used to pick victim frames
    */
   BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, size_t replacer_k = LRUK_REPLACER_K,
-                            LogManager *log_manager = nullptr);
+                            LogManager *log_manager = nullptr, ReplacerType replacer_type = ReplacerType::LRU_K);
+
+  /**
+   * @brief Creates a new BufferPoolManagerInstance that is one shard of a ParallelBufferPoolManager.
+   * @param pool_size the size of the buffer pool
+   * @param num_instances total number of BPIs in parallel BPM
+   * @param instance_index index of this BPI in the parallel BPM
+   * @param disk_manager the disk manager
+   * @param replacer_k the lookback constant k for the LRU-K replacer
+   * @param log_manager the log manager (for testing only: nullptr = disable logging). Please ignore this for P1.
+   * @param replacer_type the replacement policy used to pick victim frames
+   */
+  BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
+                            DiskManager *disk_manager, size_t replacer_k = LRUK_REPLACER_K,
+                            LogManager *log_manager = nullptr, ReplacerType replacer_type = ReplacerType::LRU_K);
 
   /**
    * @brief Destroy an existing BufferPoolManagerInstance.
@@ -52,6 +74,29 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   /** @brief Return the pointer to all the pages in the buffer pool. */
   auto GetPages() -> Page * { return pages_; }
 
+  /**
+   * @brief Start the page cleaner, a background thread that keeps the next num_clean_victims victims of the replacer
+   * clean, so that NewPgImp and FetchPgImp rarely have to write back a dirty victim themselves. The cleaner wakes up
+   * every page_cleaner_interval, and whenever an eviction had to write back a dirty page in the foreground. Frames it
+   * is writing back are pinned, so DeletePgImp fails on them until the write is done.
+   * @param num_clean_victims how many of the next victims the cleaner keeps clean
+   */
+  void RunPageCleaner(size_t num_clean_victims);
+
+  /**
+   * @brief Stop the page cleaner and wait for it to exit. Does nothing if the cleaner is not running.
+   */
+  void StopPageCleaner();
+
+  /** @brief Return the number of dirty victims written back by NewPgImp and FetchPgImp on the caller's thread. */
+  auto GetForegroundFlushCount() const -> uint64_t { return foreground_flushes_.load(); }
+
+  /** @brief Return the number of dirty pages written back by the page cleaner. */
+  auto GetBackgroundFlushCount() const -> uint64_t { return background_flushes_.load(); }
+
+  /** @brief Return the number of pages read from disk by the prefetcher. */
+  auto GetPrefetchCount() const -> uint64_t { return prefetched_pages_.load(); }
+
  protected:
   /**
    * TODO(P1): Add implementation
@@ -72,6 +117,11 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    */
   auto NewPgImp(page_id_t *page_id) -> Page * override;
 
+  /**
+   * @brief Create a new page like NewPgImp, asking the disk manager for a page id after near_page_id.
+   */
+  auto NewPgNearImp(page_id_t *page_id, page_id_t near_page_id) -> Page * override;
+
   /**
    * TODO(P1): Add implementation
    *
@@ -84,11 +134,16 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    * to disk and update the metadata of the new page
    *
    * In addition, remember to disable eviction and record the access history of the frame like you did for NewPgImp().
+   * The access is recorded with access_type, so that pages only used by scans stay at the cold end of the replacer.
+   *
+   * The write-back of a dirty victim and the read of page_id are done without holding latch_. While they run, the frame
+   * is marked as in I/O and other fetchers of page_id (or of the victim page) wait on the frame's condition.
    *
    * @param page_id id of page to be fetched
+   * @param access_type how the page is going to be used
    * @return nullptr if page_id cannot be fetched, otherwise pointer to the requested page
    */
-  auto FetchPgImp(page_id_t page_id) -> Page * override;
+  auto FetchPgImp(page_id_t page_id, AccessType access_type = AccessType::Unknown) -> Page * override;
 
   /**
    * TODO(P1): Add implementation
@@ -142,41 +197,177 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    */
   auto DeletePgImp(page_id_t page_id) -> bool override;
 
+  /**
+   * @brief Queue pages for the prefetcher, a background thread that is started by the first request. Every queued
+   * page that is not in the buffer pool is read into a victim frame as a scan access, so that a prefetched page stays
+   * at the cold end of the replacer until somebody uses it, and unpinned right away. A
+   * page of a chain is pinned while the prefetcher reads the id of the next page from it, so DeletePgImp may fail on
+   * it meanwhile. Requests beyond pool_size_ queued pages are dropped.
+   * @param page_ids ids of the pages to read
+   * @param chain_length how many pages to follow after each of page_ids, using next_page
+   * @param next_page reads the id of the following page, may be nullptr if chain_length is 0
+   */
+  void PrefetchPgsImp(const std::vector<page_id_t> &page_ids, size_t chain_length,
+                      const next_page_fn &next_page) override;
+
   /** Number of pages in the buffer pool. */
   const size_t pool_size_;
-  /** The next page id to be allocated  */
-  std::atomic<page_id_t> next_page_id_ = 0;
-  /** Bucket size for the extendible hash table */
-  const size_t bucket_size_ = 4;
+  /** How many instances are in the parallel BPM (if present, otherwise just 1 BPI) */
+  const uint32_t num_instances_ = 1;
+  /** Index of this BPI in the parallel BPM (if present, otherwise just 0) */
+  const uint32_t instance_index_ = 0;
 
   /** Array of buffer pool pages. */
   Page *pages_;
+  /** The data of all the frames, pool_size_ pages aligned to BUSTUB_PAGE_SIZE. pages_[i] points at the i-th one. */
+  char *page_data_;
   /** Pointer to the disk manager. */
   DiskManager *disk_manager_ __attribute__((__unused__));
   /** Pointer to the log manager. Please ignore this for P1. */
   LogManager *log_manager_ __attribute__((__unused__));
   /** Page table for keeping track of buffer pool pages. */
-  ExtendibleHashTable<page_id_t, frame_id_t> *page_table_;
+  PageTable *page_table_;
   /** Replacer to find unpinned pages for replacement. */
-  LRUKReplacer *replacer_;
+  Replacer *replacer_;
   /** List of free frames that don't have any pages on them. */
   std::list<frame_id_t> free_list_;
-  /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
+  /**
+   * This latch protects the page table, the replacer, the free list, io_in_progress_ and the book-keeping fields of
+   * every frame. It is never held across disk I/O done on behalf of FetchPgImp or NewPgImp.
+   */
   std::mutex latch_;
+  /** True while a frame is being written back or read from disk without holding latch_. Protected by latch_. */
+  std::vector<bool> io_in_progress_;
+  /** One condition per frame, signaled when the frame's I/O finishes. Waited on with latch_ held. */
+  std::vector<std::condition_variable> io_cv_;
+  /**
+   * True while the page cleaner writes a frame back. The frame stays usable, but flushes of it wait on io_cv_ until
+   * the cleaner is done. Protected by latch_.
+   */
+  std::vector<bool> cleaning_;
+
+  /** The page cleaner thread, nullptr if it is not running. */
+  std::thread *cleaner_thread_ = nullptr;
+  /** How many of the next victims the page cleaner keeps clean. */
+  size_t num_clean_victims_ = 0;
+  /** Set to ask the page cleaner to exit. Protected by latch_. */
+  bool cleaner_stop_ = false;
+  /** Wakes up the page cleaner. Waited on with latch_ held. */
+  std::condition_variable cleaner_cv_;
+  std::atomic<uint64_t> foreground_flushes_ = 0;
+  std::atomic<uint64_t> background_flushes_ = 0;
+
+  /** A page queued for the prefetcher, and how much of its chain to follow. */
+  struct PrefetchRequest {
+    page_id_t page_id_;
+    size_t chain_length_;
+    next_page_fn next_page_;
+  };
+
+  /** The buffer pool that the next page of a chain is handed to, the parallel BPM if this instance is a shard. */
+  BufferPoolManager *prefetch_router_ = this;
+  /** The prefetcher thread, nullptr until the first prefetch request. */
+  std::thread *prefetch_thread_ = nullptr;
+  /** Pages waiting for the prefetcher. Protected by prefetch_latch_. */
+  std::deque<PrefetchRequest> prefetch_queue_;
+  /** Set to ask the prefetcher to exit, no requests are queued afterwards. Protected by prefetch_latch_. */
+  bool prefetch_stop_ = false;
+  /** Protects the prefetcher state. Never held together with latch_. */
+  std::mutex prefetch_latch_;
+  /** Wakes up the prefetcher. Waited on with prefetch_latch_ held. */
+  std::condition_variable prefetch_cv_;
+  std::atomic<uint64_t> prefetched_pages_ = 0;
+
+  /**
+   * @brief Pick a replacement frame, from the free list first and then from the replacer. Caller should acquire the
+   * latch before calling this function.
+   * @param[out] frame_id the replacement frame
+   * @return false if all frames are currently in use and not evictable
+   */
+  auto GetVictimFrame(frame_id_t *frame_id) -> bool;
+
+  /**
+   * @brief Look up the frame that holds page_id. If the frame is in the middle of I/O, wait until the I/O is done
+   * (releasing the latch meanwhile) and look the page up again.
+   * @param lock the held latch_
+   * @param page_id id of the page to look up
+   * @param[out] frame_id the frame holding the page
+   * @param wait_for_cleaner also wait while the page cleaner writes the frame back, for callers that write the page
+   * themselves and must not have an older image of the cleaner land after theirs
+   * @return true if the page is in the buffer pool
+   */
+  auto FindFrame(std::unique_lock<std::mutex> &lock, page_id_t page_id, frame_id_t *frame_id,
+                 bool wait_for_cleaner = false) -> bool;
+
+  /**
+   * @brief Hand a victim frame over to page_id: map page_id to the frame, pin it and record the access. Caller should
+   * acquire the latch before calling this function.
+   * @param frame_id the victim frame returned by GetVictimFrame()
+   * @param page_id id of the page that is going to live in the frame
+   * @param access_type the access recorded in the replacer
+   * @return the id of the dirty page that still has to be written back from the frame, or INVALID_PAGE_ID
+   */
+  auto ClaimFrame(frame_id_t frame_id, page_id_t page_id, AccessType access_type = AccessType::Unknown) -> page_id_t;
+
+  /**
+   * @brief Finish the I/O started on a claimed frame and wake up the threads waiting on it. Caller should acquire the
+   * latch before calling this function.
+   * @param frame_id the frame whose I/O is done
+   * @param written_page_id the page written back from the frame (as returned by ClaimFrame()), or INVALID_PAGE_ID
+   */
+  void FinishIo(frame_id_t frame_id, page_id_t written_page_id);
+
+  /**
+   * @brief Body of the page cleaner thread.
+   */
+  void PageCleanerLoop();
+
+  /**
+   * @brief Write back the dirty, unpinned frames among the next num_clean_victims_ victims. The frames are pinned and
+   * marked clean under the latch, then written without it, so a page dirtied again meanwhile stays dirty. They are
+   * marked in cleaning_ until the write is done.
+   * @param lock the held latch_, released during the writes
+   */
+  void CleanVictims(std::unique_lock<std::mutex> &lock);
+
+  /**
+   * @brief Body of the prefetcher thread.
+   */
+  void PrefetchLoop();
+
+  /**
+   * @brief Read a batch of queued pages that are not in the buffer pool yet, and queue the next page of their chains.
+   * The frames of the whole batch are claimed first and their reads are put in flight together through
+   * DiskManager::ReadPageAsync().
+   * @param requests the pages to read
+   */
+  void Prefetch(const std::vector<PrefetchRequest> &requests);
+
+  /**
+   * @brief Stop the prefetcher and wait for it to exit. Pending requests are dropped.
+   */
+  void StopPrefetcher();
 
   /**
    * @brief Allocate a page on disk. Caller should acquire the latch before calling this function.
+   * The disk manager hands out the page ids of this instance, reusing deallocated pages first.
+   * @param near_page_id if valid, prefer a page id after this one
    * @return the id of the allocated page
    */
-  auto AllocatePage() -> page_id_t;
+  auto AllocatePage(page_id_t near_page_id = INVALID_PAGE_ID) -> page_id_t;
+
+  /**
+   * @brief Validate that the page_id being used is accessible to this BPI. This can be used to ensure that the
+   * page_ids being allocated or handed in belong to this instance.
+   * @param page_id page id to validate
+   */
+  void ValidatePageId(page_id_t page_id) const;
 
   /**
    * @brief Deallocate a page on disk. Caller should acquire the latch before calling this function.
    * @param page_id id of the page to deallocate
    */
-  void DeallocatePage(__attribute__((unused)) page_id_t page_id) {
-    // This is a no-nop right now without a more complex data structure to track deallocated pages
-  }
+  void DeallocatePage(page_id_t page_id) { disk_manager_->DeallocatePage(page_id); }
 
   // TODO(student): You may add additional private members and helper functions
 };
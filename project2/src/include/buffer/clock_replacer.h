@@ -12,17 +12,25 @@
 
 #pragma once
 
-#include <list>
+#include <atomic>
+#include <cstdint>
 #include <mutex>  // NOLINT
 #include <vector>
 
 #include "buffer/replacer.h"
 #include "common/config.h"
+#include "common/macros.h"
 
 namespace bustub {
 
 /**
  * ClockReplacer implements the clock replacement policy, which approximates the Least Recently Used policy.
+ *
+ * Every frame has an atomic reference bit and an atomic state. RecordAccess on a tracked frame is a single relaxed
+ * store of the reference bit and SetEvictable is a compare-and-swap of the state, so neither takes a latch. Only
+ * Evict serializes on latch_, which protects the clock hand: it sweeps the frames, clearing set reference bits and
+ * evicting the first evictable frame whose bit is already clear. Scan accesses leave the reference bit alone, so a
+ * frame only ever touched by scans is evicted the first time the hand reaches it.
  */
 class ClockReplacer : public Replacer {
  public:
@@ -32,21 +40,45 @@ class ClockReplacer : public Replacer {
    */
   explicit ClockReplacer(size_t num_pages);
 
+  DISALLOW_COPY_AND_MOVE(ClockReplacer);
+
   /**
    * Destroys the ClockReplacer.
    */
   ~ClockReplacer() override;
 
-  auto Victim(frame_id_t *frame_id) -> bool override;
+  auto Evict(frame_id_t *frame_id) -> bool override;
+
+  void RecordAccess(frame_id_t frame_id, AccessType access_type = AccessType::Unknown) override;
 
-  void Pin(frame_id_t frame_id) override;
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
 
-  void Unpin(frame_id_t frame_id) override;
+  void Remove(frame_id_t frame_id) override;
 
   auto Size() -> size_t override;
 
+  /**
+   * List up to max_victims evictable frames in the order the clock hand would reach them, frames whose reference bit
+   * is clear first. Neither the hand nor the reference bits are touched.
+   */
+  void PeekVictims(size_t max_victims, std::vector<frame_id_t> *victims) override;
+
  private:
-  // TODO(student): implement me!
+  enum FrameState : uint8_t { UNTRACKED = 0, PINNED, EVICTABLE };
+
+  /** Throw if the frame id is out of range. */
+  void CheckFrameId(frame_id_t frame_id) const;
+
+  size_t num_frames_;
+  /** Number of evictable frames. */
+  std::atomic<size_t> curr_size_{0};
+  /** Reference bit of every frame, set on access and cleared by the clock hand. */
+  std::vector<std::atomic<bool>> ref_bits_;
+  /** FrameState of every frame. */
+  std::vector<std::atomic<uint8_t>> states_;
+  /** Protects clock_hand_. */
+  std::mutex latch_;
+  size_t clock_hand_{0};
 };
 
 }  // namespace bustub
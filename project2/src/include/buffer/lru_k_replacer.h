@@ -13,14 +13,11 @@
 #pragma once
 
 #include <cstddef>
-#include <ctime>
-#include <deque>
 #include <limits>
-#include <list>
-#include <memory>
 #include <mutex>  // NOLINT
-#include <unordered_map>
 #include <vector>
+
+#include "buffer/replacer.h"
 #include "common/config.h"
 #include "common/macros.h"
 
@@ -36,26 +33,18 @@ namespace bustub {
  * A frame with less than k historical references is given
  * +inf as its backward k-distance. When multiple frames have +inf backward
  * k-distance, classical LRU algorithm is used to choose victim.
+ *
+ * The replacer keeps one entry per frame in a frame-indexed array, the last k
+ * access timestamps of every frame in a flat ring buffer, and the evictable
+ * frames in an intrusive binary min-heap ordered by (has k accesses, timestamp
+ * of the oldest remembered access). RecordAccess, SetEvictable, Evict and
+ * Remove are O(log n) and never allocate.
+ *
+ * Frames that have only been accessed by sequential scans sit at the cold end
+ * of the heap, ahead of the +inf frames, and are evicted in FIFO order among
+ * themselves. Their first non-scan access starts a fresh access history.
  */
-struct Node {
-  frame_id_t frame_id_;
-  size_t access_count_;
-  bool evitable_;
-  size_t k_;
-  std::list<std::shared_ptr<Node>>::iterator iter_;
-  std::list<std::time_t> timestamp_list_;
-  Node() = delete;
-  explicit Node(size_t k) : frame_id_(0), access_count_(0), evitable_(true), k_(k) {}
-  void UpdateAccess(time_t current_timestamp_) {
-    access_count_++;
-    timestamp_list_.push_front(current_timestamp_);
-    if (timestamp_list_.size() > k_) {
-      timestamp_list_.pop_back();
-    }
-  }
-};
-
-class LRUKReplacer {
+class LRUKReplacer : public Replacer {
  public:
   /**
    *
@@ -74,7 +63,7 @@ class LRUKReplacer {
    *
    * @brief Destroys the LRUReplacer.
    */
-  ~LRUKReplacer() = default;
+  ~LRUKReplacer() override = default;
 
   /**
    * TODO(P1): Add implementation
@@ -94,7 +83,7 @@ class LRUKReplacer {
    * @return true if a frame is evicted successfully, false if no frames can be
    * evicted.
    */
-  auto Evict(frame_id_t *frame_id) -> bool;
+  auto Evict(frame_id_t *frame_id) -> bool override;
 
   /**
    * TODO(P1): Add implementation
@@ -107,9 +96,13 @@ class LRUKReplacer {
    * exception. You can also use BUSTUB_ASSERT to abort the process if frame id
    * is invalid.
    *
+   * A scan access only starts tracking an untracked frame, as a scan-only
+   * frame. It is ignored for frames that are already tracked.
+   *
    * @param frame_id id of frame that received a new access.
+   * @param access_type how the frame is accessed
    */
-  void RecordAccess(frame_id_t frame_id);
+  void RecordAccess(frame_id_t frame_id, AccessType access_type = AccessType::Unknown) override;
 
   /**
    * TODO(P1): Add implementation
@@ -130,7 +123,7 @@ class LRUKReplacer {
    * @param frame_id id of frame whose 'evictable' status will be modified
    * @param set_evictable whether the given frame is evictable or not
    */
-  void SetEvictable(frame_id_t frame_id, bool set_evictable);
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
 
   /**
    * TODO(P1): Add implementation
@@ -150,9 +143,7 @@ class LRUKReplacer {
    *
    * @param frame_id id of frame to be removed
    */
-  void Remove(frame_id_t frame_id);
-  auto DoRemove(frame_id_t frame_id, std::unordered_map<frame_id_t, std::shared_ptr<Node>> &access_,
-                std::list<std::shared_ptr<Node>> &list_) -> bool;
+  void Remove(frame_id_t frame_id) override;
 
   /**
    * TODO(P1): Add implementation
@@ -162,18 +153,74 @@ class LRUKReplacer {
    *
    * @return size_t
    */
-  auto Size() -> size_t;
+  auto Size() -> size_t override;
+
+  /**
+   * @brief List up to max_victims evictable frames in the order Evict would evict them, without evicting them.
+   * @param max_victims the maximum number of frames to list
+   * @param[out] victims the listed frames
+   */
+  void PeekVictims(size_t max_victims, std::vector<frame_id_t> *victims) override;
 
  private:
-  // TODO(student): implement me! You can replace these member variables as
-  // you like. Remove maybe_unused if you start using them.
+  /** Book-keeping of a single frame. */
+  struct FrameEntry {
+    /** Number of accesses recorded since the frame started being tracked. */
+    size_t access_count_{0};
+    /** Position of the frame in heap_, or NOT_IN_HEAP if the frame is not evictable. */
+    size_t heap_index_{NOT_IN_HEAP};
+    bool tracked_{false};
+    bool evictable_{false};
+    /** True while the frame has only been accessed by scans. */
+    bool scan_only_{false};
+  };
+
+  static constexpr size_t NOT_IN_HEAP = std::numeric_limits<size_t>::max();
+
+  /** @return timestamp of the oldest access among the last k accesses of the frame */
+  inline auto OldestTimestamp(frame_id_t frame_id) const -> size_t {
+    const auto &entry = frames_[frame_id];
+    return history_[frame_id * k_ + (entry.access_count_ < k_ ? 0 : entry.access_count_ % k_)];
+  }
+
+  /** @return true if frame a should be evicted before frame b */
+  inline auto EvictBefore(frame_id_t a, frame_id_t b) const -> bool {
+    if (frames_[a].scan_only_ != frames_[b].scan_only_) {
+      // scan-only frames go first
+      return frames_[a].scan_only_;
+    }
+    bool a_finite = frames_[a].access_count_ >= k_;
+    bool b_finite = frames_[b].access_count_ >= k_;
+    if (a_finite != b_finite) {
+      // +inf backward k-distance goes first
+      return !a_finite;
+    }
+    return OldestTimestamp(a) < OldestTimestamp(b);
+  }
+
+  void HeapPush(frame_id_t frame_id);
+  void HeapErase(frame_id_t frame_id);
+  void HeapSiftUp(size_t index);
+  void HeapSiftDown(size_t index);
+  inline void HeapPlace(size_t index, frame_id_t frame_id) {
+    heap_[index] = frame_id;
+    frames_[frame_id].heap_index_ = index;
+  }
+
+  /** Stop tracking a frame and forget its access history. */
+  void ResetFrame(frame_id_t frame_id);
+
   size_t current_timestamp_{0};
   size_t curr_size_;
   size_t replacer_size_;
   size_t k_;
   std::mutex latch_;
-  std::unordered_map<frame_id_t, std::shared_ptr<Node>> history_access_, cache_access_;
-  std::list<std::shared_ptr<Node>> history_list_, cache_list_;
+  /** Per-frame book-keeping, indexed by frame id. */
+  std::vector<FrameEntry> frames_;
+  /** The last k access timestamps of frame f live in history_[f * k, (f + 1) * k) as a ring buffer. */
+  std::vector<size_t> history_;
+  /** Binary min-heap of the evictable frames, the next victim is at the top. */
+  std::vector<frame_id_t> heap_;
 };
 
 }  // namespace bustub
@@ -0,0 +1,154 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager.h
+//
+// Identification: src/include/buffer/parallel_buffer_pool_manager.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/buffer_pool_manager_instance.h"
+#include "recovery/log_manager.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+/**
+ * ParallelBufferPoolManager shards the buffer pool across multiple BufferPoolManagerInstances. Every instance owns its
+ * own frames, page table, replacer and latch, so threads that touch pages living in different instances never contend
+ * with each other. A page always lives in the instance `page_id % num_instances`.
+ */
+class ParallelBufferPoolManager : public BufferPoolManager {
+ public:
+  /**
+   * @brief Creates a new ParallelBufferPoolManager.
+   * @param num_instances the number of individual BufferPoolManagerInstances to store
+   * @param pool_size the pool size of each BufferPoolManagerInstance
+   * @param disk_manager the disk manager
+   * @param replacer_k the lookback constant k for the LRU-K replacer of every instance
+   * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_type the replacement policy of every instance
+   */
+  ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
+                            size_t replacer_k = LRUK_REPLACER_K, LogManager *log_manager = nullptr,
+                            ReplacerType replacer_type = ReplacerType::LRU_K);
+
+  /**
+   * @brief Destroys an existing ParallelBufferPoolManager.
+   */
+  ~ParallelBufferPoolManager() override;
+
+  /** @brief Return the total size (number of frames) of all the buffer pool instances. */
+  auto GetPoolSize() -> size_t override;
+
+  /** @brief Return the number of buffer pool instances. */
+  auto GetNumInstances() const -> size_t { return instances_.size(); }
+
+  /**
+   * @brief Start the page cleaner of every instance.
+   * @param num_clean_victims how many of the next victims each instance's cleaner keeps clean
+   */
+  void RunPageCleaner(size_t num_clean_victims);
+
+  /** @brief Stop the page cleaner of every instance. */
+  void StopPageCleaner();
+
+  /** @brief Return the number of dirty victims written back in the foreground, summed over all instances. */
+  auto GetForegroundFlushCount() const -> uint64_t;
+
+  /** @brief Return the number of dirty pages written back by the page cleaners, summed over all instances. */
+  auto GetBackgroundFlushCount() const -> uint64_t;
+
+  /** @brief Return the number of pages read from disk by the prefetchers, summed over all instances. */
+  auto GetPrefetchCount() const -> uint64_t;
+
+ protected:
+  /**
+   * @brief Get the BufferPoolManagerInstance responsible for handling the given page id.
+   * @param page_id id of page
+   * @return pointer to the BufferPoolManagerInstance responsible for handling the given page id
+   */
+  auto GetBufferPoolManager(page_id_t page_id) -> BufferPoolManagerInstance *;
+
+  /**
+   * @brief Fetch the requested page from the responsible buffer pool instance.
+   * @param page_id id of page to be fetched
+   * @param access_type how the page is going to be used
+   * @return nullptr if page_id cannot be fetched, otherwise pointer to the requested page
+   */
+  auto FetchPgImp(page_id_t page_id, AccessType access_type = AccessType::Unknown) -> Page * override;
+
+  /**
+   * @brief Unpin the target page from the responsible buffer pool instance.
+   * @param page_id id of page to be unpinned
+   * @param is_dirty true if the page should be marked as dirty, false otherwise
+   * @return false if the page pin count is <= 0 before this call, true otherwise
+   */
+  auto UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool override;
+
+  /**
+   * @brief Flush the target page to disk through the responsible buffer pool instance.
+   * @param page_id id of page to be flushed, cannot be INVALID_PAGE_ID
+   * @return false if the page could not be found in the page table, true otherwise
+   */
+  auto FlushPgImp(page_id_t page_id) -> bool override;
+
+  /**
+   * @brief Create a new page in one of the buffer pool instances.
+   *
+   * Instances are tried in round robin order, starting from a rotating index, until one of them is able to allocate
+   * a page. Each call advances the starting index so that new pages are spread evenly across the instances.
+   *
+   * @param[out] page_id id of created page
+   * @return nullptr if no new pages could be created in any instance, otherwise pointer to new page
+   */
+  auto NewPgImp(page_id_t *page_id) -> Page * override;
+
+  /**
+   * @brief Create a new page, trying first the instance that owns the page id right after near_page_id.
+   * @param[out] page_id id of created page
+   * @param near_page_id id of the page the new page should follow
+   * @return nullptr if no new pages could be created in any instance, otherwise pointer to new page
+   */
+  auto NewPgNearImp(page_id_t *page_id, page_id_t near_page_id) -> Page * override;
+
+  /**
+   * @brief Delete a page from the responsible buffer pool instance.
+   * @param page_id id of page to be deleted
+   * @return false if the page exists but could not be deleted, true if the page didn't exist or deletion succeeded
+   */
+  auto DeletePgImp(page_id_t page_id) -> bool override;
+
+  /**
+   * @brief Flush all the pages of every buffer pool instance to disk.
+   */
+  void FlushAllPgsImp() override;
+
+  /**
+   * @brief Hand every page to the prefetcher of the responsible buffer pool instance. The instances hand the next page
+   * of a chain back to this buffer pool, as it may live in another instance.
+   * @param page_ids ids of the pages to read
+   * @param chain_length how many pages to follow after each of page_ids, using next_page
+   * @param next_page reads the id of the following page, may be nullptr if chain_length is 0
+   */
+  void PrefetchPgsImp(const std::vector<page_id_t> &page_ids, size_t chain_length,
+                      const next_page_fn &next_page) override;
+
+ private:
+  /** The buffer pool instances, indexed by `page_id % num_instances`. */
+  std::vector<std::unique_ptr<BufferPoolManagerInstance>> instances_;
+  /** The instance at which the next NewPgImp call starts looking for a free frame. */
+  std::atomic<size_t> next_instance_{0};
+};
+}  // namespace bustub
@@ -12,10 +12,16 @@
 
 #pragma once
 
+#include <cstddef>
+#include <vector>
+
 #include "common/config.h"
 
 namespace bustub {
 
+/** The replacement policies a BufferPoolManagerInstance can be created with. */
+enum class ReplacerType { LRU_K, CLOCK };
+
 /**
  * Replacer is an abstract class that tracks page usage.
  */
@@ -24,27 +30,69 @@ class Replacer {
   Replacer() = default;
   virtual ~Replacer() = default;
 
+  /**
+   * Evict a frame as defined by the replacement policy. Only frames that are marked as 'evictable' are candidates
+   * for eviction. A successful eviction decrements the size of the replacer and forgets the frame.
+   * @param[out] frame_id id of frame that was evicted
+   * @return true if a frame was evicted, false if no frame can be evicted
+   */
+  virtual auto Evict(frame_id_t *frame_id) -> bool = 0;
+
+  /**
+   * Record that the given frame was accessed. Start tracking the frame if it has not been seen before.
+   *
+   * A frame first tracked by an AccessType::Scan access is kept at the cold end of the replacement order, ahead of
+   * every other frame, until it gets an access of another type. Scan accesses never make a frame hotter.
+   * @param frame_id id of frame that received a new access
+   * @param access_type how the frame is accessed
+   */
+  virtual void RecordAccess(frame_id_t frame_id, AccessType access_type = AccessType::Unknown) = 0;
+
+  /**
+   * Toggle whether a tracked frame is evictable or not. Size of the replacer is the number of evictable frames.
+   * @param frame_id id of frame whose 'evictable' status will be modified
+   * @param set_evictable whether the given frame is evictable or not
+   */
+  virtual void SetEvictable(frame_id_t frame_id, bool set_evictable) = 0;
+
+  /**
+   * Stop tracking an evictable frame, no matter where the replacement policy ranks it.
+   * @param frame_id id of frame to be removed
+   */
+  virtual void Remove(frame_id_t frame_id) = 0;
+
+  /** @return the number of elements in the replacer that can be victimized */
+  virtual auto Size() -> size_t = 0;
+
+  /**
+   * List the evictable frames that Evict would pick next, best victim first, without evicting them. Used by the page
+   * cleaner to write back dirty frames before they are evicted. Policies that cannot rank their frames list none.
+   * @param max_victims the maximum number of frames to list
+   * @param[out] victims the listed frames
+   */
+  virtual void PeekVictims(size_t max_victims, std::vector<frame_id_t> *victims) { victims->clear(); }
+
   /**
    * Remove the victim frame as defined by the replacement policy.
    * @param[out] frame_id id of frame that was removed, nullptr if no victim was found
    * @return true if a victim frame was found, false otherwise
    */
-  virtual auto Victim(frame_id_t *frame_id) -> bool = 0;
+  virtual auto Victim(frame_id_t *frame_id) -> bool { return Evict(frame_id); }
 
   /**
    * Pins a frame, indicating that it should not be victimized until it is unpinned.
    * @param frame_id the id of the frame to pin
    */
-  virtual void Pin(frame_id_t frame_id) = 0;
+  virtual void Pin(frame_id_t frame_id) { SetEvictable(frame_id, false); }
 
   /**
    * Unpins a frame, indicating that it can now be victimized.
    * @param frame_id the id of the frame to unpin
    */
-  virtual void Unpin(frame_id_t frame_id) = 0;
-
-  /** @return the number of elements in the replacer that can be victimized */
-  virtual auto Size() -> size_t = 0;
+  virtual void Unpin(frame_id_t frame_id) {
+    RecordAccess(frame_id);
+    SetEvictable(frame_id, true);
+  }
 };
 
 }  // namespace bustub
@@ -12,8 +12,11 @@
 
 #pragma once
 
+#include <algorithm>
+#include <functional>
 #include <memory>
 #include <string>
+#include <thread>  // NOLINT
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -228,12 +231,30 @@ class Catalog {
     // TODO(chi): support both hash index and btree index
     auto index = std::make_unique<BPlusTreeIndex<KeyType, ValueType, KeyComparator>>(std::move(meta), bpm_);
 
-    // Populate the index with all tuples in table heap
+    // Populate the index with all tuples in table heap, sorted and loaded bottom up rather than inserted one by one.
+    // The table is read, and its keys extracted and sorted, by several threads taking its pages one at a time.
     auto *table_meta = GetTable(table_name);
-    auto *heap = table_meta->table_.get();
-    for (auto tuple = heap->Begin(txn); tuple != heap->End(); ++tuple) {
-      index->InsertEntry(tuple->KeyFromTuple(schema, key_schema, key_attrs), tuple->GetRid(), txn);
+    TablePageCursor cursor(table_meta->table_.get());
+    size_t num_threads = index_build_threads;
+    if (num_threads == 0) {
+      num_threads = std::max(std::thread::hardware_concurrency(), 1U);
     }
+    std::vector<std::function<bool(Tuple *, RID *)>> producers;
+    for (size_t i = 0; i < num_threads; i++) {
+      producers.emplace_back([&, tuples = std::vector<Tuple>(), position = size_t{0}](Tuple *key, RID *rid) mutable {
+        while (position == tuples.size()) {
+          position = 0;
+          if (!cursor.ReadNextPage(&tuples, txn)) {
+            return false;
+          }
+        }
+        *key = tuples[position].KeyFromTuple(schema, key_schema, key_attrs);
+        *rid = tuples[position].GetRid();
+        position++;
+        return true;
+      });
+    }
+    index->BulkLoad(producers, INDEX_FILL_FACTOR);
 
     // Get the next OID for the new index
     const auto index_oid = next_index_oid_.fetch_add(1);
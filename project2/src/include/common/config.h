@@ -14,6 +14,7 @@
 
 #include <atomic>
 #include <chrono>  // NOLINT
+#include <cstddef>
 #include <cstdint>
 
 namespace bustub {
@@ -27,15 +28,27 @@ extern std::atomic<bool> enable_logging;
 /** If ENABLE_LOGGING is true, the log should be flushed to disk every LOG_TIMEOUT. */
 extern std::chrono::duration<int64_t> log_timeout;
 
+/** A running buffer pool page cleaner looks for dirty victims every PAGE_CLEANER_INTERVAL milliseconds. */
+extern std::chrono::milliseconds page_cleaner_interval;
+
+/** A table scan asks the buffer pool to read ahead the next TABLE_PREFETCH_PAGES pages of the table, 0 disables it. */
+extern std::atomic<size_t> table_prefetch_pages;
+
+/** CREATE INDEX reads and sorts the table with INDEX_BUILD_THREADS threads, 0 means one per hardware thread. */
+extern std::atomic<size_t> index_build_threads;
+
 static constexpr int INVALID_PAGE_ID = -1;                                           // invalid page id
 static constexpr int INVALID_TXN_ID = -1;                                            // invalid transaction id
 static constexpr int INVALID_LSN = -1;                                               // invalid log sequence number
 static constexpr int HEADER_PAGE_ID = 0;                                             // the header page id
 static constexpr int BUSTUB_PAGE_SIZE = 4096;                                        // size of a data page in byte
 static constexpr int BUFFER_POOL_SIZE = 10;                                          // size of buffer pool
+static constexpr int BUFFER_POOL_INSTANCES = 1;                                      // number of buffer pool shards
 static constexpr int LOG_BUFFER_SIZE = ((BUFFER_POOL_SIZE + 1) * BUSTUB_PAGE_SIZE);  // size of a log buffer in byte
 static constexpr int BUCKET_SIZE = 50;                                               // size of extendible hash bucket
 static constexpr int LRUK_REPLACER_K = 10;  // lookback window for lru-k replacer
+static constexpr double INDEX_FILL_FACTOR = 0.9;  // how full CREATE INDEX packs the pages of a new B+ tree
+static constexpr size_t INDEX_SORT_RUN_BYTES = 64 << 20;  // index entries CREATE INDEX sorts in memory at a time
 
 using frame_id_t = int32_t;    // frame id type
 using page_id_t = int32_t;     // page id type
@@ -46,4 +59,11 @@ using oid_t = uint16_t;
 
 static constexpr int VARCHAR_DEFAULT_LENGTH = 128;  // default length for varchar when constructing the column
 
+/**
+ * How a page is about to be used, passed to the buffer pool as a hint for its replacement policy. Pages touched only
+ * by sequential scans are evicted before any other page, so that a scan of a big table does not push the working set
+ * of point lookups out of the buffer pool.
+ */
+enum class AccessType { Unknown = 0, Lookup, Scan, Index };
+
 }  // namespace bustub
@@ -0,0 +1,41 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// crc32c.h
+//
+// Identification: src/include/common/util/crc32c.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace bustub {
+
+/**
+ * Crc32c computes the CRC-32C (Castagnoli) checksum, the one iSCSI and ext4 use. On x86 CPUs with SSE4.2 it runs on
+ * the crc32 instruction, elsewhere on a lookup table.
+ */
+class Crc32c {
+ public:
+  /**
+   * @param data the bytes to checksum
+   * @param length number of bytes
+   * @param crc the checksum of the bytes before data, to checksum a buffer in pieces
+   * @return the checksum of the bytes so far
+   */
+  static auto Compute(const char *data, size_t length, uint32_t crc = 0) -> uint32_t;
+
+  /** Compute with the lookup table, whatever the CPU supports. */
+  static auto ComputeSoftware(const char *data, size_t length, uint32_t crc = 0) -> uint32_t;
+
+  /** @return true if Compute uses the crc32 instruction */
+  static auto IsHardwareAccelerated() -> bool;
+};
+
+}  // namespace bustub
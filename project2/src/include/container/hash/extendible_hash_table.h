@@ -17,12 +17,15 @@
 
 #pragma once
 
-#include <list>
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <mutex>  // NOLINT
+#include <shared_mutex>
 #include <utility>
 #include <vector>
 
+#include "common/rwlatch.h"
 #include "container/hash/hash_table.h"
 
 namespace bustub {
@@ -30,6 +33,13 @@ namespace bustub {
 /**
  * ExtendibleHashTable implements a hash table using the extendible hashing
  * algorithm.
+ *
+ * Concurrency: lookups, inserts and removes hold the directory latch in shared
+ * mode plus the latch of the one bucket they touch, so operations on different
+ * buckets run in parallel. Splitting a bucket whose local depth is below the
+ * global depth also happens under the shared directory latch, as it only
+ * repoints the directory slots of that bucket. The directory latch is taken
+ * exclusively only to double the directory when the global depth grows.
  * @tparam K key type
  * @tparam V value type
  */
@@ -98,8 +108,6 @@ class ExtendibleHashTable : public HashTable<K, V> {
    */
   void Insert(const K &key, const V &value) override;
 
-  void DoInsert(const K &key, const V &value);
-
   /**
    *
    * TODO(P1): Add implementation
@@ -113,13 +121,18 @@ class ExtendibleHashTable : public HashTable<K, V> {
 
   /**
    * Bucket class for each hash table bucket that the directory points to.
+   *
+   * Items live in contiguous arrays that are allocated once with the bucket: a
+   * one byte fingerprint of every key's hash, the keys and the values. Lookups
+   * walk the fingerprint array and only compare keys whose fingerprint
+   * matches, so a miss rarely touches the keys at all.
    */
   class Bucket {
    public:
     explicit Bucket(size_t size, int depth = 0);
 
     /** @brief Check if a bucket is full. */
-    inline auto IsFull() const -> bool { return list_.size() == size_; }
+    inline auto IsFull() const -> bool { return num_items_ == size_; }
 
     /** @brief Get the local depth of the bucket. */
     inline auto GetDepth() const -> int { return depth_; }
@@ -129,7 +142,24 @@ class ExtendibleHashTable : public HashTable<K, V> {
 
     inline auto GetSize() -> size_t { return size_; }
 
-    inline auto GetItems() -> std::list<std::pair<K, V>> & { return list_; }
+    /** @brief Get the number of items in the bucket. */
+    inline auto GetNumItems() const -> size_t { return num_items_; }
+
+    inline auto KeyAt(size_t index) const -> const K & { return keys_[index]; }
+
+    inline auto ValueAt(size_t index) const -> const V & { return values_[index]; }
+
+    /**
+     * @brief Remove the item at the given index, the last item takes its place.
+     * @param index The index of the item to be removed.
+     */
+    void RemoveAt(size_t index);
+
+    /** Acquire and release the bucket latch, which protects the items and the depth of the bucket. */
+    inline void WLatch() { latch_.WLock(); }
+    inline void WUnlatch() { latch_.WUnlock(); }
+    inline void RLatch() { latch_.RLock(); }
+    inline void RUnlatch() { latch_.RUnlock(); }
 
     /**
      *
@@ -169,33 +199,60 @@ class ExtendibleHashTable : public HashTable<K, V> {
    private:
     // TODO(student): You may add additional private members and helper
     // functions
+    /** @return the fingerprint of a key, taken from the high bits of its hash as the low bits pick the bucket */
+    static auto Fingerprint(const K &key) -> uint8_t;
+
+    /** @return the index of the key in the bucket, or num_items_ if it is absent */
+    auto IndexOfKey(const K &key, uint8_t fingerprint) const -> size_t;
+
     size_t size_;
     int depth_;
-    std::list<std::pair<K, V>> list_;
+    size_t num_items_{0};
+    std::vector<uint8_t> fingerprints_;
+    std::vector<K> keys_;
+    std::vector<V> values_;
+    ReaderWriterLatch latch_;
   };
 
  private:
   // TODO(student): You may add additional private members and helper functions
   // and remove the ones you don't need.
 
-  int global_depth_;    // The global depth of the directory
-  size_t bucket_size_;  // The size of a bucket
-  int num_buckets_;     // The number of buckets in the hash table
-  mutable std::mutex latch_;
-  std::vector<std::shared_ptr<Bucket>> dir_;  // The directory of the hash table
+  int global_depth_;                              // The global depth of the directory
+  size_t bucket_size_;                            // The size of a bucket
+  std::atomic<int> num_buckets_;                  // The number of buckets in the hash table
+  mutable std::shared_mutex dir_latch_;           // Shared to use the directory, exclusive to resize it
+  std::vector<std::atomic<Bucket *>> dir_;        // The directory of the hash table
+  std::mutex buckets_latch_;                      // Protects buckets_
+  std::vector<std::unique_ptr<Bucket>> buckets_;  // Owns every bucket, buckets live as long as the table
+
+  /**
+   * @brief Find the bucket the key hashes to and latch it. Retries if the bucket is split before the latch is
+   * acquired, so the returned bucket is guaranteed to own the key.
+   * @param key The key to be hashed.
+   * @param exclusive Whether to take the bucket latch in write mode.
+   * @param[out] index The directory index the key hashes to.
+   * @return The latched bucket.
+   */
+  auto LatchBucket(const K &key, bool exclusive, size_t *index) -> Bucket *;
 
-  // The following functions are completely optional, you can delete them if you
-  // have your own ideas.
+  /**
+   * @brief Split a full bucket whose local depth is below the global depth into itself and a new bucket, and repoint
+   * half of its directory slots to the new bucket. Caller holds dir_latch_ in shared mode and the bucket latch in
+   * write mode.
+   * @param bucket The bucket to be split.
+   * @param index Any directory index that points to the bucket.
+   */
+  void SplitBucket(Bucket *bucket, size_t index);
 
   /**
-   * @brief Redistribute the kv pairs in a full bucket.
-   * @param bucket The bucket to be redistributed.
+   * @brief Double the directory and increment the global depth. Caller holds dir_latch_ in exclusive mode.
    */
-  auto RedistributeBucket(std::shared_ptr<Bucket> bucket) -> void;
+  void GrowDirectory();
 
-  /*****************************************************************
-   * Must acquire latch_ first before calling the below functions. *
-   *****************************************************************/
+  /*********************************************************************
+   * Must acquire dir_latch_ first before calling the below functions. *
+   *********************************************************************/
 
   /**
    * @brief For the given key, return the entry index in the directory where the
@@ -0,0 +1,120 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table.h
+//
+// Identification: src/include/container/hash/page_table.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+#include "container/hash/hash_table.h"
+
+namespace bustub {
+
+/**
+ * PageTable maps page ids to frame ids for a buffer pool of fixed size.
+ *
+ * All slots are allocated up front in cache-line-aligned groups and collisions are resolved with linear probing, so a
+ * lookup touches one or two cache lines and never follows a pointer. Removal shifts the following entries of the probe
+ * sequence backwards instead of leaving tombstones, which keeps probe sequences short under constant churn.
+ *
+ * Writers serialize on a mutex. Readers take no lock: Find is guarded by a sequence counter (seqlock) that every
+ * writer bumps before and after modifying the slots, and retries if a write overlapped the lookup.
+ */
+class PageTable : public HashTable<page_id_t, frame_id_t> {
+ public:
+  /**
+   * @brief Create a new PageTable.
+   * @param max_entries the maximum number of mappings the table will ever hold at the same time
+   */
+  explicit PageTable(size_t max_entries);
+
+  DISALLOW_COPY_AND_MOVE(PageTable);
+
+  ~PageTable() override = default;
+
+  /**
+   * @brief Find the frame that holds the given page.
+   * @param page_id the page to look up
+   * @param[out] frame_id the frame holding the page
+   * @return true if the page is in the table, false otherwise
+   */
+  auto Find(const page_id_t &page_id, frame_id_t &frame_id) -> bool override;
+
+  /**
+   * @brief Remove the mapping of the given page.
+   * @param page_id the page to remove
+   * @return true if the page was in the table, false otherwise
+   */
+  auto Remove(const page_id_t &page_id) -> bool override;
+
+  /**
+   * @brief Insert or overwrite the mapping of the given page.
+   *
+   * Throws an OUT_OF_RANGE exception if the table already holds max_entries mappings.
+   *
+   * @param page_id the page to insert, cannot be INVALID_PAGE_ID
+   * @param frame_id the frame holding the page
+   */
+  void Insert(const page_id_t &page_id, const frame_id_t &frame_id) override;
+
+  /** @return the number of mappings in the table */
+  auto Size() const -> size_t { return num_entries_.load(std::memory_order_relaxed); }
+
+  /** @return the number of slots of the table */
+  auto GetCapacity() const -> size_t { return capacity_; }
+
+ private:
+  static constexpr size_t CACHE_LINE_SIZE = 64;
+
+  struct Slot {
+    std::atomic<page_id_t> page_id_{INVALID_PAGE_ID};
+    std::atomic<frame_id_t> frame_id_{-1};
+  };
+
+  static constexpr size_t SLOTS_PER_GROUP = CACHE_LINE_SIZE / sizeof(Slot);
+
+  /** A cache line worth of slots. */
+  struct alignas(CACHE_LINE_SIZE) SlotGroup {
+    Slot slots_[SLOTS_PER_GROUP];
+  };
+
+  /** @return the slot at the given index */
+  auto GetSlot(size_t index) -> Slot & { return groups_[index / SLOTS_PER_GROUP].slots_[index % SLOTS_PER_GROUP]; }
+
+  /** @return the index of the first slot probed for the given page */
+  auto HomeIndex(page_id_t page_id) const -> size_t;
+
+  /** @return the index of the slot holding the given page, or capacity_ if it is absent. Caller holds write_latch_. */
+  auto FindIndex(page_id_t page_id) -> size_t;
+
+  /** Begin and end a modification of the slots, see Find for the matching reader protocol. */
+  void BeginWrite();
+  void EndWrite();
+
+  const size_t max_entries_;
+  /** Number of slots, a power of two. */
+  size_t capacity_;
+  /** log2(capacity_) */
+  size_t capacity_bits_;
+  std::vector<SlotGroup> groups_;
+  std::atomic<size_t> num_entries_{0};
+  /** Odd while a writer is modifying the slots. Lives on its own cache line as every reader polls it. */
+  alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> sequence_{0};
+  /** Serializes writers. */
+  alignas(CACHE_LINE_SIZE) std::mutex write_latch_;
+};
+
+}  // namespace bustub
@@ -13,9 +13,11 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
 #include <condition_variable>  // NOLINT
 #include <future>              // NOLINT
 #include <mutex>               // NOLINT
+#include <thread>              // NOLINT
 
 #include "recovery/log_record.h"
 #include "storage/disk/disk_manager.h"
@@ -25,20 +27,29 @@ namespace bustub {
 /**
  * LogManager maintains a separate thread that is awakened whenever the log buffer is full or whenever a timeout
  * happens. When the thread is awakened, the log buffer's content is written into the disk log file.
+ *
+ * Commits are grouped: a committing transaction appends its COMMIT record and waits in WaitForFlush until
+ * persistent_lsn_ reaches it. The flush thread swaps the buffers and writes everything appended so far with one write
+ * and one sync, while the records of the next group are appended into the other buffer.
+ *
+ * Appending does not take latch_. An appender reserves the next lsn and the space for its record in the active buffer
+ * with a single compare-and-swap on reserve_state_, then copies the record in parallel with the other appenders. The
+ * flush thread seals the active buffer by switching reserve_state_ to the other buffer, and before writing the sealed
+ * one it waits for the copies still in flight into it, counted by copied_bytes_.
  */
 class LogManager {
  public:
-  explicit LogManager(DiskManager *disk_manager)
-      : next_lsn_(0), persistent_lsn_(INVALID_LSN), disk_manager_(disk_manager) {
-    log_buffer_ = new char[LOG_BUFFER_SIZE];
-    flush_buffer_ = new char[LOG_BUFFER_SIZE];
+  explicit LogManager(DiskManager *disk_manager) : persistent_lsn_(INVALID_LSN), disk_manager_(disk_manager) {
+    for (auto &log_buffer : log_buffers_) {
+      log_buffer = new char[LOG_BUFFER_SIZE];
+    }
   }
 
   ~LogManager() {
-    delete[] log_buffer_;
-    delete[] flush_buffer_;
-    log_buffer_ = nullptr;
-    flush_buffer_ = nullptr;
+    for (auto &log_buffer : log_buffers_) {
+      delete[] log_buffer;
+      log_buffer = nullptr;
+    }
   }
 
   void RunFlushThread();
@@ -46,29 +57,73 @@ class LogManager {
 
   auto AppendLogRecord(LogRecord *log_record) -> lsn_t;
 
-  inline auto GetNextLSN() -> lsn_t { return next_lsn_; }
+  /**
+   * Block until the log records up to and including lsn are on disk. Without a flush thread, the caller flushes the
+   * log buffer itself.
+   * @param lsn the log sequence number that must be persistent
+   */
+  void WaitForFlush(lsn_t lsn);
+
+  inline auto GetNextLSN() -> lsn_t { return StateLSN(reserve_state_); }
   inline auto GetPersistentLSN() -> lsn_t { return persistent_lsn_; }
   inline void SetPersistentLSN(lsn_t lsn) { persistent_lsn_ = lsn; }
-  inline auto GetLogBuffer() -> char * { return log_buffer_; }
+  inline auto GetLogBuffer() -> char * { return log_buffers_[StateBuffer(reserve_state_)]; }
 
  private:
-  // TODO(students): you may add your own member variables
+  /**
+   * reserve_state_ packs the next lsn (high 32 bits), the index of the active buffer (bit 31) and the number of bytes
+   * reserved in the active buffer (low 31 bits), so that one compare-and-swap reserves both the lsn and the space.
+   */
+  static auto StateLSN(uint64_t state) -> lsn_t { return static_cast<lsn_t>(state >> 32); }
+  static auto StateBuffer(uint64_t state) -> int { return static_cast<int>((state >> 31) & 1); }
+  static auto StateOffset(uint64_t state) -> int { return static_cast<int>(state & OFFSET_MASK); }
+  static auto MakeState(lsn_t lsn, int buffer, int offset) -> uint64_t {
+    return static_cast<uint64_t>(lsn) << 32 | static_cast<uint64_t>(buffer) << 31 | static_cast<uint64_t>(offset);
+  }
+
+  /** Copy the record into the log buffer at data, the lsn of the record must be set. */
+  static void SerializeLogRecord(LogRecord *log_record, char *data);
+
+  /**
+   * Seal the active log buffer, write it to disk and advance persistent_lsn_. Caller should hold latch_ through lock,
+   * which is released during the write.
+   */
+  void FlushLogBuffer(std::unique_lock<std::mutex> *lock);
 
-  /** The atomic counter which records the next log sequence number. */
-  std::atomic<lsn_t> next_lsn_;
+  /** Wait, or flush without a flush thread, until a record of the given size fits in the active buffer. */
+  void WaitForSpace(int size);
+
+  /** Body of the flush thread. */
+  void FlushLoop();
+
+  static constexpr uint64_t OFFSET_MASK = (uint64_t{1} << 31) - 1;
+
+  /** The next lsn, the active buffer and its reserved bytes, see MakeState. */
+  std::atomic<uint64_t> reserve_state_{0};
   /** The log records before and including the persistent lsn have been written to disk. */
   std::atomic<lsn_t> persistent_lsn_;
 
-  char *log_buffer_;
-  char *flush_buffer_;
-
+  /** Records are appended to the active buffer while the other one is written. */
+  char *log_buffers_[2];
+  /** Number of bytes copied into each buffer, a sealed buffer is complete once it reaches the reserved size. */
+  std::atomic<int> copied_bytes_[2]{0, 0};
+  /** The highest lsn a committer waits for, the flush thread flushes right away while it is above persistent_lsn_. */
+  lsn_t flush_lsn_{INVALID_LSN};
+  /** True while a sealed buffer is being written, the active buffer must not be sealed then. */
+  bool flushing_{false};
+  bool stop_flush_thread_{false};
+
+  /** Protects the fields above, and serializes sealing the active buffer. Appenders only take it when it is full. */
   std::mutex latch_;
 
-  std::thread *flush_thread_ __attribute__((__unused__));
+  std::thread *flush_thread_{nullptr};
 
+  /** Wakes up the flush thread. */
   std::condition_variable cv_;
+  /** Signaled after every flush, wakes up the committers and the appenders waiting for buffer space. */
+  std::condition_variable flushed_cv_;
 
-  DiskManager *disk_manager_ __attribute__((__unused__));
+  DiskManager *disk_manager_;
 };
 
 }  // namespace bustub
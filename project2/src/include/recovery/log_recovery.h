@@ -37,12 +37,19 @@ class LogRecovery {
     log_buffer_ = nullptr;
   }
 
+  /**
+   * Restore the pages a crash tore in the middle of their write, before the log is replayed on top of them. Pages are
+   * only repaired by a disk manager that keeps second copies of them, see ChecksumDiskManager.
+   * @return the number of pages repaired
+   */
+  auto RepairPages() -> size_t;
+
   void Redo();
   void Undo();
   auto DeserializeLogRecord(const char *data, LogRecord *log_record) -> bool;
 
  private:
-  DiskManager *disk_manager_ __attribute__((__unused__));
+  DiskManager *disk_manager_;
   BufferPoolManager *buffer_pool_manager_ __attribute__((__unused__));
 
   /** Maintain active transactions and its corresponding latest lsn. */
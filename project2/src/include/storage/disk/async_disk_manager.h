@@ -0,0 +1,154 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// async_disk_manager.h
+//
+// Identification: src/include/storage/disk/async_disk_manager.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <sys/uio.h>
+
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <future>  // NOLINT
+#include <mutex>   // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+#include "storage/disk/disk_manager.h"
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace bustub {
+
+/**
+ * AsyncDiskManager reads and writes the pages of the database file with positional I/O, like DiskManager, but lets any
+ * number of page reads and writes be in flight at the same time, up to the queue depth, without a thread per request.
+ *
+ * Requests are submitted to an io_uring instance and completed by a reaper thread. When io_uring is not available
+ * (an old kernel, or a sandbox that blocks it), a pool of threads runs pread/pwrite instead. ReadPage and WritePage
+ * submit a single request and wait for it. The log file is still handled by DiskManager.
+ */
+class AsyncDiskManager : public DiskManager {
+ public:
+  /** How the requests are carried out. */
+  enum class Backend { IO_URING, THREAD_POOL };
+
+  /**
+   * Creates a new asynchronous disk manager that writes to the specified database file.
+   * @param db_file the file name of the database file to write to
+   * @param queue_depth the maximum number of requests in flight, submitting more waits for a request to complete
+   * @param use_io_uring false to always use the thread pool
+   */
+  explicit AsyncDiskManager(const std::string &db_file, size_t queue_depth = 64, bool use_io_uring = true);
+
+  DISALLOW_COPY_AND_MOVE(AsyncDiskManager);
+
+  ~AsyncDiskManager() override;
+
+  /**
+   * Wait for the requests in flight, stop the backend and close all the file resources.
+   */
+  void ShutDown() override;
+
+  void WritePage(page_id_t page_id, const char *page_data) override;
+
+  void ReadPage(page_id_t page_id, char *page_data) override;
+
+  /**
+   * Submit a page write. The write may complete in any order relative to other requests in flight.
+   */
+  auto WritePageAsync(page_id_t page_id, const char *page_data) -> std::future<void> override;
+
+  /**
+   * Submit a page read. Reading past the end of the file fills the page with zeros.
+   */
+  auto ReadPageAsync(page_id_t page_id, char *page_data) -> std::future<void> override;
+
+  /** @return the backend chosen when the disk manager was created */
+  auto GetBackend() const -> Backend { return backend_; }
+
+ private:
+  /** A submitted read or write, owned by the backend until it completes. */
+  struct DiskRequest {
+    bool is_write_;
+    page_id_t page_id_;
+    /** The page buffer, io_uring reads and writes it through a one element iovec. */
+    struct iovec iov_;
+    std::promise<void> done_;
+  };
+
+  /** Hand a request over to the backend, waiting while queue_depth_ requests are in flight. */
+  auto Submit(bool is_write, page_id_t page_id, char *page_data) -> std::future<void>;
+
+  /** Finish a request whose I/O returned result (bytes transferred, or a negative errno) and free it. */
+  void Complete(DiskRequest *request, ssize_t result);
+
+  /** Create the io_uring instance and map its rings. @return false if io_uring is not available */
+  auto SetUpIoUring() -> bool;
+
+  /**
+   * Fill in a submission queue entry and submit it. Caller should hold latch_.
+   * @param request the request to carry out, nullptr for the NOP that wakes up the reaper on shutdown
+   */
+  void SubmitToIoUring(DiskRequest *request);
+
+  /** Body of the reaper thread of the io_uring backend. */
+  void ReapLoop();
+
+  /** Body of the worker threads of the thread pool backend. */
+  void WorkerLoop();
+
+  /** Unmap the rings and close the io_uring instance, whatever part of it was set up. */
+  void TearDownIoUring();
+
+  /** The thread pool backend runs at most this many workers, however deep the queue. */
+  static constexpr size_t MAX_WORKERS = 16;
+
+  const size_t queue_depth_;
+  Backend backend_;
+  bool shut_down_{false};
+
+  /** Protects inflight_, queue_, stop_ and the io_uring submission queue. */
+  std::mutex latch_;
+  /** Signaled whenever a request completes. Waited on with latch_ held. */
+  std::condition_variable inflight_cv_;
+  /** Signaled when a request is queued for the thread pool, or the workers should exit. Waited on with latch_ held. */
+  std::condition_variable queue_cv_;
+  /** Number of submitted requests that have not completed yet. */
+  size_t inflight_{0};
+  /** Set to ask the reaper or the workers to exit. */
+  bool stop_{false};
+  std::vector<std::thread> threads_;
+
+  /** Requests waiting for a worker of the thread pool backend. */
+  std::deque<DiskRequest *> queue_;
+
+  /** The io_uring instance and its mapped rings. */
+  int ring_fd_{-1};
+  void *sq_ring_{nullptr};
+  size_t sq_ring_size_{0};
+  void *cq_ring_{nullptr};
+  size_t cq_ring_size_{0};
+  io_uring_sqe *sqes_{nullptr};
+  size_t sqes_size_{0};
+  unsigned *sq_tail_{nullptr};
+  unsigned *sq_mask_{nullptr};
+  unsigned *sq_array_{nullptr};
+  unsigned *cq_head_{nullptr};
+  unsigned *cq_tail_{nullptr};
+  unsigned *cq_mask_{nullptr};
+  io_uring_cqe *cqes_{nullptr};
+};
+
+}  // namespace bustub
@@ -0,0 +1,207 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// checksum_disk_manager.h
+//
+// Identification: src/include/storage/disk/checksum_disk_manager.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <mutex>  // NOLINT
+#include <shared_mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+/**
+ * ChecksumDiskManager stores pages like DiskManager and keeps a CRC-32C checksum of every page it writes, so that a
+ * page torn by a crash in the middle of its write, or damaged on the device, is detected when it is read back.
+ *
+ * The checksums are kept in the .crc file next to the database file, and in memory. They are not stored in the page
+ * itself: the page layouts have no field in common to put it in, hash table bucket pages and the header page use their
+ * very first bytes for data. The file starts with a header telling how many pages the database file held when it got
+ * its checksums. Those pages are unchecked until they are written again, they always pass. Any other page without a
+ * checksum was never written, and passes only if it reads as zeros.
+ *
+ * The checksum entry of a page holds the checksum of the page as written, and of the version before it, and is written
+ * before the page. A page torn by a crash matches neither, while a page whose write did not start before the crash
+ * matches the version before. Writes and reads of the same page are serialized, so that a reader never sees a page and
+ * a checksum from two different writes. A page is checksummed on a private copy, the caller may be changing its buffer
+ * meanwhile.
+ *
+ * Without a double-write buffer the database file and the checksum file are only synced on ShutDown. A crash of the
+ * process never makes an intact page fail verification. After a crash of the OS, a page written since the last
+ * shutdown may reach the disk before its checksum entry and fail verification although it is whole.
+ *
+ * Detecting a torn page is not enough to get it back. With a double-write buffer, every batch of pages is first
+ * appended to the .dwb file, a circular buffer of full page images with a header page per batch, and synced, then
+ * written in place. A page torn in place still has its image in the buffer: RepairTornPages copies it back. The buffer
+ * costs one fdatasync per batch, plus one of the database file whenever it wraps around, since the pages written
+ * before are about to lose their images. Single pages written by several threads at once, e.g. victims evicted by
+ * concurrent misses, are grouped into one batch, so that they share the header page and the fdatasync.
+ */
+class ChecksumDiskManager : public DiskManager {
+ public:
+  /**
+   * Creates a new checksumming disk manager that writes to the specified database file.
+   * @param db_file the file name of the database file to write to
+   * @param double_write_pages size of the double-write buffer in pages, 0 to write pages in place only
+   */
+  explicit ChecksumDiskManager(const std::string &db_file, size_t double_write_pages = 0);
+
+  DISALLOW_COPY_AND_MOVE(ChecksumDiskManager);
+
+  ~ChecksumDiskManager() override;
+
+  /**
+   * Close all the file resources. The database file and the checksum file are synced first, the double-write buffer
+   * is emptied once the pages written through it are.
+   */
+  void ShutDown() override;
+
+  /**
+   * Write the checksum of a page, then the page to the database file. With a double-write buffer the page joins the
+   * batch of the pages other threads are writing, and the call returns once the batch is written.
+   */
+  void WritePage(page_id_t page_id, const char *page_data) override;
+
+  /**
+   * Write a batch of pages and their checksums. With a double-write buffer the images of the pages are synced to the
+   * buffer first, batches larger than the buffer are split.
+   */
+  void WritePages(const std::vector<std::pair<page_id_t, const char *>> &pages) override;
+
+  /**
+   * Restore every page that does not match its newest image in the double-write buffer, then empty the buffer. Runs at
+   * most once, before the first page is read or written if nobody called it earlier.
+   * @return the number of pages repaired, 0 without a double-write buffer
+   */
+  auto RepairTornPages() -> size_t override;
+
+  /**
+   * Read a page from the database file. A page that does not match its checksum is logged and counted, its contents
+   * are returned as they are.
+   */
+  void ReadPage(page_id_t page_id, char *page_data) override;
+
+  /**
+   * Read a page and check it against its checksum.
+   * @param page_id id of the page
+   * @param[out] page_data output buffer
+   * @return false if the page does not match its checksum
+   */
+  auto VerifyPage(page_id_t page_id, char *page_data) -> bool;
+
+  /** @return true if a checksum was written for the page, false for unchecked pages and pages never written */
+  auto HasChecksum(page_id_t page_id) -> bool;
+
+  /** @return the number of pages in the database file */
+  auto GetNumPages() -> page_id_t;
+
+  /** @return the number of pages read by ReadPage that did not match their checksum */
+  auto GetNumChecksumFailures() const -> size_t { return num_checksum_failures_; }
+
+  /** @return the number of batches synced to the double-write buffer */
+  auto GetNumDoubleWriteBatches() const -> size_t { return num_double_write_batches_; }
+
+  /** @return the checksum of a page as it is stored, never 0 */
+  static auto PageChecksum(const char *page_data) -> uint32_t;
+
+ private:
+  /** The checksum entry of a page in the .crc file, after the header. */
+  struct ChecksumEntry {
+    /** Checksum of the page as last written, 0 if it has none. */
+    uint32_t current_;
+    /** Checksum of the page before that write, the page may still hold it after a crash. */
+    uint32_t previous_;
+  };
+
+  /** @return the checksum entry of the page, all 0 if there is none */
+  auto StoredEntry(page_id_t page_id) -> ChecksumEntry;
+
+  /** Number of latches the pages are striped over. */
+  static constexpr size_t NUM_PAGE_LATCHES = 64;
+
+  /** @return the latch held while the page and its checksum are written, or read */
+  auto PageLatch(page_id_t page_id) -> std::shared_mutex & { return page_latches_[page_id % NUM_PAGE_LATCHES]; }
+
+  /** Store the checksum of a page, then write the page in place. */
+  void WriteInPlace(page_id_t page_id, const char *page_data, uint32_t checksum);
+
+  /** Copy a page, and write the copy in place with its checksum. */
+  void WriteCopyInPlace(page_id_t page_id, const char *page_data);
+
+  /** Write a page through the double-write buffer, in one batch with the pages other threads are writing meanwhile. */
+  void WriteGrouped(page_id_t page_id, const char *page_data);
+
+  /** Sync a batch of at most MaxBatchSize() pages to the double-write buffer, then write it in place. */
+  void WriteBatch(const std::pair<page_id_t, const char *> *pages, size_t num_pages);
+
+  /** @return the largest batch the double-write buffer takes at once */
+  auto MaxBatchSize() const -> size_t;
+
+  /** Make sure RepairTornPages ran before the first page I/O. */
+  void EnsureRepaired();
+
+  /** The body of RepairTornPages. */
+  auto RepairFromDoubleWriteBuffer() -> size_t;
+
+  /** Sync the database file and the checksum file. */
+  void SyncInPlace();
+
+  std::string crc_name_;
+  /** Descriptor of the .crc file. */
+  int crc_fd_{-1};
+  /** Protects checksums_. Page I/O is done without it. */
+  std::shared_mutex latch_;
+  /** Held exclusively across writing a page and its checksum, shared across reading them. */
+  std::array<std::shared_mutex, NUM_PAGE_LATCHES> page_latches_;
+  /** The checksum entry of every page. */
+  std::vector<ChecksumEntry> checksums_;
+  /** Pages below this one were written before the database file got its checksums. */
+  page_id_t num_unchecked_pages_{0};
+  std::atomic<size_t> num_checksum_failures_{0};
+  bool shut_down_{false};
+
+  std::string dwb_name_;
+  /** Descriptor of the .dwb file, -1 without a double-write buffer. */
+  int dwb_fd_{-1};
+  /** Size of the double-write buffer in pages. */
+  size_t double_write_pages_{0};
+  /** Serializes the batches, protects the double-write buffer state below. */
+  std::mutex double_write_latch_;
+  /** Slot of the double-write buffer the next batch goes to. */
+  size_t dwb_slot_{0};
+  /** Bumped whenever the buffer wraps around, only the batches of the current cycle still lack a sync in place. */
+  uint64_t dwb_cycle_{0};
+  /** Sequence number of the next batch, the newest image of a page wins. */
+  uint64_t dwb_sequence_{0};
+  /** Protects the pages waiting for a batch, and group_leader_. */
+  std::mutex group_latch_;
+  /** Notified when a group of pages is written. */
+  std::condition_variable group_cv_;
+  /** Pages written by WritePage that wait for the next group. */
+  std::vector<std::pair<page_id_t, const char *>> group_pages_;
+  /** Number of groups written, a page is written once the group it joined is. */
+  uint64_t num_groups_{0};
+  /** True while a thread writes a group, the pages written meanwhile wait for the next one. */
+  bool group_leader_{false};
+  std::once_flag repair_once_;
+  std::atomic<size_t> num_double_write_batches_{0};
+};
+
+}  // namespace bustub
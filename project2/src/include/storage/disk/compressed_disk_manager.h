@@ -0,0 +1,166 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compressed_disk_manager.h
+//
+// Identification: src/include/storage/disk/compressed_disk_manager.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <array>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <shared_mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "common/config.h"
+#include "common/macros.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/disk/page_codec.h"
+
+namespace bustub {
+
+/**
+ * CompressedDiskManager stores every page compressed, in an extent of whole slots of the database file, instead of at
+ * page_id * BUSTUB_PAGE_SIZE. The page map from page id to extent is kept in memory, and in the .pagemap file next to
+ * the database file: a snapshot of the map, followed by a journal of the changes made to it since. The snapshot is
+ * written again on ShutDown, and whenever the journal grows longer than the map.
+ *
+ * Every write of a page appends the new extent of the page to the journal before writing the extent, so the map
+ * survives a crash of the process. Before an extent that another page may have used is written, the journal is synced,
+ * so after a crash of the OS the map never points a page at an extent that another page took over since. The extent
+ * of a page also holds the checksum of what was stored in it: a page written since the last sync of the database file
+ * may read back as zeros after a crash of the OS, but never as the bytes of another page.
+ *
+ * A rewritten page stays in its extent if it still needs the same number of slots, and moves otherwise, leaving the old
+ * extent for pages of that size. Pages that do not compress by at least a slot are stored as they are. The buffer pool
+ * reads and writes whole pages as with DiskManager.
+ */
+class CompressedDiskManager : public DiskManager {
+ public:
+  /**
+   * Creates a new compressed disk manager that writes to the specified database file.
+   * @param db_file the file name of the database file to write to
+   * @param codec the codec to compress pages with, LzPageCodec by default. A database file must be opened again with
+   * the codec it was written with.
+   */
+  explicit CompressedDiskManager(const std::string &db_file, std::unique_ptr<PageCodec> codec = nullptr);
+
+  DISALLOW_COPY_AND_MOVE(CompressedDiskManager);
+
+  ~CompressedDiskManager() override;
+
+  /**
+   * Write the page map and close all the file resources.
+   */
+  void ShutDown() override;
+
+  void WritePage(page_id_t page_id, const char *page_data) override;
+
+  /**
+   * Read a page. A page that was never written reads as zeros.
+   */
+  void ReadPage(page_id_t page_id, char *page_data) override;
+
+  /** @return the number of bytes of the database file in use, including the free extents between pages */
+  auto GetStoredBytes() -> size_t;
+
+  /** @return the codec pages are compressed with */
+  auto GetCodec() const -> const PageCodec & { return *codec_; }
+
+  /** Extents are made of slots of this size. */
+  static constexpr size_t SLOT_SIZE = 256;
+
+  /** Number of latches the pages are striped over. */
+  static constexpr size_t NUM_PAGE_LATCHES = 64;
+
+ protected:
+  /** @return one past the highest page id in the page map, the database file holds no page at its offset. */
+  auto GetNumFilePages() -> page_id_t override;
+
+ private:
+  /** Where a page is stored. A page stored as is has length_ == BUSTUB_PAGE_SIZE. */
+  struct Extent {
+    uint32_t slot_;
+    uint16_t num_slots_;
+    uint16_t length_;
+    /** CRC-32C of the length_ bytes stored in the extent. */
+    uint32_t checksum_;
+  };
+
+  /** Find room for an extent of num_slots slots, reusing a free extent if possible. Caller should hold latch_. */
+  auto AllocateExtent(size_t num_slots) -> uint32_t;
+
+  /** Make an extent available for reuse, merging it with the free extents around it. Caller should hold latch_. */
+  void FreeExtent(uint32_t slot, size_t num_slots);
+
+  /**
+   * Read the page map file, replaying the journal up to its first torn record, and find the free extents between the
+   * pages. Creates the file for a new database file.
+   */
+  void LoadPageMap();
+
+  /**
+   * Write a snapshot of the page map next to the page map file, sync it and put it in its place, which empties the
+   * journal. If that fails the old file is kept, the journal still holds the changes.
+   * @return true if the snapshot was written
+   */
+  auto SavePageMap() -> bool;
+
+  /** Append a change of the page map to the journal. Caller should hold latch_. */
+  void AppendToJournal(page_id_t page_id, const Extent &extent);
+
+  /** Sync the journal, if the first num_records records appended to it are not synced yet. */
+  void SyncJournal(uint64_t num_records);
+
+  /** @return the latch held while a page is written to its extent, or read from it */
+  auto PageLatch(page_id_t page_id) -> std::shared_mutex & { return page_latches_[page_id % NUM_PAGE_LATCHES]; }
+
+  std::unique_ptr<PageCodec> codec_;
+  std::string map_name_;
+  bool shut_down_{false};
+
+  /** Taken before latch_ by whoever syncs the journal or replaces the page map file. */
+  std::mutex journal_latch_;
+  /** Descriptor of the page map file, guarded by journal_latch_ and latch_ to be replaced. */
+  int map_fd_{-1};
+  /** Where the next journal record goes. Guarded by latch_. */
+  off_t journal_end_{0};
+  /** Records in the journal of the page map file. Guarded by latch_. */
+  uint64_t num_journal_records_{0};
+  /** Records ever appended to the journal. Guarded by latch_. */
+  uint64_t num_records_{0};
+  /** Records known to be synced, they are all in the snapshot after SavePageMap. Guarded by journal_latch_. */
+  uint64_t num_synced_records_{0};
+  /**
+   * No page known to the page map file was stored at or past this slot, an extent there is written without syncing
+   * the journal first. Guarded by latch_.
+   */
+  uint32_t fresh_slot_{0};
+
+  /** Protects page_map_, the free extents and next_slot_. Page I/O is done without it. */
+  std::shared_mutex latch_;
+  /**
+   * Held exclusively from choosing the extent of a page to the end of its write, shared from looking the extent up to
+   * the end of the read. An extent is only freed by a writer of its page, so nobody else writes it meanwhile.
+   */
+  std::array<std::shared_mutex, NUM_PAGE_LATCHES> page_latches_;
+  std::unordered_map<page_id_t, Extent> page_map_;
+  /** Free extents by first slot, to merge neighbours, mapped to their number of slots. */
+  std::map<uint32_t, size_t> free_by_slot_;
+  /** Free extents by (number of slots, first slot), to find the smallest one that fits. */
+  std::set<std::pair<size_t, uint32_t>> free_by_size_;
+  /** The first slot past the end of the file in use. */
+  uint32_t next_slot_{0};
+};
+
+}  // namespace bustub
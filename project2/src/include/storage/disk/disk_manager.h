@@ -13,36 +13,50 @@
 #pragma once
 
 #include <atomic>
-#include <fstream>
 #include <future>  // NOLINT
-#include <mutex>   // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "common/config.h"
+#include "storage/disk/free_space_map.h"
 
 namespace bustub {
 
 /**
  * DiskManager takes care of the allocation and deallocation of pages within a database. It performs the reading and
  * writing of pages to and from disk, providing a logical file layer within the context of a database management system.
+ *
+ * Pages are read and written with pread/pwrite on a file descriptor. Positional I/O shares no seek pointer, so any
+ * number of threads can read and write pages at the same time without a latch.
+ *
+ * Page ids are handed out by a FreeSpaceMap, so that deallocated pages are reused. The map can be stored in the .fsm
+ * file next to the database file, then the free pages and the next page id survive restarts.
  */
 class DiskManager {
  public:
   /**
    * Creates a new disk manager that writes to the specified database file.
    * @param db_file the file name of the database file to write to
+   * @param direct_io open the database file with O_DIRECT, bypassing the OS page cache so that the buffer pool is the
+   * only cache of the pages. Falls back to buffered I/O if the file system does not support it.
+   * @param persistent_free_space_map keep the free space map in the .fsm file next to the database file, so that the
+   * pages deallocated before a restart are reused after it. Otherwise the map lives in memory, and every page of an
+   * existing database file counts as allocated.
    */
-  explicit DiskManager(const std::string &db_file);
+  explicit DiskManager(const std::string &db_file, bool direct_io = false, bool persistent_free_space_map = false);
 
   /** FOR TEST / LEADERBOARD ONLY, used by DiskManagerMemory */
   DiskManager() = default;
 
-  virtual ~DiskManager() = default;
+  virtual ~DiskManager();
 
   /**
    * Shut down the disk manager and close all the file resources.
    */
-  void ShutDown();
+  virtual void ShutDown();
 
   /**
    * Write a page to the database file.
@@ -58,6 +72,54 @@ class DiskManager {
    */
   virtual void ReadPage(page_id_t page_id, char *page_data);
 
+  /**
+   * Start writing a page to the database file. The default implementation writes the page before returning.
+   * @param page_id id of the page
+   * @param page_data raw page data, must stay untouched until the write is done
+   * @return a future that becomes ready once the write is done
+   */
+  virtual auto WritePageAsync(page_id_t page_id, const char *page_data) -> std::future<void>;
+
+  /**
+   * Start reading a page from the database file. The default implementation reads the page before returning.
+   * @param page_id id of the page
+   * @param[out] page_data output buffer, filled in once the read is done
+   * @return a future that becomes ready once the read is done
+   */
+  virtual auto ReadPageAsync(page_id_t page_id, char *page_data) -> std::future<void>;
+
+  /**
+   * Write a batch of pages to the database file. The default implementation writes them one by one, disk managers
+   * that make page writes crash safe pay for that once per batch instead of once per page.
+   * @param pages the id and the raw data of every page in the batch
+   */
+  virtual void WritePages(const std::vector<std::pair<page_id_t, const char *>> &pages);
+
+  /**
+   * Repair the pages a crash left torn in the middle of their write. Only disk managers that keep a second copy of the
+   * pages they write can do it, the default implementation repairs nothing.
+   * @return the number of pages repaired
+   */
+  virtual auto RepairTornPages() -> size_t { return 0; }
+
+  /**
+   * Allocate a page id, reusing a deallocated page if there is one.
+   * @param near_page_id if valid, prefer the lowest free page after this one, e.g. the last page of a table
+   * @param stride together with offset, the page ids that may be allocated, see FreeSpaceMap::Allocate
+   * @param offset the remainder modulo stride of the page ids that may be allocated
+   * @return the id of the allocated page
+   */
+  auto AllocatePage(page_id_t near_page_id = INVALID_PAGE_ID, uint32_t stride = 1, uint32_t offset = 0) -> page_id_t;
+
+  /**
+   * Deallocate a page id, it may be handed out again by AllocatePage.
+   * @param page_id id of the page to deallocate
+   */
+  void DeallocatePage(page_id_t page_id);
+
+  /** @return the map of the allocated page ids */
+  auto GetFreeSpaceMap() -> FreeSpaceMap * { return free_space_map_.get(); }
+
   /**
    * Flush the entire log buffer into disk.
    * @param log_data raw log data
@@ -83,6 +145,9 @@ class DiskManager {
   /** @return the number of disk writes */
   auto GetNumWrites() const -> int;
 
+  /** @return true if the database file is read and written with O_DIRECT */
+  auto IsDirectIo() const -> bool { return direct_io_; }
+
   /**
    * Sets the future which is used to check for non-blocking flushes.
    * @param f the non-blocking flush check
@@ -93,19 +158,35 @@ class DiskManager {
   inline auto HasFlushLogFuture() -> bool { return flush_log_f_ != nullptr; }
 
  protected:
+  /**
+   * Open the free space map, seeded with GetNumFilePages(). Subclasses that store pages elsewhere than at
+   * page_id * BUSTUB_PAGE_SIZE open it again once GetNumFilePages() can tell.
+   */
+  void OpenFreeSpaceMap();
+
+  /**
+   * @return the number of pages the database file holds, pages past the next page id of the free space map count as
+   * allocated. The default implementation assumes page i is stored at i * BUSTUB_PAGE_SIZE.
+   */
+  virtual auto GetNumFilePages() -> page_id_t;
+
   auto GetFileSize(const std::string &file_name) -> int;
-  // stream to write log file
-  std::fstream log_io_;
+  // descriptor of the log file, opened with O_APPEND
+  int log_fd_{-1};
   std::string log_name_;
-  // stream to write db file
-  std::fstream db_io_;
+  // descriptor of the db file, pages are read and written at their offset with pread/pwrite
+  int db_fd_{-1};
+  // true if db_fd_ was opened with O_DIRECT, page I/O then needs page-aligned buffers
+  bool direct_io_{false};
+  // true if the free space map is kept in the .fsm file
+  bool persistent_free_space_map_{false};
   std::string file_name_;
-  int num_flushes_{0};
-  int num_writes_{0};
+  // the allocated page ids, kept in memory only for the in-memory disk managers
+  std::unique_ptr<FreeSpaceMap> free_space_map_{std::make_unique<FreeSpaceMap>()};
+  std::atomic<int> num_flushes_{0};
+  std::atomic<int> num_writes_{0};
   bool flush_log_{false};
   std::future<void> *flush_log_f_{nullptr};
-  // With multiple buffer pool instances, need to protect file access
-  std::mutex db_io_latch_;
 };
 
 }  // namespace bustub
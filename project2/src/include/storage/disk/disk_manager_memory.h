@@ -10,9 +10,12 @@
 //
 //===----------------------------------------------------------------------===//
 #include <array>
+#include <atomic>
+#include <chrono>  // NOLINT
 #include <cstring>
 #include <fstream>
 #include <future>  // NOLINT
+#include <limits>
 #include <memory>
 #include <mutex>  // NOLINT
 #include <optional>
@@ -24,6 +27,7 @@
 #include "common/config.h"
 #include "common/exception.h"
 #include "common/logger.h"
+#include "common/macros.h"
 #include "storage/disk/disk_manager.h"
 
 namespace bustub {
@@ -57,60 +61,72 @@ class DiskManagerMemory : public DiskManager {
 };
 
 /**
- * DiskManagerMemory replicates the utility of DiskManager on memory. It is primarily used for
- * data structure performance testing.
+ * DiskManagerUnlimitedMemory keeps every page that is written in memory, however many there are. It is what
+ * BustubInstance runs on by default and what the in-memory benchmarks use, so it must not become their bottleneck.
+ *
+ * Pages are found through a two level page directory: a fixed array of chunk pointers, each chunk holding the
+ * pointers to PAGES_PER_CHUNK pages. Chunks and pages are created on their first write and published with a
+ * compare-and-swap, then never move, so reading and rewriting a page that exists takes no latch but the page's own.
+ * The directory can be reserved up front so that the first writes do not create chunks.
+ *
+ * Reads and writes can be given an artificial latency, to simulate a device for features that overlap I/O.
  */
 class DiskManagerUnlimitedMemory : public DiskManager {
  public:
-  DiskManagerUnlimitedMemory() = default;
+  /**
+   * Creates an empty in-memory disk manager.
+   * @param reserve_pages number of pages to create the page directory chunks for right away
+   */
+  explicit DiskManagerUnlimitedMemory(size_t reserve_pages = 0);
+
+  DISALLOW_COPY_AND_MOVE(DiskManagerUnlimitedMemory);
+
+  ~DiskManagerUnlimitedMemory() override;
 
   /**
    * Write a page to the database file.
    * @param page_id id of the page
    * @param page_data raw page data
    */
-  void WritePage(page_id_t page_id, const char *page_data) override {
-    std::unique_lock<std::mutex> l(mutex_);
-    if (page_id >= static_cast<int>(data_.size())) {
-      data_.resize(page_id + 1);
-    }
-    if (data_[page_id] == nullptr) {
-      data_[page_id] = std::make_shared<ProtectedPage>();
-    }
-    std::shared_ptr<ProtectedPage> ptr = data_[page_id];
-    std::unique_lock<std::shared_mutex> l_page(ptr->second);
-    l.unlock();
-
-    memcpy(ptr->first.data(), page_data, BUSTUB_PAGE_SIZE);
-  }
+  void WritePage(page_id_t page_id, const char *page_data) override;
 
   /**
    * Read a page from the database file.
    * @param page_id id of the page
    * @param[out] page_data output buffer
    */
-  void ReadPage(page_id_t page_id, char *page_data) override {
-    std::unique_lock<std::mutex> l(mutex_);
-    if (page_id >= static_cast<int>(data_.size()) || page_id < 0) {
-      LOG_WARN("page not exist");
-      return;
-    }
-    if (data_[page_id] == nullptr) {
-      LOG_WARN("page not exist");
-      return;
-    }
-    std::shared_ptr<ProtectedPage> ptr = data_[page_id];
-    std::shared_lock<std::shared_mutex> l_page(ptr->second);
-    l.unlock();
-
-    memcpy(page_data, ptr->first.data(), BUSTUB_PAGE_SIZE);
-  }
+  void ReadPage(page_id_t page_id, char *page_data) override;
+
+  /**
+   * Make every page read and write take at least the given time, like a device would. May be changed at any time.
+   * @param read_latency latency of a read, zero for none
+   * @param write_latency latency of a write, zero for none
+   */
+  void SetLatency(std::chrono::microseconds read_latency, std::chrono::microseconds write_latency);
 
  private:
-  std::mutex mutex_;
-  using Page = std::array<char, BUSTUB_PAGE_SIZE>;
-  using ProtectedPage = std::pair<Page, std::shared_mutex>;
-  std::vector<std::shared_ptr<ProtectedPage>> data_;
+  /** Pages in a chunk of the page directory. */
+  static constexpr size_t PAGES_PER_CHUNK = 1 << 16;
+  /** Chunks needed to hold every non-negative page id. */
+  static constexpr size_t MAX_CHUNKS =
+      (static_cast<size_t>(std::numeric_limits<page_id_t>::max()) + PAGES_PER_CHUNK) / PAGES_PER_CHUNK;
+
+  struct ProtectedPage {
+    std::array<char, BUSTUB_PAGE_SIZE> data_;
+    std::shared_mutex latch_;
+  };
+  using Chunk = std::array<std::atomic<ProtectedPage *>, PAGES_PER_CHUNK>;
+
+  /** @return the chunk at index, created if it does not exist and create is set, nullptr otherwise */
+  auto GetChunk(size_t index, bool create) -> Chunk *;
+
+  /** @return the page, created if it does not exist and create is set, nullptr otherwise */
+  auto GetPage(page_id_t page_id, bool create) -> ProtectedPage *;
+
+  /** The page directory, MAX_CHUNKS chunk pointers. */
+  std::unique_ptr<std::atomic<Chunk *>[]> chunks_;
+  std::atomic<int64_t> read_latency_us_{0};
+  std::atomic<int64_t> write_latency_us_{0};
 };
 
 }  // namespace bustub
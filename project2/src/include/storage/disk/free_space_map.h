@@ -0,0 +1,153 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map.h
+//
+// Identification: src/include/storage/disk/free_space_map.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * FreeSpaceMap keeps track of which page ids of a database are in use, so that deallocated pages are handed out again
+ * instead of the database file growing forever.
+ *
+ * It is a bitmap with one bit per page id, set while the page is allocated. The bitmap is stored in pages of its own,
+ * in the .fsm file next to the database file: a meta page with the next never allocated page id, followed by the
+ * bitmap pages, each covering BUSTUB_PAGE_SIZE * 8 page ids.
+ *
+ * A page is never handed out twice, even after a crash of the process or the OS: Allocate writes the bitmap page, and
+ * the disk manager calls SyncAllocations before it writes any page, so no page on disk refers to a page id that the map
+ * on disk still has free. Allocate itself does not sync, it is called with the buffer pool latch held. Deallocations
+ * are only written on Flush, so a crash can at worst leak the pages freed since then.
+ */
+class FreeSpaceMap {
+ public:
+  /** Number of page ids covered by a bitmap page. */
+  static constexpr size_t PAGES_PER_BITMAP = static_cast<size_t>(BUSTUB_PAGE_SIZE) * 8;
+
+  /**
+   * Creates a free space map that lives in memory only, every page id is free.
+   */
+  FreeSpaceMap() = default;
+
+  /**
+   * Creates a free space map that lives in memory only, for a database file that already holds some pages.
+   * @param num_file_pages number of pages in the database file, they count as allocated
+   */
+  explicit FreeSpaceMap(page_id_t num_file_pages);
+
+  /**
+   * Opens the free space map stored in the given file, creating it if it does not exist.
+   * @param file_name the file name of the free space map
+   * @param num_file_pages number of pages in the database file. The map is started over when the database file is
+   * empty, and pages of the file past the stored next page id count as allocated, they were written without one.
+   */
+  FreeSpaceMap(const std::string &file_name, page_id_t num_file_pages);
+
+  DISALLOW_COPY_AND_MOVE(FreeSpaceMap);
+
+  ~FreeSpaceMap();
+
+  /**
+   * Allocate the lowest free page id that is congruent to offset modulo stride. Parallel buffer pools give every
+   * instance the page ids with the instance index as the offset.
+   * @param near_page_id if valid, prefer the lowest free page id after this one, so that pages allocated one after the
+   * other for the same table or index stay in sequence on disk
+   * @param stride together with offset, the page ids that may be allocated
+   * @param offset the remainder modulo stride of the page ids that may be allocated
+   * @return the allocated page id
+   */
+  auto Allocate(page_id_t near_page_id = INVALID_PAGE_ID, uint32_t stride = 1, uint32_t offset = 0) -> page_id_t;
+
+  /**
+   * Make the allocations made so far durable, if they are not already. Concurrent callers share a single fdatasync, and
+   * a call with no allocation since the last sync returns right away. Does nothing for a map in memory.
+   */
+  void SyncAllocations();
+
+  /**
+   * Return a page id to the free pages. Deallocating a free page id does nothing.
+   * @param page_id id of the page to deallocate
+   */
+  void Deallocate(page_id_t page_id);
+
+  /** @return true if the page id is allocated */
+  auto IsAllocated(page_id_t page_id) -> bool;
+
+  /** @return one past the highest page id ever allocated */
+  auto GetNextPageId() -> page_id_t;
+
+  /** @return the number of free page ids below GetNextPageId() */
+  auto GetNumFreePages() -> size_t;
+
+  /**
+   * Write the bitmap pages and the meta page changed since the last flush. Does nothing for a map in memory.
+   */
+  void Flush();
+
+  /**
+   * Flush the map and close its file.
+   */
+  void Close();
+
+ private:
+  /** Number of 64 bit words in a bitmap page. */
+  static constexpr size_t WORDS_PER_BITMAP = PAGES_PER_BITMAP / 64;
+
+  auto TestBit(page_id_t page_id) const -> bool;
+
+  /** Set or clear the bit of a page id, growing the bitmap to a whole number of bitmap pages if needed. */
+  void SetBit(page_id_t page_id, bool allocated);
+
+  /** Write bitmap page index to the file. Caller should hold latch_. */
+  void WriteBitmap(size_t index);
+
+  /** Write the meta page to the file. Caller should hold latch_. */
+  void WriteMeta();
+
+  std::mutex latch_;
+  /** The bitmap, one bit per page id, set if the page is allocated. Always a whole number of bitmap pages. */
+  std::vector<uint64_t> bits_;
+  /** Bitmap pages with deallocations that are not written yet. */
+  std::vector<bool> dirty_;
+  /** One past the highest page id ever allocated. */
+  page_id_t next_page_id_{0};
+  /** True if next_page_id_ changed since the meta page was written. */
+  bool meta_dirty_{false};
+  /** Number of allocated page ids. */
+  size_t num_allocated_{0};
+  /**
+   * For every offset of cursor_stride_, no page id with that offset below the cursor is free. Keeps Allocate from
+   * scanning over the allocated pages again and again.
+   */
+  std::vector<page_id_t> cursors_;
+  uint32_t cursor_stride_{0};
+  /** Descriptor of the .fsm file, -1 for a map in memory. */
+  int fd_{-1};
+  /** Number of allocations written to the file, guarded by latch_. */
+  uint64_t num_allocations_{0};
+  /**
+   * Serializes SyncAllocations and keeps Close from closing the file under it. The fdatasync runs without latch_, so
+   * that Allocate does not wait for it. Taken before latch_.
+   */
+  std::mutex sync_latch_;
+  /** Number of allocations made durable, guarded by sync_latch_. */
+  uint64_t num_synced_allocations_{0};
+};
+
+}  // namespace bustub
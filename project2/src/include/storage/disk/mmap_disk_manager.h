@@ -0,0 +1,65 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// mmap_disk_manager.h
+//
+// Identification: src/include/storage/disk/mmap_disk_manager.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <string>
+
+#include "common/config.h"
+#include "common/macros.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+/**
+ * MmapDiskManager serves a read-only snapshot of a database file, for reporting replicas. The file is mapped once when
+ * the disk manager is created, and ReadPage copies the page out of the mapping, so reading a page that the OS already
+ * caches costs a memcpy and no system call. Pages past the end of the snapshot read as zeros, and writing a page
+ * throws.
+ *
+ * The buffer pool still gets its own copy of every page: it writes into its frames in place (NewPage resets them,
+ * table pages update their LSN and tuples), which a read-only mapping can not take.
+ */
+class MmapDiskManager : public DiskManager {
+ public:
+  /**
+   * Creates a new disk manager that maps the specified database file.
+   * @param db_file the file name of the database file to read
+   * @param populate read the whole file into the page cache up front (MAP_POPULATE), instead of on first access
+   */
+  explicit MmapDiskManager(const std::string &db_file, bool populate = false);
+
+  DISALLOW_COPY_AND_MOVE(MmapDiskManager);
+
+  ~MmapDiskManager() override;
+
+  /**
+   * Unmap the file and close all the file resources.
+   */
+  void ShutDown() override;
+
+  /**
+   * The snapshot is read-only, this always throws.
+   */
+  void WritePage(page_id_t page_id, const char *page_data) override;
+
+  void ReadPage(page_id_t page_id, char *page_data) override;
+
+  /** @return the number of whole pages in the snapshot */
+  auto GetNumPages() const -> page_id_t { return static_cast<page_id_t>(map_size_ / BUSTUB_PAGE_SIZE); }
+
+ private:
+  char *map_{nullptr};
+  size_t map_size_{0};
+};
+
+}  // namespace bustub
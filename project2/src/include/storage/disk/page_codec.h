@@ -0,0 +1,72 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_codec.h
+//
+// Identification: src/include/storage/disk/page_codec.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace bustub {
+
+/**
+ * PageCodec compresses and decompresses whole pages for CompressedDiskManager.
+ */
+class PageCodec {
+ public:
+  virtual ~PageCodec() = default;
+
+  /** @return the name the codec is created with, see CreatePageCodec */
+  virtual auto Name() const -> std::string = 0;
+
+  /**
+   * Compress src into dst.
+   * @param src the data to compress
+   * @param src_size the size of src
+   * @param[out] dst the output buffer
+   * @param dst_capacity the size of dst
+   * @return the size of the compressed data, or 0 if it does not fit in dst_capacity bytes
+   */
+  virtual auto Compress(const char *src, size_t src_size, char *dst, size_t dst_capacity) const -> size_t = 0;
+
+  /**
+   * Decompress src into dst.
+   * @param src the compressed data
+   * @param src_size the size of src
+   * @param[out] dst the output buffer
+   * @param dst_size the size of the decompressed data
+   * @return false if src is corrupt or does not decompress to exactly dst_size bytes
+   */
+  virtual auto Decompress(const char *src, size_t src_size, char *dst, size_t dst_size) const -> bool = 0;
+};
+
+/**
+ * LzPageCodec is the in-tree codec, a greedy LZ77 compressor writing the LZ4 block format: every sequence is a token
+ * with the literal and match lengths, the literals, and a two byte offset back to the match. It needs no dictionary or
+ * library, and decompressing is a loop of copies, which is what reading pages cares about.
+ */
+class LzPageCodec : public PageCodec {
+ public:
+  auto Name() const -> std::string override { return "lz"; }
+
+  auto Compress(const char *src, size_t src_size, char *dst, size_t dst_capacity) const -> size_t override;
+
+  auto Decompress(const char *src, size_t src_size, char *dst, size_t dst_size) const -> bool override;
+};
+
+/**
+ * Create a codec by name: "lz" for LzPageCodec, or "zlib" when BusTub is built with zlib.
+ * @return the codec, or nullptr if it is not available
+ */
+auto CreatePageCodec(const std::string &name) -> std::unique_ptr<PageCodec>;
+
+}  // namespace bustub
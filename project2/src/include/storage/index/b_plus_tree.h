@@ -10,10 +10,15 @@
 //===----------------------------------------------------------------------===//
 #pragma once
 
+#include <atomic>
+#include <fstream>
+#include <functional>
+#include <mutex>  // NOLINT
 #include <queue>
 #include <string>
 #include <vector>
 
+#include "common/rwlatch.h"
 #include "concurrency/transaction.h"
 #include "storage/index/index_iterator.h"
 #include "storage/page/b_plus_tree_internal_page.h"
@@ -32,15 +37,30 @@ namespace bustub {
  * (2) support insert & remove
  * (3) The structure should shrink and grow dynamically
  * (4) Implement index iterator for range scan
+ *
+ * Concurrency: writers descend optimistically, read latching the internal pages down to the leaf, which they write
+ * latch, since most inserts and removals change the leaf only. If the leaf would split or underflow, they start over
+ * with latch crabbing: write latches from the root down, kept in Transaction::GetPageSet() for as long as the pages
+ * below them may split or merge. root_latch_ protects root_page_id_, it sits in the page set as nullptr.
+ *
+ * With optimistic reads, GetValue and the iterators take no latch at all (optimistic lock coupling): they read the
+ * version of every page before and after reading from it, see Page::GetVersion(), and start over from the root when a
+ * writer got in between. Every write latch bumps the version, so the writers do not change. After
+ * MAX_OPTIMISTIC_RESTARTS conflicts in a row, a lookup falls back to read latches.
+ *
+ * A page taken out of the tree by a merge may still be pinned by an iterator, the buffer pool does not delete it then.
+ * Such pages are kept in deferred_page_ids_ and deleted by a later removal, once the iterator let go of them.
  */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTree {
+  friend class IndexIterator<KeyType, ValueType, KeyComparator>;
   using InternalPage = BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator>;
   using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
 
  public:
   explicit BPlusTree(std::string name, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
-                     int leaf_max_size = LEAF_PAGE_SIZE, int internal_max_size = INTERNAL_PAGE_SIZE);
+                     int leaf_max_size = LEAF_PAGE_SIZE, int internal_max_size = INTERNAL_PAGE_SIZE,
+                     bool optimistic_reads = false);
 
   // Returns true if this B+ tree has no keys and values.
   auto IsEmpty() const -> bool;
@@ -54,6 +74,16 @@ class BPlusTree {
   // return the value associated with a given key
   auto GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction = nullptr) -> bool;
 
+  /**
+   * Build the tree bottom up from entries sorted by key, instead of descending from the root for every one of them.
+   * The leaves are written left to right and the internal levels above them one at a time. Of entries with equal keys,
+   * only the first one is loaded, like Insert would. Other threads must not use the tree until this returns.
+   * @param next yields the next entry, false after the last one
+   * @param fill_factor how full to pack the pages, from 0 to 1. The room left takes later inserts without splits.
+   * @return false if the tree is not empty
+   */
+  auto BulkLoad(const std::function<bool(MappingType *)> &next, double fill_factor = 1.0) -> bool;
+
   // return the page id of the root node
   auto GetRootPageId() -> page_id_t;
 
@@ -75,8 +105,119 @@ class BPlusTree {
   void RemoveFromFile(const std::string &file_name, Transaction *transaction = nullptr);
 
  private:
+  /** Optimistic lookups that conflict with writers this many times in a row take read latches instead. */
+  static constexpr int MAX_OPTIMISTIC_RESTARTS = 16;
+
+  /** What a write is going to do to the leaf, which decides when a page is safe. */
+  enum class Operation { INSERT, REMOVE };
+
   void UpdateRootPageId(int insert_record = 0);
 
+  /** Fetch a page of the tree, throwing if the buffer pool is out of frames. */
+  auto FetchTreePage(page_id_t page_id) -> Page *;
+
+  /** Allocate a page of the tree next to near_page_id, throwing if the buffer pool is out of frames. */
+  auto NewTreePage(page_id_t *page_id, page_id_t near_page_id) -> Page *;
+
+  /**
+   * Descend with read latches to the leaf that may contain key, or to the leftmost leaf.
+   * @return the leaf page, pinned and read latched, nullptr if the tree is empty
+   */
+  auto FindLeafRead(const KeyType &key, bool leftmost) -> Page *;
+
+  /**
+   * Descend without latches to the leaf that may contain key, or to the leftmost leaf, validating the version of every
+   * page read on the way.
+   * @param[out] leaf the leaf page, pinned, nullptr if the tree is empty
+   * @param[out] version the version of the leaf page when its parent was validated
+   * @return false if a writer got in the way, nothing is pinned then
+   */
+  auto FindLeafVersioned(const KeyType &key, bool leftmost, Page **leaf, uint64_t *version) -> bool;
+
+  /**
+   * Binary search the keys [begin, end) of a page read without a latch. Every key is copied out and validated against
+   * the version before it is compared, so the comparator never sees a key torn by a writer.
+   * @param upper find the first key greater than key, instead of the first key not less than it
+   * @param[out] index the position found
+   * @return false if the page changed since version was read
+   */
+  template <typename NodeType>
+  auto SearchVersioned(const Page *page, uint64_t version, const NodeType *node, int begin, int end,
+                       const KeyType &key, bool upper, int *index) const -> bool;
+
+  /** SearchVersioned in a leaf, for IndexIterator. */
+  auto SearchLeafVersioned(Page *page, uint64_t version, int size, const KeyType &key, bool upper,
+                           int *index) const -> bool;
+
+  /**
+   * Delete pages taken out of the tree, and the pages deferred by earlier calls. A page the buffer pool does not
+   * delete, because it is still pinned, e.g. by an iterator, is deferred to the next call.
+   */
+  void DeletePages(const std::vector<page_id_t> &page_ids);
+
+  /**
+   * Look the key up without latches. @return false if a writer got in the way
+   * @param[out] found the result of the lookup, if it was done
+   */
+  auto GetValueOptimistic(const KeyType &key, std::vector<ValueType> *result, bool *found) -> bool;
+
+  /**
+   * Descend with read latches on the internal pages to the leaf that may contain key.
+   * @param[out] is_root true if the leaf is the root
+   * @return the leaf page, pinned and write latched, nullptr if the tree is empty
+   */
+  auto FindLeafOptimistic(const KeyType &key, bool *is_root) -> Page *;
+
+  /**
+   * Descend with write latches to the leaf that may contain key, releasing the pages above a page that is safe for the
+   * operation. The latched pages end up in the page set of the transaction, the leaf last.
+   * @return the leaf page, nullptr if the tree is empty, with root_latch_ held
+   */
+  auto FindLeafPessimistic(const KeyType &key, Operation op, Transaction *transaction) -> Page *;
+
+  /** @return true if the operation can not split or merge the page, so the pages above it are not needed */
+  auto IsSafe(const BPlusTreePage *node, Operation op, bool is_root) const -> bool;
+  /** @return the fewest entries of a page that is not the root, see BPlusTreeInternalPage::MinSize */
+  auto GetMinSize(const BPlusTreePage *node) const -> int;
+
+  /** Unlatch and unpin the pages in the page set, and release root_latch_ if it is there. */
+  void ReleasePageSet(Transaction *transaction, bool is_dirty);
+
+  /**
+   * Insert into the leaf if it does not split. @return false if the insert has to be done pessimistically
+   * @param[out] inserted the result of the insert, if it was done
+   */
+  auto InsertOptimistic(const KeyType &key, const ValueType &value, bool *inserted) -> bool;
+
+  /** Remove from the leaf if it does not underflow. @return false if the removal has to be done pessimistically */
+  auto RemoveOptimistic(const KeyType &key) -> bool;
+
+  void StartNewTree(const KeyType &key, const ValueType &value);
+
+  /**
+   * Insert the new right half of a split page into its parent, splitting the parent if it is full.
+   * @param index position of the split page in the page set
+   */
+  void InsertIntoParent(Transaction *transaction, size_t index, const KeyType &key, BPlusTreePage *new_node);
+
+  /**
+   * Merge the page with a sibling or borrow an entry from it, if the page is below its min size.
+   * @param index position of the page in the page set
+   */
+  void CoalesceOrRedistribute(Transaction *transaction, size_t index);
+
+  /** Shrink the tree when the root internal page is left with a single child, or the root leaf with no keys. */
+  void AdjustRoot(BPlusTreePage *old_root, Transaction *transaction);
+
+  /**
+   * Build the level of internal pages above a level of pages, with fill children per page. The last two pages share
+   * the children left over so that neither is below the min size.
+   * @param children the first key and the page id of every page of the level below, from left to right
+   * @return the first key and the page id of every page of the new level
+   */
+  auto BuildInternalLevel(const std::vector<std::pair<KeyType, page_id_t>> &children, int fill)
+      -> std::vector<std::pair<KeyType, page_id_t>>;
+
   /* Debug Routines for FREE!! */
   void ToGraph(BPlusTreePage *page, BufferPoolManager *bpm, std::ofstream &out) const;
 
@@ -84,11 +225,20 @@ class BPlusTree {
 
   // member variable
   std::string index_name_;
-  page_id_t root_page_id_;
+  /** Written under root_latch_, optimistic readers read it without. */
+  std::atomic<page_id_t> root_page_id_;
   BufferPoolManager *buffer_pool_manager_;
   KeyComparator comparator_;
   int leaf_max_size_;
   int internal_max_size_;
+  /** True if GetValue and the iterators read pages without latching them. */
+  bool optimistic_reads_;
+  /** Protects root_page_id_. */
+  mutable ReaderWriterLatch root_latch_;
+  /** Protects deferred_page_ids_. */
+  std::mutex deferred_latch_;
+  /** Pages taken out of the tree that were still pinned when they were to be deleted. */
+  std::vector<page_id_t> deferred_page_ids_;
 };
 
 }  // namespace bustub
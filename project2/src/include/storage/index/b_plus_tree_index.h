@@ -12,6 +12,7 @@
 #pragma once
 
 #include <map>
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -35,6 +36,24 @@ class BPlusTreeIndex : public Index {
 
   void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
 
+  /**
+   * Fill the empty index with the entries of a whole table at once. The entries are sorted, in sorted runs spilled to
+   * temporary files when there are more than INDEX_SORT_RUN_BYTES of them, and the tree is built bottom up from them,
+   * see BPlusTree::BulkLoad.
+   * @param next yields the key and the RID of the next tuple, false after the last one
+   * @param fill_factor how full to pack the pages of the tree
+   */
+  void BulkLoad(const std::function<bool(Tuple *, RID *)> &next, double fill_factor);
+
+  /**
+   * Like BulkLoad with a single producer, but the producers run on threads of their own, one each, and every thread
+   * sorts the entries it produced. The runs of all threads are merged into the tree on the calling thread. An exception
+   * thrown by a producer is thrown here once all of them stopped.
+   * @param producers each yields the key and the RID of the next tuple of its share of the table, false after the last
+   * @param fill_factor how full to pack the pages of the tree
+   */
+  void BulkLoad(const std::vector<std::function<bool(Tuple *, RID *)>> &producers, double fill_factor);
+
   auto GetBeginIterator() -> INDEXITERATOR_TYPE;
 
   auto GetBeginIterator(const KeyType &key) -> INDEXITERATOR_TYPE;
@@ -0,0 +1,219 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// external_sorter.h
+//
+// Identification: src/include/storage/index/external_sorter.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <queue>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "common/exception.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * ExternalSorter sorts more items than fit in memory, for building an index bottom up.
+ *
+ * Items are collected into a run of run_size items. A full run is sorted and spilled to a temporary file, and Next
+ * merges the runs. The last run is sorted in memory and never written, so without a spill the items come straight out
+ * of memory. The sort is stable: items that compare equal come out in the order they were added.
+ *
+ * Several threads can add items at once, each through a lane of its own. Every lane collects its own runs, so the
+ * threads sort and spill in parallel, and Next merges the runs of all lanes. Items of different lanes that compare
+ * equal come out in no particular order.
+ *
+ * Items are written to the runs as raw bytes, so they must be copyable as bytes, like the (key, RID) entries of a B+
+ * tree.
+ */
+template <typename T, typename Less>
+class ExternalSorter {
+  // std::pair is never trivially copyable, its assignment is not trivial, but copying its bytes is enough here
+  static_assert(std::is_trivially_copy_constructible_v<T> && std::is_trivially_destructible_v<T>,
+                "runs hold the raw bytes of the items");
+
+ public:
+  /**
+   * @param less the order of the items
+   * @param run_size number of items sorted in memory at a time, per lane
+   * @param num_lanes number of threads that may add items at once
+   */
+  ExternalSorter(Less less, size_t run_size, size_t num_lanes = 1)
+      : less_(std::move(less)), run_size_(std::max<size_t>(run_size, 1)), lanes_(std::max<size_t>(num_lanes, 1)) {}
+
+  DISALLOW_COPY_AND_MOVE(ExternalSorter);
+
+  ~ExternalSorter() {
+    for (auto &run : runs_) {
+      if (run.file_ != nullptr) {
+        fclose(run.file_);
+      }
+    }
+  }
+
+  /**
+   * Add an item, spilling the current run of its lane when it is full. Only before the first call to Next. Threads
+   * adding items at once must use different lanes.
+   * @param item the item to add
+   * @param lane the lane to add the item through
+   */
+  void Add(const T &item, size_t lane = 0) {
+    BUSTUB_ASSERT(!merging_, "items added after the merge started");
+    auto &buffer = lanes_[lane];
+    buffer.push_back(item);
+    if (buffer.size() == run_size_) {
+      AddRun(&buffer, true);
+    }
+  }
+
+  /**
+   * Sort the last run of a lane, so that the thread of the lane sorts it rather than the first call to Next. Items can
+   * still be added to the lane afterwards.
+   * @param lane the lane to finish
+   */
+  void FinishLane(size_t lane) {
+    if (!lanes_[lane].empty()) {
+      AddRun(&lanes_[lane], false);
+    }
+  }
+
+  /**
+   * Move on to the next item in sorted order.
+   * @param[out] item the next item
+   * @return false after the last item
+   */
+  auto Next(T *item) -> bool {
+    if (!merging_) {
+      StartMerge();
+    }
+    if (runs_.size() == 1) {
+      return ReadRun(&runs_[0], item);
+    }
+    if (heap_.empty()) {
+      return false;
+    }
+    size_t run_index = heap_.top().second;
+    *item = heap_.top().first;
+    heap_.pop();
+    T next;
+    if (ReadRun(&runs_[run_index], &next)) {
+      heap_.emplace(next, run_index);
+    }
+    return true;
+  }
+
+  /** @return the number of runs spilled to temporary files */
+  auto GetNumSpilledRuns() const -> size_t {
+    return std::count_if(runs_.begin(), runs_.end(), [](const Run &run) { return run.file_ != nullptr; });
+  }
+
+ private:
+  /** Number of items read from a spilled run at a time. */
+  static constexpr size_t READ_BATCH_SIZE = 4096;
+
+  /** A sorted run, in a temporary file or, for the last run of a lane, in memory. */
+  struct Run {
+    /** The rest of the run, nullptr if the run is in memory. */
+    std::FILE *file_;
+    /** The items read from the file, or the whole run when it is in memory. */
+    std::vector<T> batch_;
+    size_t position_;
+  };
+
+  /** Heap order: the smallest item on top, the earlier run first among equal items. */
+  struct HeapGreater {
+    const Less *less_;
+    auto operator()(const std::pair<T, size_t> &lhs, const std::pair<T, size_t> &rhs) const -> bool {
+      if ((*less_)(rhs.first, lhs.first)) {
+        return true;
+      }
+      return !(*less_)(lhs.first, rhs.first) && rhs.second < lhs.second;
+    }
+  };
+
+  /** Sort the items of a lane and make them a run, emptying the lane. Only the run list is shared between lanes. */
+  void AddRun(std::vector<T> *buffer, bool spill) {
+    std::stable_sort(buffer->begin(), buffer->end(), less_);
+    Run run{nullptr, {}, 0};
+    if (spill) {
+      run.file_ = std::tmpfile();
+      if (run.file_ == nullptr) {
+        throw Exception(ExceptionType::OUT_OF_MEMORY, "can't create a temporary file for a sorted run");
+      }
+      if (std::fwrite(buffer->data(), sizeof(T), buffer->size(), run.file_) != buffer->size()) {
+        fclose(run.file_);
+        throw Exception(ExceptionType::OUT_OF_MEMORY, "can't write a sorted run to its temporary file");
+      }
+      std::rewind(run.file_);
+      buffer->clear();
+    } else {
+      run.batch_ = std::move(*buffer);
+      buffer->clear();
+    }
+    std::scoped_lock lock(latch_);
+    runs_.push_back(std::move(run));
+  }
+
+  void StartMerge() {
+    merging_ = true;
+    for (auto &buffer : lanes_) {
+      if (!buffer.empty()) {
+        AddRun(&buffer, false);
+      }
+      buffer.shrink_to_fit();
+    }
+    if (runs_.size() == 1) {
+      return;
+    }
+    for (size_t i = 0; i < runs_.size(); i++) {
+      T item;
+      if (ReadRun(&runs_[i], &item)) {
+        heap_.emplace(item, i);
+      }
+    }
+  }
+
+  auto ReadRun(Run *run, T *item) -> bool {
+    if (run->position_ == run->batch_.size()) {
+      if (run->file_ == nullptr) {
+        return false;
+      }
+      run->batch_.resize(READ_BATCH_SIZE);
+      run->batch_.resize(std::fread(run->batch_.data(), sizeof(T), READ_BATCH_SIZE, run->file_));
+      run->position_ = 0;
+      if (run->batch_.empty()) {
+        return false;
+      }
+    }
+    *item = run->batch_[run->position_++];
+    return true;
+  }
+
+  Less less_;
+  const size_t run_size_;
+  /** The run being collected by every lane. */
+  std::vector<std::vector<T>> lanes_;
+  bool merging_{false};
+  /** Protects runs_ while lanes add to it. */
+  std::mutex latch_;
+  std::vector<Run> runs_;
+  /** The smallest unread item of every run that has one left, with the index of its run. */
+  std::priority_queue<std::pair<T, size_t>, std::vector<std::pair<T, size_t>>, HeapGreater> heap_{HeapGreater{&less_}};
+};
+
+}  // namespace bustub
@@ -13,9 +13,12 @@
 #pragma once
 
 #include <cstring>
+#include <string>
+#include <vector>
 
 #include "storage/table/tuple.h"
 #include "type/value.h"
+#include "type/value_factory.h"
 
 namespace bustub {
 
@@ -94,6 +97,71 @@ class GenericComparator {
     return 0;
   }
 
+  /**
+   * The separator of two keys with the fewest bytes that are not zero, for internal B+ tree pages to store in less
+   * room: the columns of rhs up to the first one that differs from lhs, with the characters after the first one that
+   * differs zeroed if it is a VARCHAR, then zero for every other column. A VARCHAR keeps its length, which is stored in
+   * front of it: separators of keys as long keep a common prefix that way. The separator is greater than lhs and not
+   * greater than rhs, rhs itself if there is nothing shorter.
+   */
+  auto ShortestSeparator(const GenericKey<KeySize> &lhs, const GenericKey<KeySize> &rhs) const -> GenericKey<KeySize> {
+    uint32_t column_count = key_schema_->GetColumnCount();
+    std::vector<Value> values;
+    values.reserve(column_count);
+    uint32_t i = 0;
+    for (; i < column_count; i++) {
+      Value lhs_value = lhs.ToValue(key_schema_, i);
+      Value rhs_value = rhs.ToValue(key_schema_, i);
+      if (lhs_value.IsNull() || rhs_value.IsNull()) {
+        return rhs;
+      }
+      if (lhs_value.CompareEquals(rhs_value) == CmpBool::CmpTrue) {
+        values.push_back(rhs_value);
+        continue;
+      }
+      if (rhs_value.GetTypeId() == TypeId::VARCHAR) {
+        std::string lhs_string(lhs_value.GetData(), lhs_value.GetLength() - 1);
+        std::string rhs_string(rhs_value.GetData(), rhs_value.GetLength() - 1);
+        size_t common = 0;
+        while (common < lhs_string.size() && common < rhs_string.size() && lhs_string[common] == rhs_string[common]) {
+          common++;
+        }
+        if (common + 1 < rhs_string.size()) {
+          rhs_string.replace(common + 1, std::string::npos, rhs_string.size() - common - 1, '\0');
+        }
+        values.push_back(ValueFactory::GetVarcharValue(rhs_string));
+      } else {
+        values.push_back(rhs_value);
+      }
+      break;
+    }
+    if (i == column_count) {
+      // the keys are equal
+      return rhs;
+    }
+    for (i++; i < column_count; i++) {
+      TypeId type = key_schema_->GetColumn(i).GetType();
+      if (type == TypeId::VARCHAR) {
+        Value rhs_value = rhs.ToValue(key_schema_, i);
+        values.push_back(ValueFactory::GetVarcharValue(std::string(rhs_value.GetLength() - 1, '\0')));
+      } else if (type == TypeId::TIMESTAMP) {
+        values.push_back(rhs.ToValue(key_schema_, i));
+      } else {
+        values.push_back(ValueFactory::GetZeroValueByType(type));
+      }
+    }
+    Tuple tuple(values, key_schema_);
+    if (tuple.GetLength() > KeySize) {
+      return rhs;
+    }
+    GenericKey<KeySize> separator;
+    separator.SetFromKey(tuple);
+    if ((*this)(lhs, separator) >= 0 || (*this)(separator, rhs) > 0) {
+      return rhs;
+    }
+    return separator;
+  }
+
   GenericComparator(const GenericComparator &other) : key_schema_{other.key_schema_} {}
 
   // constructor
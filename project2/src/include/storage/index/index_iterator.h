@@ -17,13 +17,43 @@
 
 namespace bustub {
 
+INDEX_TEMPLATE_ARGUMENTS
+class BPlusTree;
+
 #define INDEXITERATOR_TYPE IndexIterator<KeyType, ValueType, KeyComparator>
 
+/**
+ * IndexIterator walks the leaf pages of a B+ tree from left to right.
+ *
+ * It keeps the current leaf pinned, and read latches it only while stepping, so that a caller can modify the tree
+ * between two steps without deadlocking on its own iterator. The current entry is copied out of the page for the same
+ * reason. An optimistic iterator takes no latch at all: it reads the entry and checks the page version, see
+ * Page::GetVersion(), and reads again if a writer got in between.
+ *
+ * An iterator runs concurrently with writers, it is not a snapshot, but it keeps its place by key: when the current
+ * leaf changed since the current entry was read, the next entry is searched for by key in the leaf, and when the leaf
+ * was merged away, which leaves it empty, from the root. The next leaf is pinned before the current one is read again
+ * to check that it still follows, and the current one is let go of once the first entry of the next one is read and
+ * no entry moved back into the current one meanwhile. So every entry that is in the tree throughout the scan is seen
+ * once, in key order. Entries inserted or removed during the scan may or may not be seen.
+ */
 INDEX_TEMPLATE_ARGUMENTS
 class IndexIterator {
  public:
-  // you may define your own constructor based on your member variables
+  /** Creates the end iterator. */
   IndexIterator();
+  /**
+   * @param tree the tree to iterate over
+   * @param page a leaf page, pinned for the iterator, which unpins it. nullptr for the end iterator.
+   * @param index position in the leaf page, past its last entry moves on to the next leaf page
+   * @param optimistic read the leaf pages without latching them
+   * @param key if not nullptr, the key the iterator starts at, index is the place of the first key not less than it
+   * @param version the version of the page index was found at, with key
+   */
+  IndexIterator(BPlusTree<KeyType, ValueType, KeyComparator> *tree, Page *page, int index, bool optimistic = false,
+                const KeyType *key = nullptr, uint64_t version = NO_VERSION);
+  IndexIterator(IndexIterator &&other) noexcept;
+  auto operator=(IndexIterator &&other) noexcept -> IndexIterator &;
   ~IndexIterator();  // NOLINT
 
   auto IsEnd() -> bool;
@@ -32,12 +62,49 @@ class IndexIterator {
 
   auto operator++() -> IndexIterator &;
 
-  auto operator==(const IndexIterator &itr) const -> bool { throw std::runtime_error("unimplemented"); }
+  auto operator==(const IndexIterator &itr) const -> bool {
+    return (page_ == nullptr ? INVALID_PAGE_ID : page_->GetPageId()) ==
+               (itr.page_ == nullptr ? INVALID_PAGE_ID : itr.page_->GetPageId()) &&
+           (page_ == nullptr || index_ == itr.index_);
+  }
 
-  auto operator!=(const IndexIterator &itr) const -> bool { throw std::runtime_error("unimplemented"); }
+  auto operator!=(const IndexIterator &itr) const -> bool { return !(*this == itr); }
 
  private:
-  // add your own private member variables here
+  using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
+
+  /** Copy out the entry at index_, moving on to the next leaf pages while index_ is past the end of the current one. */
+  void Settle();
+
+  /**
+   * Read the size and the next page id of the current leaf, and copy out the entry at index_ if there is one. If the
+   * leaf changed since version_, index_ is searched for by key first.
+   * @return the size of the leaf
+   */
+  auto ReadLeaf(page_id_t *next_page_id) -> int;
+
+  /** Start over from the root, at the first key after the current one. */
+  void Reseek();
+
+  /** An optimistic read of a leaf that conflicts with writers this many times in a row takes the read latch. */
+  static constexpr int MAX_OPTIMISTIC_ATTEMPTS = 16;
+  /** No page has this version while it is not write latched, index_ is searched for on the next read. */
+  static constexpr uint64_t NO_VERSION = 1;
+
+  BPlusTree<KeyType, ValueType, KeyComparator> *tree_{nullptr};
+  BufferPoolManager *buffer_pool_manager_{nullptr};
+  /** The current leaf page, pinned. nullptr at the end. */
+  Page *page_{nullptr};
+  int index_{0};
+  /** The version of the current leaf that index_ is the place of the next entry at. */
+  uint64_t version_{NO_VERSION};
+  bool optimistic_{false};
+  /** Copy of the current entry. Its key is where the iterator is, if has_key_. */
+  MappingType item_;
+  /** True once the iterator has a key, the key of the current entry or the key it starts at. */
+  bool has_key_{false};
+  /** True while the key is the one the iterator starts at, an entry with that key comes next. */
+  bool inclusive_{false};
 };
 
 }  // namespace bustub
@@ -10,7 +10,9 @@
 //===----------------------------------------------------------------------===//
 #pragma once
 
+#include <algorithm>
 #include <queue>
+#include <vector>
 
 #include "storage/page/b_plus_tree_page.h"
 
@@ -18,7 +20,10 @@ namespace bustub {
 
 #define B_PLUS_TREE_INTERNAL_PAGE_TYPE BPlusTreeInternalPage<KeyType, ValueType, KeyComparator>
 #define INTERNAL_PAGE_HEADER_SIZE 24
-#define INTERNAL_PAGE_SIZE ((BUSTUB_PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE) / (sizeof(MappingType)))
+// header, prefix size, key size, first key and prefix
+#define INTERNAL_PAGE_ENTRIES_OFFSET (INTERNAL_PAGE_HEADER_SIZE + 4 + 2 * sizeof(KeyType))
+// as many children as fit with keys that are all compressed away
+#define INTERNAL_PAGE_SIZE ((BUSTUB_PAGE_SIZE - INTERNAL_PAGE_ENTRIES_OFFSET) / sizeof(page_id_t))
 /**
  * Store n indexed keys and n+1 child pointers (page_id) within internal page.
  * Pointer PAGE_ID(i) points to a subtree in which all keys K satisfy:
@@ -27,23 +32,103 @@ namespace bustub {
  * the first key always remains invalid. That is to say, any search/lookup
  * should ignore the first key.
  *
+ * The keys are prefix compressed: the bytes all keys but the first one have in common are stored once, in PREFIX, and
+ * so are the zero bytes they all end with, which are not stored at all. Every entry keeps the bytes of its key in
+ * between, [PrefixSize, KeySize), so that the entries are all as big and binary search reads them in place. The
+ * separators pushed up on splits are as short as can be (see GenericComparator::ShortestSeparator), they end with
+ * zeros. The first key is stored in full, it is only read as the separator to push up after a split or a
+ * redistribution.
+ *
+ * How many children fit thus depends on the keys. A page has room for MIN_CAPACITY children whatever their keys, and
+ * HasRoomFor tells whether a given key fits. A page splits once it is full or has no room for a new key, and the min
+ * size of a page is half of MIN_CAPACITY.
+ *
  * Internal page format (keys are stored in increasing order):
- *  --------------------------------------------------------------------------
- * | HEADER | KEY(1)+PAGE_ID(1) | KEY(2)+PAGE_ID(2) | ... | KEY(n)+PAGE_ID(n) |
- *  --------------------------------------------------------------------------
+ *  ------------------------------------------------------------------------------------------------------
+ * | HEADER | PrefixSize (2) | KeySize (2) | KEY(0) | PREFIX | SUFFIX(0)+PAGE_ID(0) | ... | SUFFIX(n)+PAGE_ID(n) |
+ *  ------------------------------------------------------------------------------------------------------
  */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeInternalPage : public BPlusTreePage {
  public:
+  /** Number of children a page has room for whatever their keys. */
+  static constexpr int MIN_CAPACITY =
+      (BUSTUB_PAGE_SIZE - INTERNAL_PAGE_ENTRIES_OFFSET) / (sizeof(KeyType) + sizeof(ValueType));
+  /** Number of children a page has room for at most, when the keys take no room at all. */
+  static constexpr int MAX_CAPACITY = (BUSTUB_PAGE_SIZE - INTERNAL_PAGE_ENTRIES_OFFSET) / sizeof(ValueType);
+
   // must call initialize method after "create" a new node
   void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID, int max_size = INTERNAL_PAGE_SIZE);
 
+  // fewest children of a page that is not the root: half of what a page has room for whatever its keys
+  static auto MinSize(int max_size) -> int { return (std::min(max_size, MIN_CAPACITY) + 1) / 2; }
+  auto GetMinSize() const -> int { return MinSize(GetMaxSize()); }
+
   auto KeyAt(int index) const -> KeyType;
+  // the page must have room for the key, see CanSetKeyAt
   void SetKeyAt(int index, const KeyType &key);
   auto ValueAt(int index) const -> ValueType;
+  void SetValueAt(int index, const ValueType &value);
+  // index of the child pointer equal to value, -1 if there is none
+  auto ValueIndex(const ValueType &value) const -> int;
+  // child pointer of the subtree that may contain key
+  auto Lookup(const KeyType &key, const KeyComparator &comparator) const -> ValueType;
+
+  // true if one more child with this key fits in the bytes of the page, the max size is up to the caller
+  auto HasRoomFor(const KeyType &key) const -> bool;
+  // true if the key at index can be replaced by this one
+  auto CanSetKeyAt(int index, const KeyType &key) const -> bool;
+  // true if all children of page fit after the children of this page, see MoveAllTo
+  auto HasRoomForAllOf(const BPlusTreeInternalPage *page, const KeyType &middle_key) const -> bool;
+
+  // turn a new page into the root above the two halves of the old root
+  void PopulateNewRoot(const ValueType &old_value, const KeyType &new_key, const ValueType &new_value);
+  // insert a child pointer after old_value into a page that has room for it, return the size after the insertion
+  auto InsertNodeAfter(const ValueType &old_value, const KeyType &new_key, const ValueType &new_value) -> int;
+  // bulk loading: add a child pointer after the last one into a page that has room for it, key is ignored for the
+  // first child
+  void Append(const KeyType &key, const ValueType &value);
+  // split a page that is full or has no room for new_key: insert the child pointer after old_value and move the upper
+  // half of the children to recipient, a new right sibling. The first key of recipient is the separator to push up.
+  // Both pages keep at least MinSize children.
+  void InsertAndMoveHalfTo(const ValueType &old_value, const KeyType &new_key, const ValueType &new_value,
+                           BPlusTreeInternalPage *recipient, BufferPoolManager *buffer_pool_manager);
+  void Remove(int index);
+  // the only child of a root that lost all its keys
+  auto RemoveAndReturnOnlyChild() -> ValueType;
+
+  // merge: move all children to the left sibling, middle_key is the separator of the two pages in the parent
+  void MoveAllTo(BPlusTreeInternalPage *recipient, const KeyType &middle_key, BufferPoolManager *buffer_pool_manager);
+  // redistribute: lend the first child to the left sibling, or the last child to the right sibling. The new separator
+  // is the first key of the right page afterwards. The recipient must be below its min size, then it has room.
+  void MoveFirstToEndOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
+                        BufferPoolManager *buffer_pool_manager);
+  void MoveLastToFrontOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
+                         BufferPoolManager *buffer_pool_manager);
 
  private:
+  // point the parent page id of the children in [begin, end) to this page
+  void AdoptChildren(int begin, int end, BufferPoolManager *buffer_pool_manager);
+
+  // all children, with their keys decompressed
+  auto GetItems() const -> std::vector<MappingType>;
+  // replace all children, compressing the keys as much as they allow
+  void SetItems(const std::vector<MappingType> &items);
+  // true if the key is stored as is with the current prefix size and key size
+  auto FitsEncoding(const KeyType &key) const -> bool;
+  // the prefix size and key size, read once and trimmed to sizeof(KeyType) for readers racing with a writer
+  auto GetEncoding() const -> std::pair<int, int>;
+  // the entry of a child: the bytes of its key after the prefix, then its page id. nullptr if it would end past the
+  // page, which only a reader racing with a writer asks for.
+  auto EntryAt(int index, int entry_size) const -> const char *;
+  auto EntryAt(int index, int entry_size) -> char *;
+  void WriteEntry(int index, const MappingType &item);
+
+  uint16_t prefix_size_;
+  uint16_t key_size_;
+  KeyType first_key_;
+  char prefix_[sizeof(KeyType)];
   // Flexible array member for page data.
-  MappingType array_[1];
+  char entries_[1];
 };
 }  // namespace bustub
@@ -49,6 +49,28 @@ class BPlusTreeLeafPage : public BPlusTreePage {
   auto GetNextPageId() const -> page_id_t;
   void SetNextPageId(page_id_t next_page_id);
   auto KeyAt(int index) const -> KeyType;
+  auto ValueAt(int index) const -> ValueType;
+  auto GetItem(int index) const -> const MappingType &;
+
+  // index of the first key that is not less than key, GetSize() if there is none
+  auto KeyIndex(const KeyType &key, const KeyComparator &comparator) const -> int;
+  // find the value of key, return false if the key is not in the page
+  auto Lookup(const KeyType &key, ValueType *value, const KeyComparator &comparator) const -> bool;
+
+  // insert a key that is not in the page yet, return the size after the insertion
+  auto Insert(const KeyType &key, const ValueType &value, const KeyComparator &comparator) -> int;
+  // bulk loading: add an entry whose key is greater than every key in the page
+  void Append(const KeyType &key, const ValueType &value);
+  // remove key if it is in the page, return the size after the removal
+  auto RemoveAndDeleteRecord(const KeyType &key, const KeyComparator &comparator) -> int;
+
+  // split: move the upper half of the entries to a new right sibling
+  void MoveHalfTo(BPlusTreeLeafPage *recipient);
+  // merge: move all entries to the left sibling, which takes over the next page id
+  void MoveAllTo(BPlusTreeLeafPage *recipient);
+  // redistribute: lend the first entry to the left sibling, or the last entry to the right sibling
+  void MoveFirstToEndOf(BPlusTreeLeafPage *recipient);
+  void MoveLastToFrontOf(BPlusTreeLeafPage *recipient);
 
  private:
   page_id_t next_page_id_;
@@ -12,6 +12,9 @@
 
 #pragma once
 
+#include <mutex>  // NOLINT
+#include <vector>
+
 #include "buffer/buffer_pool_manager.h"
 #include "recovery/log_manager.h"
 #include "storage/page/table_page.h"
@@ -26,6 +29,7 @@ namespace bustub {
  */
 class TableHeap {
   friend class TableIterator;
+  friend class TablePageCursor;
 
  public:
   ~TableHeap() = default;
@@ -95,9 +99,12 @@ class TableHeap {
    * @param rid rid of the tuple to read
    * @param tuple output variable for the tuple
    * @param txn transaction performing the read
+   * @param acquire_read_lock whether to read latch the page, false if the caller already holds the latch
+   * @param access_type how the page is accessed, AccessType::Scan when the read is part of a sequential scan
    * @return true if the read was successful (i.e. the tuple exists)
    */
-  auto GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, bool acquire_read_lock = true) -> bool;
+  auto GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, bool acquire_read_lock = true,
+                AccessType access_type = AccessType::Unknown) -> bool;
 
   /** @return the begin iterator of this table */
   auto Begin(Transaction *txn) -> TableIterator;
@@ -109,10 +116,39 @@ class TableHeap {
   inline auto GetFirstPageId() const -> page_id_t { return first_page_id_; }
 
  private:
+  /** @return the id of the table page that follows the given table page, used to read ahead the table */
+  static auto NextPageId(Page *page) -> page_id_t;
+
   BufferPoolManager *buffer_pool_manager_;
   LockManager *lock_manager_;
   LogManager *log_manager_;
   page_id_t first_page_id_{};
 };
 
+/**
+ * TablePageCursor hands out the pages of a TableHeap one at a time, in chain order, to several threads reading the
+ * table at once. Every page goes to exactly one of them. The page chain is a linked list, so the threads cannot split
+ * the table up front; instead each one takes the next page whenever it is done with the last.
+ */
+class TablePageCursor {
+ public:
+  explicit TablePageCursor(TableHeap *table_heap)
+      : table_heap_(table_heap), next_page_id_(table_heap->GetFirstPageId()) {}
+
+  /**
+   * Read the tuples of the next page no thread has read yet. Safe to call from several threads at once.
+   * @param[out] tuples the tuples of the page, empty if all of them were deleted or every page was handed out
+   * @param txn the transaction performing the read
+   * @return false once every page was handed out
+   */
+  auto ReadNextPage(std::vector<Tuple> *tuples, Transaction *txn) -> bool;
+
+ private:
+  TableHeap *table_heap_;
+  /** Protects next_page_id_ and pages_until_prefetch_. */
+  std::mutex latch_;
+  page_id_t next_page_id_;
+  size_t pages_until_prefetch_{0};
+};
+
 }  // namespace bustub
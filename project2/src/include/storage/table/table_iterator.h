@@ -21,6 +21,7 @@
 namespace bustub {
 
 class TableHeap;
+class TablePage;
 
 /**
  * TableIterator enables the sequential scan of a TableHeap.
@@ -32,7 +33,10 @@ class TableIterator {
   TableIterator(TableHeap *table_heap, RID rid, Transaction *txn);
 
   TableIterator(const TableIterator &other)
-      : table_heap_(other.table_heap_), tuple_(new Tuple(*other.tuple_)), txn_(other.txn_) {}
+      : table_heap_(other.table_heap_),
+        tuple_(new Tuple(*other.tuple_)),
+        txn_(other.txn_),
+        pages_until_prefetch_(other.pages_until_prefetch_) {}
 
   ~TableIterator() { delete tuple_; }
 
@@ -54,13 +58,23 @@ class TableIterator {
     table_heap_ = other.table_heap_;
     *tuple_ = *other.tuple_;
     txn_ = other.txn_;
+    pages_until_prefetch_ = other.pages_until_prefetch_;
     return *this;
   }
 
  private:
+  /**
+   * Called whenever the scan moves on to a new page. Every table_prefetch_pages / 2 pages, ask the buffer pool to read
+   * ahead the next table_prefetch_pages pages, so the scan keeps a window of pages in flight ahead of it.
+   * @param page the page the scan just moved to, read latched
+   */
+  void ReadAhead(TablePage *page);
+
   TableHeap *table_heap_;
   Tuple *tuple_;
   Transaction *txn_;
+  /** Pages left to scan before the next read-ahead. TableHeap::Begin() issues the first one. */
+  size_t pages_until_prefetch_;
 };
 
 }  // namespace bustub
@@ -12,6 +12,10 @@
 
 #include "recovery/log_manager.h"
 
+#include <cstring>
+
+#include "common/macros.h"
+
 namespace bustub {
 /*
  * set enable_logging = true
@@ -22,33 +26,180 @@ namespace bustub {
  *
  * This thread runs forever until system shutdown/StopFlushThread
  */
-void LogManager::RunFlushThread() {}
+void LogManager::RunFlushThread() {
+  std::scoped_lock lock(latch_);
+  if (flush_thread_ != nullptr) {
+    return;
+  }
+  enable_logging = true;
+  stop_flush_thread_ = false;
+  flush_thread_ = new std::thread(&LogManager::FlushLoop, this);
+}
 
 /*
  * Stop and join the flush thread, set enable_logging = false
+ * The thread flushes whatever is left in the log buffer before it exits.
  */
-void LogManager::StopFlushThread() {}
+void LogManager::StopFlushThread() {
+  std::thread *flush_thread;
+  {
+    std::scoped_lock lock(latch_);
+    if (flush_thread_ == nullptr) {
+      return;
+    }
+    stop_flush_thread_ = true;
+    cv_.notify_one();
+    flush_thread = flush_thread_;
+  }
+  flush_thread->join();
+  delete flush_thread;
+  std::scoped_lock lock(latch_);
+  flush_thread_ = nullptr;
+  enable_logging = false;
+}
+
+void LogManager::FlushLoop() {
+  std::unique_lock<std::mutex> lock(latch_);
+  while (true) {
+    // A committer or an appender that ran out of space asks for a flush through flush_lsn_. Everything appended while
+    // the previous group was being written goes out together in the next one.
+    cv_.wait_for(lock, log_timeout, [&] { return stop_flush_thread_ || flush_lsn_ > persistent_lsn_; });
+    FlushLogBuffer(&lock);
+    if (stop_flush_thread_) {
+      return;
+    }
+  }
+}
+
+void LogManager::FlushLogBuffer(std::unique_lock<std::mutex> *lock) {
+  // Seal the active buffer by switching the appenders to the other one. It was written by the previous flush, which
+  // finished before flushing_ was cleared.
+  uint64_t state = reserve_state_.load();
+  do {
+    if (StateOffset(state) == 0) {
+      return;
+    }
+  } while (!reserve_state_.compare_exchange_weak(state, MakeState(StateLSN(state), 1 - StateBuffer(state), 0)));
+  int buffer = StateBuffer(state);
+  int size = StateOffset(state);
+  lsn_t lsn = StateLSN(state) - 1;
+  flushing_ = true;
+  // the appenders waiting for space can use the other buffer now
+  flushed_cv_.notify_all();
+
+  lock->unlock();
+  // wait for the appenders that reserved space in the sealed buffer to finish copying their records
+  while (copied_bytes_[buffer].load(std::memory_order_acquire) != size) {
+    std::this_thread::yield();
+  }
+  disk_manager_->WriteLog(log_buffers_[buffer], size);
+  copied_bytes_[buffer].store(0, std::memory_order_relaxed);
+  lock->lock();
+
+  persistent_lsn_ = lsn;
+  flushing_ = false;
+  flushed_cv_.notify_all();
+}
+
+void LogManager::WaitForFlush(lsn_t lsn) {
+  std::unique_lock<std::mutex> lock(latch_);
+  while (persistent_lsn_ < lsn) {
+    if (flush_thread_ != nullptr) {
+      flush_lsn_ = std::max(flush_lsn_, lsn);
+      cv_.notify_one();
+      flushed_cv_.wait(lock);
+    } else if (flushing_) {
+      flushed_cv_.wait(lock);
+    } else {
+      FlushLogBuffer(&lock);
+    }
+  }
+}
+
+void LogManager::WaitForSpace(int size) {
+  std::unique_lock<std::mutex> lock(latch_);
+  // the buffer is only sealed with latch_ held, so checking under it does not miss the wake up
+  while (StateOffset(reserve_state_) + size > LOG_BUFFER_SIZE) {
+    if (flush_thread_ != nullptr) {
+      flush_lsn_ = std::max(flush_lsn_, GetNextLSN() - 1);
+      cv_.notify_one();
+      flushed_cv_.wait(lock);
+    } else if (flushing_) {
+      flushed_cv_.wait(lock);
+    } else {
+      FlushLogBuffer(&lock);
+    }
+  }
+}
 
 /*
  * append a log record into log buffer
  * you MUST set the log record's lsn within this method
  * @return: lsn that is assigned to this log record
  *
- *
- * example below
- * // First, serialize the must have fields(20 bytes in total)
- * log_record.lsn_ = next_lsn_++;
- * memcpy(log_buffer_ + offset_, &log_record, 20);
- * int pos = offset_ + 20;
- *
- * if (log_record.log_record_type_ == LogRecordType::INSERT) {
- *    memcpy(log_buffer_ + pos, &log_record.insert_rid_, sizeof(RID));
- *    pos += sizeof(RID);
- *    // we have provided serialize function for tuple class
- *    log_record.insert_tuple_.SerializeTo(log_buffer_ + pos);
- *  }
- *
+ * The lsn and the space in the active buffer are reserved together, so the records are laid out in lsn order. If the
+ * record does not fit, wait for the active buffer to be sealed.
+ */
+auto LogManager::AppendLogRecord(LogRecord *log_record) -> lsn_t {
+  int size = log_record->size_;
+  BUSTUB_ASSERT(size <= LOG_BUFFER_SIZE, "log record is larger than the log buffer");
+  uint64_t state = reserve_state_.load();
+  while (true) {
+    if (StateOffset(state) + size > LOG_BUFFER_SIZE) {
+      WaitForSpace(size);
+      state = reserve_state_.load();
+      continue;
+    }
+    uint64_t reserved = MakeState(StateLSN(state) + 1, StateBuffer(state), StateOffset(state) + size);
+    if (reserve_state_.compare_exchange_weak(state, reserved)) {
+      break;
+    }
+  }
+
+  int buffer = StateBuffer(state);
+  log_record->lsn_ = StateLSN(state);
+  SerializeLogRecord(log_record, log_buffers_[buffer] + StateOffset(state));
+  copied_bytes_[buffer].fetch_add(size, std::memory_order_release);
+  return log_record->lsn_;
+}
+
+/*
+ * First, serialize the must have fields(20 bytes in total), then the fields of the record type, see log_record.h
  */
-auto LogManager::AppendLogRecord(LogRecord *log_record) -> lsn_t { return INVALID_LSN; }
+void LogManager::SerializeLogRecord(LogRecord *log_record, char *data) {
+  // the header fields are the first members of LogRecord
+  memcpy(data, log_record, LogRecord::HEADER_SIZE);
+  int pos = LogRecord::HEADER_SIZE;
+
+  switch (log_record->log_record_type_) {
+    case LogRecordType::INSERT:
+      memcpy(data + pos, &log_record->insert_rid_, sizeof(RID));
+      pos += sizeof(RID);
+      log_record->insert_tuple_.SerializeTo(data + pos);
+      break;
+    case LogRecordType::MARKDELETE:
+    case LogRecordType::APPLYDELETE:
+    case LogRecordType::ROLLBACKDELETE:
+      memcpy(data + pos, &log_record->delete_rid_, sizeof(RID));
+      pos += sizeof(RID);
+      log_record->delete_tuple_.SerializeTo(data + pos);
+      break;
+    case LogRecordType::UPDATE:
+      memcpy(data + pos, &log_record->update_rid_, sizeof(RID));
+      pos += sizeof(RID);
+      log_record->old_tuple_.SerializeTo(data + pos);
+      pos += sizeof(int32_t) + log_record->old_tuple_.GetLength();
+      log_record->new_tuple_.SerializeTo(data + pos);
+      break;
+    case LogRecordType::NEWPAGE:
+      memcpy(data + pos, &log_record->prev_page_id_, sizeof(page_id_t));
+      pos += sizeof(page_id_t);
+      memcpy(data + pos, &log_record->page_id_, sizeof(page_id_t));
+      break;
+    default:
+      // BEGIN, COMMIT and ABORT are just the header
+      break;
+  }
+}
 
 }  // namespace bustub
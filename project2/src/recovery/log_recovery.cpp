@@ -12,6 +12,7 @@
 
 #include "recovery/log_recovery.h"
 
+#include "common/logger.h"
 #include "storage/page/table_page.h"
 
 namespace bustub {
@@ -22,6 +23,14 @@ namespace bustub {
  */
 auto LogRecovery::DeserializeLogRecord(const char *data, LogRecord *log_record) -> bool { return false; }
 
+auto LogRecovery::RepairPages() -> size_t {
+  size_t num_repaired_pages = disk_manager_->RepairTornPages();
+  if (num_repaired_pages > 0) {
+    LOG_INFO("repaired %zu torn pages", num_repaired_pages);
+  }
+  return num_repaired_pages;
+}
+
 /*
  *redo phase on TABLE PAGE level(table/table_page.h)
  *read log file from the beginning to end (you must prefetch log records into
@@ -29,7 +38,7 @@ auto LogRecovery::DeserializeLogRecord(const char *data, LogRecord *log_record)
  *LSN with log_record's sequence number, and also build active_txn_ table &
  *lsn_mapping_ table
  */
-void LogRecovery::Redo() {}
+void LogRecovery::Redo() { RepairPages(); }
 
 /*
  *undo phase on TABLE PAGE level(table/table_page.h)
@@ -0,0 +1,292 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// async_disk_manager.cpp
+//
+// Identification: src/storage/disk/async_disk_manager.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/async_disk_manager.h"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "common/exception.h"
+#include "common/logger.h"
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>) && defined(__NR_io_uring_setup)
+#include <linux/io_uring.h>
+#define BUSTUB_HAVE_IO_URING 1
+#endif
+
+namespace bustub {
+
+AsyncDiskManager::AsyncDiskManager(const std::string &db_file, size_t queue_depth, bool use_io_uring)
+    : DiskManager(db_file), queue_depth_(std::max<size_t>(queue_depth, 1)), backend_(Backend::THREAD_POOL) {
+  if (use_io_uring && SetUpIoUring()) {
+    backend_ = Backend::IO_URING;
+    threads_.emplace_back(&AsyncDiskManager::ReapLoop, this);
+  } else {
+    for (size_t i = 0; i < std::min(queue_depth_, MAX_WORKERS); i++) {
+      threads_.emplace_back(&AsyncDiskManager::WorkerLoop, this);
+    }
+  }
+}
+
+AsyncDiskManager::~AsyncDiskManager() { ShutDown(); }
+
+void AsyncDiskManager::ShutDown() {
+  {
+    std::unique_lock<std::mutex> lock(latch_);
+    if (shut_down_) {
+      return;
+    }
+    shut_down_ = true;
+    inflight_cv_.wait(lock, [&] { return inflight_ == 0; });
+    stop_ = true;
+    if (backend_ == Backend::IO_URING) {
+      // the reaper sleeps in io_uring_enter, a NOP completion wakes it up
+      SubmitToIoUring(nullptr);
+    }
+    queue_cv_.notify_all();
+  }
+  for (auto &thread : threads_) {
+    thread.join();
+  }
+  threads_.clear();
+  TearDownIoUring();
+  DiskManager::ShutDown();
+}
+
+void AsyncDiskManager::WritePage(page_id_t page_id, const char *page_data) {
+  WritePageAsync(page_id, page_data).get();
+}
+
+void AsyncDiskManager::ReadPage(page_id_t page_id, char *page_data) { ReadPageAsync(page_id, page_data).get(); }
+
+auto AsyncDiskManager::WritePageAsync(page_id_t page_id, const char *page_data) -> std::future<void> {
+  free_space_map_->SyncAllocations();
+  // the buffer is only read from, iovec just has no const variant
+  return Submit(true, page_id, const_cast<char *>(page_data));
+}
+
+auto AsyncDiskManager::ReadPageAsync(page_id_t page_id, char *page_data) -> std::future<void> {
+  return Submit(false, page_id, page_data);
+}
+
+auto AsyncDiskManager::Submit(bool is_write, page_id_t page_id, char *page_data) -> std::future<void> {
+  auto *request = new DiskRequest{is_write, page_id, {page_data, BUSTUB_PAGE_SIZE}, {}};
+  auto done = request->done_.get_future();
+
+  std::unique_lock<std::mutex> lock(latch_);
+  BUSTUB_ASSERT(!shut_down_, "page I/O submitted after ShutDown");
+  inflight_cv_.wait(lock, [&] { return inflight_ < queue_depth_; });
+  inflight_++;
+  if (is_write) {
+    num_writes_ += 1;
+  }
+  if (backend_ == Backend::IO_URING) {
+    SubmitToIoUring(request);
+  } else {
+    queue_.push_back(request);
+    queue_cv_.notify_one();
+  }
+  return done;
+}
+
+void AsyncDiskManager::Complete(DiskRequest *request, ssize_t result) {
+  if (result < 0) {
+    LOG_DEBUG("I/O error while %s page %d: %s", request->is_write_ ? "writing" : "reading", request->page_id_,
+              strerror(static_cast<int>(-result)));
+  } else if (request->is_write_ && result < BUSTUB_PAGE_SIZE) {
+    LOG_DEBUG("Wrote less than a page");
+  }
+  if (!request->is_write_ && result < BUSTUB_PAGE_SIZE) {
+    // the file ends before the page does, like DiskManager the rest of the page reads as zeros
+    size_t read_count = result < 0 ? 0 : static_cast<size_t>(result);
+    memset(static_cast<char *>(request->iov_.iov_base) + read_count, 0, BUSTUB_PAGE_SIZE - read_count);
+  }
+  request->done_.set_value();
+  delete request;
+
+  std::scoped_lock<std::mutex> lock(latch_);
+  inflight_--;
+  inflight_cv_.notify_all();
+}
+
+void AsyncDiskManager::WorkerLoop() {
+  std::unique_lock<std::mutex> lock(latch_);
+  while (true) {
+    queue_cv_.wait(lock, [&] { return stop_ || !queue_.empty(); });
+    if (queue_.empty()) {
+      return;
+    }
+    DiskRequest *request = queue_.front();
+    queue_.pop_front();
+    lock.unlock();
+
+    off_t offset = static_cast<off_t>(request->page_id_) * BUSTUB_PAGE_SIZE;
+    ssize_t result = request->is_write_ ? pwrite(db_fd_, request->iov_.iov_base, BUSTUB_PAGE_SIZE, offset)
+                                        : pread(db_fd_, request->iov_.iov_base, BUSTUB_PAGE_SIZE, offset);
+    Complete(request, result < 0 ? -errno : result);
+
+    lock.lock();
+  }
+}
+
+#ifdef BUSTUB_HAVE_IO_URING
+
+auto AsyncDiskManager::SetUpIoUring() -> bool {
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  ring_fd_ = static_cast<int>(syscall(__NR_io_uring_setup, static_cast<unsigned>(queue_depth_), &params));
+  if (ring_fd_ < 0) {
+    LOG_DEBUG("io_uring is not available (%s), using a thread pool", strerror(errno));
+    ring_fd_ = -1;
+    return false;
+  }
+
+  // The submission queue ring, the completion queue ring and the submission queue entries are shared with the kernel
+  // through three mappings, or two when the kernel maps both rings at once.
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) {
+    sq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  }
+  sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                  IORING_OFF_SQ_RING);
+  if (sq_ring_ == MAP_FAILED) {
+    sq_ring_ = nullptr;
+    TearDownIoUring();
+    return false;
+  }
+  if (single_mmap) {
+    cq_ring_ = sq_ring_;
+    cq_ring_size_ = 0;
+  } else {
+    cq_ring_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                    IORING_OFF_CQ_RING);
+    if (cq_ring_ == MAP_FAILED) {
+      cq_ring_ = nullptr;
+      TearDownIoUring();
+      return false;
+    }
+  }
+  sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+  void *sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) {
+    TearDownIoUring();
+    return false;
+  }
+  sqes_ = static_cast<struct io_uring_sqe *>(sqes);
+
+  auto *sq = static_cast<char *>(sq_ring_);
+  sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+  sq_mask_ = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+  auto *cq = static_cast<char *>(cq_ring_);
+  cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+  cq_mask_ = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+  cqes_ = reinterpret_cast<struct io_uring_cqe *>(cq + params.cq_off.cqes);
+  // sq_entries >= queue_depth_ and cq_entries >= sq_entries, so bounding inflight_ keeps both rings from overflowing
+  return true;
+}
+
+void AsyncDiskManager::SubmitToIoUring(DiskRequest *request) {
+  // Only submitters move the tail, and they hold latch_. The kernel consumes the entry within io_uring_enter below,
+  // so the slot is free again once it returns.
+  unsigned tail = *sq_tail_;
+  unsigned index = tail & *sq_mask_;
+  struct io_uring_sqe *sqe = &sqes_[index];
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = IORING_OP_NOP;
+  sqe->fd = -1;
+  if (request != nullptr) {
+    // the vectored operations are the ones every io_uring kernel supports
+    sqe->opcode = request->is_write_ ? IORING_OP_WRITEV : IORING_OP_READV;
+    sqe->fd = db_fd_;
+    sqe->addr = reinterpret_cast<uint64_t>(&request->iov_);
+    sqe->len = 1;
+    sqe->off = static_cast<uint64_t>(request->page_id_) * BUSTUB_PAGE_SIZE;
+  }
+  sqe->user_data = reinterpret_cast<uint64_t>(request);
+  sq_array_[index] = index;
+  __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+
+  while (syscall(__NR_io_uring_enter, ring_fd_, 1, 0, 0, nullptr, 0) < 0) {
+    if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+      // the entry stays in the ring, failing it here could complete the request twice
+      throw Exception(ExceptionType::UNKNOWN_TYPE, std::string("io_uring_enter failed: ") + strerror(errno));
+    }
+  }
+}
+
+void AsyncDiskManager::ReapLoop() {
+  while (true) {
+    if (syscall(__NR_io_uring_enter, ring_fd_, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 && errno != EINTR) {
+      LOG_DEBUG("io_uring_enter failed while waiting for completions: %s", strerror(errno));
+    }
+    // only the reaper moves the head
+    unsigned head = *cq_head_;
+    unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    bool stop = false;
+    for (; head != tail; head++) {
+      const struct io_uring_cqe *cqe = &cqes_[head & *cq_mask_];
+      auto *request = reinterpret_cast<DiskRequest *>(cqe->user_data);
+      if (request == nullptr) {
+        stop = true;
+      } else {
+        Complete(request, cqe->res);
+      }
+    }
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    if (stop) {
+      return;
+    }
+  }
+}
+
+void AsyncDiskManager::TearDownIoUring() {
+  if (sqes_ != nullptr) {
+    munmap(sqes_, sqes_size_);
+    sqes_ = nullptr;
+  }
+  if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+    munmap(cq_ring_, cq_ring_size_);
+  }
+  cq_ring_ = nullptr;
+  if (sq_ring_ != nullptr) {
+    munmap(sq_ring_, sq_ring_size_);
+    sq_ring_ = nullptr;
+  }
+  if (ring_fd_ >= 0) {
+    close(ring_fd_);
+    ring_fd_ = -1;
+  }
+}
+
+#else
+
+auto AsyncDiskManager::SetUpIoUring() -> bool { return false; }
+
+void AsyncDiskManager::SubmitToIoUring(DiskRequest *request) {
+  UNREACHABLE("io_uring is not available");
+}
+
+void AsyncDiskManager::ReapLoop() {}
+
+void AsyncDiskManager::TearDownIoUring() {}
+
+#endif
+
+}  // namespace bustub
@@ -0,0 +1,410 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// checksum_disk_manager.cpp
+//
+// Identification: src/storage/disk/checksum_disk_manager.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/checksum_disk_manager.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+
+#include "common/exception.h"
+#include "common/logger.h"
+#include "common/util/crc32c.h"
+
+namespace bustub {
+
+namespace {
+
+/** The header page of a batch in the double-write buffer. The page images of the batch follow it. */
+struct DoubleWriteHeader {
+  uint32_t magic_;
+  /** Checksum of the header page, computed with this field set to 0. */
+  uint32_t checksum_;
+  uint64_t cycle_;
+  uint64_t sequence_;
+  uint32_t num_pages_;
+  uint32_t padding_;
+};
+
+/** Where a page image of a batch came from and what it should checksum to. */
+struct DoubleWriteEntry {
+  page_id_t page_id_;
+  uint32_t checksum_;
+};
+
+/** The header of the .crc file, the checksum entries of the pages follow it. */
+struct ChecksumFileHeader {
+  uint32_t magic_;
+  page_id_t num_unchecked_pages_;
+};
+
+constexpr uint32_t CHECKSUM_FILE_MAGIC = 0x43524342;
+constexpr uint32_t DOUBLE_WRITE_MAGIC = 0x42574442;
+constexpr size_t MAX_DOUBLE_WRITE_ENTRIES = (BUSTUB_PAGE_SIZE - sizeof(DoubleWriteHeader)) / sizeof(DoubleWriteEntry);
+
+auto HeaderChecksum(const char *header_page) -> uint32_t {
+  char page[BUSTUB_PAGE_SIZE];
+  memcpy(page, header_page, BUSTUB_PAGE_SIZE);
+  reinterpret_cast<DoubleWriteHeader *>(page)->checksum_ = 0;
+  return Crc32c::Compute(page, BUSTUB_PAGE_SIZE);
+}
+
+/** @return the checksum of a page of zeros, what a page never written reads as */
+auto ZeroPageChecksum() -> uint32_t {
+  static const uint32_t checksum = [] {
+    std::vector<char> page(BUSTUB_PAGE_SIZE, 0);
+    return ChecksumDiskManager::PageChecksum(page.data());
+  }();
+  return checksum;
+}
+
+}  // namespace
+
+ChecksumDiskManager::ChecksumDiskManager(const std::string &db_file, size_t double_write_pages)
+    : DiskManager(db_file) {
+  std::string stem = file_name_.substr(0, file_name_.rfind('.'));
+  crc_name_ = stem + ".crc";
+  crc_fd_ = open(crc_name_.c_str(), O_RDWR | O_CREAT, 0644);
+  if (crc_fd_ < 0) {
+    throw Exception("can't open checksum file");
+  }
+  if (double_write_pages > 0) {
+    // a header page and at least one page image
+    double_write_pages_ = std::max<size_t>(double_write_pages, 2);
+    dwb_name_ = stem + ".dwb";
+    dwb_fd_ = open(dwb_name_.c_str(), O_RDWR | O_CREAT, 0644);
+    if (dwb_fd_ < 0) {
+      throw Exception("can't open double-write buffer file");
+    }
+  }
+  static_assert(sizeof(ChecksumFileHeader) == sizeof(ChecksumEntry), "the entries are indexed by page id + 1");
+  page_id_t num_pages = GetNumPages();
+  ChecksumFileHeader header{0, 0};
+  if (num_pages > 0 && pread(crc_fd_, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header)) &&
+      header.magic_ == CHECKSUM_FILE_MAGIC) {
+    num_unchecked_pages_ = header.num_unchecked_pages_;
+    checksums_.resize(std::max<size_t>(std::max(GetFileSize(crc_name_), 0) / sizeof(ChecksumEntry), 1) - 1);
+    size_t length = checksums_.size() * sizeof(ChecksumEntry);
+    if (pread(crc_fd_, checksums_.data(), length, sizeof(header)) != static_cast<ssize_t>(length)) {
+      throw Exception("can't read checksum file");
+    }
+    return;
+  }
+
+  // A new database, whatever the files hold belongs to a database file that was removed. Or a database file without
+  // checksums yet, its pages stay unchecked until they are written. The header is synced, without it every page with
+  // a checksum would fail verification.
+  if (num_pages > 0) {
+    LOG_WARN("%s has no checksums, its %d pages are unchecked", file_name_.c_str(), num_pages);
+  }
+  num_unchecked_pages_ = num_pages;
+  header = {CHECKSUM_FILE_MAGIC, num_pages};
+  if (ftruncate(crc_fd_, 0) != 0 || pwrite(crc_fd_, &header, sizeof(header), 0) != sizeof(header) ||
+      fdatasync(crc_fd_) != 0) {
+    throw Exception("can't write checksum file");
+  }
+  if (num_pages == 0 && dwb_fd_ >= 0 && ftruncate(dwb_fd_, 0) != 0) {
+    LOG_DEBUG("I/O error while truncating the double-write buffer");
+  }
+}
+
+ChecksumDiskManager::~ChecksumDiskManager() { ShutDown(); }
+
+void ChecksumDiskManager::ShutDown() {
+  if (shut_down_) {
+    return;
+  }
+  shut_down_ = true;
+  if (dwb_fd_ >= 0) {
+    std::scoped_lock lock(double_write_latch_);
+    if (dwb_slot_ > 0) {
+      // every page with an image in the buffer is in place now, a clean restart has nothing to repair
+      SyncInPlace();
+      if (ftruncate(dwb_fd_, 0) != 0) {
+        LOG_DEBUG("I/O error while emptying the double-write buffer");
+      }
+    }
+    close(dwb_fd_);
+    dwb_fd_ = -1;
+  } else {
+    // nothing else ever syncs the checksums written in place
+    SyncInPlace();
+  }
+  close(crc_fd_);
+  crc_fd_ = -1;
+  DiskManager::ShutDown();
+}
+
+void ChecksumDiskManager::WritePage(page_id_t page_id, const char *page_data) {
+  if (dwb_fd_ >= 0) {
+    WriteGrouped(page_id, page_data);
+    return;
+  }
+  WriteCopyInPlace(page_id, page_data);
+}
+
+void ChecksumDiskManager::WriteGrouped(page_id_t page_id, const char *page_data) {
+  EnsureRepaired();
+  std::unique_lock lock(group_latch_);
+  group_pages_.emplace_back(page_id, page_data);
+  // the group after the one being written, if any, is the one our page is in
+  uint64_t group = num_groups_ + (group_leader_ ? 1 : 0);
+  group_cv_.wait(lock, [&] { return num_groups_ > group || !group_leader_; });
+  if (num_groups_ > group) {
+    return;
+  }
+
+  // Nobody writes a group: write ours, with every page that joined it meanwhile. The pages arriving while we write
+  // wait for the next group, whose first waiter to wake up writes it.
+  group_leader_ = true;
+  std::vector<std::pair<page_id_t, const char *>> pages;
+  pages.swap(group_pages_);
+  lock.unlock();
+  {
+    std::scoped_lock double_write_lock(double_write_latch_);
+    for (size_t start = 0; start < pages.size(); start += MaxBatchSize()) {
+      WriteBatch(pages.data() + start, std::min(MaxBatchSize(), pages.size() - start));
+    }
+  }
+  lock.lock();
+  num_groups_++;
+  group_leader_ = false;
+  group_cv_.notify_all();
+}
+
+void ChecksumDiskManager::WritePages(const std::vector<std::pair<page_id_t, const char *>> &pages) {
+  if (dwb_fd_ < 0) {
+    for (const auto &[page_id, page_data] : pages) {
+      WriteCopyInPlace(page_id, page_data);
+    }
+    return;
+  }
+  EnsureRepaired();
+  std::scoped_lock lock(double_write_latch_);
+  for (size_t start = 0; start < pages.size(); start += MaxBatchSize()) {
+    WriteBatch(pages.data() + start, std::min(MaxBatchSize(), pages.size() - start));
+  }
+}
+
+auto ChecksumDiskManager::RepairTornPages() -> size_t {
+  if (dwb_fd_ < 0) {
+    return 0;
+  }
+  size_t num_repaired_pages = 0;
+  std::call_once(repair_once_, [&] { num_repaired_pages = RepairFromDoubleWriteBuffer(); });
+  return num_repaired_pages;
+}
+
+void ChecksumDiskManager::WriteInPlace(page_id_t page_id, const char *page_data, uint32_t checksum) {
+  // the page latch keeps two writers of the page, e.g. the page cleaner and a flush, from leaving the data of one and
+  // the checksum of the other
+  std::unique_lock page_lock(PageLatch(page_id));
+  ChecksumEntry entry{checksum, StoredEntry(page_id).current_};
+  if (entry.previous_ == 0) {
+    // the first write of the page through us, it holds zeros or was written before the file had checksums
+    if (page_id < num_unchecked_pages_) {
+      std::vector<char> page(BUSTUB_PAGE_SIZE);
+      DiskManager::ReadPage(page_id, page.data());
+      entry.previous_ = PageChecksum(page.data());
+    } else {
+      entry.previous_ = ZeroPageChecksum();
+    }
+  }
+  {
+    std::unique_lock lock(latch_);
+    if (static_cast<size_t>(page_id) >= checksums_.size()) {
+      checksums_.resize(page_id + 1, ChecksumEntry{0, 0});
+    }
+    checksums_[page_id] = entry;
+  }
+  // the entry goes first, a crash before the page is written leaves the page matching the previous checksum
+  if (pwrite(crc_fd_, &entry, sizeof(entry), static_cast<off_t>(page_id + 1) * sizeof(entry)) != sizeof(entry)) {
+    LOG_DEBUG("I/O error while writing the checksum of page %d", page_id);
+  }
+  DiskManager::WritePage(page_id, page_data);
+}
+
+void ChecksumDiskManager::WriteCopyInPlace(page_id_t page_id, const char *page_data) {
+  // the caller may change its buffer meanwhile, e.g. a flush of a frame that is not latched, what is written must be
+  // what was checksummed
+  char page[BUSTUB_PAGE_SIZE];
+  memcpy(page, page_data, BUSTUB_PAGE_SIZE);
+  WriteInPlace(page_id, page, PageChecksum(page));
+}
+
+void ChecksumDiskManager::WriteBatch(const std::pair<page_id_t, const char *> *pages, size_t num_pages) {
+  if (dwb_slot_ + num_pages + 1 > double_write_pages_) {
+    // the batches at the start of the buffer are about to be overwritten, their pages must not need them anymore
+    SyncInPlace();
+    dwb_slot_ = 0;
+    dwb_cycle_++;
+  }
+
+  // a page repaired from the buffer is as good as written, it may refer to page ids allocated since the last write
+  free_space_map_->SyncAllocations();
+  std::vector<char> buffer((num_pages + 1) * BUSTUB_PAGE_SIZE, 0);
+  auto *header = reinterpret_cast<DoubleWriteHeader *>(buffer.data());
+  auto *entries = reinterpret_cast<DoubleWriteEntry *>(buffer.data() + sizeof(DoubleWriteHeader));
+  *header = {DOUBLE_WRITE_MAGIC, 0, dwb_cycle_, dwb_sequence_++, static_cast<uint32_t>(num_pages), 0};
+  for (size_t i = 0; i < num_pages; i++) {
+    char *image = buffer.data() + (i + 1) * BUSTUB_PAGE_SIZE;
+    memcpy(image, pages[i].second, BUSTUB_PAGE_SIZE);
+    entries[i] = {pages[i].first, PageChecksum(image)};
+  }
+  header->checksum_ = HeaderChecksum(buffer.data());
+
+  auto offset = static_cast<off_t>(dwb_slot_ * BUSTUB_PAGE_SIZE);
+  if (pwrite(dwb_fd_, buffer.data(), buffer.size(), offset) != static_cast<ssize_t>(buffer.size()) ||
+      fdatasync(dwb_fd_) != 0) {
+    LOG_DEBUG("I/O error while writing the double-write buffer");
+  }
+  dwb_slot_ += num_pages + 1;
+  num_double_write_batches_++;
+
+  for (size_t i = 0; i < num_pages; i++) {
+    WriteInPlace(entries[i].page_id_, buffer.data() + (i + 1) * BUSTUB_PAGE_SIZE, entries[i].checksum_);
+  }
+}
+
+auto ChecksumDiskManager::MaxBatchSize() const -> size_t {
+  return std::min(MAX_DOUBLE_WRITE_ENTRIES, double_write_pages_ - 1);
+}
+
+void ChecksumDiskManager::EnsureRepaired() {
+  if (dwb_fd_ >= 0) {
+    RepairTornPages();
+  }
+}
+
+auto ChecksumDiskManager::RepairFromDoubleWriteBuffer() -> size_t {
+  std::scoped_lock lock(double_write_latch_);
+  size_t num_slots = std::max(GetFileSize(dwb_name_), 0) / BUSTUB_PAGE_SIZE;
+  std::vector<char> buffer(num_slots * BUSTUB_PAGE_SIZE);
+  if (pread(dwb_fd_, buffer.data(), buffer.size(), 0) != static_cast<ssize_t>(buffer.size())) {
+    LOG_DEBUG("I/O error while reading the double-write buffer");
+    return 0;
+  }
+
+  // A batch whose header got torn, or was partly overwritten after a wrap around, is skipped as a whole or image by
+  // image. Batches of earlier cycles were synced in place before the buffer wrapped, their images may be stale.
+  auto header_at = [&](size_t slot) {
+    return reinterpret_cast<const DoubleWriteHeader *>(buffer.data() + slot * BUSTUB_PAGE_SIZE);
+  };
+  auto valid_header = [&](size_t slot) {
+    const auto *header = header_at(slot);
+    return header->magic_ == DOUBLE_WRITE_MAGIC && header->num_pages_ <= MAX_DOUBLE_WRITE_ENTRIES &&
+           header->checksum_ == HeaderChecksum(reinterpret_cast<const char *>(header));
+  };
+  uint64_t cycle = 0;
+  for (size_t slot = 0; slot < num_slots; slot++) {
+    if (valid_header(slot)) {
+      cycle = std::max(cycle, header_at(slot)->cycle_);
+    }
+  }
+
+  // the newest image of every page
+  struct Image {
+    uint64_t sequence_;
+    const char *data_;
+    uint32_t checksum_;
+  };
+  std::unordered_map<page_id_t, Image> images;
+  for (size_t slot = 0; slot < num_slots; slot++) {
+    if (!valid_header(slot) || header_at(slot)->cycle_ != cycle) {
+      continue;
+    }
+    const auto *header = header_at(slot);
+    const char *page = buffer.data() + slot * BUSTUB_PAGE_SIZE;
+    const auto *entries = reinterpret_cast<const DoubleWriteEntry *>(page + sizeof(DoubleWriteHeader));
+    for (size_t i = 0; i < header->num_pages_ && slot + i + 1 < num_slots; i++) {
+      const char *image = page + (i + 1) * BUSTUB_PAGE_SIZE;
+      auto it = images.find(entries[i].page_id_);
+      // a page written twice in a batch was written in place in order, the later image wins
+      bool newer = it == images.end() || it->second.sequence_ <= header->sequence_;
+      if (newer && PageChecksum(image) == entries[i].checksum_) {
+        images[entries[i].page_id_] = {header->sequence_, image, entries[i].checksum_};
+      }
+    }
+  }
+
+  // Every write in place after the newest image of a page has an image of its own, so a page that does not match its
+  // newest image did not make it to disk whole.
+  size_t num_repaired_pages = 0;
+  std::vector<char> page(BUSTUB_PAGE_SIZE);
+  for (const auto &[page_id, image] : images) {
+    DiskManager::ReadPage(page_id, page.data());
+    if (PageChecksum(page.data()) != image.checksum_) {
+      LOG_WARN("page %d was torn, restoring it from the double-write buffer", page_id);
+      WriteInPlace(page_id, image.data_, image.checksum_);
+      num_repaired_pages++;
+    } else if (StoredEntry(page_id).current_ != image.checksum_) {
+      // the page made it, its checksum did not
+      WriteInPlace(page_id, image.data_, image.checksum_);
+    }
+  }
+
+  SyncInPlace();
+  if (ftruncate(dwb_fd_, 0) != 0) {
+    LOG_DEBUG("I/O error while emptying the double-write buffer");
+  }
+  dwb_slot_ = 0;
+  dwb_cycle_ = cycle + 1;
+  return num_repaired_pages;
+}
+
+void ChecksumDiskManager::SyncInPlace() {
+  if (fdatasync(db_fd_) != 0 || fdatasync(crc_fd_) != 0) {
+    LOG_DEBUG("I/O error while syncing the database file");
+  }
+}
+
+void ChecksumDiskManager::ReadPage(page_id_t page_id, char *page_data) {
+  if (!VerifyPage(page_id, page_data)) {
+    num_checksum_failures_++;
+    LOG_WARN("page %d does not match its checksum, it was torn or damaged", page_id);
+  }
+}
+
+auto ChecksumDiskManager::VerifyPage(page_id_t page_id, char *page_data) -> bool {
+  EnsureRepaired();
+  std::shared_lock page_lock(PageLatch(page_id));
+  DiskManager::ReadPage(page_id, page_data);
+  ChecksumEntry entry = StoredEntry(page_id);
+  page_lock.unlock();
+  uint32_t checksum = PageChecksum(page_data);
+  if (entry.current_ == 0) {
+    return page_id < num_unchecked_pages_ || checksum == ZeroPageChecksum();
+  }
+  return checksum == entry.current_ || checksum == entry.previous_;
+}
+
+auto ChecksumDiskManager::HasChecksum(page_id_t page_id) -> bool { return StoredEntry(page_id).current_ != 0; }
+
+auto ChecksumDiskManager::GetNumPages() -> page_id_t {
+  return (std::max(GetFileSize(file_name_), 0) + BUSTUB_PAGE_SIZE - 1) / BUSTUB_PAGE_SIZE;
+}
+
+auto ChecksumDiskManager::PageChecksum(const char *page_data) -> uint32_t {
+  uint32_t checksum = Crc32c::Compute(page_data, BUSTUB_PAGE_SIZE);
+  // 0 marks a page without a checksum
+  return checksum == 0 ? 1 : checksum;
+}
+
+auto ChecksumDiskManager::StoredEntry(page_id_t page_id) -> ChecksumEntry {
+  std::shared_lock lock(latch_);
+  return page_id >= 0 && static_cast<size_t>(page_id) < checksums_.size() ? checksums_[page_id] : ChecksumEntry{0, 0};
+}
+
+}  // namespace bustub
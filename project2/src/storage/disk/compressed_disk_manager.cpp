@@ -0,0 +1,410 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compressed_disk_manager.cpp
+//
+// Identification: src/storage/disk/compressed_disk_manager.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/compressed_disk_manager.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iterator>
+#include <mutex>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "common/exception.h"
+#include "common/logger.h"
+#include "common/util/crc32c.h"
+
+namespace bustub {
+
+namespace {
+
+/**
+ * The page map file starts with this, then the codec name, the number of pages and their extents. The journal records
+ * follow, each one the page id, its new extent and the checksum of both.
+ */
+constexpr uint32_t PAGE_MAP_MAGIC = 0x4a505442;
+
+/** The journal is replaced by a snapshot once it holds more records than this, or than the page map. */
+constexpr uint64_t MIN_JOURNAL_RECORDS = 1024;
+
+/** Sync the directory of a file, so that a file renamed into it survives a crash of the OS. */
+auto SyncDirectory(const std::string &file_name) -> bool {
+  std::string directory = std::filesystem::path(file_name).parent_path().string();
+  int fd = open(directory.empty() ? "." : directory.c_str(), O_RDONLY | O_DIRECTORY);
+  if (fd < 0) {
+    return false;
+  }
+  bool synced = fsync(fd) == 0;
+  close(fd);
+  return synced;
+}
+
+}  // namespace
+
+CompressedDiskManager::CompressedDiskManager(const std::string &db_file, std::unique_ptr<PageCodec> codec)
+    : DiskManager(db_file), codec_(std::move(codec)) {
+  if (codec_ == nullptr) {
+    codec_ = std::make_unique<LzPageCodec>();
+  }
+  map_name_ = file_name_.substr(0, file_name_.rfind('.')) + ".pagemap";
+  try {
+    LoadPageMap();
+  } catch (const Exception &) {
+    if (map_fd_ >= 0) {
+      close(map_fd_);
+    }
+    throw;
+  }
+  // the free space map is seeded from the page map, the size of the file says nothing about the page ids in it
+  OpenFreeSpaceMap();
+}
+
+CompressedDiskManager::~CompressedDiskManager() { ShutDown(); }
+
+void CompressedDiskManager::ShutDown() {
+  if (shut_down_) {
+    return;
+  }
+  shut_down_ = true;
+  SavePageMap();
+  close(map_fd_);
+  map_fd_ = -1;
+  DiskManager::ShutDown();
+}
+
+/**
+ * Compress the page and write it to its extent, moving it if the size in slots changed
+ */
+void CompressedDiskManager::WritePage(page_id_t page_id, const char *page_data) {
+  // only keep the compressed page if it saves at least a slot
+  char compressed[BUSTUB_PAGE_SIZE];
+  size_t length = codec_->Compress(page_data, BUSTUB_PAGE_SIZE, compressed, BUSTUB_PAGE_SIZE - SLOT_SIZE);
+  const char *data = compressed;
+  if (length == 0) {
+    length = BUSTUB_PAGE_SIZE;
+    data = page_data;
+  }
+  size_t num_slots = (length + SLOT_SIZE - 1) / SLOT_SIZE;
+  uint32_t checksum = Crc32c::Compute(data, length);
+  free_space_map_->SyncAllocations();
+
+  std::unique_lock page_lock(PageLatch(page_id));
+  uint32_t slot;
+  // the number of records the journal must have synced before the extent is written, 0 if none
+  uint64_t sync_records = 0;
+  bool save_page_map;
+  {
+    std::unique_lock lock(latch_);
+    num_writes_ += 1;
+    auto it = page_map_.find(page_id);
+    if (it != page_map_.end() && it->second.num_slots_ == num_slots) {
+      slot = it->second.slot_;
+    } else {
+      if (it != page_map_.end()) {
+        FreeExtent(it->second.slot_, it->second.num_slots_);
+      }
+      slot = AllocateExtent(num_slots);
+      if (slot < fresh_slot_) {
+        // the page map file may still point another page here
+        sync_records = num_records_ + 1;
+      }
+      fresh_slot_ = std::max<uint32_t>(fresh_slot_, slot + num_slots);
+    }
+    Extent extent{slot, static_cast<uint16_t>(num_slots), static_cast<uint16_t>(length), checksum};
+    page_map_[page_id] = extent;
+    AppendToJournal(page_id, extent);
+    save_page_map = num_journal_records_ > std::max<uint64_t>(MIN_JOURNAL_RECORDS, page_map_.size());
+  }
+  if (sync_records > 0) {
+    SyncJournal(sync_records);
+  }
+
+  ssize_t write_count = pwrite(db_fd_, data, length, static_cast<off_t>(slot) * SLOT_SIZE);
+  // check for I/O error
+  if (write_count < 0) {
+    LOG_DEBUG("I/O error while writing");
+  } else if (static_cast<size_t>(write_count) < length) {
+    LOG_DEBUG("Wrote less than a page");
+  }
+  page_lock.unlock();
+  if (save_page_map) {
+    SavePageMap();
+  }
+}
+
+/**
+ * Read the extent of the page and decompress it into the given memory area
+ */
+void CompressedDiskManager::ReadPage(page_id_t page_id, char *page_data) {
+  std::shared_lock page_lock(PageLatch(page_id));
+  Extent extent;
+  {
+    std::shared_lock lock(latch_);
+    auto it = page_map_.find(page_id);
+    if (it == page_map_.end()) {
+      memset(page_data, 0, BUSTUB_PAGE_SIZE);
+      return;
+    }
+    extent = it->second;
+  }
+  char compressed[BUSTUB_PAGE_SIZE];
+  char *buffer = extent.length_ == BUSTUB_PAGE_SIZE ? page_data : compressed;
+  ssize_t read_count = pread(db_fd_, buffer, extent.length_, static_cast<off_t>(extent.slot_) * SLOT_SIZE);
+  page_lock.unlock();
+
+  if (read_count != extent.length_) {
+    LOG_DEBUG("I/O error while reading");
+    memset(page_data, 0, BUSTUB_PAGE_SIZE);
+    return;
+  }
+  if (Crc32c::Compute(buffer, extent.length_) != extent.checksum_) {
+    // the write of the page did not make it to disk before a crash of the OS
+    LOG_DEBUG("page %d does not match the checksum of its extent", page_id);
+    memset(page_data, 0, BUSTUB_PAGE_SIZE);
+    return;
+  }
+  if (buffer == compressed && !codec_->Decompress(compressed, extent.length_, page_data, BUSTUB_PAGE_SIZE)) {
+    LOG_DEBUG("page %d does not decompress", page_id);
+    memset(page_data, 0, BUSTUB_PAGE_SIZE);
+  }
+}
+
+auto CompressedDiskManager::GetNumFilePages() -> page_id_t {
+  std::shared_lock lock(latch_);
+  page_id_t num_pages = 0;
+  for (const auto &[page_id, extent] : page_map_) {
+    num_pages = std::max(num_pages, page_id + 1);
+  }
+  return num_pages;
+}
+
+auto CompressedDiskManager::GetStoredBytes() -> size_t {
+  std::shared_lock lock(latch_);
+  return static_cast<size_t>(next_slot_) * SLOT_SIZE;
+}
+
+auto CompressedDiskManager::AllocateExtent(size_t num_slots) -> uint32_t {
+  // take the smallest free extent that is large enough, and give back what is left of it
+  auto it = free_by_size_.lower_bound({num_slots, 0});
+  if (it == free_by_size_.end()) {
+    uint32_t slot = next_slot_;
+    next_slot_ += num_slots;
+    return slot;
+  }
+  auto [free_slots, slot] = *it;
+  free_by_size_.erase(it);
+  free_by_slot_.erase(slot);
+  if (free_slots > num_slots) {
+    FreeExtent(slot + num_slots, free_slots - num_slots);
+  }
+  return slot;
+}
+
+void CompressedDiskManager::FreeExtent(uint32_t slot, size_t num_slots) {
+  // merge with the free extent that ends where this one starts, and the one that starts where it ends
+  auto next = free_by_slot_.lower_bound(slot);
+  if (next != free_by_slot_.begin()) {
+    auto prev = std::prev(next);
+    if (prev->first + prev->second == slot) {
+      slot = prev->first;
+      num_slots += prev->second;
+      free_by_size_.erase({prev->second, prev->first});
+      free_by_slot_.erase(prev);
+    }
+  }
+  if (next != free_by_slot_.end() && slot + num_slots == next->first) {
+    num_slots += next->second;
+    free_by_size_.erase({next->second, next->first});
+    free_by_slot_.erase(next);
+  }
+  if (slot + num_slots == next_slot_) {
+    // the end of the file is not kept as a free extent
+    next_slot_ = slot;
+    return;
+  }
+  free_by_slot_[slot] = num_slots;
+  free_by_size_.emplace(num_slots, slot);
+}
+
+void CompressedDiskManager::LoadPageMap() {
+  map_fd_ = open(map_name_.c_str(), O_RDWR);
+  if (map_fd_ < 0) {
+    if (GetFileSize(file_name_) > 0) {
+      throw Exception("compressed db file has no page map");
+    }
+    if (!SavePageMap()) {
+      throw Exception("can't create page map file");
+    }
+    return;
+  }
+
+  struct stat map_stat;
+  std::vector<char> buffer;
+  if (fstat(map_fd_, &map_stat) == 0) {
+    buffer.resize(map_stat.st_size);
+  }
+  if (pread(map_fd_, buffer.data(), buffer.size(), 0) != static_cast<ssize_t>(buffer.size())) {
+    throw Exception("can't read page map file");
+  }
+  size_t pos = 0;
+  auto read = [&](void *dst, size_t size) {
+    if (pos + size > buffer.size()) {
+      return false;
+    }
+    memcpy(dst, buffer.data() + pos, size);
+    pos += size;
+    return true;
+  };
+
+  uint32_t magic = 0;
+  uint32_t name_length = 0;
+  if (!read(&magic, sizeof(magic)) || magic != PAGE_MAP_MAGIC || !read(&name_length, sizeof(name_length)) ||
+      name_length > 64) {
+    throw Exception("bad page map file");
+  }
+  std::string codec_name(name_length, '\0');
+  uint64_t num_pages = 0;
+  if (!read(codec_name.data(), codec_name.size()) || !read(&num_pages, sizeof(num_pages))) {
+    throw Exception("bad page map file");
+  }
+  if (codec_name != codec_->Name()) {
+    throw Exception("db file was compressed with the " + codec_name + " codec");
+  }
+  for (uint64_t i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    Extent extent;
+    if (!read(&page_id, sizeof(page_id)) || !read(&extent, sizeof(extent))) {
+      throw Exception("bad page map file");
+    }
+    page_map_[page_id] = extent;
+  }
+
+  // the journal ends at its first torn record, whatever follows was never synced
+  for (;;) {
+    size_t record_pos = pos;
+    page_id_t page_id;
+    Extent extent;
+    uint32_t checksum;
+    if (!read(&page_id, sizeof(page_id)) || !read(&extent, sizeof(extent)) || !read(&checksum, sizeof(checksum)) ||
+        Crc32c::Compute(buffer.data() + record_pos, sizeof(page_id) + sizeof(extent)) != checksum) {
+      pos = record_pos;
+      break;
+    }
+    page_map_[page_id] = extent;
+    num_journal_records_++;
+  }
+  journal_end_ = static_cast<off_t>(pos);
+  if (pos < buffer.size()) {
+    // records appended from here on must not be followed by stale ones after a crash
+    if (ftruncate(map_fd_, journal_end_) != 0 || fdatasync(map_fd_) != 0) {
+      throw Exception("can't truncate the journal of the page map file");
+    }
+  }
+
+  // the gaps between the extents in use are free
+  std::vector<std::pair<uint32_t, uint32_t>> extents;
+  extents.reserve(page_map_.size());
+  for (const auto &[page_id, extent] : page_map_) {
+    extents.emplace_back(extent.slot_, extent.num_slots_);
+  }
+  std::sort(extents.begin(), extents.end());
+  uint32_t slot = 0;
+  for (const auto &[extent_slot, num_slots] : extents) {
+    if (extent_slot > slot) {
+      FreeExtent(slot, extent_slot - slot);
+    }
+    slot = std::max(slot, extent_slot + num_slots);
+  }
+  next_slot_ = slot;
+  fresh_slot_ = slot;
+}
+
+auto CompressedDiskManager::SavePageMap() -> bool {
+  std::scoped_lock lock(journal_latch_, latch_);
+  std::string codec_name = codec_->Name();
+  auto name_length = static_cast<uint32_t>(codec_name.size());
+  uint64_t num_pages = page_map_.size();
+  std::vector<char> buffer;
+  auto append = [&buffer](const void *src, size_t size) {
+    buffer.insert(buffer.end(), static_cast<const char *>(src), static_cast<const char *>(src) + size);
+  };
+  append(&PAGE_MAP_MAGIC, sizeof(PAGE_MAP_MAGIC));
+  append(&name_length, sizeof(name_length));
+  append(codec_name.data(), codec_name.size());
+  append(&num_pages, sizeof(num_pages));
+  for (const auto &[page_id, extent] : page_map_) {
+    append(&page_id, sizeof(page_id));
+    append(&extent, sizeof(extent));
+  }
+
+  // the snapshot only replaces the file once it is complete and synced
+  std::string tmp_name = map_name_ + ".tmp";
+  int fd = open(tmp_name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    LOG_DEBUG("can't open %s", tmp_name.c_str());
+    return false;
+  }
+  if (pwrite(fd, buffer.data(), buffer.size(), 0) != static_cast<ssize_t>(buffer.size()) || fdatasync(fd) != 0 ||
+      rename(tmp_name.c_str(), map_name_.c_str()) != 0 || !SyncDirectory(map_name_)) {
+    LOG_DEBUG("I/O error while writing the page map");
+    close(fd);
+    remove(tmp_name.c_str());
+    return false;
+  }
+  if (map_fd_ >= 0) {
+    close(map_fd_);
+  }
+  map_fd_ = fd;
+  journal_end_ = static_cast<off_t>(buffer.size());
+  num_journal_records_ = 0;
+  num_synced_records_ = num_records_;
+  fresh_slot_ = next_slot_;
+  return true;
+}
+
+void CompressedDiskManager::AppendToJournal(page_id_t page_id, const Extent &extent) {
+  char record[sizeof(page_id) + sizeof(extent) + sizeof(uint32_t)];
+  memcpy(record, &page_id, sizeof(page_id));
+  memcpy(record + sizeof(page_id), &extent, sizeof(extent));
+  uint32_t checksum = Crc32c::Compute(record, sizeof(page_id) + sizeof(extent));
+  memcpy(record + sizeof(page_id) + sizeof(extent), &checksum, sizeof(checksum));
+  // the extent is not written if its page could not be found again
+  if (pwrite(map_fd_, record, sizeof(record), journal_end_) != static_cast<ssize_t>(sizeof(record))) {
+    throw Exception("I/O error while writing the journal of the page map");
+  }
+  journal_end_ += static_cast<off_t>(sizeof(record));
+  num_journal_records_++;
+  num_records_++;
+}
+
+void CompressedDiskManager::SyncJournal(uint64_t num_records) {
+  std::scoped_lock lock(journal_latch_);
+  // whoever synced while we waited may have covered our record
+  if (num_synced_records_ >= num_records) {
+    return;
+  }
+  uint64_t num_appended_records;
+  {
+    std::shared_lock map_lock(latch_);
+    num_appended_records = num_records_;
+  }
+  if (fdatasync(map_fd_) != 0) {
+    throw Exception("I/O error while syncing the journal of the page map");
+  }
+  num_synced_records_ = num_appended_records;
+}
+
+}  // namespace bustub
@@ -10,8 +10,13 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 #include <mutex>  // NOLINT
@@ -30,7 +35,8 @@ static char *buffer_used;
  * Constructor: open/create a single database file & log file
  * @input db_file: database file name
  */
-DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
+DiskManager::DiskManager(const std::string &db_file, bool direct_io, bool persistent_free_space_map)
+    : persistent_free_space_map_(persistent_free_space_map), file_name_(db_file) {
   std::string::size_type n = file_name_.rfind('.');
   if (n == std::string::npos) {
     LOG_DEBUG("wrong file format");
@@ -38,93 +44,173 @@ DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
   }
   log_name_ = file_name_.substr(0, n) + ".log";
 
-  log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
-  // directory or file does not exist
-  if (!log_io_.is_open()) {
-    log_io_.clear();
-    // create a new file
-    log_io_.open(log_name_, std::ios::binary | std::ios::trunc | std::ios::out | std::ios::in);
-    if (!log_io_.is_open()) {
-      throw Exception("can't open dblog file");
-    }
+  // create the file if it does not exist, records are only ever appended
+  log_fd_ = open(log_name_.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+  if (log_fd_ < 0) {
+    throw Exception("can't open dblog file");
   }
 
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out | std::ios::in);
-    if (!db_io_.is_open()) {
+#ifdef O_DIRECT
+  if (direct_io) {
+    db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT | O_DIRECT, 0644);
+    direct_io_ = db_fd_ >= 0;
+    if (!direct_io_) {
+      // e.g. tmpfs refuses O_DIRECT with EINVAL
+      LOG_DEBUG("can't open db file with O_DIRECT (%s), using buffered I/O", strerror(errno));
+    }
+  }
+#endif
+  if (db_fd_ < 0) {
+    // create the file if it does not exist
+    db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT, 0644);
+    if (db_fd_ < 0) {
       throw Exception("can't open db file");
     }
   }
+
+  OpenFreeSpaceMap();
   buffer_used = nullptr;
 }
 
+void DiskManager::OpenFreeSpaceMap() {
+  std::string::size_type n = file_name_.rfind('.');
+  if (n == std::string::npos) {
+    return;
+  }
+  if (!persistent_free_space_map_) {
+    free_space_map_ = std::make_unique<FreeSpaceMap>(GetNumFilePages());
+    return;
+  }
+  free_space_map_ = std::make_unique<FreeSpaceMap>(file_name_.substr(0, n) + ".fsm", GetNumFilePages());
+}
+
+auto DiskManager::GetNumFilePages() -> page_id_t {
+  int file_size = std::max(GetFileSize(file_name_), 0);
+  return (file_size + BUSTUB_PAGE_SIZE - 1) / BUSTUB_PAGE_SIZE;
+}
+
+DiskManager::~DiskManager() {
+  if (db_fd_ >= 0) {
+    close(db_fd_);
+  }
+  if (log_fd_ >= 0) {
+    close(log_fd_);
+  }
+}
+
 /**
  * Close all file streams
  */
 void DiskManager::ShutDown() {
-  {
-    std::scoped_lock scoped_db_io_latch(db_io_latch_);
-    db_io_.close();
+  free_space_map_->Close();
+  if (db_fd_ >= 0) {
+    close(db_fd_);
+    db_fd_ = -1;
+  }
+  if (log_fd_ >= 0) {
+    close(log_fd_);
+    log_fd_ = -1;
   }
-  log_io_.close();
 }
 
+namespace {
+
+/**
+ * A page-aligned buffer per thread, that O_DIRECT page I/O goes through when the caller's buffer is not aligned.
+ */
+auto AlignedBounceBuffer() -> char * {
+  struct BounceBuffer {
+    char *data_ = static_cast<char *>(std::aligned_alloc(BUSTUB_PAGE_SIZE, BUSTUB_PAGE_SIZE));
+    ~BounceBuffer() { std::free(data_); }
+  };
+  thread_local BounceBuffer buffer;
+  return buffer.data_;
+}
+
+auto IsPageAligned(const char *data) -> bool { return reinterpret_cast<uintptr_t>(data) % BUSTUB_PAGE_SIZE == 0; }
+
+}  // namespace
+
 /**
  * Write the contents of the specified page into disk file
  */
 void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  size_t offset = static_cast<size_t>(page_id) * BUSTUB_PAGE_SIZE;
-  // set write cursor to offset
+  // the page may refer to page ids allocated since the last write, the free space map must not have them free
+  free_space_map_->SyncAllocations();
+  off_t offset = static_cast<off_t>(page_id) * BUSTUB_PAGE_SIZE;
   num_writes_ += 1;
-  db_io_.seekp(offset);
-  db_io_.write(page_data, BUSTUB_PAGE_SIZE);
+  if (direct_io_ && !IsPageAligned(page_data)) {
+    char *aligned = AlignedBounceBuffer();
+    memcpy(aligned, page_data, BUSTUB_PAGE_SIZE);
+    page_data = aligned;
+  }
+  // pwrite hands the page to the OS right away (or to the device with O_DIRECT), there is nothing to flush
+  ssize_t write_count = pwrite(db_fd_, page_data, BUSTUB_PAGE_SIZE, offset);
   // check for I/O error
-  if (db_io_.bad()) {
+  if (write_count < 0) {
     LOG_DEBUG("I/O error while writing");
-    return;
+  } else if (write_count < BUSTUB_PAGE_SIZE) {
+    LOG_DEBUG("Wrote less than a page");
   }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
 }
 
 /**
  * Read the contents of the specified page into the given memory area
  */
 void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  int offset = page_id * BUSTUB_PAGE_SIZE;
-  // check if read beyond file length
-  if (offset > GetFileSize(file_name_)) {
-    LOG_DEBUG("I/O error reading past end of file");
-    // std::cerr << "I/O error while reading" << std::endl;
-  } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, BUSTUB_PAGE_SIZE);
-    if (db_io_.bad()) {
-      LOG_DEBUG("I/O error while reading");
-      return;
-    }
-    // if file ends before reading BUSTUB_PAGE_SIZE
-    int read_count = db_io_.gcount();
-    if (read_count < BUSTUB_PAGE_SIZE) {
-      LOG_DEBUG("Read less than a page");
-      db_io_.clear();
-      // std::cerr << "Read less than a page" << std::endl;
-      memset(page_data + read_count, 0, BUSTUB_PAGE_SIZE - read_count);
-    }
+  off_t offset = static_cast<off_t>(page_id) * BUSTUB_PAGE_SIZE;
+  char *buffer = direct_io_ && !IsPageAligned(page_data) ? AlignedBounceBuffer() : page_data;
+  ssize_t read_count = pread(db_fd_, buffer, BUSTUB_PAGE_SIZE, offset);
+  if (read_count < 0) {
+    LOG_DEBUG("I/O error while reading");
+    return;
+  }
+  // if file ends before reading BUSTUB_PAGE_SIZE, including reads past the end of the file
+  if (read_count < BUSTUB_PAGE_SIZE) {
+    LOG_DEBUG("Read less than a page");
+    memset(buffer + read_count, 0, BUSTUB_PAGE_SIZE - read_count);
+  }
+  if (buffer != page_data) {
+    memcpy(page_data, buffer, BUSTUB_PAGE_SIZE);
+  }
+}
+
+/**
+ * Write the contents of the specified page into disk file, the future is ready right away
+ */
+auto DiskManager::WritePageAsync(page_id_t page_id, const char *page_data) -> std::future<void> {
+  std::promise<void> done;
+  WritePage(page_id, page_data);
+  done.set_value();
+  return done.get_future();
+}
+
+/**
+ * Read the contents of the specified page into the given memory area, the future is ready right away
+ */
+auto DiskManager::ReadPageAsync(page_id_t page_id, char *page_data) -> std::future<void> {
+  std::promise<void> done;
+  ReadPage(page_id, page_data);
+  done.set_value();
+  return done.get_future();
+}
+
+void DiskManager::WritePages(const std::vector<std::pair<page_id_t, const char *>> &pages) {
+  for (const auto &[page_id, page_data] : pages) {
+    WritePage(page_id, page_data);
   }
 }
 
+auto DiskManager::AllocatePage(page_id_t near_page_id, uint32_t stride, uint32_t offset) -> page_id_t {
+  return free_space_map_->Allocate(near_page_id, stride, offset);
+}
+
+void DiskManager::DeallocatePage(page_id_t page_id) { free_space_map_->Deallocate(page_id); }
+
 /**
  * Write the contents of the log into disk file
- * Only return when sync is done, and only perform sequence write
+ * Only return when sync is done, and only perform sequence write. The data is made durable with a single fdatasync, so
+ * a log manager that batches the records of many transactions into one call pays for one sync per batch.
  */
 void DiskManager::WriteLog(char *log_data, int size) {
   // enforce swap log buffer
@@ -143,16 +229,25 @@ void DiskManager::WriteLog(char *log_data, int size) {
   }
 
   num_flushes_ += 1;
-  // sequence write
-  log_io_.write(log_data, size);
-
-  // check for I/O error
-  if (log_io_.bad()) {
-    LOG_DEBUG("I/O error while writing log");
+  // sequence write, O_APPEND puts the data at the end of the file
+  while (size > 0) {
+    ssize_t write_count = write(log_fd_, log_data, size);
+    if (write_count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      // check for I/O error
+      LOG_DEBUG("I/O error while writing log");
+      return;
+    }
+    log_data += write_count;
+    size -= static_cast<int>(write_count);
+  }
+  // needs to sync to keep disk file in sync, the file metadata other than its size is not needed to read the log back
+  if (fdatasync(log_fd_) < 0) {
+    LOG_DEBUG("I/O error while syncing log");
     return;
   }
-  // needs to flush to keep disk file in sync
-  log_io_.flush();
   flush_log_ = false;
 }
 
@@ -167,17 +262,14 @@ auto DiskManager::ReadLog(char *log_data, int size, int offset) -> bool {
     // LOG_DEBUG("file size is %d", GetFileSize(log_name_));
     return false;
   }
-  log_io_.seekp(offset);
-  log_io_.read(log_data, size);
+  ssize_t read_count = pread(log_fd_, log_data, size, offset);
 
-  if (log_io_.bad()) {
+  if (read_count < 0) {
     LOG_DEBUG("I/O error while reading log");
     return false;
   }
   // if log file ends before reading "size"
-  int read_count = log_io_.gcount();
   if (read_count < size) {
-    log_io_.clear();
     memset(log_data + read_count, 0, size - read_count);
   }
 
@@ -12,6 +12,7 @@
 
 #include "storage/disk/disk_manager_memory.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <cstring>
@@ -47,4 +48,95 @@ void DiskManagerMemory::ReadPage(page_id_t page_id, char *page_data) {
   memcpy(page_data, memory_ + offset, BUSTUB_PAGE_SIZE);
 }
 
+DiskManagerUnlimitedMemory::DiskManagerUnlimitedMemory(size_t reserve_pages)
+    : chunks_(std::make_unique<std::atomic<Chunk *>[]>(MAX_CHUNKS)) {
+  size_t num_chunks = std::min((reserve_pages + PAGES_PER_CHUNK - 1) / PAGES_PER_CHUNK, MAX_CHUNKS);
+  for (size_t i = 0; i < num_chunks; i++) {
+    GetChunk(i, true);
+  }
+}
+
+DiskManagerUnlimitedMemory::~DiskManagerUnlimitedMemory() {
+  for (size_t i = 0; i < MAX_CHUNKS; i++) {
+    Chunk *chunk = chunks_[i].load(std::memory_order_relaxed);
+    if (chunk == nullptr) {
+      continue;
+    }
+    for (auto &page : *chunk) {
+      delete page.load(std::memory_order_relaxed);
+    }
+    delete chunk;
+  }
+}
+
+/**
+ * Write the contents of the specified page into memory, creating the page if needed
+ */
+void DiskManagerUnlimitedMemory::WritePage(page_id_t page_id, const char *page_data) {
+  BUSTUB_ASSERT(page_id >= 0, "page id must not be negative");
+  auto latency = write_latency_us_.load(std::memory_order_relaxed);
+  if (latency > 0) {
+    std::this_thread::sleep_for(std::chrono::microseconds(latency));
+  }
+  ProtectedPage *page = GetPage(page_id, true);
+  std::unique_lock<std::shared_mutex> l_page(page->latch_);
+  memcpy(page->data_.data(), page_data, BUSTUB_PAGE_SIZE);
+}
+
+/**
+ * Read the contents of the specified page into the given memory area
+ */
+void DiskManagerUnlimitedMemory::ReadPage(page_id_t page_id, char *page_data) {
+  auto latency = read_latency_us_.load(std::memory_order_relaxed);
+  if (latency > 0) {
+    std::this_thread::sleep_for(std::chrono::microseconds(latency));
+  }
+  ProtectedPage *page = page_id < 0 ? nullptr : GetPage(page_id, false);
+  if (page == nullptr) {
+    LOG_WARN("page not exist");
+    return;
+  }
+  std::shared_lock<std::shared_mutex> l_page(page->latch_);
+  memcpy(page_data, page->data_.data(), BUSTUB_PAGE_SIZE);
+}
+
+void DiskManagerUnlimitedMemory::SetLatency(std::chrono::microseconds read_latency,
+                                            std::chrono::microseconds write_latency) {
+  read_latency_us_ = read_latency.count();
+  write_latency_us_ = write_latency.count();
+}
+
+auto DiskManagerUnlimitedMemory::GetChunk(size_t index, bool create) -> Chunk * {
+  Chunk *chunk = chunks_[index].load(std::memory_order_acquire);
+  if (chunk != nullptr || !create) {
+    return chunk;
+  }
+  // value-initialized, every page pointer starts out null
+  auto *new_chunk = new Chunk();
+  if (chunks_[index].compare_exchange_strong(chunk, new_chunk, std::memory_order_acq_rel)) {
+    return new_chunk;
+  }
+  // another writer published the chunk first, chunk now holds it
+  delete new_chunk;
+  return chunk;
+}
+
+auto DiskManagerUnlimitedMemory::GetPage(page_id_t page_id, bool create) -> ProtectedPage * {
+  Chunk *chunk = GetChunk(static_cast<size_t>(page_id) / PAGES_PER_CHUNK, create);
+  if (chunk == nullptr) {
+    return nullptr;
+  }
+  std::atomic<ProtectedPage *> &slot = (*chunk)[static_cast<size_t>(page_id) % PAGES_PER_CHUNK];
+  ProtectedPage *page = slot.load(std::memory_order_acquire);
+  if (page != nullptr || !create) {
+    return page;
+  }
+  auto *new_page = new ProtectedPage();
+  if (slot.compare_exchange_strong(page, new_page, std::memory_order_acq_rel)) {
+    return new_page;
+  }
+  delete new_page;
+  return page;
+}
+
 }  // namespace bustub
@@ -0,0 +1,255 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map.cpp
+//
+// Identification: src/storage/disk/free_space_map.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/free_space_map.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+
+#include "common/exception.h"
+#include "common/logger.h"
+
+namespace bustub {
+
+namespace {
+
+/** The meta page of the free space map file. The bitmap pages follow it. */
+struct FreeSpaceMeta {
+  uint32_t magic_;
+  page_id_t next_page_id_;
+  uint32_t num_bitmaps_;
+};
+
+constexpr uint32_t FREE_SPACE_MAP_MAGIC = 0x4d534642;
+
+}  // namespace
+
+FreeSpaceMap::FreeSpaceMap(const std::string &file_name, page_id_t num_file_pages) {
+  fd_ = open(file_name.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd_ < 0) {
+    throw Exception("can't open free space map file");
+  }
+
+  if (num_file_pages == 0) {
+    // a new database, whatever the file holds belongs to a database file that was removed
+    if (ftruncate(fd_, 0) != 0) {
+      LOG_DEBUG("I/O error while truncating the free space map");
+    }
+    return;
+  }
+
+  FreeSpaceMeta meta;
+  if (pread(fd_, &meta, sizeof(meta), 0) == static_cast<ssize_t>(sizeof(meta)) && meta.magic_ == FREE_SPACE_MAP_MAGIC) {
+    next_page_id_ = meta.next_page_id_;
+    bits_.resize(meta.num_bitmaps_ * WORDS_PER_BITMAP);
+    dirty_.resize(meta.num_bitmaps_);
+    for (size_t i = 0; i < meta.num_bitmaps_; i++) {
+      // a bitmap page that was never written reads as all free, short reads leave the zeros in place
+      if (pread(fd_, bits_.data() + i * WORDS_PER_BITMAP, BUSTUB_PAGE_SIZE,
+                static_cast<off_t>(i + 1) * BUSTUB_PAGE_SIZE) < 0) {
+        LOG_DEBUG("I/O error while reading the free space map");
+      }
+    }
+  }
+
+  // Allocate writes the bitmap page but not the meta page, so a page allocated after the last flush only shows up in
+  // the bitmap.
+  page_id_t stored_next_page_id = next_page_id_;
+  for (size_t i = bits_.size(); i > 0; i--) {
+    if (bits_[i - 1] != 0) {
+      auto highest = static_cast<page_id_t>((i - 1) * 64 + 63 - __builtin_clzll(bits_[i - 1]));
+      next_page_id_ = std::max(next_page_id_, highest + 1);
+      break;
+    }
+  }
+  for (page_id_t page_id = next_page_id_; page_id < num_file_pages; page_id++) {
+    SetBit(page_id, true);
+    dirty_[page_id / PAGES_PER_BITMAP] = true;
+  }
+  next_page_id_ = std::max(next_page_id_, num_file_pages);
+  meta_dirty_ = next_page_id_ != stored_next_page_id;
+  for (auto word : bits_) {
+    num_allocated_ += __builtin_popcountll(word);
+  }
+}
+
+FreeSpaceMap::FreeSpaceMap(page_id_t num_file_pages) {
+  for (page_id_t page_id = 0; page_id < num_file_pages; page_id++) {
+    SetBit(page_id, true);
+  }
+  next_page_id_ = num_file_pages;
+  num_allocated_ = num_file_pages;
+}
+
+FreeSpaceMap::~FreeSpaceMap() { Close(); }
+
+auto FreeSpaceMap::Allocate(page_id_t near_page_id, uint32_t stride, uint32_t offset) -> page_id_t {
+  BUSTUB_ASSERT(offset < stride, "offset must be below the stride");
+  std::scoped_lock lock(latch_);
+  if (cursor_stride_ != stride) {
+    cursor_stride_ = stride;
+    cursors_.resize(stride);
+    for (uint32_t i = 0; i < stride; i++) {
+      cursors_[i] = static_cast<page_id_t>(i);
+    }
+  }
+
+  page_id_t page_id = cursors_[offset];
+  if (near_page_id != INVALID_PAGE_ID && near_page_id >= page_id) {
+    // the first page id with our offset after the near page
+    page_id = near_page_id + 1;
+    page_id += static_cast<page_id_t>((offset + stride - static_cast<uint32_t>(page_id) % stride) % stride);
+  }
+  while (TestBit(page_id)) {
+    size_t word = page_id / 64;
+    if (stride == 1 && page_id % 64 == 0 && bits_[word] == ~0ULL) {
+      page_id += 64;
+    } else {
+      page_id += static_cast<page_id_t>(stride);
+    }
+  }
+  if (page_id == cursors_[offset]) {
+    cursors_[offset] = page_id + static_cast<page_id_t>(stride);
+  }
+
+  size_t num_bitmaps = dirty_.size();
+  SetBit(page_id, true);
+  num_allocated_++;
+  if (page_id >= next_page_id_) {
+    next_page_id_ = page_id + 1;
+    meta_dirty_ = true;
+  }
+  if (fd_ >= 0) {
+    WriteBitmap(page_id / PAGES_PER_BITMAP);
+    if (dirty_.size() != num_bitmaps) {
+      // the meta page tells how many bitmap pages to read back
+      WriteMeta();
+    }
+    num_allocations_++;
+  }
+  return page_id;
+}
+
+void FreeSpaceMap::SyncAllocations() {
+  std::scoped_lock sync_lock(sync_latch_);
+  int fd;
+  uint64_t num_allocations;
+  {
+    std::scoped_lock lock(latch_);
+    fd = fd_;
+    num_allocations = num_allocations_;
+  }
+  // whoever synced while we waited may have covered our allocations
+  if (fd < 0 || num_synced_allocations_ >= num_allocations) {
+    return;
+  }
+  if (fdatasync(fd) != 0) {
+    LOG_DEBUG("I/O error while syncing the free space map");
+  }
+  num_synced_allocations_ = num_allocations;
+}
+
+void FreeSpaceMap::Deallocate(page_id_t page_id) {
+  std::scoped_lock lock(latch_);
+  if (page_id < 0 || !TestBit(page_id)) {
+    return;
+  }
+  SetBit(page_id, false);
+  num_allocated_--;
+  dirty_[page_id / PAGES_PER_BITMAP] = true;
+  if (cursor_stride_ > 0) {
+    page_id_t &cursor = cursors_[static_cast<uint32_t>(page_id) % cursor_stride_];
+    cursor = std::min(cursor, page_id);
+  }
+}
+
+auto FreeSpaceMap::IsAllocated(page_id_t page_id) -> bool {
+  std::scoped_lock lock(latch_);
+  return page_id >= 0 && TestBit(page_id);
+}
+
+auto FreeSpaceMap::GetNextPageId() -> page_id_t {
+  std::scoped_lock lock(latch_);
+  return next_page_id_;
+}
+
+auto FreeSpaceMap::GetNumFreePages() -> size_t {
+  std::scoped_lock lock(latch_);
+  return static_cast<size_t>(next_page_id_) - num_allocated_;
+}
+
+void FreeSpaceMap::Flush() {
+  std::scoped_lock lock(latch_);
+  if (fd_ < 0) {
+    return;
+  }
+  for (size_t i = 0; i < dirty_.size(); i++) {
+    if (dirty_[i]) {
+      WriteBitmap(i);
+    }
+  }
+  if (meta_dirty_) {
+    WriteMeta();
+  }
+}
+
+void FreeSpaceMap::Close() {
+  Flush();
+  // a sync in progress still uses the file
+  std::scoped_lock lock(sync_latch_, latch_);
+  if (fd_ >= 0) {
+    close(fd_);
+    fd_ = -1;
+  }
+}
+
+auto FreeSpaceMap::TestBit(page_id_t page_id) const -> bool {
+  size_t word = page_id / 64;
+  return word < bits_.size() && (bits_[word] >> (page_id % 64) & 1) != 0;
+}
+
+void FreeSpaceMap::SetBit(page_id_t page_id, bool allocated) {
+  size_t word = page_id / 64;
+  if (word >= bits_.size()) {
+    size_t num_bitmaps = page_id / PAGES_PER_BITMAP + 1;
+    bits_.resize(num_bitmaps * WORDS_PER_BITMAP);
+    dirty_.resize(num_bitmaps);
+  }
+  if (allocated) {
+    bits_[word] |= 1ULL << (page_id % 64);
+  } else {
+    bits_[word] &= ~(1ULL << (page_id % 64));
+  }
+}
+
+void FreeSpaceMap::WriteBitmap(size_t index) {
+  dirty_[index] = false;
+  if (pwrite(fd_, bits_.data() + index * WORDS_PER_BITMAP, BUSTUB_PAGE_SIZE,
+             static_cast<off_t>(index + 1) * BUSTUB_PAGE_SIZE) != BUSTUB_PAGE_SIZE) {
+    LOG_DEBUG("I/O error while writing the free space map");
+  }
+}
+
+void FreeSpaceMap::WriteMeta() {
+  meta_dirty_ = false;
+  char page[BUSTUB_PAGE_SIZE];
+  memset(page, 0, BUSTUB_PAGE_SIZE);
+  FreeSpaceMeta meta{FREE_SPACE_MAP_MAGIC, next_page_id_, static_cast<uint32_t>(dirty_.size())};
+  memcpy(page, &meta, sizeof(meta));
+  if (pwrite(fd_, page, BUSTUB_PAGE_SIZE, 0) != BUSTUB_PAGE_SIZE) {
+    LOG_DEBUG("I/O error while writing the meta page of the free space map");
+  }
+}
+
+}  // namespace bustub
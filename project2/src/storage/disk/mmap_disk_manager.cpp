@@ -0,0 +1,74 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// mmap_disk_manager.cpp
+//
+// Identification: src/storage/disk/mmap_disk_manager.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/mmap_disk_manager.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+#include "common/exception.h"
+#include "common/logger.h"
+
+namespace bustub {
+
+MmapDiskManager::MmapDiskManager(const std::string &db_file, bool populate) : DiskManager(db_file) {
+  struct stat stat_buf;
+  if (fstat(db_fd_, &stat_buf) != 0) {
+    throw Exception("can't stat db file");
+  }
+  map_size_ = stat_buf.st_size;
+  if (map_size_ == 0) {
+    // an empty snapshot, mmap refuses a zero length
+    return;
+  }
+  int flags = MAP_SHARED | (populate ? MAP_POPULATE : 0);
+  void *map = mmap(nullptr, map_size_, PROT_READ, flags, db_fd_, 0);
+  if (map == MAP_FAILED) {
+    throw Exception(std::string("can't map db file: ") + strerror(errno));
+  }
+  map_ = static_cast<char *>(map);
+}
+
+MmapDiskManager::~MmapDiskManager() { ShutDown(); }
+
+void MmapDiskManager::ShutDown() {
+  if (map_ != nullptr) {
+    munmap(map_, map_size_);
+    map_ = nullptr;
+  }
+  DiskManager::ShutDown();
+}
+
+void MmapDiskManager::WritePage(page_id_t page_id, const char *page_data) {
+  throw Exception(ExceptionType::INVALID, "page " + std::to_string(page_id) + " written to a read-only snapshot");
+}
+
+/**
+ * Copy the specified page out of the mapping into the given memory area
+ */
+void MmapDiskManager::ReadPage(page_id_t page_id, char *page_data) {
+  size_t offset = static_cast<size_t>(page_id) * BUSTUB_PAGE_SIZE;
+  size_t read_count = offset < map_size_ ? std::min<size_t>(map_size_ - offset, BUSTUB_PAGE_SIZE) : 0;
+  if (read_count > 0) {
+    memcpy(page_data, map_ + offset, read_count);
+  }
+  // if the snapshot ends before the page does, like DiskManager the rest of the page reads as zeros
+  if (read_count < BUSTUB_PAGE_SIZE) {
+    memset(page_data + read_count, 0, BUSTUB_PAGE_SIZE - read_count);
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,233 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_codec.cpp
+//
+// Identification: src/storage/disk/page_codec.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/page_codec.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+
+#ifdef BUSTUB_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace bustub {
+
+namespace {
+
+/** Matches are at least this long, shorter ones cost more than the literals. */
+constexpr size_t MIN_MATCH = 4;
+/** Like LZ4, the last bytes are always literals, so that the decompressor can check bounds once per sequence. */
+constexpr size_t LAST_LITERALS = 5;
+constexpr size_t MATCH_SEARCH_LIMIT = 12;
+constexpr size_t MAX_OFFSET = 65535;
+constexpr int HASH_BITS = 12;
+
+auto Read32(const char *p) -> uint32_t {
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+auto Hash(uint32_t sequence) -> uint32_t { return (sequence * 2654435761U) >> (32 - HASH_BITS); }
+
+/** Write a length that does not fit in its nibble of the token: a run of 255s and the remainder. */
+auto WriteLength(size_t length, char *dst, size_t *pos, size_t dst_capacity) -> bool {
+  while (length >= 255) {
+    if (*pos >= dst_capacity) {
+      return false;
+    }
+    dst[(*pos)++] = static_cast<char>(255);
+    length -= 255;
+  }
+  if (*pos >= dst_capacity) {
+    return false;
+  }
+  dst[(*pos)++] = static_cast<char>(length);
+  return true;
+}
+
+/** Write a sequence: the literals src[0, literal_length), then a match of match_length bytes offset bytes back. */
+auto WriteSequence(const char *literals, size_t literal_length, size_t offset, size_t match_length, char *dst,
+                   size_t *pos, size_t dst_capacity) -> bool {
+  if (*pos >= dst_capacity) {
+    return false;
+  }
+  size_t token_pos = (*pos)++;
+  uint8_t token = literal_length >= 15 ? 15 << 4 : literal_length << 4;
+  if (literal_length >= 15 && !WriteLength(literal_length - 15, dst, pos, dst_capacity)) {
+    return false;
+  }
+  if (*pos + literal_length > dst_capacity) {
+    return false;
+  }
+  memcpy(dst + *pos, literals, literal_length);
+  *pos += literal_length;
+
+  if (match_length > 0) {
+    if (*pos + 2 > dst_capacity) {
+      return false;
+    }
+    dst[(*pos)++] = static_cast<char>(offset & 0xff);
+    dst[(*pos)++] = static_cast<char>(offset >> 8);
+    size_t length = match_length - MIN_MATCH;
+    token |= length >= 15 ? 15 : length;
+    if (length >= 15 && !WriteLength(length - 15, dst, pos, dst_capacity)) {
+      return false;
+    }
+  }
+  dst[token_pos] = static_cast<char>(token);
+  return true;
+}
+
+/** Read a length that did not fit in its nibble of the token. */
+auto ReadLength(const uint8_t *src, size_t src_size, size_t *pos, size_t *length) -> bool {
+  uint8_t byte;
+  do {
+    if (*pos >= src_size) {
+      return false;
+    }
+    byte = src[(*pos)++];
+    *length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+#ifdef BUSTUB_HAVE_ZLIB
+
+/**
+ * ZlibPageCodec deflates pages with zlib at its fastest level, it compresses better than LzPageCodec but decompresses
+ * slower.
+ */
+class ZlibPageCodec : public PageCodec {
+ public:
+  auto Name() const -> std::string override { return "zlib"; }
+
+  auto Compress(const char *src, size_t src_size, char *dst, size_t dst_capacity) const -> size_t override {
+    uLongf dst_size = dst_capacity;
+    if (compress2(reinterpret_cast<Bytef *>(dst), &dst_size, reinterpret_cast<const Bytef *>(src), src_size,
+                  Z_BEST_SPEED) != Z_OK) {
+      return 0;
+    }
+    return dst_size;
+  }
+
+  auto Decompress(const char *src, size_t src_size, char *dst, size_t dst_size) const -> bool override {
+    uLongf size = dst_size;
+    return uncompress(reinterpret_cast<Bytef *>(dst), &size, reinterpret_cast<const Bytef *>(src), src_size) == Z_OK &&
+           size == dst_size;
+  }
+};
+
+#endif
+
+}  // namespace
+
+auto LzPageCodec::Compress(const char *src, size_t src_size, char *dst, size_t dst_capacity) const -> size_t {
+  // positions of the last occurrence of every hashed 4 byte sequence, pages are far smaller than 64K
+  int32_t table[1 << HASH_BITS];
+  std::fill(std::begin(table), std::end(table), -1);
+
+  size_t pos = 0;
+  size_t anchor = 0;
+  size_t ip = 0;
+  if (src_size > MATCH_SEARCH_LIMIT) {
+    size_t match_limit = src_size - MATCH_SEARCH_LIMIT;
+    size_t match_end = src_size - LAST_LITERALS;
+    while (ip < match_limit) {
+      uint32_t sequence = Read32(src + ip);
+      uint32_t hash = Hash(sequence);
+      int32_t ref = table[hash];
+      table[hash] = static_cast<int32_t>(ip);
+      if (ref < 0 || ip - ref > MAX_OFFSET || Read32(src + ref) != sequence) {
+        ip++;
+        continue;
+      }
+      size_t match_length = MIN_MATCH;
+      while (ip + match_length < match_end && src[ref + match_length] == src[ip + match_length]) {
+        match_length++;
+      }
+      if (!WriteSequence(src + anchor, ip - anchor, ip - ref, match_length, dst, &pos, dst_capacity)) {
+        return 0;
+      }
+      ip += match_length;
+      anchor = ip;
+    }
+  }
+  // the last sequence is literals only
+  if (!WriteSequence(src + anchor, src_size - anchor, 0, 0, dst, &pos, dst_capacity)) {
+    return 0;
+  }
+  return pos;
+}
+
+auto LzPageCodec::Decompress(const char *src, size_t src_size, char *dst, size_t dst_size) const -> bool {
+  const auto *in = reinterpret_cast<const uint8_t *>(src);
+  size_t ip = 0;
+  size_t op = 0;
+  while (ip < src_size) {
+    uint8_t token = in[ip++];
+    size_t literal_length = token >> 4;
+    if (literal_length == 15 && !ReadLength(in, src_size, &ip, &literal_length)) {
+      return false;
+    }
+    if (ip + literal_length > src_size || op + literal_length > dst_size) {
+      return false;
+    }
+    memcpy(dst + op, src + ip, literal_length);
+    ip += literal_length;
+    op += literal_length;
+    if (ip == src_size) {
+      // the last sequence has no match
+      break;
+    }
+
+    if (ip + 2 > src_size) {
+      return false;
+    }
+    size_t offset = in[ip] | (in[ip + 1] << 8);
+    ip += 2;
+    size_t match_length = token & 15;
+    if (match_length == 15 && !ReadLength(in, src_size, &ip, &match_length)) {
+      return false;
+    }
+    match_length += MIN_MATCH;
+    if (offset == 0 || offset > op || op + match_length > dst_size) {
+      return false;
+    }
+    if (offset >= match_length) {
+      memcpy(dst + op, dst + op - offset, match_length);
+      op += match_length;
+    } else {
+      // the match overlaps the output it is copied to, which repeats the bytes, so copy forward one at a time
+      for (size_t i = 0; i < match_length; i++, op++) {
+        dst[op] = dst[op - offset];
+      }
+    }
+  }
+  return op == dst_size;
+}
+
+auto CreatePageCodec(const std::string &name) -> std::unique_ptr<PageCodec> {
+  if (name == "lz") {
+    return std::make_unique<LzPageCodec>();
+  }
+#ifdef BUSTUB_HAVE_ZLIB
+  if (name == "zlib") {
+    return std::make_unique<ZlibPageCodec>();
+  }
+#endif
+  return nullptr;
+}
+
+}  // namespace bustub
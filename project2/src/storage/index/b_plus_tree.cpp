@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <string>
+#include <thread>  // NOLINT
 
 #include "common/exception.h"
 #include "common/logger.h"
@@ -9,19 +11,25 @@
 namespace bustub {
 INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREE_TYPE::BPlusTree(std::string name, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
-                          int leaf_max_size, int internal_max_size)
+                          int leaf_max_size, int internal_max_size, bool optimistic_reads)
     : index_name_(std::move(name)),
       root_page_id_(INVALID_PAGE_ID),
       buffer_pool_manager_(buffer_pool_manager),
       comparator_(comparator),
       leaf_max_size_(leaf_max_size),
-      internal_max_size_(internal_max_size) {}
+      internal_max_size_(std::min(internal_max_size, InternalPage::MAX_CAPACITY)),
+      optimistic_reads_(optimistic_reads) {}
 
 /*
  * Helper function to decide whether current b+tree is empty
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::IsEmpty() const -> bool { return true; }
+auto BPLUSTREE_TYPE::IsEmpty() const -> bool {
+  root_latch_.RLock();
+  bool is_empty = root_page_id_ == INVALID_PAGE_ID;
+  root_latch_.RUnlock();
+  return is_empty;
+}
 /*****************************************************************************
  * SEARCH
  *****************************************************************************/
@@ -32,7 +40,257 @@ auto BPLUSTREE_TYPE::IsEmpty() const -> bool { return true; }
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction) -> bool {
-  return false;
+  if (optimistic_reads_) {
+    bool found;
+    for (int restart = 0; restart < MAX_OPTIMISTIC_RESTARTS; restart++) {
+      if (GetValueOptimistic(key, result, &found)) {
+        return found;
+      }
+      std::this_thread::yield();
+    }
+  }
+
+  Page *page = FindLeafRead(key, false);
+  if (page == nullptr) {
+    return false;
+  }
+  ValueType value;
+  bool found = reinterpret_cast<LeafPage *>(page->GetData())->Lookup(key, &value, comparator_);
+  page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+  if (found) {
+    result->push_back(value);
+  }
+  return found;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::GetValueOptimistic(const KeyType &key, std::vector<ValueType> *result, bool *found) -> bool {
+  Page *page;
+  uint64_t version;
+  if (!FindLeafVersioned(key, false, &page, &version)) {
+    return false;
+  }
+  *found = false;
+  if (page == nullptr) {
+    return true;
+  }
+  auto *leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  int size = leaf->GetSize();
+  int index = 0;
+  bool valid = page->ValidateVersion(version) && SearchVersioned(page, version, leaf, 0, size, key, false, &index);
+  if (valid && index < size) {
+    KeyType leaf_key = leaf->KeyAt(index);
+    ValueType value = leaf->ValueAt(index);
+    valid = page->ValidateVersion(version);
+    if (valid && comparator_(leaf_key, key) == 0) {
+      result->push_back(value);
+      *found = true;
+    }
+  }
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+  return valid;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FindLeafVersioned(const KeyType &key, bool leftmost, Page **leaf, uint64_t *version) -> bool {
+  *leaf = nullptr;
+  page_id_t root_page_id = root_page_id_;
+  if (root_page_id == INVALID_PAGE_ID) {
+    return true;
+  }
+  Page *page = FetchTreePage(root_page_id);
+  uint64_t page_version = page->GetVersion();
+  // a root replaced before its version was read is not written again, the new root id tells
+  if (page_version % 2 != 0 || root_page_id_ != root_page_id) {
+    buffer_pool_manager_->UnpinPage(root_page_id, false);
+    return false;
+  }
+
+  while (true) {
+    auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    bool is_leaf = node->IsLeafPage();
+    int size = node->GetSize();
+    int index = 1;
+    bool valid = page->ValidateVersion(page_version);
+    if (valid && is_leaf) {
+      *leaf = page;
+      *version = page_version;
+      return true;
+    }
+    auto *internal = reinterpret_cast<InternalPage *>(node);
+    if (valid && !leftmost) {
+      valid = SearchVersioned(page, page_version, internal, 1, size, key, true, &index);
+    }
+    page_id_t child_page_id = internal->ValueAt(index - 1);
+    if (!valid || !page->ValidateVersion(page_version)) {
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+      return false;
+    }
+
+    Page *child = FetchTreePage(child_page_id);
+    uint64_t child_version = child->GetVersion();
+    // The child may have been merged away, and its page reused, before it was pinned. Its parent changed then. Once
+    // pinned, its frame holds the page until it is unpinned, and writes to it change its version.
+    valid = child_version % 2 == 0 && page->ValidateVersion(page_version);
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    if (!valid) {
+      buffer_pool_manager_->UnpinPage(child_page_id, false);
+      return false;
+    }
+    page = child;
+    page_version = child_version;
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+template <typename NodeType>
+auto BPLUSTREE_TYPE::SearchVersioned(const Page *page, uint64_t version, const NodeType *node, int begin, int end,
+                                     const KeyType &key, bool upper, int *index) const -> bool {
+  while (begin < end) {
+    int mid = begin + (end - begin) / 2;
+    KeyType mid_key = node->KeyAt(mid);
+    if (!page->ValidateVersion(version)) {
+      return false;
+    }
+    int cmp = comparator_(mid_key, key);
+    if (cmp < 0 || (upper && cmp == 0)) {
+      begin = mid + 1;
+    } else {
+      end = mid;
+    }
+  }
+  *index = begin;
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::SearchLeafVersioned(Page *page, uint64_t version, int size, const KeyType &key, bool upper,
+                                         int *index) const -> bool {
+  return SearchVersioned(page, version, reinterpret_cast<const LeafPage *>(page->GetData()), 0, size, key, upper,
+                         index);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FindLeafRead(const KeyType &key, bool leftmost) -> Page * {
+  root_latch_.RLock();
+  if (root_page_id_ == INVALID_PAGE_ID) {
+    root_latch_.RUnlock();
+    return nullptr;
+  }
+  Page *page = FetchTreePage(root_page_id_);
+  page->RLatch();
+  root_latch_.RUnlock();
+
+  auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  while (!node->IsLeafPage()) {
+    auto *internal = reinterpret_cast<InternalPage *>(node);
+    Page *child = FetchTreePage(leftmost ? internal->ValueAt(0) : internal->Lookup(key, comparator_));
+    child->RLatch();
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    page = child;
+    node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  }
+  return page;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FindLeafOptimistic(const KeyType &key, bool *is_root) -> Page * {
+  root_latch_.RLock();
+  if (root_page_id_ == INVALID_PAGE_ID) {
+    root_latch_.RUnlock();
+    return nullptr;
+  }
+  Page *page = FetchTreePage(root_page_id_);
+  *is_root = true;
+  page->RLatch();
+  if (reinterpret_cast<BPlusTreePage *>(page->GetData())->IsLeafPage()) {
+    // nobody can replace the root while root_latch_ is held, the leaf stays the root between the two latches
+    page->RUnlatch();
+    page->WLatch();
+    root_latch_.RUnlock();
+    return page;
+  }
+  root_latch_.RUnlock();
+
+  while (true) {
+    auto *internal = reinterpret_cast<InternalPage *>(page->GetData());
+    Page *child = FetchTreePage(internal->Lookup(key, comparator_));
+    child->RLatch();
+    bool is_leaf = reinterpret_cast<BPlusTreePage *>(child->GetData())->IsLeafPage();
+    if (is_leaf) {
+      // splitting or merging the leaf takes a write latch on its parent, which is still read latched here
+      child->RUnlatch();
+      child->WLatch();
+    }
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    page = child;
+    *is_root = false;
+    if (is_leaf) {
+      return page;
+    }
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FindLeafPessimistic(const KeyType &key, Operation op, Transaction *transaction) -> Page * {
+  root_latch_.WLock();
+  transaction->AddIntoPageSet(nullptr);
+  if (root_page_id_ == INVALID_PAGE_ID) {
+    return nullptr;
+  }
+  Page *page = FetchTreePage(root_page_id_);
+  page->WLatch();
+  bool is_root = true;
+  while (true) {
+    auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    if (IsSafe(node, op, is_root)) {
+      ReleasePageSet(transaction, false);
+    }
+    transaction->AddIntoPageSet(page);
+    if (node->IsLeafPage()) {
+      return page;
+    }
+    page = FetchTreePage(reinterpret_cast<InternalPage *>(node)->Lookup(key, comparator_));
+    page->WLatch();
+    is_root = false;
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::IsSafe(const BPlusTreePage *node, Operation op, bool is_root) const -> bool {
+  if (op == Operation::INSERT) {
+    // A leaf splits once it is full, an internal page when a child is added to it while full or without room for
+    // its key. Up to MIN_CAPACITY children have room whatever their keys.
+    return node->IsLeafPage() ? node->GetSize() + 1 < node->GetMaxSize()
+                              : node->GetSize() < node->GetMaxSize() && node->GetSize() < InternalPage::MIN_CAPACITY;
+  }
+  if (is_root) {
+    // the root goes away when it loses its last key
+    return node->GetSize() > (node->IsLeafPage() ? 1 : 2);
+  }
+  return node->GetSize() > GetMinSize(node);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::GetMinSize(const BPlusTreePage *node) const -> int {
+  return node->IsLeafPage() ? node->GetMinSize() : InternalPage::MinSize(node->GetMaxSize());
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::ReleasePageSet(Transaction *transaction, bool is_dirty) {
+  auto page_set = transaction->GetPageSet();
+  for (Page *page : *page_set) {
+    if (page == nullptr) {
+      root_latch_.WUnlock();
+    } else {
+      page->WUnlatch();
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), is_dirty);
+    }
+  }
+  page_set->clear();
 }
 
 /*****************************************************************************
@@ -47,7 +305,252 @@ auto BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transaction *transaction) -> bool {
-  return false;
+  bool inserted;
+  if (InsertOptimistic(key, value, &inserted)) {
+    return inserted;
+  }
+
+  Transaction local_transaction(INVALID_TXN_ID);
+  if (transaction == nullptr) {
+    transaction = &local_transaction;
+  }
+  Page *page = FindLeafPessimistic(key, Operation::INSERT, transaction);
+  if (page == nullptr) {
+    StartNewTree(key, value);
+    ReleasePageSet(transaction, true);
+    return true;
+  }
+  auto *leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  ValueType existing;
+  if (leaf->Lookup(key, &existing, comparator_)) {
+    ReleasePageSet(transaction, false);
+    return false;
+  }
+  if (leaf->Insert(key, value, comparator_) >= leaf_max_size_) {
+    page_id_t new_page_id;
+    Page *new_page = NewTreePage(&new_page_id, leaf->GetPageId());
+    auto *new_leaf = reinterpret_cast<LeafPage *>(new_page->GetData());
+    new_leaf->Init(new_page_id, leaf->GetParentPageId(), leaf_max_size_);
+    leaf->MoveHalfTo(new_leaf);
+    InsertIntoParent(transaction, transaction->GetPageSet()->size() - 1,
+                     comparator_.ShortestSeparator(leaf->KeyAt(leaf->GetSize() - 1), new_leaf->KeyAt(0)), new_leaf);
+    buffer_pool_manager_->UnpinPage(new_page_id, true);
+  }
+  ReleasePageSet(transaction, true);
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::InsertOptimistic(const KeyType &key, const ValueType &value, bool *inserted) -> bool {
+  bool is_root;
+  Page *page = FindLeafOptimistic(key, &is_root);
+  if (page == nullptr) {
+    return false;
+  }
+  auto *leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  ValueType existing;
+  bool done = true;
+  *inserted = false;
+  if (leaf->Lookup(key, &existing, comparator_)) {
+    // a duplicate, nothing to do
+  } else if (IsSafe(leaf, Operation::INSERT, is_root)) {
+    leaf->Insert(key, value, comparator_);
+    *inserted = true;
+  } else {
+    done = false;
+  }
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), *inserted);
+  return done;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {
+  page_id_t page_id;
+  Page *page = NewTreePage(&page_id, INVALID_PAGE_ID);
+  auto *leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  leaf->Init(page_id, INVALID_PAGE_ID, leaf_max_size_);
+  leaf->Insert(key, value, comparator_);
+  root_page_id_ = page_id;
+  UpdateRootPageId(1);
+  buffer_pool_manager_->UnpinPage(page_id, true);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::InsertIntoParent(Transaction *transaction, size_t index, const KeyType &key,
+                                      BPlusTreePage *new_node) {
+  auto page_set = transaction->GetPageSet();
+  auto *old_node = reinterpret_cast<BPlusTreePage *>((*page_set)[index]->GetData());
+  // a page that splits was not safe, so the page above it is in the page set: its parent, or root_latch_
+  Page *parent_page = (*page_set)[index - 1];
+  if (parent_page == nullptr) {
+    page_id_t root_page_id;
+    Page *root_page = NewTreePage(&root_page_id, INVALID_PAGE_ID);
+    auto *root = reinterpret_cast<InternalPage *>(root_page->GetData());
+    root->Init(root_page_id, INVALID_PAGE_ID, internal_max_size_);
+    root->PopulateNewRoot(old_node->GetPageId(), key, new_node->GetPageId());
+    old_node->SetParentPageId(root_page_id);
+    new_node->SetParentPageId(root_page_id);
+    root_page_id_ = root_page_id;
+    UpdateRootPageId();
+    buffer_pool_manager_->UnpinPage(root_page_id, true);
+    return;
+  }
+
+  auto *parent = reinterpret_cast<InternalPage *>(parent_page->GetData());
+  if (parent->GetSize() < internal_max_size_ && parent->HasRoomFor(key)) {
+    parent->InsertNodeAfter(old_node->GetPageId(), key, new_node->GetPageId());
+    new_node->SetParentPageId(parent->GetPageId());
+    return;
+  }
+  page_id_t sibling_page_id;
+  Page *sibling_page = NewTreePage(&sibling_page_id, parent->GetPageId());
+  auto *sibling = reinterpret_cast<InternalPage *>(sibling_page->GetData());
+  sibling->Init(sibling_page_id, parent->GetParentPageId(), internal_max_size_);
+  parent->InsertAndMoveHalfTo(old_node->GetPageId(), key, new_node->GetPageId(), sibling, buffer_pool_manager_);
+  InsertIntoParent(transaction, index - 1, sibling->KeyAt(0), sibling);
+  buffer_pool_manager_->UnpinPage(sibling_page_id, true);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::BulkLoad(const std::function<bool(MappingType *)> &next, double fill_factor) -> bool {
+  root_latch_.WLock();
+  if (root_page_id_ != INVALID_PAGE_ID) {
+    root_latch_.WUnlock();
+    return false;
+  }
+  // a leaf splits when it is full, so it holds max size - 1 entries at most
+  int leaf_capacity = leaf_max_size_ - 1;
+  int leaf_min_size = std::max(leaf_max_size_ / 2, 1);
+  int leaf_fill = std::clamp(static_cast<int>(leaf_capacity * fill_factor), leaf_min_size, leaf_capacity);
+  int internal_min_size = std::max(InternalPage::MinSize(internal_max_size_), 2);
+  int internal_fill =
+      std::clamp(static_cast<int>(internal_max_size_ * fill_factor), internal_min_size, internal_max_size_);
+
+  std::vector<std::pair<KeyType, page_id_t>> level;
+  Page *prev_page = nullptr;
+  Page *page = nullptr;
+  LeafPage *leaf = nullptr;
+  MappingType entry;
+  KeyType last_key;
+  while (next(&entry)) {
+    if (leaf != nullptr) {
+      int cmp = comparator_(last_key, entry.first);
+      BUSTUB_ASSERT(cmp <= 0, "bulk loaded entries must be sorted by key");
+      if (cmp == 0) {
+        continue;
+      }
+    }
+    if (leaf == nullptr || leaf->GetSize() == leaf_fill) {
+      page_id_t page_id;
+      Page *new_page = NewTreePage(&page_id, page == nullptr ? INVALID_PAGE_ID : page->GetPageId());
+      auto *new_leaf = reinterpret_cast<LeafPage *>(new_page->GetData());
+      new_leaf->Init(page_id, INVALID_PAGE_ID, leaf_max_size_);
+      if (leaf != nullptr) {
+        leaf->SetNextPageId(page_id);
+      }
+      // the previous leaf stays pinned until the last one is known, they may have to share entries
+      if (prev_page != nullptr) {
+        buffer_pool_manager_->UnpinPage(prev_page->GetPageId(), true);
+      }
+      prev_page = page;
+      page = new_page;
+      level.emplace_back(leaf == nullptr ? entry.first : comparator_.ShortestSeparator(last_key, entry.first), page_id);
+      leaf = new_leaf;
+    }
+    leaf->Append(entry.first, entry.second);
+    last_key = entry.first;
+  }
+  if (page == nullptr) {
+    root_latch_.WUnlock();
+    return true;
+  }
+
+  page_id_t merged_page_id = INVALID_PAGE_ID;
+  if (prev_page != nullptr && leaf->GetSize() < leaf_min_size) {
+    auto *prev_leaf = reinterpret_cast<LeafPage *>(prev_page->GetData());
+    if (prev_leaf->GetSize() + leaf->GetSize() <= leaf_capacity) {
+      leaf->MoveAllTo(prev_leaf);
+      level.pop_back();
+      merged_page_id = page->GetPageId();
+    } else {
+      // more than the capacity is at least twice the min size, half of it is enough for both
+      while (leaf->GetSize() + 1 < prev_leaf->GetSize()) {
+        prev_leaf->MoveLastToFrontOf(leaf);
+      }
+      level.back().first = comparator_.ShortestSeparator(prev_leaf->KeyAt(prev_leaf->GetSize() - 1), leaf->KeyAt(0));
+    }
+  }
+  if (prev_page != nullptr) {
+    buffer_pool_manager_->UnpinPage(prev_page->GetPageId(), true);
+  }
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+  if (merged_page_id != INVALID_PAGE_ID) {
+    DeletePages({merged_page_id});
+  }
+
+  while (level.size() > 1) {
+    level = BuildInternalLevel(level, internal_fill);
+  }
+  root_page_id_ = level[0].second;
+  UpdateRootPageId(1);
+  root_latch_.WUnlock();
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::BuildInternalLevel(const std::vector<std::pair<KeyType, page_id_t>> &children, int fill)
+    -> std::vector<std::pair<KeyType, page_id_t>> {
+  std::vector<std::pair<KeyType, page_id_t>> level;
+  Page *prev_page = nullptr;
+  Page *page = nullptr;
+  InternalPage *node = nullptr;
+  for (const auto &[key, child_page_id] : children) {
+    if (node == nullptr || node->GetSize() == fill || !node->HasRoomFor(key)) {
+      page_id_t page_id;
+      Page *new_page = NewTreePage(&page_id, page == nullptr ? INVALID_PAGE_ID : page->GetPageId());
+      auto *new_node = reinterpret_cast<InternalPage *>(new_page->GetData());
+      new_node->Init(page_id, INVALID_PAGE_ID, internal_max_size_);
+      if (prev_page != nullptr) {
+        buffer_pool_manager_->UnpinPage(prev_page->GetPageId(), true);
+      }
+      prev_page = page;
+      page = new_page;
+      node = new_node;
+      level.emplace_back(key, page_id);
+    }
+    node->Append(key, child_page_id);
+    Page *child_page = FetchTreePage(child_page_id);
+    reinterpret_cast<BPlusTreePage *>(child_page->GetData())->SetParentPageId(node->GetPageId());
+    buffer_pool_manager_->UnpinPage(child_page_id, true);
+  }
+
+  page_id_t merged_page_id = INVALID_PAGE_ID;
+  int min_size = std::max(InternalPage::MinSize(internal_max_size_), 2);
+  if (prev_page != nullptr && node->GetSize() < min_size) {
+    auto *prev_node = reinterpret_cast<InternalPage *>(prev_page->GetData());
+    if (prev_node->GetSize() + node->GetSize() <= internal_max_size_ &&
+        prev_node->HasRoomForAllOf(node, level.back().first)) {
+      node->MoveAllTo(prev_node, level.back().first, buffer_pool_manager_);
+      level.pop_back();
+      merged_page_id = page->GetPageId();
+    } else {
+      // below its min size node has room for whatever it gets, past it the separator may not fit
+      while (node->GetSize() + 1 < prev_node->GetSize() &&
+             (node->GetSize() < min_size || node->HasRoomFor(level.back().first))) {
+        prev_node->MoveLastToFrontOf(node, level.back().first, buffer_pool_manager_);
+        level.back().first = node->KeyAt(0);
+      }
+    }
+  }
+  if (prev_page != nullptr) {
+    buffer_pool_manager_->UnpinPage(prev_page->GetPageId(), true);
+  }
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+  if (merged_page_id != INVALID_PAGE_ID) {
+    DeletePages({merged_page_id});
+  }
+  return level;
 }
 
 /*****************************************************************************
@@ -61,7 +564,178 @@ auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transact
  * necessary.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {}
+void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {
+  if (RemoveOptimistic(key)) {
+    return;
+  }
+
+  Transaction local_transaction(INVALID_TXN_ID);
+  if (transaction == nullptr) {
+    transaction = &local_transaction;
+  }
+  Page *page = FindLeafPessimistic(key, Operation::REMOVE, transaction);
+  if (page == nullptr) {
+    ReleasePageSet(transaction, false);
+    return;
+  }
+  auto *leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  int size = leaf->GetSize();
+  if (leaf->RemoveAndDeleteRecord(key, comparator_) == size) {
+    ReleasePageSet(transaction, false);
+    return;
+  }
+  CoalesceOrRedistribute(transaction, transaction->GetPageSet()->size() - 1);
+  ReleasePageSet(transaction, true);
+
+  // an iterator on a merged away page finds its place again from the root, since the page is empty
+  auto deleted_page_set = transaction->GetDeletedPageSet();
+  DeletePages({deleted_page_set->begin(), deleted_page_set->end()});
+  deleted_page_set->clear();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::DeletePages(const std::vector<page_id_t> &page_ids) {
+  std::scoped_lock lock(deferred_latch_);
+  deferred_page_ids_.insert(deferred_page_ids_.end(), page_ids.begin(), page_ids.end());
+  std::vector<page_id_t> pinned_page_ids;
+  for (auto page_id : deferred_page_ids_) {
+    if (!buffer_pool_manager_->DeletePage(page_id)) {
+      pinned_page_ids.push_back(page_id);
+    }
+  }
+  deferred_page_ids_ = std::move(pinned_page_ids);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::RemoveOptimistic(const KeyType &key) -> bool {
+  bool is_root;
+  Page *page = FindLeafOptimistic(key, &is_root);
+  if (page == nullptr) {
+    return true;
+  }
+  auto *leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  ValueType existing;
+  bool done = true;
+  bool removed = false;
+  if (!leaf->Lookup(key, &existing, comparator_)) {
+    // not in the tree, nothing to do
+  } else if (IsSafe(leaf, Operation::REMOVE, is_root)) {
+    leaf->RemoveAndDeleteRecord(key, comparator_);
+    removed = true;
+  } else {
+    done = false;
+  }
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), removed);
+  return done;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::CoalesceOrRedistribute(Transaction *transaction, size_t index) {
+  auto page_set = transaction->GetPageSet();
+  auto *node = reinterpret_cast<BPlusTreePage *>((*page_set)[index]->GetData());
+  if (index == 0) {
+    // the first page of the set was safe, it does not underflow
+    return;
+  }
+  Page *parent_page = (*page_set)[index - 1];
+  if (parent_page == nullptr) {
+    AdjustRoot(node, transaction);
+    return;
+  }
+  if (node->GetSize() >= GetMinSize(node)) {
+    return;
+  }
+
+  // The sibling is write latched while the parent is, and only one thread at a time can hold the latch of a parent
+  // together with those of its children. Iterators hold one leaf latch at a time, so the order of the two leaf latches
+  // does not matter.
+  auto *parent = reinterpret_cast<InternalPage *>(parent_page->GetData());
+  int node_index = parent->ValueIndex(node->GetPageId());
+  int sibling_index = node_index == 0 ? 1 : node_index - 1;
+  Page *sibling_page = FetchTreePage(parent->ValueAt(sibling_index));
+  sibling_page->WLatch();
+  auto *sibling = reinterpret_cast<BPlusTreePage *>(sibling_page->GetData());
+
+  int right_index = std::max(node_index, sibling_index);
+  BPlusTreePage *left = node_index < sibling_index ? node : sibling;
+  BPlusTreePage *right = node_index < sibling_index ? sibling : node;
+  bool coalesce = node->IsLeafPage() ? left->GetSize() + right->GetSize() < leaf_max_size_
+                                     : left->GetSize() + right->GetSize() <= internal_max_size_ &&
+                                           reinterpret_cast<InternalPage *>(left)->HasRoomForAllOf(
+                                               reinterpret_cast<InternalPage *>(right), parent->KeyAt(right_index));
+  if (coalesce) {
+    if (node->IsLeafPage()) {
+      reinterpret_cast<LeafPage *>(right)->MoveAllTo(reinterpret_cast<LeafPage *>(left));
+    } else {
+      reinterpret_cast<InternalPage *>(right)->MoveAllTo(reinterpret_cast<InternalPage *>(left),
+                                                         parent->KeyAt(right_index), buffer_pool_manager_);
+    }
+    parent->Remove(right_index);
+    transaction->AddIntoDeletedPageSet(right->GetPageId());
+  } else {
+    // The separator changes, and the parent may have no room for the new one. The page then stays below its min size,
+    // which only costs room: it is merged or lent to once a sibling changes.
+    int separator_index = std::max(node_index, 1);
+    KeyType separator;
+    if (node->IsLeafPage()) {
+      auto *sibling_leaf = reinterpret_cast<LeafPage *>(sibling);
+      // the two keys of the sibling around the entry it lends
+      int first = node_index == 0 ? 0 : sibling_leaf->GetSize() - 2;
+      separator = comparator_.ShortestSeparator(sibling_leaf->KeyAt(first), sibling_leaf->KeyAt(first + 1));
+    } else {
+      auto *sibling_internal = reinterpret_cast<InternalPage *>(sibling);
+      separator = sibling_internal->KeyAt(node_index == 0 ? 1 : sibling_internal->GetSize() - 1);
+    }
+    if (parent->CanSetKeyAt(separator_index, separator)) {
+      if (node->IsLeafPage()) {
+        auto *leaf = reinterpret_cast<LeafPage *>(node);
+        auto *sibling_leaf = reinterpret_cast<LeafPage *>(sibling);
+        if (node_index == 0) {
+          sibling_leaf->MoveFirstToEndOf(leaf);
+        } else {
+          sibling_leaf->MoveLastToFrontOf(leaf);
+        }
+      } else {
+        auto *internal = reinterpret_cast<InternalPage *>(node);
+        auto *sibling_internal = reinterpret_cast<InternalPage *>(sibling);
+        if (node_index == 0) {
+          sibling_internal->MoveFirstToEndOf(internal, parent->KeyAt(1), buffer_pool_manager_);
+        } else {
+          sibling_internal->MoveLastToFrontOf(internal, parent->KeyAt(node_index), buffer_pool_manager_);
+        }
+      }
+      parent->SetKeyAt(separator_index, separator);
+    }
+  }
+  sibling_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(sibling_page->GetPageId(), true);
+
+  if (coalesce) {
+    CoalesceOrRedistribute(transaction, index - 1);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root, Transaction *transaction) {
+  if (old_root->IsLeafPage()) {
+    if (old_root->GetSize() == 0) {
+      root_page_id_ = INVALID_PAGE_ID;
+      UpdateRootPageId();
+      transaction->AddIntoDeletedPageSet(old_root->GetPageId());
+    }
+    return;
+  }
+  if (old_root->GetSize() == 1) {
+    page_id_t child_page_id = reinterpret_cast<InternalPage *>(old_root)->RemoveAndReturnOnlyChild();
+    Page *child_page = FetchTreePage(child_page_id);
+    reinterpret_cast<BPlusTreePage *>(child_page->GetData())->SetParentPageId(INVALID_PAGE_ID);
+    buffer_pool_manager_->UnpinPage(child_page_id, true);
+    root_page_id_ = child_page_id;
+    UpdateRootPageId();
+    transaction->AddIntoDeletedPageSet(old_root->GetPageId());
+  }
+}
 
 /*****************************************************************************
  * INDEX ITERATOR
@@ -72,7 +746,25 @@ void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {}
  * @return : index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::Begin() -> INDEXITERATOR_TYPE { return INDEXITERATOR_TYPE(); }
+auto BPLUSTREE_TYPE::Begin() -> INDEXITERATOR_TYPE {
+  if (optimistic_reads_) {
+    for (int restart = 0; restart < MAX_OPTIMISTIC_RESTARTS; restart++) {
+      Page *page;
+      uint64_t version;
+      if (FindLeafVersioned(KeyType{}, true, &page, &version)) {
+        return page == nullptr ? INDEXITERATOR_TYPE() : INDEXITERATOR_TYPE(this, page, 0, true);
+      }
+      std::this_thread::yield();
+    }
+  }
+
+  Page *page = FindLeafRead(KeyType{}, true);
+  if (page == nullptr) {
+    return INDEXITERATOR_TYPE();
+  }
+  page->RUnlatch();
+  return INDEXITERATOR_TYPE(this, page, 0, optimistic_reads_);
+}
 
 /*
  * Input parameter is low key, find the leaf page that contains the input key
@@ -80,7 +772,36 @@ auto BPLUSTREE_TYPE::Begin() -> INDEXITERATOR_TYPE { return INDEXITERATOR_TYPE()
  * @return : index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::Begin(const KeyType &key) -> INDEXITERATOR_TYPE { return INDEXITERATOR_TYPE(); }
+auto BPLUSTREE_TYPE::Begin(const KeyType &key) -> INDEXITERATOR_TYPE {
+  if (optimistic_reads_) {
+    for (int restart = 0; restart < MAX_OPTIMISTIC_RESTARTS; restart++) {
+      Page *page;
+      uint64_t version;
+      if (FindLeafVersioned(key, false, &page, &version)) {
+        if (page == nullptr) {
+          return INDEXITERATOR_TYPE();
+        }
+        auto *leaf = reinterpret_cast<LeafPage *>(page->GetData());
+        int size = leaf->GetSize();
+        int index = 0;
+        if (page->ValidateVersion(version) && SearchVersioned(page, version, leaf, 0, size, key, false, &index)) {
+          return INDEXITERATOR_TYPE(this, page, index, true, &key, version);
+        }
+        buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+      }
+      std::this_thread::yield();
+    }
+  }
+
+  Page *page = FindLeafRead(key, false);
+  if (page == nullptr) {
+    return INDEXITERATOR_TYPE();
+  }
+  int index = reinterpret_cast<LeafPage *>(page->GetData())->KeyIndex(key, comparator_);
+  uint64_t version = page->GetVersion();
+  page->RUnlatch();
+  return INDEXITERATOR_TYPE(this, page, index, optimistic_reads_, &key, version);
+}
 
 /*
  * Input parameter is void, construct an index iterator representing the end
@@ -94,7 +815,30 @@ auto BPLUSTREE_TYPE::End() -> INDEXITERATOR_TYPE { return INDEXITERATOR_TYPE();
  * @return Page id of the root of this tree
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::GetRootPageId() -> page_id_t { return 0; }
+auto BPLUSTREE_TYPE::GetRootPageId() -> page_id_t {
+  root_latch_.RLock();
+  page_id_t root_page_id = root_page_id_;
+  root_latch_.RUnlock();
+  return root_page_id;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FetchTreePage(page_id_t page_id) -> Page * {
+  Page *page = buffer_pool_manager_->FetchPage(page_id, AccessType::Index);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "can't fetch a B+ tree page, all frames are pinned");
+  }
+  return page;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::NewTreePage(page_id_t *page_id, page_id_t near_page_id) -> Page * {
+  Page *page = buffer_pool_manager_->NewPageNear(page_id, near_page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "can't allocate a B+ tree page, all frames are pinned");
+  }
+  return page;
+}
 
 /*****************************************************************************
  * UTILITIES AND DEBUG
@@ -110,13 +854,14 @@ auto BPLUSTREE_TYPE::GetRootPageId() -> page_id_t { return 0; }
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
   auto *header_page = static_cast<HeaderPage *>(buffer_pool_manager_->FetchPage(HEADER_PAGE_ID));
-  if (insert_record != 0) {
-    // create a new record<index_name + root_page_id> in header_page
-    header_page->InsertRecord(index_name_, root_page_id_);
-  } else {
+  // every index keeps its record in the header page
+  header_page->WLatch();
+  // a tree that became empty and grew again already has its record
+  if (insert_record == 0 || !header_page->InsertRecord(index_name_, root_page_id_)) {
     // update root_page_id in header_page
     header_page->UpdateRecord(index_name_, root_page_id_);
   }
+  header_page->WUnlatch();
   buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, true);
 }
 
@@ -11,6 +11,12 @@
 
 #include "storage/index/b_plus_tree_index.h"
 
+#include <algorithm>
+#include <exception>
+#include <thread>  // NOLINT
+
+#include "storage/index/external_sorter.h"
+
 namespace bustub {
 /*
  * Constructor
@@ -48,6 +54,56 @@ void BPLUSTREE_INDEX_TYPE::ScanKey(const Tuple &key, std::vector<RID> *result, T
   container_.GetValue(index_key, result, transaction);
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::BulkLoad(const std::function<bool(Tuple *, RID *)> &next, double fill_factor) {
+  BulkLoad(std::vector<std::function<bool(Tuple *, RID *)>>{next}, fill_factor);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::BulkLoad(const std::vector<std::function<bool(Tuple *, RID *)>> &producers,
+                                    double fill_factor) {
+  auto less = [this](const MappingType &lhs, const MappingType &rhs) { return comparator_(lhs.first, rhs.first) < 0; };
+  size_t num_lanes = std::max<size_t>(producers.size(), 1);
+  // the threads share the memory budget
+  ExternalSorter<MappingType, decltype(less)> sorter(less, INDEX_SORT_RUN_BYTES / sizeof(MappingType) / num_lanes,
+                                                     num_lanes);
+  auto produce = [&](size_t lane) {
+    Tuple key;
+    RID rid;
+    while (producers[lane](&key, &rid)) {
+      KeyType index_key;
+      index_key.SetFromKey(key);
+      sorter.Add({index_key, rid}, lane);
+    }
+    sorter.FinishLane(lane);
+  };
+
+  if (producers.size() == 1) {
+    produce(0);
+  } else {
+    std::vector<std::exception_ptr> errors(producers.size());
+    std::vector<std::thread> threads;
+    for (size_t lane = 0; lane < producers.size(); lane++) {
+      threads.emplace_back([&, lane] {
+        try {
+          produce(lane);
+        } catch (...) {
+          errors[lane] = std::current_exception();
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    for (auto &error : errors) {
+      if (error != nullptr) {
+        std::rethrow_exception(error);
+      }
+    }
+  }
+  container_.BulkLoad([&sorter](MappingType *entry) { return sorter.Next(entry); }, fill_factor);
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_INDEX_TYPE::GetBeginIterator() -> INDEXITERATOR_TYPE { return container_.Begin(); }
 
@@ -2,29 +2,213 @@
  * index_iterator.cpp
  */
 #include <cassert>
+#include <thread>  // NOLINT
 
+#include "common/exception.h"
+#include "storage/index/b_plus_tree.h"
 #include "storage/index/index_iterator.h"
 
 namespace bustub {
 
-/*
- * NOTE: you can change the destructor/constructor method here
- * set your own input parameters
- */
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE::IndexIterator() = default;
 
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE::~IndexIterator() = default;  // NOLINT
+INDEXITERATOR_TYPE::IndexIterator(BPlusTree<KeyType, ValueType, KeyComparator> *tree, Page *page, int index,
+                                  bool optimistic, const KeyType *key, uint64_t version)
+    : tree_(tree),
+      buffer_pool_manager_(tree->buffer_pool_manager_),
+      page_(page),
+      index_(index),
+      version_(version),
+      optimistic_(optimistic) {
+  if (key != nullptr) {
+    item_.first = *key;
+    has_key_ = true;
+    inclusive_ = true;
+  }
+  Settle();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE::IndexIterator(IndexIterator &&other) noexcept
+    : tree_(other.tree_),
+      buffer_pool_manager_(other.buffer_pool_manager_),
+      page_(other.page_),
+      index_(other.index_),
+      version_(other.version_),
+      optimistic_(other.optimistic_),
+      item_(other.item_),
+      has_key_(other.has_key_),
+      inclusive_(other.inclusive_) {
+  other.page_ = nullptr;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto INDEXITERATOR_TYPE::operator=(IndexIterator &&other) noexcept -> IndexIterator & {
+  if (this != &other) {
+    if (page_ != nullptr) {
+      buffer_pool_manager_->UnpinPage(page_->GetPageId(), false);
+    }
+    tree_ = other.tree_;
+    buffer_pool_manager_ = other.buffer_pool_manager_;
+    page_ = other.page_;
+    index_ = other.index_;
+    version_ = other.version_;
+    optimistic_ = other.optimistic_;
+    item_ = other.item_;
+    has_key_ = other.has_key_;
+    inclusive_ = other.inclusive_;
+    other.page_ = nullptr;
+  }
+  return *this;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE::~IndexIterator() {  // NOLINT
+  if (page_ != nullptr) {
+    buffer_pool_manager_->UnpinPage(page_->GetPageId(), false);
+  }
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-auto INDEXITERATOR_TYPE::IsEnd() -> bool { throw std::runtime_error("unimplemented"); }
+auto INDEXITERATOR_TYPE::IsEnd() -> bool { return page_ == nullptr; }
 
 INDEX_TEMPLATE_ARGUMENTS
-auto INDEXITERATOR_TYPE::operator*() -> const MappingType & { throw std::runtime_error("unimplemented"); }
+auto INDEXITERATOR_TYPE::operator*() -> const MappingType & {
+  BUSTUB_ASSERT(page_ != nullptr, "dereferencing the end iterator");
+  return item_;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto INDEXITERATOR_TYPE::operator++() -> INDEXITERATOR_TYPE & {
+  if (page_ != nullptr) {
+    index_++;
+    Settle();
+  }
+  return *this;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::Settle() {
+  Page *prev_page = nullptr;
+  uint64_t prev_version = 0;
+  MappingType prev_item;
+  bool prev_inclusive = false;
+  while (page_ != nullptr) {
+    page_id_t next_page_id;
+    int size = ReadLeaf(&next_page_id);
+    if (prev_page != nullptr) {
+      // a redistribution may have moved the first entries of this leaf into the previous one before they were read
+      bool changed = prev_page->GetVersion() != prev_version;
+      buffer_pool_manager_->UnpinPage(prev_page->GetPageId(), false);
+      prev_page = nullptr;
+      if (changed) {
+        item_ = prev_item;
+        inclusive_ = prev_inclusive;
+        Reseek();
+        return;
+      }
+    }
+    if (index_ < size) {
+      return;
+    }
+    if (size == 0) {
+      // merged into its left sibling
+      Reseek();
+      return;
+    }
+    if (next_page_id == INVALID_PAGE_ID) {
+      buffer_pool_manager_->UnpinPage(page_->GetPageId(), false);
+      page_ = nullptr;
+      return;
+    }
+
+    // Only one latch at a time: removals latch sibling leaves right to left as well as left to right. The next leaf is
+    // pinned before the current one is read again to check that it still follows, a pinned page is not reused.
+    Page *next_page = buffer_pool_manager_->FetchPage(next_page_id, AccessType::Index);
+    if (next_page == nullptr) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "can't fetch the next leaf page");
+    }
+    page_id_t following_page_id;
+    size = ReadLeaf(&following_page_id);
+    if (index_ < size || size == 0 || following_page_id != next_page_id) {
+      buffer_pool_manager_->UnpinPage(next_page_id, false);
+      continue;
+    }
+    prev_page = page_;
+    prev_version = version_;
+    prev_item = item_;
+    prev_inclusive = inclusive_;
+    page_ = next_page;
+    index_ = 0;
+    version_ = NO_VERSION;
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto INDEXITERATOR_TYPE::ReadLeaf(page_id_t *next_page_id) -> int {
+  auto *leaf = reinterpret_cast<LeafPage *>(page_->GetData());
+  for (int attempt = 0; optimistic_ && attempt < MAX_OPTIMISTIC_ATTEMPTS; attempt++) {
+    uint64_t version = page_->GetVersion();
+    if (version % 2 == 0) {
+      int size = leaf->GetSize();
+      int index = index_;
+      // a torn size could point past the page
+      bool valid = size <= leaf->GetMaxSize() &&
+                   (!has_key_ || version == version_ ||
+                    tree_->SearchLeafVersioned(page_, version, size, item_.first, !inclusive_, &index));
+      bool has_item = valid && index < size;
+      MappingType item;
+      if (has_item) {
+        item = leaf->GetItem(index);
+      }
+      page_id_t next = leaf->GetNextPageId();
+      if (valid && page_->ValidateVersion(version)) {
+        index_ = index;
+        version_ = version;
+        if (has_item) {
+          item_ = item;
+          has_key_ = true;
+          inclusive_ = false;
+        }
+        *next_page_id = next;
+        return size;
+      }
+    }
+    std::this_thread::yield();
+  }
+
+  page_->RLatch();
+  uint64_t version = page_->GetVersion();
+  int size = leaf->GetSize();
+  if (has_key_ && version != version_) {
+    index_ = leaf->KeyIndex(item_.first, tree_->comparator_);
+    if (!inclusive_ && index_ < size && tree_->comparator_(leaf->KeyAt(index_), item_.first) == 0) {
+      index_++;
+    }
+  }
+  version_ = version;
+  if (index_ < size) {
+    item_ = leaf->GetItem(index_);
+    has_key_ = true;
+    inclusive_ = false;
+  }
+  *next_page_id = leaf->GetNextPageId();
+  page_->RUnlatch();
+  return size;
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-auto INDEXITERATOR_TYPE::operator++() -> INDEXITERATOR_TYPE & { throw std::runtime_error("unimplemented"); }
+void INDEXITERATOR_TYPE::Reseek() {
+  auto *tree = tree_;
+  KeyType key = item_.first;
+  bool skip_key = has_key_ && !inclusive_;
+  *this = has_key_ ? tree->Begin(key) : tree->Begin();
+  if (skip_key && page_ != nullptr && tree->comparator_(item_.first, key) == 0) {
+    ++(*this);
+  }
+}
 
 template class IndexIterator<GenericKey<4>, RID, GenericComparator<4>>;
 
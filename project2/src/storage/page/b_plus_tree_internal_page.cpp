@@ -9,13 +9,54 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <sstream>
+#include <vector>
 
 #include "common/exception.h"
 #include "storage/page/b_plus_tree_internal_page.h"
 
 namespace bustub {
+
+namespace {
+
+/** Number of bytes of a key up to its last one that is not zero. */
+auto SignificantSize(const char *key, int key_size) -> int {
+  while (key_size > 0 && key[key_size - 1] == 0) {
+    key_size--;
+  }
+  return key_size;
+}
+
+auto CommonPrefixSize(const char *lhs, const char *rhs, int size) -> int {
+  int i = 0;
+  while (i < size && lhs[i] == rhs[i]) {
+    i++;
+  }
+  return i;
+}
+
+/** True if num_children entries of entry_size bytes fit after the header, first key and prefix of entries_offset. */
+auto FitsInPage(size_t entries_offset, int num_children, int entry_size) -> bool {
+  return entries_offset + static_cast<size_t>(num_children) * entry_size <= BUSTUB_PAGE_SIZE;
+}
+
+/** The prefix size and key size that compress the keys of all children but the first one the most. */
+template <typename Item>
+auto ComputeEncoding(const std::vector<Item> &items) -> std::pair<int, int> {
+  int prefix_size = sizeof(items[0].first);
+  int key_size = 0;
+  for (size_t i = 1; i < items.size(); i++) {
+    key_size = std::max(key_size, SignificantSize(items[i].first.data_, sizeof(items[i].first)));
+    prefix_size = std::min(prefix_size, CommonPrefixSize(items[1].first.data_, items[i].first.data_, prefix_size));
+  }
+  return {std::min(prefix_size, key_size), key_size};
+}
+
+}  // namespace
+
 /*****************************************************************************
  * HELPER METHODS AND UTILITIES
  *****************************************************************************/
@@ -25,27 +66,363 @@ namespace bustub {
  * max page size
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id, int max_size) {}
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id, int max_size) {
+  SetPageType(IndexPageType::INTERNAL_PAGE);
+  SetSize(0);
+  SetPageId(page_id);
+  SetParentPageId(parent_id);
+  SetMaxSize(max_size);
+  SetLSN();
+  prefix_size_ = 0;
+  key_size_ = 0;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetEncoding() const -> std::pair<int, int> {
+  int prefix_size = std::min<int>(prefix_size_, sizeof(KeyType));
+  int key_size = std::clamp<int>(key_size_, prefix_size, sizeof(KeyType));
+  return {prefix_size, key_size};
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::EntryAt(int index, int entry_size) const -> const char * {
+  if (index < 0 || !FitsInPage(INTERNAL_PAGE_ENTRIES_OFFSET, index + 1, entry_size)) {
+    return nullptr;
+  }
+  return entries_ + static_cast<size_t>(index) * entry_size;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::EntryAt(int index, int entry_size) -> char * {
+  return const_cast<char *>(static_cast<const BPlusTreeInternalPage *>(this)->EntryAt(index, entry_size));
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::WriteEntry(int index, const MappingType &item) {
+  auto [prefix_size, key_size] = GetEncoding();
+  char *entry = EntryAt(index, key_size - prefix_size + sizeof(ValueType));
+  BUSTUB_ASSERT(entry != nullptr, "internal page overflow");
+  if (index == 0) {
+    // the first key lives in first_key_
+    first_key_ = item.first;
+    memset(entry, 0, key_size - prefix_size);
+  } else {
+    memcpy(entry, item.first.data_ + prefix_size, key_size - prefix_size);
+  }
+  memcpy(entry + key_size - prefix_size, &item.second, sizeof(ValueType));
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::FitsEncoding(const KeyType &key) const -> bool {
+  auto [prefix_size, key_size] = GetEncoding();
+  return GetSize() > 1 && SignificantSize(key.data_, sizeof(KeyType)) <= key_size &&
+         memcmp(key.data_, prefix_, prefix_size) == 0;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetItems() const -> std::vector<MappingType> {
+  std::vector<MappingType> items;
+  items.reserve(GetSize() + 1);
+  for (int i = 0; i < GetSize(); i++) {
+    items.emplace_back(KeyAt(i), ValueAt(i));
+  }
+  return items;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetItems(const std::vector<MappingType> &items) {
+  auto [prefix_size, key_size] = ComputeEncoding(items);
+  BUSTUB_ASSERT(FitsInPage(INTERNAL_PAGE_ENTRIES_OFFSET, items.size(), key_size - prefix_size + sizeof(ValueType)),
+                "internal page overflow");
+  prefix_size_ = prefix_size;
+  key_size_ = key_size;
+  if (items.size() > 1) {
+    memcpy(prefix_, items[1].first.data_, prefix_size);
+  }
+  for (size_t i = 0; i < items.size(); i++) {
+    WriteEntry(static_cast<int>(i), items[i]);
+  }
+  SetSize(static_cast<int>(items.size()));
+}
+
 /*
  * Helper method to get/set the key associated with input "index"(a.k.a
  * array offset)
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::KeyAt(int index) const -> KeyType {
-  // replace with your own code
-  KeyType key{};
+  if (index == 0) {
+    return first_key_;
+  }
+  auto [prefix_size, key_size] = GetEncoding();
+  KeyType key;
+  memset(key.data_, 0, sizeof(KeyType));
+  const char *entry = EntryAt(index, key_size - prefix_size + sizeof(ValueType));
+  if (entry != nullptr) {
+    memcpy(key.data_, prefix_, prefix_size);
+    memcpy(key.data_ + prefix_size, entry, key_size - prefix_size);
+  }
   return key;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) {}
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) {
+  if (index == 0) {
+    first_key_ = key;
+  } else if (FitsEncoding(key)) {
+    WriteEntry(index, {key, ValueAt(index)});
+  } else {
+    auto items = GetItems();
+    items[index].first = key;
+    SetItems(items);
+  }
+}
 
 /*
  * Helper method to get the value associated with input "index"(a.k.a array
  * offset)
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const -> ValueType { return 0; }
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const -> ValueType {
+  auto [prefix_size, key_size] = GetEncoding();
+  const char *entry = EntryAt(index, key_size - prefix_size + sizeof(ValueType));
+  ValueType value{};
+  if (entry != nullptr) {
+    memcpy(&value, entry + key_size - prefix_size, sizeof(ValueType));
+  }
+  return value;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetValueAt(int index, const ValueType &value) {
+  auto [prefix_size, key_size] = GetEncoding();
+  memcpy(EntryAt(index, key_size - prefix_size + sizeof(ValueType)) + key_size - prefix_size, &value,
+         sizeof(ValueType));
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueIndex(const ValueType &value) const -> int {
+  for (int i = 0; i < GetSize(); i++) {
+    if (ValueAt(i) == value) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/*
+ * Binary search for the last key that is not greater than the input key, the first key is invalid and always matches.
+ * The keys are compared in place: the prefix is copied once, then only the bytes of each entry.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::Lookup(const KeyType &key, const KeyComparator &comparator) const -> ValueType {
+  auto [prefix_size, key_size] = GetEncoding();
+  int entry_size = key_size - prefix_size + sizeof(ValueType);
+  KeyType probe;
+  memcpy(probe.data_, prefix_, prefix_size);
+  memset(probe.data_ + key_size, 0, sizeof(KeyType) - key_size);
+  int low = 1;
+  int high = GetSize();
+  while (low < high) {
+    int mid = low + (high - low) / 2;
+    const char *entry = EntryAt(mid, entry_size);
+    if (entry == nullptr) {
+      high = mid;
+      continue;
+    }
+    memcpy(probe.data_ + prefix_size, entry, key_size - prefix_size);
+    if (comparator(key, probe) < 0) {
+      high = mid;
+    } else {
+      low = mid + 1;
+    }
+  }
+  const char *entry = EntryAt(low - 1, entry_size);
+  ValueType value{};
+  if (entry != nullptr) {
+    memcpy(&value, entry + key_size - prefix_size, sizeof(ValueType));
+  }
+  return value;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::HasRoomFor(const KeyType &key) const -> bool {
+  int key_size = SignificantSize(key.data_, sizeof(KeyType));
+  int prefix_size = key_size;
+  if (GetSize() > 1) {
+    auto [old_prefix_size, old_key_size] = GetEncoding();
+    key_size = std::max(key_size, old_key_size);
+    prefix_size = std::min(CommonPrefixSize(prefix_, key.data_, old_prefix_size), key_size);
+  }
+  return FitsInPage(INTERNAL_PAGE_ENTRIES_OFFSET, GetSize() + 1, key_size - prefix_size + sizeof(ValueType));
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::CanSetKeyAt(int index, const KeyType &key) const -> bool {
+  if (index == 0 || FitsEncoding(key)) {
+    return true;
+  }
+  auto items = GetItems();
+  items[index].first = key;
+  auto [prefix_size, key_size] = ComputeEncoding(items);
+  return FitsInPage(INTERNAL_PAGE_ENTRIES_OFFSET, items.size(), key_size - prefix_size + sizeof(ValueType));
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::HasRoomForAllOf(const BPlusTreeInternalPage *page, const KeyType &middle_key) const
+    -> bool {
+  auto items = GetItems();
+  auto other_items = page->GetItems();
+  other_items[0].first = middle_key;
+  items.insert(items.end(), other_items.begin(), other_items.end());
+  auto [prefix_size, key_size] = ComputeEncoding(items);
+  return FitsInPage(INTERNAL_PAGE_ENTRIES_OFFSET, items.size(), key_size - prefix_size + sizeof(ValueType));
+}
+
+/*****************************************************************************
+ * INSERTION AND REMOVAL
+ *****************************************************************************/
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::PopulateNewRoot(const ValueType &old_value, const KeyType &new_key,
+                                                     const ValueType &new_value) {
+  KeyType first_key;
+  memset(first_key.data_, 0, sizeof(KeyType));
+  SetItems({{first_key, old_value}, {new_key, new_value}});
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertNodeAfter(const ValueType &old_value, const KeyType &new_key,
+                                                     const ValueType &new_value) -> int {
+  int index = ValueIndex(old_value) + 1;
+  auto [prefix_size, key_size] = GetEncoding();
+  int entry_size = key_size - prefix_size + sizeof(ValueType);
+  if (FitsEncoding(new_key) && FitsInPage(INTERNAL_PAGE_ENTRIES_OFFSET, GetSize() + 1, entry_size)) {
+    memmove(EntryAt(index + 1, entry_size), EntryAt(index, entry_size), (GetSize() - index) * entry_size);
+    IncreaseSize(1);
+    WriteEntry(index, {new_key, new_value});
+  } else {
+    auto items = GetItems();
+    items.insert(items.begin() + index, {new_key, new_value});
+    SetItems(items);
+  }
+  return GetSize();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Append(const KeyType &key, const ValueType &value) {
+  auto [prefix_size, key_size] = GetEncoding();
+  int entry_size = key_size - prefix_size + sizeof(ValueType);
+  if (GetSize() == 0 ||
+      (FitsEncoding(key) && FitsInPage(INTERNAL_PAGE_ENTRIES_OFFSET, GetSize() + 1, entry_size))) {
+    IncreaseSize(1);
+    WriteEntry(GetSize() - 1, {key, value});
+  } else {
+    auto items = GetItems();
+    items.emplace_back(key, value);
+    SetItems(items);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertAndMoveHalfTo(const ValueType &old_value, const KeyType &new_key,
+                                                         const ValueType &new_value, BPlusTreeInternalPage *recipient,
+                                                         BufferPoolManager *buffer_pool_manager) {
+  // the page has no room for the new child, line them all up next to it
+  auto items = GetItems();
+  int new_index = ValueIndex(old_value) + 1;
+  items.insert(items.begin() + new_index, {new_key, new_value});
+  int num_items = static_cast<int>(items.size());
+  auto fits = [&](int begin, int end) {
+    std::vector<MappingType> half(items.begin() + begin, items.begin() + end);
+    auto [prefix_size, key_size] = ComputeEncoding(half);
+    return FitsInPage(INTERNAL_PAGE_ENTRIES_OFFSET, end - begin, key_size - prefix_size + sizeof(ValueType));
+  };
+  int split = (num_items + 1) / 2;
+  if (!fits(0, split) || !fits(split, num_items)) {
+    // Only the half with the new key can lack room, the other one is a part of what the page held. Split right before
+    // the new key: it is the first key of recipient then, which is stored in full. Unless that leaves a half below its
+    // min size, then that half has the new key and at most MinSize <= MIN_CAPACITY children.
+    int min_size = GetMinSize();
+    split = std::clamp(new_index, min_size, num_items - min_size);
+  }
+  SetItems({items.begin(), items.begin() + split});
+  recipient->SetItems({items.begin() + split, items.end()});
+  recipient->AdoptChildren(0, recipient->GetSize(), buffer_pool_manager);
+  if (ValueIndex(new_value) >= 0) {
+    AdoptChildren(ValueIndex(new_value), ValueIndex(new_value) + 1, buffer_pool_manager);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Remove(int index) {
+  // fewer keys never need more room, the prefix and key size stay as they are
+  if (index == 0 && GetSize() > 1) {
+    first_key_ = KeyAt(1);
+  }
+  auto [prefix_size, key_size] = GetEncoding();
+  int entry_size = key_size - prefix_size + sizeof(ValueType);
+  if (index + 1 < GetSize()) {
+    memmove(EntryAt(index, entry_size), EntryAt(index + 1, entry_size), (GetSize() - index - 1) * entry_size);
+  }
+  IncreaseSize(-1);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::RemoveAndReturnOnlyChild() -> ValueType {
+  SetSize(0);
+  return ValueAt(0);
+}
+
+/*****************************************************************************
+ * MERGE AND REDISTRIBUTE
+ *****************************************************************************/
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveAllTo(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
+                                               BufferPoolManager *buffer_pool_manager) {
+  auto items = recipient->GetItems();
+  int start = static_cast<int>(items.size());
+  auto moved_items = GetItems();
+  moved_items[0].first = middle_key;
+  items.insert(items.end(), moved_items.begin(), moved_items.end());
+  recipient->SetItems(items);
+  recipient->AdoptChildren(start, recipient->GetSize(), buffer_pool_manager);
+  SetSize(0);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveFirstToEndOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
+                                                      BufferPoolManager *buffer_pool_manager) {
+  recipient->Append(middle_key, ValueAt(0));
+  recipient->AdoptChildren(recipient->GetSize() - 1, recipient->GetSize(), buffer_pool_manager);
+  Remove(0);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveLastToFrontOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
+                                                       BufferPoolManager *buffer_pool_manager) {
+  auto items = recipient->GetItems();
+  items[0].first = middle_key;
+  items.insert(items.begin(), {KeyAt(GetSize() - 1), ValueAt(GetSize() - 1)});
+  recipient->SetItems(items);
+  recipient->AdoptChildren(0, 1, buffer_pool_manager);
+  IncreaseSize(-1);
+}
+
+/*
+ * The parent page id of a child is only read by the debug routines. It is written while the parent is write latched,
+ * without latching the child: a thread that is inside the child does not look at it.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::AdoptChildren(int begin, int end, BufferPoolManager *buffer_pool_manager) {
+  for (int i = begin; i < end; i++) {
+    Page *page = buffer_pool_manager->FetchPage(ValueAt(i), AccessType::Index);
+    if (page == nullptr) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "can't fetch the child of a B+ tree page");
+    }
+    reinterpret_cast<BPlusTreePage *>(page->GetData())->SetParentPageId(GetPageId());
+    buffer_pool_manager->UnpinPage(ValueAt(i), true);
+  }
+}
 
 // valuetype for internalNode should be page id_t
 template class BPlusTreeInternalPage<GenericKey<4>, page_id_t, GenericComparator<4>>;
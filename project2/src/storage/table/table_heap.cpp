@@ -12,6 +12,7 @@
 
 #include <cassert>
 
+#include "common/exception.h"
 #include "common/logger.h"
 #include "fmt/format.h"
 #include "storage/table/table_heap.h"
@@ -63,8 +64,9 @@ auto TableHeap::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn) -> b
       buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), false);
       cur_page = next_page;
     } else {
-      // Otherwise we have run out of valid pages. We need to create a new page.
-      auto new_page = static_cast<TablePage *>(buffer_pool_manager_->NewPage(&next_page_id));
+      // Otherwise we have run out of valid pages. We need to create a new page, right after this one on disk if we can.
+      auto new_page =
+          static_cast<TablePage *>(buffer_pool_manager_->NewPageNear(&next_page_id, cur_page->GetTablePageId()));
       // If we could not create a new page,
       if (new_page == nullptr) {
         // Then life sucks and we abort the transaction.
@@ -156,9 +158,10 @@ void TableHeap::RollbackDelete(const RID &rid, Transaction *txn) {
   buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
 }
 
-auto TableHeap::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, bool acquire_read_lock) -> bool {
+auto TableHeap::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, bool acquire_read_lock,
+                         AccessType access_type) -> bool {
   // Find the page which contains the tuple.
-  auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
+  auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId(), access_type));
   // If the page could not be found, then abort the transaction.
   if (page == nullptr) {
     txn->SetState(TransactionState::ABORTED);
@@ -182,10 +185,14 @@ auto TableHeap::Begin(Transaction *txn) -> TableIterator {
   RID rid;
   auto page_id = first_page_id_;
   while (page_id != INVALID_PAGE_ID) {
-    auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+    auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id, AccessType::Scan));
     page->RLatch();
     // If this fails because there is no tuple, then RID will be the default-constructed value, which means EOF.
     auto found_tuple = page->GetFirstTupleRid(&rid);
+    if (found_tuple) {
+      // start reading ahead the pages after the first one, TableIterator keeps it going
+      buffer_pool_manager_->PrefetchChain(page->GetNextPageId(), table_prefetch_pages, NextPageId);
+    }
     page->RUnlatch();
     buffer_pool_manager_->UnpinPage(page_id, false);
     if (found_tuple) {
@@ -196,6 +203,55 @@ auto TableHeap::Begin(Transaction *txn) -> TableIterator {
   return {this, rid, txn};
 }
 
+auto TableHeap::NextPageId(Page *page) -> page_id_t { return static_cast<TablePage *>(page)->GetNextPageId(); }
+
 auto TableHeap::End() -> TableIterator { return {this, RID(INVALID_PAGE_ID, 0), nullptr}; }
 
+auto TablePageCursor::ReadNextPage(std::vector<Tuple> *tuples, Transaction *txn) -> bool {
+  auto *buffer_pool_manager = table_heap_->buffer_pool_manager_;
+  TablePage *page;
+  {
+    std::scoped_lock lock(latch_);
+    if (next_page_id_ == INVALID_PAGE_ID) {
+      tuples->clear();
+      return false;
+    }
+    page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(next_page_id_, AccessType::Scan));
+    if (page == nullptr) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "can't fetch a table page, all frames are pinned");
+    }
+    page->RLatch();
+    next_page_id_ = page->GetNextPageId();
+    // read ahead like TableIterator does, only the cursor knows where the scan is
+    size_t num_pages = table_prefetch_pages;
+    if (num_pages > 0 && next_page_id_ != INVALID_PAGE_ID) {
+      if (pages_until_prefetch_ == 0) {
+        pages_until_prefetch_ = num_pages / 2;
+        buffer_pool_manager->PrefetchChain(next_page_id_, num_pages, TableHeap::NextPageId);
+      } else {
+        pages_until_prefetch_--;
+      }
+    }
+  }
+
+  // the page stays read latched, other threads are free to take the next pages meanwhile
+  size_t num_tuples = 0;
+  RID rid;
+  for (bool found = page->GetFirstTupleRid(&rid); found;) {
+    if (num_tuples == tuples->size()) {
+      tuples->emplace_back();
+    }
+    if (page->GetTuple(rid, &(*tuples)[num_tuples], txn, table_heap_->lock_manager_)) {
+      num_tuples++;
+    }
+    RID next_rid;
+    found = page->GetNextTupleRid(rid, &next_rid);
+    rid = next_rid;
+  }
+  tuples->resize(num_tuples);
+  page->RUnlatch();
+  buffer_pool_manager->UnpinPage(page->GetTablePageId(), false);
+  return true;
+}
+
 }  // namespace bustub
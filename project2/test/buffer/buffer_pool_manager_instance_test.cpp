@@ -12,12 +12,20 @@
 
 #include "buffer/buffer_pool_manager_instance.h"
 
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <condition_variable>  // NOLINT
 #include <cstdio>
+#include <mutex>  // NOLINT
 #include <random>
 #include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
 
 namespace bustub {
 
@@ -145,4 +153,365 @@ TEST(BufferPoolManagerInstanceTest, SampleTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, PageCleanerTest) {
+  const size_t buffer_pool_size = 10;
+
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  // Scenario: Without the cleaner, evicting dirty pages writes them back in the foreground.
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "%d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  EXPECT_EQ(1, bpm->GetForegroundFlushCount());
+  EXPECT_EQ(0, bpm->GetBackgroundFlushCount());
+
+  // Scenario: The cleaner writes back every dirty, unpinned frame it is asked to keep clean.
+  bpm->RunPageCleaner(buffer_pool_size);
+  for (int i = 0; i < 500 && bpm->GetBackgroundFlushCount() < buffer_pool_size; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(buffer_pool_size, bpm->GetBackgroundFlushCount());
+
+  // Scenario: Evicting the cleaned pages needs no foreground write.
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+  }
+  EXPECT_EQ(1, bpm->GetForegroundFlushCount());
+  bpm->StopPageCleaner();
+
+  // Scenario: The pages written back by the cleaner can be read again.
+  for (page_id_t page_id = 0; page_id < static_cast<page_id_t>(buffer_pool_size); ++page_id) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(std::to_string(page_id), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, PrefetchTest) {
+  const size_t buffer_pool_size = 10;
+  const page_id_t num_pages = 30;
+
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  // Scenario: Create a chain of pages, every page starts with the id of the next one. Only the last pages stay in the
+  // buffer pool.
+  page_id_t page_id_temp;
+  for (page_id_t i = 0; i < num_pages; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    *reinterpret_cast<page_id_t *>(page->GetData()) = i + 1 < num_pages ? i + 1 : INVALID_PAGE_ID;
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+  auto wait_for_prefetches = [&](uint64_t count) {
+    for (int i = 0; i < 500 && bpm->GetPrefetchCount() < count; ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(count, bpm->GetPrefetchCount());
+  };
+
+  // Scenario: Prefetching reads the evicted pages, and leaves the resident ones alone.
+  bpm->PrefetchPages({0, 1, num_pages - 1});
+  wait_for_prefetches(2);
+
+  // Scenario: Prefetching a chain follows the next page ids, and stops at the end of the chain.
+  auto next_page = [](Page *page) { return *reinterpret_cast<page_id_t *>(page->GetData()); };
+  bpm->PrefetchChain(2, 4, next_page);
+  wait_for_prefetches(6);
+  bpm->PrefetchChain(num_pages - 3, 10, next_page);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(6, bpm->GetPrefetchCount());
+
+  // Scenario: The prefetched pages are unpinned and hold the right data.
+  for (page_id_t page_id = 0; page_id < 6; ++page_id) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(1, page->GetPinCount());
+    EXPECT_EQ(page_id + 1, next_page(page));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  delete bpm;
+  delete disk_manager;
+}
+
+/**
+ * A disk manager that counts the pages it reads.
+ */
+class CountingDiskManager : public DiskManagerUnlimitedMemory {
+ public:
+  void ReadPage(page_id_t page_id, char *page_data) override {
+    num_reads_++;
+    DiskManagerUnlimitedMemory::ReadPage(page_id, page_data);
+  }
+
+  auto GetNumReads() -> int { return num_reads_.load(); }
+
+ private:
+  std::atomic<int> num_reads_{0};
+};
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ScanAccessTest) {
+  const size_t buffer_pool_size = 10;
+  const page_id_t num_hot_pages = 5;
+  const page_id_t num_pages = 40;
+
+  auto *disk_manager = new CountingDiskManager();
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, 2);
+
+  page_id_t page_id_temp;
+  for (page_id_t i = 0; i < num_pages; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Scenario: A few pages are used by lookups and become hot.
+  for (int round = 0; round < 2; ++round) {
+    for (page_id_t page_id = 0; page_id < num_hot_pages; ++page_id) {
+      ASSERT_NE(nullptr, bpm->FetchPage(page_id, AccessType::Lookup));
+      EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+    }
+  }
+
+  // Scenario: A scan passes through all the pages, several times per page like TableIterator does.
+  for (page_id_t page_id = 0; page_id < num_pages; ++page_id) {
+    for (int tuple = 0; tuple < 3; ++tuple) {
+      ASSERT_NE(nullptr, bpm->FetchPage(page_id, AccessType::Scan));
+      EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+    }
+  }
+
+  // Scenario: The scan recycled its own frames, the hot pages are still in the buffer pool.
+  int num_reads = disk_manager->GetNumReads();
+  for (page_id_t page_id = 0; page_id < num_hot_pages; ++page_id) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id, AccessType::Lookup));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(num_reads, disk_manager->GetNumReads());
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ClockReplacerTest) {
+  const size_t buffer_pool_size = 10;
+
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, LRUK_REPLACER_K, nullptr,
+                                            ReplacerType::CLOCK);
+
+  // Scenario: Fill the buffer pool and write every page's id into it.
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "%d", page_id_temp);
+  }
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+
+  // Scenario: Unpinning every page lets the clock evict them to make room for new pages.
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    EXPECT_EQ(true, bpm->UnpinPage(i, true));
+  }
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+  }
+
+  // Scenario: The evicted pages were written back and can be read again.
+  for (page_id_t page_id = 0; page_id < static_cast<page_id_t>(buffer_pool_size); ++page_id) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(std::to_string(page_id), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  delete bpm;
+  delete disk_manager;
+}
+
+/**
+ * A disk manager whose ReadPage blocks on a chosen page until the test releases it.
+ */
+class SlowReadDiskManager : public DiskManagerUnlimitedMemory {
+ public:
+  explicit SlowReadDiskManager(page_id_t slow_page_id) : slow_page_id_(slow_page_id) {}
+
+  void ReadPage(page_id_t page_id, char *page_data) override {
+    if (page_id == slow_page_id_) {
+      std::unique_lock<std::mutex> l(mutex_);
+      num_slow_reads_++;
+      cv_.notify_all();
+      cv_.wait(l, [&] { return released_; });
+    }
+    DiskManagerUnlimitedMemory::ReadPage(page_id, page_data);
+  }
+
+  /** Wait until some thread is blocked reading the slow page. */
+  void WaitForSlowRead() {
+    std::unique_lock<std::mutex> l(mutex_);
+    cv_.wait(l, [&] { return num_slow_reads_ > 0; });
+  }
+
+  void Release() {
+    std::unique_lock<std::mutex> l(mutex_);
+    released_ = true;
+    cv_.notify_all();
+  }
+
+  auto GetNumSlowReads() -> int {
+    std::unique_lock<std::mutex> l(mutex_);
+    return num_slow_reads_;
+  }
+
+ private:
+  page_id_t slow_page_id_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  int num_slow_reads_{0};
+  bool released_{false};
+};
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, HitDuringReadTest) {
+  const size_t buffer_pool_size = 4;
+  const page_id_t slow_page_id = 0;
+
+  auto *disk_manager = new SlowReadDiskManager(slow_page_id);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, 2);
+
+  // Scenario: page 0 is written and then pushed out of the buffer pool by pages {1, 2, 3, 4}.
+  page_id_t page_id_temp;
+  auto *page0 = bpm->NewPage(&page_id_temp);
+  ASSERT_NE(nullptr, page0);
+  snprintf(page0->GetData(), BUSTUB_PAGE_SIZE, "Hello");
+  EXPECT_EQ(true, bpm->UnpinPage(slow_page_id, true));
+  for (size_t i = 1; i <= buffer_pool_size; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+  }
+
+  // Scenario: two threads fetch page 0. The first one blocks inside ReadPage, the second one waits for that read.
+  std::atomic<Page *> fetched[2] = {nullptr, nullptr};
+  std::thread reader([&] { fetched[0] = bpm->FetchPage(slow_page_id); });
+  disk_manager->WaitForSlowRead();
+  std::thread waiter([&] { fetched[1] = bpm->FetchPage(slow_page_id); });
+
+  // Scenario: cache hits on other pages proceed while the read is in flight.
+  for (page_id_t page_id = 2; page_id <= 4; ++page_id) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(page_id, page->GetPageId());
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(nullptr, fetched[0].load());
+  EXPECT_EQ(nullptr, fetched[1].load());
+
+  // Scenario: once the read finishes, both fetchers get the same frame and the page was read only once.
+  disk_manager->Release();
+  reader.join();
+  waiter.join();
+  ASSERT_NE(nullptr, fetched[0].load());
+  EXPECT_EQ(fetched[0].load(), fetched[1].load());
+  EXPECT_EQ(0, strcmp(fetched[0].load()->GetData(), "Hello"));
+  EXPECT_EQ(2, fetched[0].load()->GetPinCount());
+  EXPECT_EQ(1, disk_manager->GetNumSlowReads());
+  EXPECT_EQ(true, bpm->UnpinPage(slow_page_id, false));
+  EXPECT_EQ(true, bpm->UnpinPage(slow_page_id, false));
+
+  delete bpm;
+  delete disk_manager;
+}
+
+/**
+ * A disk manager whose WritePages, the batches of the page cleaner, blocks until the test releases it.
+ */
+class SlowBatchDiskManager : public DiskManagerUnlimitedMemory {
+ public:
+  void WritePages(const std::vector<std::pair<page_id_t, const char *>> &pages) override {
+    {
+      std::unique_lock<std::mutex> l(mutex_);
+      num_slow_batches_++;
+      cv_.notify_all();
+      cv_.wait(l, [&] { return released_; });
+    }
+    DiskManagerUnlimitedMemory::WritePages(pages);
+  }
+
+  /** Wait until some thread is blocked writing a batch. */
+  void WaitForSlowBatch() {
+    std::unique_lock<std::mutex> l(mutex_);
+    cv_.wait(l, [&] { return num_slow_batches_ > 0; });
+  }
+
+  void Release() {
+    std::unique_lock<std::mutex> l(mutex_);
+    released_ = true;
+    cv_.notify_all();
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  int num_slow_batches_{0};
+  bool released_{false};
+};
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, FlushDuringCleaningTest) {
+  const size_t buffer_pool_size = 4;
+
+  auto *disk_manager = new SlowBatchDiskManager();
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  // Scenario: the page cleaner copies a dirty page and blocks in the middle of writing it back.
+  page_id_t page_id;
+  auto *page = bpm->NewPage(&page_id);
+  ASSERT_NE(nullptr, page);
+  snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "old");
+  EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  bpm->RunPageCleaner(buffer_pool_size);
+  disk_manager->WaitForSlowBatch();
+
+  // Scenario: the page is changed meanwhile. Flushing it waits for the cleaner, so the older image of the cleaner
+  // does not land on disk after the newer one.
+  page = bpm->FetchPage(page_id);
+  ASSERT_NE(nullptr, page);
+  snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "new");
+  EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  std::atomic<bool> flushed{false};
+  std::thread flusher([&] {
+    EXPECT_EQ(true, bpm->FlushPage(page_id));
+    flushed = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(flushed.load());
+
+  disk_manager->Release();
+  flusher.join();
+  bpm->StopPageCleaner();
+  char data[BUSTUB_PAGE_SIZE];
+  disk_manager->ReadPage(page_id, data);
+  EXPECT_EQ(0, strcmp(data, "new"));
+
+  delete bpm;
+  delete disk_manager;
+}
+
 }  // namespace bustub
@@ -19,7 +19,7 @@
 
 namespace bustub {
 
-TEST(ClockReplacerTest, DISABLED_SampleTest) {
+TEST(ClockReplacerTest, SampleTest) {
   ClockReplacer clock_replacer(7);
 
   // Scenario: unpin six elements, i.e. add them to the replacer.
@@ -57,6 +57,44 @@ TEST(ClockReplacerTest, DISABLED_SampleTest) {
   EXPECT_EQ(6, value);
   clock_replacer.Victim(&value);
   EXPECT_EQ(4, value);
+  EXPECT_EQ(0, clock_replacer.Size());
+  EXPECT_FALSE(clock_replacer.Victim(&value));
+}
+
+TEST(ClockReplacerTest, ConcurrencyTest) {
+  const size_t num_threads = 4;
+  const size_t frames_per_thread = 64;
+  ClockReplacer clock_replacer(num_threads * frames_per_thread);
+
+  // Scenario: every thread repeatedly pins and unpins its own frames while the others do the same.
+  std::vector<std::thread> threads;
+  for (size_t tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&, tid] {
+      for (int round = 0; round < 100; round++) {
+        for (size_t i = 0; i < frames_per_thread; i++) {
+          auto frame_id = static_cast<frame_id_t>(tid * frames_per_thread + i);
+          clock_replacer.RecordAccess(frame_id);
+          clock_replacer.SetEvictable(frame_id, false);
+          clock_replacer.SetEvictable(frame_id, true);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_threads * frames_per_thread, clock_replacer.Size());
+
+  // Scenario: every frame is evicted exactly once.
+  std::vector<bool> evicted(num_threads * frames_per_thread, false);
+  int value;
+  for (size_t i = 0; i < num_threads * frames_per_thread; i++) {
+    ASSERT_TRUE(clock_replacer.Evict(&value));
+    EXPECT_FALSE(evicted[value]);
+    evicted[value] = true;
+  }
+  EXPECT_FALSE(clock_replacer.Evict(&value));
+  EXPECT_EQ(0, clock_replacer.Size());
 }
 
 }  // namespace bustub
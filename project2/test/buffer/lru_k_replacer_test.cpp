@@ -16,7 +16,7 @@
 
 namespace bustub {
 
-TEST(LRUKReplacerTest, DISABLED_SampleTest) {
+TEST(LRUKReplacerTest, SampleTest) {
   LRUKReplacer lru_replacer(7, 2);
 
   // Scenario: add six elements to the replacer. We have [1,2,3,4,5]. Frame 6 is non-evictable.
@@ -97,4 +97,126 @@ TEST(LRUKReplacerTest, DISABLED_SampleTest) {
   lru_replacer.Remove(1);
   ASSERT_EQ(0, lru_replacer.Size());
 }
+
+TEST(LRUKReplacerTest, RandomizedTest) {
+  const size_t num_frames = 64;
+  const size_t k = 3;
+  LRUKReplacer lru_replacer(num_frames, k);
+
+  // Reference model: full access history and evictable flag of every tracked frame.
+  std::vector<std::vector<size_t>> history(num_frames);
+  std::vector<bool> evictable(num_frames, false);
+  size_t timestamp = 0;
+
+  std::default_random_engine gen(15445);
+  std::uniform_int_distribution<frame_id_t> frame_dist(0, num_frames - 1);
+  std::uniform_int_distribution<int> op_dist(0, 9);
+
+  for (int i = 0; i < 20000; i++) {
+    auto frame_id = frame_dist(gen);
+    auto op = op_dist(gen);
+    if (op < 5) {
+      if (history[frame_id].empty()) {
+        evictable[frame_id] = true;
+      }
+      history[frame_id].push_back(++timestamp);
+      lru_replacer.RecordAccess(frame_id);
+    } else if (op < 8) {
+      bool set_evictable = op == 5;
+      if (!history[frame_id].empty()) {
+        evictable[frame_id] = set_evictable;
+      }
+      lru_replacer.SetEvictable(frame_id, set_evictable);
+    } else {
+      // Expected victim: +inf distance first (ordered by first access), then the smallest kth most recent access.
+      frame_id_t expected = -1;
+      std::pair<bool, size_t> expected_key;
+      for (frame_id_t f = 0; f < static_cast<frame_id_t>(num_frames); f++) {
+        if (history[f].empty() || !evictable[f]) {
+          continue;
+        }
+        bool finite = history[f].size() >= k;
+        std::pair<bool, size_t> key = {finite, finite ? history[f][history[f].size() - k] : history[f].front()};
+        if (expected == -1 || key < expected_key) {
+          expected = f;
+          expected_key = key;
+        }
+      }
+      frame_id_t victim;
+      ASSERT_EQ(expected != -1, lru_replacer.Evict(&victim));
+      if (expected != -1) {
+        ASSERT_EQ(expected, victim);
+        history[victim].clear();
+        evictable[victim] = false;
+      }
+    }
+    size_t size = 0;
+    for (size_t f = 0; f < num_frames; f++) {
+      size += (!history[f].empty() && evictable[f]) ? 1 : 0;
+    }
+    ASSERT_EQ(size, lru_replacer.Size());
+  }
+}
+
+TEST(LRUKReplacerTest, PeekVictimsTest) {
+  const size_t num_frames = 64;
+  LRUKReplacer lru_replacer(num_frames, 3);
+
+  std::default_random_engine gen(15445);
+  std::uniform_int_distribution<frame_id_t> frame_dist(0, num_frames - 1);
+  for (int i = 0; i < 500; i++) {
+    lru_replacer.RecordAccess(frame_dist(gen));
+  }
+  for (frame_id_t frame_id = 0; frame_id < static_cast<frame_id_t>(num_frames); frame_id += 5) {
+    lru_replacer.SetEvictable(frame_id, false);
+  }
+
+  // Scenario: peeking does not evict, and lists frames in the exact order Evict picks them.
+  std::vector<frame_id_t> peeked;
+  lru_replacer.PeekVictims(20, &peeked);
+  ASSERT_EQ(20, peeked.size());
+  size_t size = lru_replacer.Size();
+  lru_replacer.PeekVictims(num_frames, &peeked);
+  EXPECT_EQ(size, peeked.size());
+  EXPECT_EQ(size, lru_replacer.Size());
+
+  for (auto expected : peeked) {
+    frame_id_t frame_id;
+    ASSERT_TRUE(lru_replacer.Evict(&frame_id));
+    EXPECT_EQ(expected, frame_id);
+  }
+  EXPECT_EQ(0, lru_replacer.Size());
+}
+
+TEST(LRUKReplacerTest, ScanAccessTest) {
+  LRUKReplacer lru_replacer(7, 2);
+
+  // Scenario: frames 1 and 2 are hot, 3 has been seen once.
+  lru_replacer.RecordAccess(1);
+  lru_replacer.RecordAccess(1);
+  lru_replacer.RecordAccess(2);
+  lru_replacer.RecordAccess(2);
+  lru_replacer.RecordAccess(3);
+
+  // Scenario: a scan passes through frames 4, 5, 6 and touches the hot frame 1 on its way.
+  lru_replacer.RecordAccess(4, AccessType::Scan);
+  lru_replacer.RecordAccess(5, AccessType::Scan);
+  lru_replacer.RecordAccess(4, AccessType::Scan);
+  lru_replacer.RecordAccess(1, AccessType::Scan);
+  lru_replacer.RecordAccess(6, AccessType::Scan);
+  ASSERT_EQ(6, lru_replacer.Size());
+
+  // Scenario: frame 5 turns out to be used by a lookup, it loses its scan-only status.
+  lru_replacer.RecordAccess(5, AccessType::Lookup);
+
+  // Scenario: the scan-only frames go first in the order they came in, then the rest as usual. The scan access to frame
+  // 1 did not make it hotter than frame 2.
+  frame_id_t frame_id;
+  for (frame_id_t expected : {4, 6, 3, 5, 1, 2}) {
+    ASSERT_TRUE(lru_replacer.Evict(&frame_id));
+    EXPECT_EQ(expected, frame_id);
+  }
+  EXPECT_EQ(0, lru_replacer.Size());
+}
+
 }  // namespace bustub
@@ -10,7 +10,7 @@
 
 namespace bustub {
 
-TEST(ExtendibleHashTableTest, DISABLED_SampleTest) {
+TEST(ExtendibleHashTableTest, SampleTest) {
   auto table = std::make_unique<ExtendibleHashTable<int, std::string>>(2);
 
   table->Insert(1, "a");
@@ -42,7 +42,35 @@ TEST(ExtendibleHashTableTest, DISABLED_SampleTest) {
   EXPECT_FALSE(table->Remove(20));
 }
 
-TEST(ExtendibleHashTableTest, DISABLED_ConcurrentInsertTest) {
+TEST(ExtendibleHashTableTest, RemoveReinsertTest) {
+  auto table = std::make_unique<ExtendibleHashTable<int, std::string>>(4);
+
+  // Scenario: removing from the middle of a full bucket moves its last item into the hole.
+  for (int i = 0; i < 4; i++) {
+    table->Insert(i, std::to_string(i));
+  }
+  EXPECT_EQ(1, table->GetNumBuckets());
+  EXPECT_TRUE(table->Remove(1));
+  EXPECT_FALSE(table->Remove(1));
+
+  std::string result;
+  for (int i : {0, 2, 3}) {
+    EXPECT_TRUE(table->Find(i, result));
+    EXPECT_EQ(std::to_string(i), result);
+  }
+  EXPECT_FALSE(table->Find(1, result));
+
+  // Scenario: the freed slot is reused without splitting, and overwriting keeps a single copy of the key.
+  table->Insert(4, "4");
+  table->Insert(4, "four");
+  EXPECT_EQ(1, table->GetNumBuckets());
+  EXPECT_TRUE(table->Find(4, result));
+  EXPECT_EQ("four", result);
+  EXPECT_TRUE(table->Remove(4));
+  EXPECT_FALSE(table->Find(4, result));
+}
+
+TEST(ExtendibleHashTableTest, ConcurrentInsertTest) {
   const int num_runs = 50;
   const int num_threads = 3;
 
@@ -68,4 +96,50 @@ TEST(ExtendibleHashTableTest, DISABLED_ConcurrentInsertTest) {
   }
 }
 
+TEST(ExtendibleHashTableTest, ContentionTest) {
+  const int num_threads = 8;
+  const int keys_per_thread = 2000;
+  auto table = std::make_unique<ExtendibleHashTable<int, int>>(4);
+
+  // Scenario: every thread inserts, overwrites, looks up and removes its own keys while the other threads keep
+  // splitting buckets and growing the directory, and also reads the keys of its neighbor.
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([tid, &table]() {
+      int val;
+      for (int i = 0; i < keys_per_thread; i++) {
+        int key = i * num_threads + tid;
+        table->Insert(key, key);
+        table->Insert(key, key + 1);
+        EXPECT_TRUE(table->Find(key, val));
+        EXPECT_EQ(key + 1, val);
+        int neighbor_key = i * num_threads + (tid + 1) % num_threads;
+        if (table->Find(neighbor_key, val)) {
+          EXPECT_TRUE(val == neighbor_key || val == neighbor_key + 1);
+        }
+      }
+      for (int i = 0; i < keys_per_thread; i += 2) {
+        EXPECT_TRUE(table->Remove(i * num_threads + tid));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  int val;
+  for (int key = 0; key < num_threads * keys_per_thread; key++) {
+    bool removed = (key / num_threads) % 2 == 0;
+    EXPECT_EQ(!removed, table->Find(key, val));
+    if (!removed) {
+      EXPECT_EQ(key + 1, val);
+    }
+  }
+  // every directory slot points to a bucket whose local depth does not exceed the global depth
+  int global_depth = table->GetGlobalDepth();
+  for (int i = 0; i < (1 << global_depth); i++) {
+    EXPECT_LE(table->GetLocalDepth(i), global_depth);
+  }
+}
+
 }  // namespace bustub
@@ -0,0 +1,117 @@
+/**
+ * page_table_test.cpp
+ */
+
+#include <memory>
+#include <random>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "common/exception.h"
+#include "container/hash/page_table.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+TEST(PageTableTest, SampleTest) {
+  auto table = std::make_unique<PageTable>(8);
+  EXPECT_EQ(16, table->GetCapacity());
+
+  for (page_id_t page_id = 0; page_id < 8; page_id++) {
+    table->Insert(page_id, page_id + 100);
+  }
+  EXPECT_EQ(8, table->Size());
+
+  frame_id_t frame_id;
+  for (page_id_t page_id = 0; page_id < 8; page_id++) {
+    ASSERT_TRUE(table->Find(page_id, frame_id));
+    EXPECT_EQ(page_id + 100, frame_id);
+  }
+  EXPECT_FALSE(table->Find(8, frame_id));
+
+  // Scenario: inserting an existing page overwrites its frame, inserting a new page into a full table throws.
+  table->Insert(3, 7);
+  ASSERT_TRUE(table->Find(3, frame_id));
+  EXPECT_EQ(7, frame_id);
+  EXPECT_THROW(table->Insert(8, 0), Exception);
+
+  EXPECT_TRUE(table->Remove(3));
+  EXPECT_FALSE(table->Remove(3));
+  EXPECT_FALSE(table->Find(3, frame_id));
+  EXPECT_EQ(7, table->Size());
+  table->Insert(8, 0);
+  ASSERT_TRUE(table->Find(8, frame_id));
+  EXPECT_EQ(0, frame_id);
+}
+
+TEST(PageTableTest, RandomizedTest) {
+  const size_t max_entries = 1000;
+  PageTable table(max_entries);
+  std::unordered_map<page_id_t, frame_id_t> expected;
+
+  // Scenario: random inserts and removes of a key space much larger than the table exercise long probe sequences and
+  // the backward shift of removal.
+  std::default_random_engine gen(15445);
+  std::uniform_int_distribution<page_id_t> page_dist(0, 100000);
+  for (int i = 0; i < 100000; i++) {
+    page_id_t page_id = page_dist(gen);
+    if (expected.size() < max_entries && i % 3 != 0) {
+      table.Insert(page_id, i);
+      expected[page_id] = i;
+    } else {
+      EXPECT_EQ(expected.erase(page_id) == 1, table.Remove(page_id));
+    }
+  }
+
+  EXPECT_EQ(expected.size(), table.Size());
+  frame_id_t frame_id;
+  for (auto [page_id, expected_frame_id] : expected) {
+    ASSERT_TRUE(table.Find(page_id, frame_id));
+    EXPECT_EQ(expected_frame_id, frame_id);
+  }
+}
+
+TEST(PageTableTest, ConcurrentReadTest) {
+  const page_id_t num_pages = 256;
+  PageTable table(2 * num_pages);
+  for (page_id_t page_id = 0; page_id < num_pages; page_id++) {
+    table.Insert(page_id, page_id);
+  }
+
+  // Scenario: readers never miss the stable pages while a writer keeps inserting and removing other pages next to
+  // them, which moves the stable pages around through backward shifts.
+  std::atomic<bool> stop{false};
+  std::thread writer([&] {
+    for (int round = 0; round < 200; round++) {
+      for (page_id_t page_id = num_pages; page_id < 2 * num_pages; page_id++) {
+        table.Insert(page_id, page_id);
+      }
+      for (page_id_t page_id = num_pages; page_id < 2 * num_pages; page_id++) {
+        table.Remove(page_id);
+      }
+    }
+    stop = true;
+  });
+
+  std::vector<std::thread> readers;
+  for (int tid = 0; tid < 2; tid++) {
+    readers.emplace_back([&] {
+      frame_id_t frame_id;
+      while (!stop) {
+        for (page_id_t page_id = 0; page_id < num_pages; page_id++) {
+          ASSERT_TRUE(table.Find(page_id, frame_id));
+          ASSERT_EQ(page_id, frame_id);
+        }
+      }
+    });
+  }
+
+  writer.join();
+  for (auto &reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(num_pages, table.Size());
+}
+
+}  // namespace bustub
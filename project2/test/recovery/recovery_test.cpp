@@ -10,7 +10,11 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <cstring>
+#include <filesystem>
 #include <string>
+#include <thread>  // NOLINT
+#include <utility>
 #include <vector>
 
 #include "buffer/buffer_pool_manager_instance.h"
@@ -25,6 +29,7 @@
 #include "recovery/checkpoint_manager.h"
 #include "recovery/log_manager.h"
 #include "recovery/log_recovery.h"
+#include "storage/disk/checksum_disk_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/table/table_heap.h"
 #include "storage/table/table_iterator.h"
@@ -320,4 +325,199 @@ TEST_F(RecoveryTest, DISABLED_CheckpointTest) {
   LOG_INFO("Shutdown System");
   delete bustub_instance;
 }
+
+/**
+ * Walk the log file and collect the lsn and type of every record.
+ */
+auto ReadLogHeaders(DiskManager *disk_manager) -> std::vector<std::pair<lsn_t, LogRecordType>> {
+  std::vector<std::pair<lsn_t, LogRecordType>> records;
+  std::vector<char> log(LOG_BUFFER_SIZE);
+  int offset = 0;
+  while (disk_manager->ReadLog(log.data(), LOG_BUFFER_SIZE, offset)) {
+    int pos = 0;
+    while (pos + static_cast<int>(sizeof(int32_t)) <= LOG_BUFFER_SIZE) {
+      // the header is | size | LSN | transID | prevLSN | LogType |
+      auto size = *reinterpret_cast<int32_t *>(log.data() + pos);
+      if (size == 0 || pos + size > LOG_BUFFER_SIZE) {
+        break;
+      }
+      auto lsn = *reinterpret_cast<lsn_t *>(log.data() + pos + 4);
+      auto type = *reinterpret_cast<LogRecordType *>(log.data() + pos + 16);
+      records.emplace_back(lsn, type);
+      pos += size;
+    }
+    if (pos == 0) {
+      break;
+    }
+    offset += pos;
+  }
+  return records;
+}
+
+// NOLINTNEXTLINE
+TEST_F(RecoveryTest, GroupCommitTest) {
+  // ctest runs the tests in parallel, so this one keeps its own files
+  remove("group_commit_test.db");
+  remove("group_commit_test.log");
+  auto *disk_manager = new DiskManager("group_commit_test.db");
+  auto *log_manager = new LogManager(disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *txn_manager = new TransactionManager(lock_manager, log_manager);
+
+  // Scenario: without the flush thread, waiting for an lsn flushes the log buffer in the caller.
+  LogRecord begin_record(0, INVALID_LSN, LogRecordType::BEGIN);
+  lsn_t begin_lsn = log_manager->AppendLogRecord(&begin_record);
+  EXPECT_EQ(0, begin_lsn);
+  EXPECT_EQ(INVALID_LSN, log_manager->GetPersistentLSN());
+  log_manager->WaitForFlush(begin_lsn);
+  EXPECT_EQ(begin_lsn, log_manager->GetPersistentLSN());
+  EXPECT_EQ(1, disk_manager->GetNumFlushes());
+
+  // Scenario: concurrent committers return only once their COMMIT record is on disk, and share the flushes.
+  log_manager->RunFlushThread();
+  ASSERT_TRUE(enable_logging);
+  const int num_threads = 8;
+  const int txns_per_thread = 50;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_threads; i++) {
+    threads.emplace_back([&] {
+      for (int j = 0; j < txns_per_thread; j++) {
+        Transaction *txn = txn_manager->Begin();
+        txn_manager->Commit(txn);
+        EXPECT_LE(txn->GetPrevLSN(), log_manager->GetPersistentLSN());
+        delete txn;
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  log_manager->StopFlushThread();
+  ASSERT_FALSE(enable_logging);
+  EXPECT_LE(disk_manager->GetNumFlushes(), 1 + num_threads * txns_per_thread);
+
+  // Scenario: the log holds one BEGIN and one COMMIT record per transaction, in lsn order.
+  auto records = ReadLogHeaders(disk_manager);
+  int num_begins = 0;
+  int num_commits = 0;
+  for (size_t i = 0; i < records.size(); i++) {
+    EXPECT_EQ(static_cast<lsn_t>(i), records[i].first);
+    num_begins += records[i].second == LogRecordType::BEGIN ? 1 : 0;
+    num_commits += records[i].second == LogRecordType::COMMIT ? 1 : 0;
+  }
+  EXPECT_EQ(1 + num_threads * txns_per_thread, num_begins);
+  EXPECT_EQ(num_threads * txns_per_thread, num_commits);
+
+  delete txn_manager;
+  delete lock_manager;
+  delete log_manager;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  remove("group_commit_test.db");
+  remove("group_commit_test.log");
+}
+
+// NOLINTNEXTLINE
+TEST_F(RecoveryTest, ConcurrentAppendTest) {
+  remove("concurrent_append_test.db");
+  remove("concurrent_append_test.log");
+  auto *disk_manager = new DiskManager("concurrent_append_test.db");
+  auto *log_manager = new LogManager(disk_manager);
+  Column col{"a", TypeId::VARCHAR, 200};
+  Schema schema{std::vector<Column>{col}};
+  const Tuple tuple({Value(TypeId::VARCHAR, std::string(200, 'x'))}, &schema);
+  const int num_threads = 8;
+  const int records_per_thread = 500;
+
+  // Scenario: appenders copy their records in parallel and fill both buffers many times over, with and without the
+  // flush thread. Every record ends up in the log exactly once, in lsn order.
+  for (bool flush_thread : {false, true}) {
+    if (flush_thread) {
+      log_manager->RunFlushThread();
+    }
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_threads; i++) {
+      threads.emplace_back([&, i] {
+        LogRecord record(i, INVALID_LSN, LogRecordType::INSERT, RID(i, 0), tuple);
+        for (int j = 0; j < records_per_thread; j++) {
+          log_manager->AppendLogRecord(&record);
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    if (flush_thread) {
+      log_manager->StopFlushThread();
+    }
+  }
+  lsn_t last_lsn = log_manager->GetNextLSN() - 1;
+  EXPECT_EQ(2 * num_threads * records_per_thread - 1, last_lsn);
+  log_manager->WaitForFlush(last_lsn);
+  EXPECT_EQ(last_lsn, log_manager->GetPersistentLSN());
+  EXPECT_GT(disk_manager->GetNumFlushes(), 2);
+
+  auto records = ReadLogHeaders(disk_manager);
+  ASSERT_EQ(static_cast<size_t>(last_lsn + 1), records.size());
+  for (size_t i = 0; i < records.size(); i++) {
+    EXPECT_EQ(static_cast<lsn_t>(i), records[i].first);
+    EXPECT_EQ(LogRecordType::INSERT, records[i].second);
+  }
+
+  delete log_manager;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  remove("concurrent_append_test.db");
+  remove("concurrent_append_test.log");
+}
+
+// NOLINTNEXTLINE
+TEST_F(RecoveryTest, TornPageRepairTest) {
+  std::vector<std::string> extensions{".db", ".log", ".crc", ".dwb"};
+  for (const auto &extension : extensions) {
+    remove(("torn_page_test" + extension).c_str());
+    remove(("torn_page_crash" + extension).c_str());
+  }
+  const page_id_t num_pages = 5;
+  {
+    ChecksumDiskManager disk_manager("torn_page_test.db", 16);
+    BufferPoolManagerInstance bpm(10, &disk_manager);
+    for (page_id_t i = 0; i < num_pages; i++) {
+      page_id_t page_id;
+      Page *page = bpm.NewPage(&page_id);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+      bpm.UnpinPage(page_id, true);
+    }
+    // Scenario: the buffer pool flushes its pages as a single batch, with a single sync of the double-write buffer.
+    bpm.FlushAllPages();
+    EXPECT_EQ(1, disk_manager.GetNumDoubleWriteBatches());
+
+    // Crash: the files as they are now, with the second half of page 2 torn.
+    for (const auto &extension : extensions) {
+      std::filesystem::copy_file("torn_page_test" + extension, "torn_page_crash" + extension);
+    }
+    FILE *file = fopen("torn_page_crash.db", "r+b");
+    ASSERT_NE(nullptr, file);
+    fseek(file, 2 * BUSTUB_PAGE_SIZE + BUSTUB_PAGE_SIZE / 2, SEEK_SET);
+    fwrite(std::string(BUSTUB_PAGE_SIZE / 2, 'y').data(), 1, BUSTUB_PAGE_SIZE / 2, file);
+    fclose(file);
+  }
+
+  // Scenario: on restart, recovery restores the torn page before replaying the log.
+  ChecksumDiskManager disk_manager("torn_page_crash.db", 16);
+  LogRecovery log_recovery(&disk_manager, nullptr);
+  EXPECT_EQ(1, log_recovery.RepairPages());
+  char buf[BUSTUB_PAGE_SIZE];
+  for (page_id_t page_id = 0; page_id < num_pages; page_id++) {
+    EXPECT_TRUE(disk_manager.VerifyPage(page_id, buf)) << page_id;
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(buf));
+  }
+  disk_manager.ShutDown();
+  for (const auto &extension : extensions) {
+    remove(("torn_page_test" + extension).c_str());
+    remove(("torn_page_crash" + extension).c_str());
+  }
+}
+
 }  // namespace bustub
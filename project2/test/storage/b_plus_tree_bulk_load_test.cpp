@@ -0,0 +1,242 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_bulk_load_test.cpp
+//
+// Identification: test/storage/b_plus_tree_bulk_load_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "catalog/catalog.h"
+#include "gtest/gtest.h"
+#include "storage/index/b_plus_tree.h"
+#include "storage/index/external_sorter.h"
+#include "test_util.h"  // NOLINT
+#include "type/value_factory.h"
+
+namespace bustub {
+
+using BulkLoadTree = BPlusTree<GenericKey<8>, RID, GenericComparator<8>>;
+using BulkLoadLeaf = BPlusTreeLeafPage<GenericKey<8>, RID, GenericComparator<8>>;
+using BulkLoadInternal = BPlusTreeInternalPage<GenericKey<8>, page_id_t, GenericComparator<8>>;
+
+/** Check that every page but the root is between its min and max size, and return the height of the subtree. */
+auto CheckPageSizes(BufferPoolManager *bpm, page_id_t page_id, bool is_root) -> int {
+  auto *page = bpm->FetchPage(page_id);
+  auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  int height = 1;
+  if (!is_root) {
+    EXPECT_GE(node->GetSize(), node->GetMinSize());
+  }
+  if (node->IsLeafPage()) {
+    EXPECT_LT(node->GetSize(), node->GetMaxSize());
+  } else {
+    auto *internal = reinterpret_cast<BulkLoadInternal *>(node);
+    EXPECT_LE(internal->GetSize(), internal->GetMaxSize());
+    for (int i = 0; i < internal->GetSize(); i++) {
+      height = CheckPageSizes(bpm, internal->ValueAt(i), false) + 1;
+    }
+  }
+  bpm->UnpinPage(page_id, false);
+  return height;
+}
+
+TEST(BPlusTreeTests, ExternalSorterTest) {
+  std::mt19937 gen(0);
+  std::vector<std::pair<int, int>> items;
+  for (int i = 0; i < 1000; i++) {
+    items.emplace_back(static_cast<int>(gen() % 100), i);
+  }
+  auto less = [](const std::pair<int, int> &lhs, const std::pair<int, int> &rhs) { return lhs.first < rhs.first; };
+
+  // Scenario: runs of 64 items spill to temporary files, the merge is sorted and keeps equal items in order.
+  ExternalSorter<std::pair<int, int>, decltype(less)> sorter(less, 64);
+  for (const auto &item : items) {
+    sorter.Add(item);
+  }
+  EXPECT_EQ(sorter.GetNumSpilledRuns(), 15);
+  std::vector<std::pair<int, int>> sorted;
+  std::pair<int, int> item;
+  while (sorter.Next(&item)) {
+    sorted.push_back(item);
+  }
+  std::stable_sort(items.begin(), items.end(), less);
+  EXPECT_EQ(sorted, items);
+
+  // Scenario: fewer items than a run never touch a file.
+  ExternalSorter<std::pair<int, int>, decltype(less)> small_sorter(less, 64);
+  small_sorter.Add({2, 0});
+  small_sorter.Add({1, 1});
+  EXPECT_TRUE(small_sorter.Next(&item));
+  EXPECT_EQ(item.first, 1);
+  EXPECT_TRUE(small_sorter.Next(&item));
+  EXPECT_FALSE(small_sorter.Next(&item));
+  EXPECT_EQ(small_sorter.GetNumSpilledRuns(), 0);
+
+  // Scenario: threads adding through lanes of their own at once sort and spill their own runs, the merge sees them all.
+  const size_t num_lanes = 4;
+  ExternalSorter<std::pair<int, int>, decltype(less)> lane_sorter(less, 64, num_lanes);
+  std::vector<std::thread> threads;
+  for (size_t lane = 0; lane < num_lanes; lane++) {
+    threads.emplace_back([&, lane] {
+      for (size_t i = lane; i < items.size(); i += num_lanes) {
+        lane_sorter.Add(items[i], lane);
+      }
+      lane_sorter.FinishLane(lane);
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(lane_sorter.GetNumSpilledRuns(), 12);
+  std::vector<int> keys;
+  while (lane_sorter.Next(&item)) {
+    keys.push_back(item.first);
+  }
+  ASSERT_EQ(keys.size(), items.size());
+  for (size_t i = 0; i < items.size(); i++) {
+    EXPECT_EQ(keys[i], items[i].first);
+  }
+}
+
+TEST(BPlusTreeTests, BulkLoadTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  ASSERT_EQ(page_id, HEADER_PAGE_ID);
+  (void)header_page;
+
+  const int64_t num_keys = 2000;
+  for (double fill_factor : {1.0, 0.5}) {
+    BulkLoadTree tree("foo_pk", bpm, comparator, 5, 5);
+    // Scenario: a sorted stream with duplicate keys loads the first entry of every key.
+    int64_t next_key = 0;
+    bool duplicate = false;
+    auto next = [&](std::pair<GenericKey<8>, RID> *entry) {
+      if (next_key == num_keys) {
+        return false;
+      }
+      entry->first.SetFromInteger(next_key);
+      entry->second.Set(duplicate ? 1 : 0, static_cast<uint32_t>(next_key));
+      if (next_key % 10 == 0 && !duplicate) {
+        duplicate = true;
+      } else {
+        duplicate = false;
+        next_key++;
+      }
+      return true;
+    };
+    ASSERT_TRUE(tree.BulkLoad(next, fill_factor));
+
+    GenericKey<8> index_key;
+    for (int64_t key = 0; key < num_keys; key++) {
+      std::vector<RID> result;
+      index_key.SetFromInteger(key);
+      ASSERT_TRUE(tree.GetValue(index_key, &result));
+      EXPECT_EQ(result[0].GetPageId(), 0);
+      EXPECT_EQ(result[0].GetSlotNum(), key);
+    }
+    int64_t size = 0;
+    for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator) {
+      EXPECT_EQ((*iterator).second.GetSlotNum(), size);
+      size++;
+    }
+    EXPECT_EQ(size, num_keys);
+    // Scenario: no page is below its min size, not even the last ones of a level, and every leaf is as deep.
+    CheckPageSizes(bpm, tree.GetRootPageId(), true);
+
+    // Scenario: a loaded tree can only be loaded once.
+    EXPECT_FALSE(tree.BulkLoad([](std::pair<GenericKey<8>, RID> *entry) { return false; }));
+
+    // Scenario: the loaded tree takes inserts and removes like any other.
+    RID rid;
+    for (int64_t key = num_keys; key < num_keys + 100; key++) {
+      rid.Set(0, static_cast<uint32_t>(key));
+      index_key.SetFromInteger(key);
+      EXPECT_TRUE(tree.Insert(index_key, rid));
+    }
+    for (int64_t key = 0; key < num_keys + 100; key++) {
+      index_key.SetFromInteger(key);
+      tree.Remove(index_key);
+    }
+    EXPECT_TRUE(tree.IsEmpty());
+  }
+
+  // Scenario: loading nothing leaves the tree empty.
+  BulkLoadTree empty_tree("bar_pk", bpm, comparator, 5, 5);
+  EXPECT_TRUE(empty_tree.BulkLoad([](std::pair<GenericKey<8>, RID> *entry) { return false; }));
+  EXPECT_TRUE(empty_tree.IsEmpty());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeTests, CreateIndexBulkLoadTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(64, disk_manager);
+  // the index keeps its root page id in the header page
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+  ASSERT_EQ(page_id, HEADER_PAGE_ID);
+  auto *catalog = new Catalog(bpm, nullptr, nullptr);
+  Transaction txn(0);
+
+  std::vector<Column> columns;
+  columns.emplace_back("a", TypeId::BIGINT);
+  columns.emplace_back("b", TypeId::INTEGER);
+  Schema schema(columns);
+  auto *table_info = catalog->CreateTable(&txn, "t", schema);
+  const int64_t num_rows = 3000;
+  std::vector<RID> rids(num_rows);
+  for (int64_t i = 0; i < num_rows; i++) {
+    // the keys go in out of order
+    int64_t key = (i * 7919) % num_rows;
+    Tuple tuple({ValueFactory::GetBigIntValue(key), ValueFactory::GetIntegerValue(static_cast<int32_t>(i))}, &schema);
+    ASSERT_TRUE(table_info->table_->InsertTuple(tuple, &rids[key], &txn));
+  }
+
+  std::vector<Column> key_columns;
+  key_columns.emplace_back("a", TypeId::BIGINT);
+  Schema key_schema(key_columns);
+  for (size_t num_threads : {1, 4}) {
+    // Scenario: CREATE INDEX on a table with rows finds every row through the index, however many threads read it.
+    index_build_threads = num_threads;
+    auto *index_info = catalog->CreateIndex<GenericKey<8>, RID, GenericComparator<8>>(
+        &txn, "t_a" + std::to_string(num_threads), "t", schema, key_schema, {0}, 8, HashFunction<GenericKey<8>>());
+    ASSERT_NE(index_info, Catalog::NULL_INDEX_INFO);
+    for (int64_t key = 0; key < num_rows; key++) {
+      std::vector<RID> result;
+      index_info->index_->ScanKey(Tuple({ValueFactory::GetBigIntValue(key)}, &key_schema), &result, &txn);
+      ASSERT_EQ(result.size(), 1);
+      EXPECT_EQ(result[0], rids[key]);
+    }
+  }
+  index_build_threads = 0;
+
+  delete catalog;
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+}  // namespace bustub
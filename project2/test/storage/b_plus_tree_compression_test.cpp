@@ -0,0 +1,181 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_compression_test.cpp
+//
+// Identification: test/storage/b_plus_tree_compression_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/index/b_plus_tree.h"
+#include "test_util.h"  // NOLINT
+#include "type/value_factory.h"
+
+namespace bustub {
+
+using CompressedTree = BPlusTree<GenericKey<64>, RID, GenericComparator<64>>;
+using CompressedInternal = BPlusTreeInternalPage<GenericKey<64>, page_id_t, GenericComparator<64>>;
+
+auto MakeKey(const std::vector<Value> &values, Schema *key_schema) -> GenericKey<64> {
+  GenericKey<64> key;
+  key.SetFromKey(Tuple(values, key_schema));
+  return key;
+}
+
+auto MakeKey(const std::string &name, Schema *key_schema) -> GenericKey<64> {
+  return MakeKey({ValueFactory::GetVarcharValue(name)}, key_schema);
+}
+
+/** A customer name, all of them share a long prefix and are as long. */
+auto CustomerName(int64_t i) -> std::string {
+  std::string number = std::to_string(i);
+  return "customer/eu-west/" + std::string(8 - number.size(), '0') + number;
+}
+
+/** Return the height of the subtree, and the most children of an internal page in it. */
+auto MeasureTree(BufferPoolManager *bpm, page_id_t page_id, int *max_children) -> int {
+  auto *page = bpm->FetchPage(page_id);
+  auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  int height = 1;
+  if (!node->IsLeafPage()) {
+    auto *internal = reinterpret_cast<CompressedInternal *>(node);
+    *max_children = std::max(*max_children, internal->GetSize());
+    height = MeasureTree(bpm, internal->ValueAt(0), max_children) + 1;
+  }
+  bpm->UnpinPage(page_id, false);
+  return height;
+}
+
+TEST(BPlusTreeTests, ShortestSeparatorTest) {
+  auto key_schema = ParseCreateStatement("a varchar(40),b bigint");
+  GenericComparator<64> comparator(key_schema.get());
+  auto key = [&](const std::string &a, int64_t b) {
+    return MakeKey({ValueFactory::GetVarcharValue(a), ValueFactory::GetBigIntValue(b)}, key_schema.get());
+  };
+  auto expect_key = [&](const GenericKey<64> &actual, const std::string &a, int64_t b) {
+    EXPECT_EQ(actual.ToValue(key_schema.get(), 0).ToString(), a);
+    EXPECT_EQ(actual.ToValue(key_schema.get(), 1).GetAs<int64_t>(), b);
+  };
+
+  // Scenario: the first column that differs is zeroed after its first character that differs, the columns after it are
+  // zero. Strings keep their length.
+  expect_key(comparator.ShortestSeparator(key("apple pie", 7), key("apricot jam", 3)), "apr" + std::string(8, '\0'),
+             0);
+  // Scenario: a string that is a prefix of the other one is zeroed after the next character.
+  expect_key(comparator.ShortestSeparator(key("ab", 5), key("abcdef", 1)), "abc" + std::string(3, '\0'), 0);
+  // Scenario: when only the last column differs, there is nothing shorter than the key on the right.
+  expect_key(comparator.ShortestSeparator(key("same", 1), key("same", 9)), "same", 9);
+  // Scenario: a separator of equal keys is the key itself.
+  expect_key(comparator.ShortestSeparator(key("same", 1), key("same", 1)), "same", 1);
+  // Scenario: a separator that would be greater than the key on the right is not used.
+  expect_key(comparator.ShortestSeparator(key("ab", 5), key("abc", -1)), "abc", -1);
+}
+
+TEST(BPlusTreeTests, InternalPagePrefixCompressionTest) {
+  auto key_schema = ParseCreateStatement("a varchar(40)");
+  GenericComparator<64> comparator(key_schema.get());
+  auto name = [](int i) { return CustomerName(i); };
+
+  char data[BUSTUB_PAGE_SIZE];
+  auto *page = reinterpret_cast<CompressedInternal *>(data);
+  page->Init(1);
+  // Scenario: keys with a long common prefix take a few bytes each, many more than MIN_CAPACITY of them fit.
+  int size = 0;
+  while (page->HasRoomFor(MakeKey(name(size), key_schema.get()))) {
+    page->Append(MakeKey(name(size), key_schema.get()), size);
+    size++;
+  }
+  EXPECT_GT(size, 3 * CompressedInternal::MIN_CAPACITY);
+  for (int i = 1; i < size; i++) {
+    EXPECT_EQ(comparator(page->KeyAt(i), MakeKey(name(i), key_schema.get())), 0);
+    EXPECT_EQ(page->ValueAt(i), i);
+  }
+  EXPECT_EQ(page->Lookup(MakeKey(name(42), key_schema.get()), comparator), 42);
+
+  // Scenario: a key without the common prefix does not fit in a page that is that full.
+  EXPECT_FALSE(page->CanSetKeyAt(1, MakeKey("a completely different key", key_schema.get())));
+  EXPECT_TRUE(page->CanSetKeyAt(1, MakeKey(name(size), key_schema.get())));
+
+  // Scenario: removing the first child keeps the next key, it is the one to push up after a split.
+  page->Remove(0);
+  EXPECT_EQ(comparator(page->KeyAt(0), MakeKey(name(1), key_schema.get())), 0);
+  EXPECT_EQ(page->ValueAt(0), 1);
+}
+
+TEST(BPlusTreeTests, PrefixCompressionTest) {
+  auto key_schema = ParseCreateStatement("a varchar(40)");
+  GenericComparator<64> comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(64, disk_manager);
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  const int num_keys = 5000;
+  std::vector<int> order(num_keys);
+  for (int i = 0; i < num_keys; i++) {
+    order[i] = i;
+  }
+  std::shuffle(order.begin(), order.end(), std::mt19937(0));
+  auto name = [](int i) { return CustomerName(i * 7); };
+
+  // Scenario: keys inserted out of order end up in internal pages with more children than uncompressed keys fit.
+  CompressedTree tree("foo_pk", bpm, comparator, 4);
+  RID rid;
+  for (int i : order) {
+    rid.Set(0, i);
+    ASSERT_TRUE(tree.Insert(MakeKey(name(i), key_schema.get()), rid));
+  }
+  int max_children = 0;
+  MeasureTree(bpm, tree.GetRootPageId(), &max_children);
+  EXPECT_GT(max_children, CompressedInternal::MIN_CAPACITY);
+
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<RID> result;
+    ASSERT_TRUE(tree.GetValue(MakeKey(name(i), key_schema.get()), &result));
+    EXPECT_EQ(result[0].GetSlotNum(), i);
+    // keys in between the separators are not in the tree
+    result.clear();
+    EXPECT_FALSE(tree.GetValue(MakeKey(name(i) + "5", key_schema.get()), &result));
+  }
+  int next = 0;
+  for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator) {
+    EXPECT_EQ((*iterator).second.GetSlotNum(), next);
+    next++;
+  }
+  EXPECT_EQ(next, num_keys);
+
+  // Scenario: removing the keys in another order merges and redistributes the compressed pages.
+  std::shuffle(order.begin(), order.end(), std::mt19937(1));
+  for (int n = 0; n < num_keys; n++) {
+    tree.Remove(MakeKey(name(order[n]), key_schema.get()));
+    if (n == num_keys / 2) {
+      for (int m = n + 1; m < num_keys; m++) {
+        std::vector<RID> result;
+        ASSERT_TRUE(tree.GetValue(MakeKey(name(order[m]), key_schema.get()), &result));
+        EXPECT_EQ(result[0].GetSlotNum(), order[m]);
+      }
+    }
+  }
+  EXPECT_TRUE(tree.IsEmpty());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+}  // namespace bustub
@@ -12,6 +12,7 @@
 
 #include <algorithm>
 #include <cstdio>
+#include <vector>
 
 #include "buffer/buffer_pool_manager_instance.h"
 #include "gtest/gtest.h"
@@ -20,7 +21,7 @@
 
 namespace bustub {
 
-TEST(BPlusTreeTests, DISABLED_DeleteTest1) {
+TEST(BPlusTreeTests, DeleteTest1) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
@@ -92,7 +93,7 @@ TEST(BPlusTreeTests, DISABLED_DeleteTest1) {
   remove("test.log");
 }
 
-TEST(BPlusTreeTests, DISABLED_DeleteTest2) {
+TEST(BPlusTreeTests, DeleteTest2) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
@@ -163,4 +164,67 @@ TEST(BPlusTreeTests, DISABLED_DeleteTest2) {
   remove("test.db");
   remove("test.log");
 }
+
+TEST(BPlusTreeTests, DeleteWhileIteratingTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  GenericKey<8> index_key;
+  RID rid;
+
+  // Removes keys 1 to 30 out of 1 to 60 from trees with small pages, which merges leaves, optionally while an iterator
+  // is parked on key 25. @return the number of free pages after the removals.
+  auto run = [&](bool optimistic, bool iterate) {
+    auto *disk_manager = new DiskManager("test.db");
+    BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+    BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 3, 3, optimistic);
+    page_id_t page_id;
+    bpm->NewPage(&page_id);
+    for (int64_t key = 1; key <= 60; key++) {
+      rid.Set(0, static_cast<uint32_t>(key));
+      index_key.SetFromInteger(key);
+      tree.Insert(index_key, rid);
+    }
+
+    std::vector<int64_t> seen;
+    {
+      index_key.SetFromInteger(25);
+      auto iterator = tree.Begin(index_key);
+      if (iterate) {
+        EXPECT_EQ((*iterator).second.GetSlotNum(), 25);
+        seen.push_back((*iterator).second.GetSlotNum());
+      }
+      for (int64_t key = 1; key <= 30; key++) {
+        index_key.SetFromInteger(key);
+        tree.Remove(index_key);
+      }
+      for (++iterator; iterate && !iterator.IsEnd(); ++iterator) {
+        seen.push_back((*iterator).second.GetSlotNum());
+      }
+    }
+    if (iterate) {
+      // Scenario: the leaf of the iterator was merged away, it finds its place again and sees every key left once.
+      std::vector<int64_t> expected = {25};
+      for (int64_t key = 31; key <= 60; key++) {
+        expected.push_back(key);
+      }
+      EXPECT_EQ(seen, expected);
+    }
+
+    // Scenario: pages still pinned by the iterator when they were merged away are deleted by a later removal.
+    index_key.SetFromInteger(60);
+    tree.Remove(index_key);
+    size_t num_free_pages = disk_manager->GetFreeSpaceMap()->GetNumFreePages();
+
+    bpm->UnpinPage(HEADER_PAGE_ID, true);
+    delete bpm;
+    delete disk_manager;
+    remove("test.db");
+    remove("test.log");
+    return num_free_pages;
+  };
+
+  for (bool optimistic : {false, true}) {
+    EXPECT_EQ(run(optimistic, true), run(optimistic, false));
+  }
+}
 }  // namespace bustub
@@ -10,11 +10,28 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <chrono>  // NOLINT
 #include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <future>  // NOLINT
+#include <limits>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
 
+#include "buffer/buffer_pool_manager_instance.h"
 #include "common/exception.h"
+#include "common/util/crc32c.h"
 #include "gtest/gtest.h"
+#include "storage/disk/async_disk_manager.h"
+#include "storage/disk/checksum_disk_manager.h"
+#include "storage/disk/compressed_disk_manager.h"
 #include "storage/disk/disk_manager.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/disk/mmap_disk_manager.h"
+#include "storage/disk/page_codec.h"
 
 namespace bustub {
 
@@ -24,12 +41,20 @@ class DiskManagerTest : public ::testing::Test {
   void SetUp() override {
     remove("test.db");
     remove("test.log");
+    remove("test.pagemap");
+    remove("test.fsm");
+    remove("test.crc");
+    remove("test.dwb");
   }
 
   // This function is called after every test.
   void TearDown() override {
     remove("test.db");
     remove("test.log");
+    remove("test.pagemap");
+    remove("test.fsm");
+    remove("test.crc");
+    remove("test.dwb");
   };
 };
 
@@ -72,6 +97,691 @@ TEST_F(DiskManagerTest, ReadWriteLogTest) {
   dm.ShutDown();
 }
 
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, AsyncReadWritePageTest) {
+  const page_id_t num_pages = 100;
+  std::string db_file("test.db");
+
+  // Scenario: both backends, io_uring is skipped when the kernel does not offer it.
+  for (bool use_io_uring : {true, false}) {
+    remove("test.db");
+    AsyncDiskManager dm(db_file, 8, use_io_uring);
+    if (use_io_uring && dm.GetBackend() != AsyncDiskManager::Backend::IO_URING) {
+      continue;
+    }
+    char buf[BUSTUB_PAGE_SIZE] = {0};
+    dm.ReadPage(0, buf);  // tolerate empty read
+
+    // Scenario: many more writes than the queue depth in flight at once.
+    std::vector<std::vector<char>> pages(num_pages, std::vector<char>(BUSTUB_PAGE_SIZE));
+    std::vector<std::future<void>> requests;
+    for (page_id_t page_id = 0; page_id < num_pages; ++page_id) {
+      snprintf(pages[page_id].data(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+      requests.push_back(dm.WritePageAsync(page_id, pages[page_id].data()));
+    }
+    for (auto &request : requests) {
+      request.get();
+    }
+    EXPECT_EQ(num_pages, dm.GetNumWrites());
+
+    // Scenario: reads in flight at once, in reverse order, see the written pages.
+    std::vector<std::vector<char>> read_pages(num_pages, std::vector<char>(BUSTUB_PAGE_SIZE, 'x'));
+    requests.clear();
+    for (page_id_t page_id = num_pages - 1; page_id >= 0; --page_id) {
+      requests.push_back(dm.ReadPageAsync(page_id, read_pages[page_id].data()));
+    }
+    for (auto &request : requests) {
+      request.get();
+    }
+    for (page_id_t page_id = 0; page_id < num_pages; ++page_id) {
+      EXPECT_EQ(0, std::memcmp(pages[page_id].data(), read_pages[page_id].data(), BUSTUB_PAGE_SIZE));
+    }
+
+    // Scenario: a page past the end of the file reads as zeros.
+    std::memset(buf, 'x', sizeof(buf));
+    dm.ReadPage(num_pages + 10, buf);
+    EXPECT_EQ(0, std::memcmp(buf, std::vector<char>(BUSTUB_PAGE_SIZE, 0).data(), BUSTUB_PAGE_SIZE));
+
+    dm.ShutDown();
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, DirectIoTest) {
+  const size_t buffer_pool_size = 4;
+  const page_id_t num_pages = 12;
+  std::string db_file("test.db");
+
+  // Scenario: O_DIRECT falls back to buffered I/O where the file system does not support it, either way pages
+  // round-trip. An unaligned buffer is read and written as well.
+  auto dm = DiskManager(db_file, true);
+  std::vector<char> unaligned(BUSTUB_PAGE_SIZE + 1);
+  std::strncpy(unaligned.data() + 1, "A test string.", BUSTUB_PAGE_SIZE);
+  dm.WritePage(num_pages, unaligned.data() + 1);
+  std::vector<char> buf(BUSTUB_PAGE_SIZE + 1);
+  dm.ReadPage(num_pages, buf.data() + 1);
+  EXPECT_EQ(0, std::memcmp(unaligned.data() + 1, buf.data() + 1, BUSTUB_PAGE_SIZE));
+
+  // Scenario: the frames of the buffer pool are page-aligned, and survive being evicted and read back.
+  {
+    BufferPoolManagerInstance bpm(buffer_pool_size, &dm);
+    page_id_t page_id;
+    for (page_id_t i = 0; i < num_pages; ++i) {
+      auto *page = bpm.NewPage(&page_id);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(0, reinterpret_cast<uintptr_t>(page->GetData()) % BUSTUB_PAGE_SIZE);
+      snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+      EXPECT_TRUE(bpm.UnpinPage(page_id, true));
+    }
+    for (page_id_t i = 0; i < num_pages; ++i) {
+      auto *page = bpm.FetchPage(i);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ("page " + std::to_string(i), std::string(page->GetData()));
+      EXPECT_TRUE(bpm.UnpinPage(i, false));
+    }
+  }
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, PageCodecTest) {
+  std::vector<std::string> codec_names{"lz", "zlib"};
+  std::mt19937 gen(0);
+  std::vector<char> random_page(BUSTUB_PAGE_SIZE);
+  for (auto &c : random_page) {
+    c = static_cast<char>(gen());
+  }
+  std::vector<char> text_page(BUSTUB_PAGE_SIZE);
+  for (size_t i = 0; i < text_page.size(); i++) {
+    text_page[i] = "row 12345, value abcde; "[i % 24] + (i % 1000 == 0 ? 1 : 0);
+  }
+  std::vector<std::vector<char>> pages{std::vector<char>(BUSTUB_PAGE_SIZE, 0), random_page, text_page};
+
+  for (const auto &codec_name : codec_names) {
+    auto codec = CreatePageCodec(codec_name);
+    if (codec == nullptr) {
+      // zlib is optional
+      continue;
+    }
+    EXPECT_EQ(codec_name, codec->Name());
+    for (const auto &page : pages) {
+      // Scenario: a page round-trips, when it compresses into the output buffer at all.
+      std::vector<char> compressed(2 * BUSTUB_PAGE_SIZE);
+      size_t length = codec->Compress(page.data(), page.size(), compressed.data(), compressed.size());
+      ASSERT_GT(length, 0);
+      std::vector<char> decompressed(BUSTUB_PAGE_SIZE);
+      ASSERT_TRUE(codec->Decompress(compressed.data(), length, decompressed.data(), decompressed.size()));
+      EXPECT_EQ(page, decompressed);
+
+      // Scenario: compressing into a buffer that is too small fails instead of overrunning it.
+      EXPECT_EQ(0, codec->Compress(page.data(), page.size(), compressed.data(), length - 1));
+
+      // Scenario: truncated data does not decompress.
+      EXPECT_FALSE(codec->Decompress(compressed.data(), length / 2, decompressed.data(), decompressed.size()));
+    }
+  }
+  EXPECT_EQ(nullptr, CreatePageCodec("no such codec"));
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, CompressedReadWritePageTest) {
+  const page_id_t num_pages = 32;
+  std::string db_file("test.db");
+  std::mt19937 gen(0);
+  auto compressible_page = [](page_id_t page_id) {
+    std::vector<char> page(BUSTUB_PAGE_SIZE);
+    snprintf(page.data(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+    return page;
+  };
+  auto random_page = [&gen]() {
+    std::vector<char> page(BUSTUB_PAGE_SIZE);
+    for (auto &c : page) {
+      c = static_cast<char>(gen());
+    }
+    return page;
+  };
+
+  std::vector<std::vector<char>> pages;
+  {
+    CompressedDiskManager dm(db_file);
+    std::vector<char> buf(BUSTUB_PAGE_SIZE, 'x');
+    dm.ReadPage(0, buf.data());
+    EXPECT_EQ(std::vector<char>(BUSTUB_PAGE_SIZE, 0), buf);
+
+    // Scenario: compressible pages take a slot each, pages that do not compress are stored as they are.
+    for (page_id_t page_id = 0; page_id < num_pages; ++page_id) {
+      pages.push_back(page_id % 4 == 0 ? random_page() : compressible_page(page_id));
+      dm.WritePage(page_id, pages[page_id].data());
+    }
+    size_t expected_slots = num_pages / 4 * (BUSTUB_PAGE_SIZE / CompressedDiskManager::SLOT_SIZE) + num_pages / 4 * 3;
+    EXPECT_EQ(expected_slots * CompressedDiskManager::SLOT_SIZE, dm.GetStoredBytes());
+
+    // Scenario: rewriting a page that still needs the same number of slots keeps it in place.
+    pages[1] = compressible_page(num_pages + 1);
+    dm.WritePage(1, pages[1].data());
+    EXPECT_EQ(expected_slots * CompressedDiskManager::SLOT_SIZE, dm.GetStoredBytes());
+
+    // Scenario: rewriting pages with a different compressed size moves them. Pages that grow after others shrank fit
+    // in the freed extents, and the file does not grow.
+    for (page_id_t page_id = 0; page_id < num_pages; ++page_id) {
+      pages[page_id] = page_id % 4 == 0 ? compressible_page(page_id) : random_page();
+      dm.WritePage(page_id, pages[page_id].data());
+    }
+    size_t stored_bytes = dm.GetStoredBytes();
+    EXPECT_LT(expected_slots * CompressedDiskManager::SLOT_SIZE, stored_bytes);
+    for (bool grow : {false, true}) {
+      for (page_id_t page_id = 0; page_id < num_pages; ++page_id) {
+        if ((page_id % 4 == 0) == grow) {
+          pages[page_id] = grow ? random_page() : compressible_page(page_id);
+          dm.WritePage(page_id, pages[page_id].data());
+        }
+      }
+    }
+    EXPECT_GE(stored_bytes, dm.GetStoredBytes());
+    for (page_id_t page_id = 0; page_id < num_pages; ++page_id) {
+      dm.ReadPage(page_id, buf.data());
+      EXPECT_EQ(pages[page_id], buf);
+    }
+    dm.ShutDown();
+  }
+
+  // Scenario: the page map is saved on shutdown, so the pages read back after opening the file again.
+  {
+    CompressedDiskManager dm(db_file);
+    std::vector<char> buf(BUSTUB_PAGE_SIZE);
+    for (page_id_t page_id = 0; page_id < num_pages; ++page_id) {
+      dm.ReadPage(page_id, buf.data());
+      EXPECT_EQ(pages[page_id], buf);
+    }
+    // Scenario: the pages written without being allocated count as allocated by the page ids in the page map, the
+    // file holds fewer pages than that.
+    EXPECT_GT(static_cast<uintmax_t>(num_pages) * BUSTUB_PAGE_SIZE, std::filesystem::file_size(db_file));
+    EXPECT_EQ(num_pages, dm.AllocatePage());
+    dm.ShutDown();
+  }
+
+  // Scenario: a compressed file is not opened with another codec.
+  auto zlib = CreatePageCodec("zlib");
+  if (zlib != nullptr) {
+    EXPECT_THROW(CompressedDiskManager(db_file, std::move(zlib)), Exception);
+  }
+
+  {
+    CompressedDiskManager dm(db_file);
+    // Scenario: threads writing pages that change size, and reading them, while others move in and out of the freed
+    // extents, always read back one of the versions written.
+    std::vector<std::vector<char>> versions{compressible_page(0), random_page()};
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < 2; t++) {
+      threads.emplace_back([&, t] {
+        for (int i = 0; i < 50; i++) {
+          for (page_id_t page_id = 0; page_id < num_pages; ++page_id) {
+            dm.WritePage(page_id, versions[(page_id + i + t) % 2].data());
+          }
+        }
+      });
+    }
+    threads.emplace_back([&] {
+      std::vector<char> buf(BUSTUB_PAGE_SIZE);
+      for (int i = 0; i < 50; i++) {
+        for (page_id_t page_id = 0; page_id < num_pages; ++page_id) {
+          dm.ReadPage(page_id, buf.data());
+          EXPECT_TRUE(buf == versions[0] || buf == versions[1] || buf == pages[page_id]) << page_id;
+        }
+      }
+    });
+    for (auto &thread : threads) {
+      thread.join();
+    }
+
+    // Scenario: a file that was not shut down cleanly opens with the journal of its page map replayed, a torn record
+    // at its end is dropped, and every page reads back as the version last written.
+    for (const auto *extension : {".db", ".pagemap"}) {
+      std::filesystem::copy_file(std::string("test") + extension, std::string("crash") + extension,
+                                 std::filesystem::copy_options::overwrite_existing);
+    }
+    {
+      std::ofstream torn("crash.pagemap", std::ios::binary | std::ios::app);
+      torn.write("torn", 4);
+    }
+    std::vector<char> buf(BUSTUB_PAGE_SIZE);
+    std::vector<char> crash_buf(BUSTUB_PAGE_SIZE);
+    {
+      CompressedDiskManager crashed("crash.db");
+      for (page_id_t page_id = 0; page_id < num_pages; ++page_id) {
+        dm.ReadPage(page_id, buf.data());
+        crashed.ReadPage(page_id, crash_buf.data());
+        EXPECT_EQ(buf, crash_buf) << page_id;
+      }
+      // the crashed file is written on, and crashes again without a snapshot of its page map
+      crashed.WritePage(0, versions[1].data());
+      std::filesystem::copy_file("crash.pagemap", "crash2.pagemap");
+      crashed.ShutDown();
+      std::filesystem::rename("crash2.pagemap", "crash.pagemap");
+    }
+
+    // Scenario: a session that only reads leaves the file as it found it, it opens again after a crash.
+    for (int session = 0; session < 2; session++) {
+      std::filesystem::copy_file("crash.pagemap", "crash2.pagemap");
+      CompressedDiskManager crashed("crash.db");
+      crashed.ReadPage(0, crash_buf.data());
+      EXPECT_EQ(versions[1], crash_buf);
+      crashed.ShutDown();
+      std::filesystem::rename("crash2.pagemap", "crash.pagemap");
+    }
+    dm.ShutDown();
+  }
+  for (const auto *extension : {".db", ".pagemap", ".log"}) {
+    remove((std::string("crash") + extension).c_str());
+  }
+
+  // Scenario: after a clean shutdown the file opens again.
+  CompressedDiskManager dm(db_file);
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, MmapReadPageTest) {
+  const size_t buffer_pool_size = 4;
+  const page_id_t num_pages = 10;
+  std::string db_file("test.db");
+  {
+    DiskManager dm(db_file);
+    char data[BUSTUB_PAGE_SIZE] = {0};
+    for (page_id_t page_id = 0; page_id < num_pages; ++page_id) {
+      snprintf(data, BUSTUB_PAGE_SIZE, "page %d", page_id);
+      dm.WritePage(page_id, data);
+    }
+    dm.ShutDown();
+  }
+
+  // Scenario: the pages of the snapshot read back through the mapping, pages past its end read as zeros.
+  MmapDiskManager dm(db_file);
+  EXPECT_EQ(num_pages, dm.GetNumPages());
+  char buf[BUSTUB_PAGE_SIZE];
+  for (page_id_t page_id = 0; page_id < num_pages; ++page_id) {
+    dm.ReadPage(page_id, buf);
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(buf));
+  }
+  std::memset(buf, 'x', sizeof(buf));
+  dm.ReadPage(num_pages, buf);
+  char zeros[BUSTUB_PAGE_SIZE] = {0};
+  EXPECT_EQ(0, std::memcmp(buf, zeros, BUSTUB_PAGE_SIZE));
+
+  // Scenario: the snapshot is read-only.
+  EXPECT_THROW(dm.WritePage(0, buf), Exception);
+
+  // Scenario: the buffer pool reads through it, evicting clean pages never writes.
+  {
+    BufferPoolManagerInstance bpm(buffer_pool_size, &dm);
+    for (page_id_t page_id = 0; page_id < num_pages; ++page_id) {
+      auto *page = bpm.FetchPage(page_id);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ("page " + std::to_string(page_id), std::string(page->GetData()));
+      EXPECT_TRUE(bpm.UnpinPage(page_id, false));
+    }
+  }
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, FreeSpaceMapTest) {
+  std::string db_file("test.db");
+  char data[BUSTUB_PAGE_SIZE] = {0};
+  // Scenario: without asking for it, the map lives in memory and pages of an existing file count as allocated.
+  {
+    DiskManager dm(db_file);
+    dm.WritePage(2, data);
+    dm.ShutDown();
+    DiskManager reopened(db_file);
+    EXPECT_EQ(3, reopened.AllocatePage());
+    reopened.ShutDown();
+    EXPECT_FALSE(std::filesystem::exists("test.fsm"));
+    remove("test.db");
+  }
+  {
+    DiskManager dm(db_file, false, true);
+    // Scenario: a new database hands out the page ids in order.
+    for (page_id_t page_id = 0; page_id < 10; ++page_id) {
+      EXPECT_EQ(page_id, dm.AllocatePage());
+      dm.WritePage(page_id, data);
+    }
+
+    // Scenario: deallocated pages are reused, lowest first, before the file grows.
+    dm.DeallocatePage(7);
+    dm.DeallocatePage(3);
+    dm.DeallocatePage(3);
+    EXPECT_EQ(2, dm.GetFreeSpaceMap()->GetNumFreePages());
+    EXPECT_EQ(3, dm.AllocatePage());
+    EXPECT_EQ(7, dm.AllocatePage());
+    EXPECT_EQ(10, dm.AllocatePage());
+
+    // Scenario: a near page id picks the first free page after it, even with a lower one free.
+    dm.DeallocatePage(2);
+    dm.DeallocatePage(5);
+    EXPECT_EQ(5, dm.AllocatePage(4));
+    EXPECT_EQ(11, dm.AllocatePage(10));
+    EXPECT_EQ(2, dm.AllocatePage());
+
+    // Scenario: with a stride, only the page ids of the offset are handed out.
+    dm.DeallocatePage(9);
+    EXPECT_EQ(9, dm.AllocatePage(INVALID_PAGE_ID, 4, 1));
+    EXPECT_EQ(13, dm.AllocatePage(INVALID_PAGE_ID, 4, 1));
+    EXPECT_EQ(12, dm.AllocatePage(INVALID_PAGE_ID, 4, 0));
+    EXPECT_FALSE(dm.GetFreeSpaceMap()->IsAllocated(14));
+
+    dm.DeallocatePage(8);
+    dm.ShutDown();
+  }
+
+  // Scenario: the next page id and the free pages survive a restart.
+  {
+    DiskManager dm(db_file, false, true);
+    EXPECT_EQ(14, dm.GetFreeSpaceMap()->GetNextPageId());
+    EXPECT_EQ(8, dm.AllocatePage());
+    EXPECT_EQ(14, dm.AllocatePage());
+    // a page allocated after the last flush is still allocated after a crash
+    EXPECT_EQ(15, dm.AllocatePage());
+    FreeSpaceMap crashed("test.fsm", 16);
+    EXPECT_TRUE(crashed.IsAllocated(15));
+    EXPECT_EQ(16, crashed.GetNextPageId());
+    dm.ShutDown();
+  }
+
+  // Scenario: the buffer pool gives the page ids of deleted pages to new pages.
+  {
+    DiskManager dm(db_file, false, true);
+    BufferPoolManagerInstance bpm(4, &dm);
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm.NewPage(&page_id));
+    EXPECT_EQ(16, page_id);
+    EXPECT_TRUE(bpm.UnpinPage(page_id, true));
+    EXPECT_TRUE(bpm.DeletePage(page_id));
+    EXPECT_TRUE(bpm.DeletePage(4));
+    ASSERT_NE(nullptr, bpm.NewPage(&page_id));
+    EXPECT_EQ(4, page_id);
+    EXPECT_TRUE(bpm.UnpinPage(page_id, false));
+    ASSERT_NE(nullptr, bpm.NewPage(&page_id));
+    EXPECT_EQ(16, page_id);
+    EXPECT_TRUE(bpm.UnpinPage(page_id, false));
+  }
+
+  // Scenario: a new database file starts over, whatever the map file holds.
+  remove("test.db");
+  DiskManager dm(db_file, false, true);
+  EXPECT_EQ(0, dm.AllocatePage());
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, UnlimitedMemoryTest) {
+  const int num_threads = 8;
+  const int pages_per_thread = 1000;
+  DiskManagerUnlimitedMemory dm(4096);
+
+  // Scenario: threads write pages concurrently, creating chunks and pages as they go, and read them back.
+  std::vector<std::thread> threads;
+  for (int thread_id = 0; thread_id < num_threads; thread_id++) {
+    threads.emplace_back([&, thread_id] {
+      char data[BUSTUB_PAGE_SIZE] = {0};
+      char buf[BUSTUB_PAGE_SIZE];
+      for (int i = 0; i < pages_per_thread; i++) {
+        // every thread also rewrites page 70000, which is in the second chunk
+        for (page_id_t page_id : {i * num_threads + thread_id, 70000}) {
+          snprintf(data, BUSTUB_PAGE_SIZE, "page %d thread %d", page_id, thread_id);
+          dm.WritePage(page_id, data);
+          dm.ReadPage(page_id, buf);
+          if (page_id != 70000) {
+            EXPECT_EQ(0, std::memcmp(buf, data, BUSTUB_PAGE_SIZE));
+          }
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  char buf[BUSTUB_PAGE_SIZE];
+  for (page_id_t page_id = 0; page_id < num_threads * pages_per_thread; page_id++) {
+    dm.ReadPage(page_id, buf);
+    EXPECT_EQ("page " + std::to_string(page_id) + " thread " + std::to_string(page_id % num_threads),
+              std::string(buf));
+  }
+  dm.ReadPage(70000, buf);
+  EXPECT_EQ(0, std::strncmp(buf, "page 70000 thread ", 18));
+
+  // Scenario: the highest page id works, reading a page never written leaves the buffer alone.
+  char data[BUSTUB_PAGE_SIZE] = "last page";
+  dm.WritePage(std::numeric_limits<page_id_t>::max(), data);
+  dm.ReadPage(std::numeric_limits<page_id_t>::max(), buf);
+  EXPECT_EQ("last page", std::string(buf));
+  dm.ReadPage(num_threads * pages_per_thread, buf);
+  EXPECT_EQ("last page", std::string(buf));
+
+  // Scenario: reads and writes take at least the configured latency.
+  dm.SetLatency(std::chrono::microseconds(2000), std::chrono::microseconds(1000));
+  auto start = std::chrono::steady_clock::now();
+  dm.ReadPage(0, buf);
+  dm.WritePage(0, buf);
+  EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::microseconds(3000));
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ChecksumTest) {
+  // Scenario: the checksum is CRC-32C, with and without the crc32 instruction, whole or in pieces.
+  std::string check("123456789");
+  EXPECT_EQ(0xe3069283, Crc32c::Compute(check.data(), check.size()));
+  EXPECT_EQ(0xe3069283, Crc32c::ComputeSoftware(check.data(), check.size()));
+  std::mt19937 gen(0);
+  std::vector<char> random(BUSTUB_PAGE_SIZE + 3);
+  for (auto &c : random) {
+    c = static_cast<char>(gen());
+  }
+  uint32_t whole = Crc32c::Compute(random.data(), random.size());
+  EXPECT_EQ(whole, Crc32c::ComputeSoftware(random.data(), random.size()));
+  EXPECT_EQ(whole, Crc32c::Compute(random.data() + 101, random.size() - 101, Crc32c::Compute(random.data(), 101)));
+
+  std::string db_file("test.db");
+  const page_id_t num_pages = 5;
+  char data[BUSTUB_PAGE_SIZE] = {0};
+  char buf[BUSTUB_PAGE_SIZE];
+  {
+    ChecksumDiskManager dm(db_file);
+    for (page_id_t page_id = 0; page_id < num_pages; ++page_id) {
+      snprintf(data, BUSTUB_PAGE_SIZE, "page %d", page_id);
+      dm.WritePage(page_id, data);
+    }
+    // Scenario: pages read back as written pass.
+    for (page_id_t page_id = 0; page_id < num_pages; ++page_id) {
+      dm.ReadPage(page_id, buf);
+      EXPECT_EQ("page " + std::to_string(page_id), std::string(buf));
+    }
+    EXPECT_EQ(0, dm.GetNumChecksumFailures());
+    dm.ShutDown();
+  }
+
+  // Tear page 2: only the first half of a new version makes it to disk. Page 5 is written behind the back of the
+  // checksums.
+  {
+    DiskManager dm(db_file);
+    std::memset(data, 'y', sizeof(data));
+    dm.WritePage(num_pages, data);
+    dm.ShutDown();
+    FILE *file = fopen(db_file.c_str(), "r+b");
+    ASSERT_NE(nullptr, file);
+    fseek(file, 2 * BUSTUB_PAGE_SIZE, SEEK_SET);
+    fwrite(data, 1, BUSTUB_PAGE_SIZE / 2, file);
+    fclose(file);
+  }
+
+  // Scenario: after a restart the torn page fails verification, and so does the page without a checksum that is not
+  // made of zeros. The others pass.
+  auto dm = std::make_unique<ChecksumDiskManager>(db_file);
+  EXPECT_EQ(num_pages + 1, dm->GetNumPages());
+  for (page_id_t page_id = 0; page_id <= num_pages; ++page_id) {
+    EXPECT_EQ(page_id != 2 && page_id != num_pages, dm->VerifyPage(page_id, buf)) << page_id;
+    EXPECT_EQ(page_id != num_pages, dm->HasChecksum(page_id)) << page_id;
+  }
+  dm->ReadPage(2, buf);
+  dm->ReadPage(3, buf);
+  EXPECT_EQ(1, dm->GetNumChecksumFailures());
+
+  // Scenario: rewriting the page repairs it.
+  snprintf(data, BUSTUB_PAGE_SIZE, "page 2");
+  dm->WritePage(2, data);
+  EXPECT_TRUE(dm->VerifyPage(2, buf));
+
+  auto overwrite = [&db_file](page_id_t page_id, const char *page, size_t length) {
+    FILE *file = fopen(db_file.c_str(), "r+b");
+    ASSERT_NE(nullptr, file);
+    fseek(file, page_id * BUSTUB_PAGE_SIZE, SEEK_SET);
+    fwrite(page, 1, length, file);
+    fclose(file);
+  };
+  // Scenario: a page whose checksum was written, but not the page itself, passes as the version before.
+  std::vector<char> before(data, data + BUSTUB_PAGE_SIZE);
+  snprintf(data, BUSTUB_PAGE_SIZE, "page 2 v2");
+  dm->WritePage(2, data);
+  overwrite(2, before.data(), BUSTUB_PAGE_SIZE);
+  EXPECT_TRUE(dm->VerifyPage(2, buf));
+  EXPECT_EQ(before, std::vector<char>(buf, buf + BUSTUB_PAGE_SIZE));
+
+  // Scenario: a page torn by its very first write fails, pages never written pass as zeros.
+  std::memset(data, 'z', sizeof(data));
+  dm->WritePage(num_pages + 2, data);
+  overwrite(num_pages + 2, std::vector<char>(BUSTUB_PAGE_SIZE / 2, 0).data(), BUSTUB_PAGE_SIZE / 2);
+  EXPECT_FALSE(dm->VerifyPage(num_pages + 2, buf));
+  EXPECT_TRUE(dm->VerifyPage(num_pages + 1, buf));
+  EXPECT_FALSE(dm->HasChecksum(num_pages + 1));
+  dm->WritePage(num_pages + 2, data);
+  dm->WritePage(num_pages, data);
+
+  // Scenario: the pages of a database file that had no checksums are unchecked, they pass until written again.
+  dm->ShutDown();
+  remove("test.crc");
+  dm = std::make_unique<ChecksumDiskManager>(db_file);
+  for (page_id_t page_id = 0; page_id < dm->GetNumPages(); ++page_id) {
+    EXPECT_TRUE(dm->VerifyPage(page_id, buf)) << page_id;
+    EXPECT_FALSE(dm->HasChecksum(page_id)) << page_id;
+  }
+  dm->WritePage(0, data);
+  EXPECT_TRUE(dm->HasChecksum(0));
+  overwrite(0, std::string(BUSTUB_PAGE_SIZE / 2, 'y').data(), BUSTUB_PAGE_SIZE / 2);
+  EXPECT_FALSE(dm->VerifyPage(0, buf));
+  dm->WritePage(0, data);
+
+  // Scenario: threads writing and reading the same page at once never leave a page and a checksum that do not match.
+  std::vector<std::thread> threads;
+  for (char c : {'a', 'b'}) {
+    threads.emplace_back([&dm, c] {
+      char page[BUSTUB_PAGE_SIZE];
+      std::memset(page, c, sizeof(page));
+      for (int i = 0; i < 200; i++) {
+        dm->WritePage(3, page);
+      }
+    });
+  }
+  threads.emplace_back([&dm] {
+    char page[BUSTUB_PAGE_SIZE];
+    for (int i = 0; i < 200; i++) {
+      EXPECT_TRUE(dm->VerifyPage(3, page));
+    }
+  });
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_TRUE(dm->VerifyPage(3, buf));
+  dm->ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, DoubleWriteTest) {
+  std::string db_file("test.db");
+  char data[3][BUSTUB_PAGE_SIZE] = {{0}};
+  char buf[BUSTUB_PAGE_SIZE];
+  auto write_batch = [&](ChecksumDiskManager *dm, std::vector<page_id_t> page_ids, const char *version) {
+    std::vector<std::pair<page_id_t, const char *>> batch;
+    for (size_t i = 0; i < page_ids.size(); i++) {
+      snprintf(data[i], BUSTUB_PAGE_SIZE, "page %d %s", page_ids[i], version);
+      batch.emplace_back(page_ids[i], data[i]);
+    }
+    dm->WritePages(batch);
+  };
+
+  // A double-write buffer of 8 slots: two batches of three pages fill it, the third batch wraps around and leaves the
+  // second one in place.
+  auto dm = std::make_unique<ChecksumDiskManager>(db_file, 8);
+  write_batch(dm.get(), {0, 1, 2}, "v1");
+  write_batch(dm.get(), {1, 2, 3}, "v2");
+  write_batch(dm.get(), {1}, "v3");
+  // Scenario: every batch is synced to the buffer once.
+  EXPECT_EQ(3, dm->GetNumDoubleWriteBatches());
+
+  // Crash: the files as they are now, with page 1 torn in place.
+  for (const auto *extension : {".db", ".crc", ".dwb"}) {
+    std::filesystem::copy_file(std::string("test") + extension, std::string("crash") + extension,
+                               std::filesystem::copy_options::overwrite_existing);
+  }
+  FILE *file = fopen("crash.db", "r+b");
+  ASSERT_NE(nullptr, file);
+  fseek(file, BUSTUB_PAGE_SIZE, SEEK_SET);
+  fwrite(std::string(BUSTUB_PAGE_SIZE / 2, 'y').data(), 1, BUSTUB_PAGE_SIZE / 2, file);
+  fclose(file);
+
+  // Scenario: a batch larger than the buffer is split.
+  char page[BUSTUB_PAGE_SIZE] = {0};
+  std::vector<std::pair<page_id_t, const char *>> large_batch;
+  for (page_id_t page_id = 0; page_id < 10; page_id++) {
+    large_batch.emplace_back(page_id, page);
+  }
+  dm->WritePages(large_batch);
+  EXPECT_EQ(5, dm->GetNumDoubleWriteBatches());
+
+  // Scenario: a clean shutdown empties the buffer.
+  dm->ShutDown();
+  EXPECT_EQ(0, std::filesystem::file_size("test.dwb"));
+  dm.reset();
+
+  // Scenario: after the crash, the torn page is restored from its newest image, not from the stale one of the batch
+  // before the wrap around.
+  ChecksumDiskManager crash_dm("crash.db", 8);
+  EXPECT_EQ(1, crash_dm.RepairTornPages());
+  EXPECT_EQ(0, crash_dm.RepairTornPages());
+  const char *expected[] = {"page 0 v1", "page 1 v3", "page 2 v2", "page 3 v2"};
+  for (page_id_t page_id = 0; page_id < 4; page_id++) {
+    EXPECT_TRUE(crash_dm.VerifyPage(page_id, buf)) << page_id;
+    EXPECT_EQ(std::string(expected[page_id]), std::string(buf));
+  }
+  EXPECT_EQ(0, std::filesystem::file_size("crash.dwb"));
+
+  // Scenario: single pages written by threads at once share batches, and each one is written once its batch is.
+  std::vector<std::thread> threads;
+  const int num_threads = 4;
+  const int num_writes = 50;
+  size_t num_batches = crash_dm.GetNumDoubleWriteBatches();
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&crash_dm, t] {
+      char page[BUSTUB_PAGE_SIZE];
+      for (int i = 0; i < num_writes; i++) {
+        snprintf(page, BUSTUB_PAGE_SIZE, "page %d v%d", t, i);
+        crash_dm.WritePage(t, page);
+        char read_page[BUSTUB_PAGE_SIZE];
+        EXPECT_TRUE(crash_dm.VerifyPage(t, read_page));
+        EXPECT_STREQ(page, read_page);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_GE(num_batches + num_threads * num_writes, crash_dm.GetNumDoubleWriteBatches());
+  crash_dm.ShutDown();
+  for (const auto *extension : {".db", ".crc", ".dwb", ".log"}) {
+    remove((std::string("crash") + extension).c_str());
+  }
+}
+
 // NOLINTNEXTLINE
 TEST_F(DiskManagerTest, ThrowBadFileTest) { EXPECT_THROW(DiskManager("dev/null\\/foo/bar/baz/test.db"), Exception); }
 
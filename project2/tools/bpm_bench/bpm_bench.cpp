@@ -0,0 +1,178 @@
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "argparse/argparse.hpp"
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "common/exception.h"
+#include "fmt/core.h"
+#include "storage/disk/disk_manager_memory.h"
+
+#include <sys/time.h>
+
+auto ClockMs() -> uint64_t {
+  struct timeval tm;
+  gettimeofday(&tm, nullptr);
+  return static_cast<uint64_t>(tm.tv_sec * 1000) + static_cast<uint64_t>(tm.tv_usec / 1000);
+}
+
+struct BpmBenchConfig {
+  uint64_t duration_ms_{2000};
+  size_t frames_{1024};
+  size_t instances_{16};
+  size_t pages_{1024};
+  std::vector<size_t> threads_{1, 2, 4, 8, 16, 32};
+  bustub::ReplacerType replacer_type_{bustub::ReplacerType::LRU_K};
+  /** Simulated latency of every page read and write of the disk manager, 0 to run at memory speed. */
+  uint64_t disk_latency_us_{0};
+};
+
+/**
+ * Populate the buffer pool with `pages` pages, then let `num_threads` threads fetch and unpin uniformly random pages
+ * for the configured duration.
+ * @return the number of fetch/unpin pairs completed per second
+ */
+auto RunFetchUnpin(bustub::BufferPoolManager *bpm, const BpmBenchConfig &config, size_t num_threads) -> double {
+  for (size_t i = 0; i < config.pages_; i++) {
+    bustub::page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    if (page == nullptr) {
+      throw bustub::Exception(fmt::format("failed to create page {}", i));
+    }
+    bpm->UnpinPage(page_id, true);
+  }
+
+  std::atomic<bool> stop{false};
+  std::atomic<uint64_t> total_ops{0};
+  std::vector<std::thread> threads;
+  for (size_t thread_id = 0; thread_id < num_threads; thread_id++) {
+    threads.emplace_back([thread_id, bpm, &config, &stop, &total_ops] {
+      std::default_random_engine gen(thread_id);
+      std::uniform_int_distribution<bustub::page_id_t> page_dist(0, config.pages_ - 1);
+      uint64_t ops = 0;
+      while (!stop.load(std::memory_order_relaxed)) {
+        auto page_id = page_dist(gen);
+        auto *page = bpm->FetchPage(page_id);
+        if (page == nullptr) {
+          // every frame is pinned by some other thread, try again
+          continue;
+        }
+        page->RLatch();
+        page->RUnlatch();
+        bpm->UnpinPage(page_id, false);
+        ops++;
+      }
+      total_ops += ops;
+    });
+  }
+
+  auto start = ClockMs();
+  std::this_thread::sleep_for(std::chrono::milliseconds(config.duration_ms_));
+  stop = true;
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto elapsed = ClockMs() - start;
+  return total_ops.load() / static_cast<double>(elapsed) * 1000;
+}
+
+auto ParseSizeList(const std::string &str) -> std::vector<size_t> {
+  std::vector<size_t> result;
+  std::stringstream ss(str);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    result.push_back(std::stoul(item));
+  }
+  return result;
+}
+
+// NOLINTNEXTLINE
+auto main(int argc, char **argv) -> int {
+  argparse::ArgumentParser program("bustub-bpm-bench");
+  program.add_argument("--duration").help("run each configuration for n milliseconds");
+  program.add_argument("--frames").help("total number of frames in the buffer pool");
+  program.add_argument("--instances").help("number of buffer pool instances of the parallel buffer pool");
+  program.add_argument("--pages").help("number of distinct pages accessed by the workload");
+  program.add_argument("--threads").help("comma separated list of thread counts, e.g. 1,2,4,8,16,32");
+  program.add_argument("--replacer").help("replacement policy of the buffer pool: lru-k or clock");
+  program.add_argument("--disk-latency").help("simulated latency of a page read or write in microseconds");
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::runtime_error &err) {
+    std::cerr << err.what() << std::endl;
+    std::cerr << program;
+    return 1;
+  }
+
+  BpmBenchConfig config;
+  if (program.present("--duration")) {
+    config.duration_ms_ = std::stoi(program.get("--duration"));
+  }
+  if (program.present("--frames")) {
+    config.frames_ = std::stoi(program.get("--frames"));
+  }
+  if (program.present("--instances")) {
+    config.instances_ = std::stoi(program.get("--instances"));
+  }
+  config.pages_ = config.frames_;
+  if (program.present("--pages")) {
+    config.pages_ = std::stoi(program.get("--pages"));
+  }
+  if (program.present("--threads")) {
+    config.threads_ = ParseSizeList(program.get("--threads"));
+  }
+  if (program.present("--replacer")) {
+    auto replacer = program.get("--replacer");
+    if (replacer == "clock") {
+      config.replacer_type_ = bustub::ReplacerType::CLOCK;
+    } else if (replacer != "lru-k") {
+      std::cerr << "unknown replacer: " << replacer << std::endl;
+      return 1;
+    }
+  }
+
+  if (program.present("--disk-latency")) {
+    config.disk_latency_us_ = std::stoul(program.get("--disk-latency"));
+  }
+
+  std::cerr << fmt::format("x: frames={} instances={} pages={} duration={}ms replacer={} disk_latency={}us",
+                           config.frames_, config.instances_, config.pages_, config.duration_ms_,
+                           config.replacer_type_ == bustub::ReplacerType::CLOCK ? "clock" : "lru-k",
+                           config.disk_latency_us_)
+            << std::endl;
+  auto latency = std::chrono::microseconds(config.disk_latency_us_);
+
+  fmt::print("<<< BEGIN\n");
+  fmt::print("{:>8} {:>16} {:>16} {:>8}\n", "threads", "single (ops/s)", "parallel (ops/s)", "speedup");
+  for (auto num_threads : config.threads_) {
+    double single;
+    {
+      auto disk_manager = std::make_unique<bustub::DiskManagerUnlimitedMemory>(config.pages_);
+      disk_manager->SetLatency(latency, latency);
+      auto bpm = std::make_unique<bustub::BufferPoolManagerInstance>(
+          config.frames_, disk_manager.get(), bustub::LRUK_REPLACER_K, nullptr, config.replacer_type_);
+      single = RunFetchUnpin(bpm.get(), config, num_threads);
+    }
+    double parallel;
+    {
+      auto disk_manager = std::make_unique<bustub::DiskManagerUnlimitedMemory>(config.pages_);
+      disk_manager->SetLatency(latency, latency);
+      auto bpm = std::make_unique<bustub::ParallelBufferPoolManager>(
+          config.instances_, config.frames_ / config.instances_, disk_manager.get(), bustub::LRUK_REPLACER_K, nullptr,
+          config.replacer_type_);
+      parallel = RunFetchUnpin(bpm.get(), config, num_threads);
+    }
+    fmt::print("{:>8} {:>16.0f} {:>16.0f} {:>7.2f}x\n", num_threads, single, parallel, parallel / single);
+  }
+  fmt::print(">>> END\n");
+
+  return 0;
+}
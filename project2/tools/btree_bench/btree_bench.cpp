@@ -0,0 +1,443 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "argparse/argparse.hpp"
+#include "buffer/buffer_pool_manager_instance.h"
+#include "common/exception.h"
+#include "fmt/core.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/index/b_plus_tree.h"
+#include "storage/index/b_plus_tree_index.h"
+#include "test_util.h"  // NOLINT
+#include "type/value_factory.h"
+
+using BPlusTree = bustub::BPlusTree<bustub::GenericKey<8>, bustub::RID, bustub::GenericComparator<8>>;
+
+struct BTreeBenchConfig {
+  /**
+   * insert: build a tree from random keys. lookup: point lookups of random keys in a tree built beforehand.
+   * index-build: index rows in random key order, bulk loaded like CREATE INDEX does, or inserted one by one.
+   * wide-keys: point lookups in a tree of 64 byte keys with the default page sizes.
+   */
+  std::string workload_{"insert"};
+  size_t keys_{200000};
+  uint64_t duration_ms_{2000};
+  size_t frames_{4096};
+  int leaf_max_size_{64};
+  int internal_max_size_{64};
+  std::vector<size_t> threads_{1, 2, 4, 8, 16, 32};
+  std::vector<size_t> rows_{1000000};
+};
+
+/**
+ * Insert the keys into an empty tree with `num_threads` threads, thread i taking every num_threads-th key.
+ * @param serialize run every insert under one global mutex, the baseline without any latch crabbing
+ * @return the number of inserts per second
+ */
+auto RunInserts(const std::vector<int64_t> &keys, const BTreeBenchConfig &config, size_t num_threads, bool serialize)
+    -> double {
+  auto key_schema = bustub::ParseCreateStatement("a bigint");
+  bustub::GenericComparator<8> comparator(key_schema.get());
+  auto disk_manager = std::make_unique<bustub::DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<bustub::BufferPoolManagerInstance>(config.frames_, disk_manager.get());
+  bustub::page_id_t header_page_id;
+  bpm->NewPage(&header_page_id);
+  BPlusTree tree("bench", bpm.get(), comparator, config.leaf_max_size_, config.internal_max_size_);
+
+  std::mutex global_latch;
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t thread_id = 0; thread_id < num_threads; thread_id++) {
+    threads.emplace_back([&, thread_id] {
+      bustub::Transaction transaction(static_cast<bustub::txn_id_t>(thread_id));
+      bustub::GenericKey<8> index_key;
+      bustub::RID rid;
+      for (size_t i = thread_id; i < keys.size(); i += num_threads) {
+        rid.Set(static_cast<int32_t>(keys[i] >> 32), static_cast<uint32_t>(keys[i] & 0xFFFFFFFF));
+        index_key.SetFromInteger(keys[i]);
+        if (serialize) {
+          std::scoped_lock lock(global_latch);
+          tree.Insert(index_key, rid, &transaction);
+        } else {
+          tree.Insert(index_key, rid, &transaction);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  bpm->UnpinPage(header_page_id, true);
+  return keys.size() / elapsed;
+}
+
+/**
+ * Insert the keys, then let `num_threads` threads look up uniformly random keys for the configured duration.
+ * @param optimistic read the pages without latches, validating their versions
+ * @return the number of lookups per second
+ */
+auto RunLookups(const std::vector<int64_t> &keys, const BTreeBenchConfig &config, size_t num_threads, bool optimistic)
+    -> double {
+  auto key_schema = bustub::ParseCreateStatement("a bigint");
+  bustub::GenericComparator<8> comparator(key_schema.get());
+  auto disk_manager = std::make_unique<bustub::DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<bustub::BufferPoolManagerInstance>(config.frames_, disk_manager.get());
+  bustub::page_id_t header_page_id;
+  bpm->NewPage(&header_page_id);
+  BPlusTree tree("bench", bpm.get(), comparator, config.leaf_max_size_, config.internal_max_size_, optimistic);
+  bustub::GenericKey<8> index_key;
+  bustub::RID rid;
+  for (auto key : keys) {
+    rid.Set(static_cast<int32_t>(key >> 32), static_cast<uint32_t>(key & 0xFFFFFFFF));
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, rid);
+  }
+
+  std::atomic<bool> stop{false};
+  std::atomic<uint64_t> total_lookups{0};
+  std::atomic<uint64_t> total_misses{0};
+  std::vector<std::thread> threads;
+  for (size_t thread_id = 0; thread_id < num_threads; thread_id++) {
+    threads.emplace_back([&, thread_id] {
+      std::mt19937 gen(thread_id);
+      std::uniform_int_distribution<size_t> key_dist(0, keys.size() - 1);
+      bustub::GenericKey<8> lookup_key;
+      std::vector<bustub::RID> result;
+      uint64_t lookups = 0;
+      uint64_t misses = 0;
+      while (!stop.load(std::memory_order_relaxed)) {
+        result.clear();
+        lookup_key.SetFromInteger(keys[key_dist(gen)]);
+        if (!tree.GetValue(lookup_key, &result)) {
+          misses++;
+        }
+        lookups++;
+      }
+      total_lookups += lookups;
+      total_misses += misses;
+    });
+  }
+  auto start = std::chrono::steady_clock::now();
+  std::this_thread::sleep_for(std::chrono::milliseconds(config.duration_ms_));
+  stop = true;
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  if (total_misses > 0) {
+    throw bustub::Exception(fmt::format("{} lookups missed their key", total_misses.load()));
+  }
+  bpm->UnpinPage(header_page_id, true);
+  return total_lookups / elapsed;
+}
+
+/**
+ * Index `num_rows` rows in random key order, once the way Catalog::CreateIndex does with BPlusTreeIndex::BulkLoad, and
+ * once by inserting every row into an empty index. The rows are generated rather than scanned from a table:
+ * TableHeap::InsertTuple walks the page chain from the first page, so filling a table of millions of rows alone would
+ * take the better part of an hour.
+ * @return the seconds taken by the bulk load and by the inserts
+ */
+auto RunIndexBuild(const BTreeBenchConfig &config, size_t num_rows) -> std::pair<double, double> {
+  using BPlusTreeIndex = bustub::BPlusTreeIndex<bustub::GenericKey<8>, bustub::RID, bustub::GenericComparator<8>>;
+  auto disk_manager = std::make_unique<bustub::DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<bustub::BufferPoolManagerInstance>(config.frames_, disk_manager.get());
+  // the indexes keep their root page ids in the header page
+  bustub::page_id_t header_page_id;
+  bpm->NewPage(&header_page_id);
+
+  bustub::Schema schema({bustub::Column("a", bustub::TypeId::BIGINT)});
+  std::vector<int64_t> keys(num_rows);
+  std::iota(keys.begin(), keys.end(), 0);
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(0));
+  auto rid_of = [](int64_t key) {
+    return bustub::RID(static_cast<bustub::page_id_t>(key / 256), static_cast<uint32_t>(key % 256));
+  };
+
+  auto start = std::chrono::steady_clock::now();
+  BPlusTreeIndex bulk_index(std::make_unique<bustub::IndexMetadata>("bulk", "bench", &schema, std::vector<uint32_t>{0}),
+                            bpm.get());
+  size_t next_row = 0;
+  bulk_index.BulkLoad(
+      [&](bustub::Tuple *key, bustub::RID *rid) {
+        if (next_row == num_rows) {
+          return false;
+        }
+        *key = bustub::Tuple({bustub::ValueFactory::GetBigIntValue(keys[next_row])}, &schema);
+        *rid = rid_of(keys[next_row]);
+        next_row++;
+        return true;
+      },
+      bustub::INDEX_FILL_FACTOR);
+  double bulk_load = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  start = std::chrono::steady_clock::now();
+  BPlusTreeIndex insert_index(
+      std::make_unique<bustub::IndexMetadata>("insert", "bench", &schema, std::vector<uint32_t>{0}), bpm.get());
+  bustub::Transaction txn(0);
+  for (auto key : keys) {
+    insert_index.InsertEntry(bustub::Tuple({bustub::ValueFactory::GetBigIntValue(key)}, &schema), rid_of(key), &txn);
+  }
+  double inserts = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  bpm->UnpinPage(header_page_id, true);
+  return {bulk_load, inserts};
+}
+
+/**
+ * Index `num_rows` rows of two columns in random key order with BPlusTreeIndex::BulkLoad, reading the rows with
+ * `num_threads` producers the way Catalog::CreateIndex does: every producer takes slices of the rows in turn and
+ * extracts the key of each row with Tuple::KeyFromTuple. The rows are generated for the same reason as in
+ * RunIndexBuild.
+ * @return the seconds taken by the bulk load
+ */
+auto RunParallelIndexBuild(const BTreeBenchConfig &config, size_t num_rows, size_t num_threads) -> double {
+  using BPlusTreeIndex = bustub::BPlusTreeIndex<bustub::GenericKey<8>, bustub::RID, bustub::GenericComparator<8>>;
+  auto disk_manager = std::make_unique<bustub::DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<bustub::BufferPoolManagerInstance>(config.frames_, disk_manager.get());
+  bustub::page_id_t header_page_id;
+  bpm->NewPage(&header_page_id);
+
+  bustub::Schema schema({bustub::Column("a", bustub::TypeId::BIGINT), bustub::Column("b", bustub::TypeId::INTEGER)});
+  bustub::Schema key_schema({bustub::Column("a", bustub::TypeId::BIGINT)});
+  std::vector<uint32_t> key_attrs{0};
+  std::vector<int64_t> keys(num_rows);
+  std::iota(keys.begin(), keys.end(), 0);
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(0));
+
+  auto start = std::chrono::steady_clock::now();
+  BPlusTreeIndex index(std::make_unique<bustub::IndexMetadata>("parallel", "bench", &schema, key_attrs), bpm.get());
+  // slices as big as a table page of these rows, handed out like TablePageCursor hands out pages
+  const size_t slice_size = 200;
+  std::atomic<size_t> next_slice{0};
+  std::vector<std::function<bool(bustub::Tuple *, bustub::RID *)>> producers;
+  for (size_t i = 0; i < num_threads; i++) {
+    producers.emplace_back([&, row = size_t{0}, end = size_t{0}](bustub::Tuple *key, bustub::RID *rid) mutable {
+      if (row == end) {
+        row = next_slice.fetch_add(1) * slice_size;
+        end = std::min(row + slice_size, num_rows);
+        if (row >= num_rows) {
+          row = end;
+          return false;
+        }
+      }
+      bustub::Tuple tuple({bustub::ValueFactory::GetBigIntValue(keys[row]),
+                           bustub::ValueFactory::GetIntegerValue(static_cast<int32_t>(row))},
+                          &schema);
+      *key = tuple.KeyFromTuple(schema, key_schema, key_attrs);
+      *rid = bustub::RID(static_cast<bustub::page_id_t>(row / slice_size), static_cast<uint32_t>(row % slice_size));
+      row++;
+      return true;
+    });
+  }
+  index.BulkLoad(producers, bustub::INDEX_FILL_FACTOR);
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  bpm->UnpinPage(header_page_id, true);
+  return elapsed;
+}
+
+/** The shape of a tree, and how fast it is to look up. */
+struct WideKeysResult {
+  int height_;
+  size_t internal_pages_;
+  double lookup_ns_;
+};
+
+/** Count the internal pages of a subtree, and return its height. */
+template <typename InternalPage>
+auto MeasureSubtree(bustub::BufferPoolManager *bpm, bustub::page_id_t page_id, size_t *internal_pages) -> int {
+  auto *page = bpm->FetchPage(page_id);
+  auto *node = reinterpret_cast<bustub::BPlusTreePage *>(page->GetData());
+  int height = 1;
+  if (!node->IsLeafPage()) {
+    (*internal_pages)++;
+    auto *internal = reinterpret_cast<InternalPage *>(node);
+    for (int i = 0; i < internal->GetSize(); i++) {
+      height = MeasureSubtree<InternalPage>(bpm, internal->ValueAt(i), internal_pages) + 1;
+    }
+  }
+  bpm->UnpinPage(page_id, false);
+  return height;
+}
+
+/**
+ * Insert the keys in random order as VARCHARs of 64 byte keys, with a long common prefix like the names of the objects
+ * of a bucket, into a tree with the default page sizes. Then look them up at random on one thread.
+ */
+auto RunWideKeys(const std::vector<int64_t> &keys, const BTreeBenchConfig &config) -> WideKeysResult {
+  using WideTree = bustub::BPlusTree<bustub::GenericKey<64>, bustub::RID, bustub::GenericComparator<64>>;
+  using WideInternalPage =
+      bustub::BPlusTreeInternalPage<bustub::GenericKey<64>, bustub::page_id_t, bustub::GenericComparator<64>>;
+  // names of 47 characters, a key of 64 bytes with the inlined part and the length of the VARCHAR
+  auto key_schema = bustub::ParseCreateStatement("a varchar(47)");
+  bustub::GenericComparator<64> comparator(key_schema.get());
+  auto disk_manager = std::make_unique<bustub::DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<bustub::BufferPoolManagerInstance>(config.frames_, disk_manager.get());
+  bustub::page_id_t header_page_id;
+  bpm->NewPage(&header_page_id);
+  WideTree tree("bench", bpm.get(), comparator);
+  auto key_of = [&](int64_t key) {
+    auto name = fmt::format("tenant-4/orders/eu-west-1/2026/customer-{:07}", key);
+    bustub::GenericKey<64> index_key;
+    index_key.SetFromKey(bustub::Tuple({bustub::ValueFactory::GetVarcharValue(name)}, key_schema.get()));
+    return index_key;
+  };
+  for (auto key : keys) {
+    tree.Insert(key_of(key), bustub::RID(static_cast<int32_t>(key >> 32), static_cast<uint32_t>(key & 0xFFFFFFFF)));
+  }
+
+  WideKeysResult result{};
+  result.height_ = MeasureSubtree<WideInternalPage>(bpm.get(), tree.GetRootPageId(), &result.internal_pages_);
+
+  // the keys are built beforehand, only the lookups are timed
+  std::vector<bustub::GenericKey<64>> lookup_keys;
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<size_t> key_dist(0, keys.size() - 1);
+  for (size_t i = 0; i < std::min<size_t>(keys.size(), 100000); i++) {
+    lookup_keys.push_back(key_of(keys[key_dist(gen)]));
+  }
+  std::vector<bustub::RID> rids;
+  uint64_t lookups = 0;
+  auto start = std::chrono::steady_clock::now();
+  auto deadline = start + std::chrono::milliseconds(config.duration_ms_);
+  while (std::chrono::steady_clock::now() < deadline) {
+    for (const auto &lookup_key : lookup_keys) {
+      rids.clear();
+      if (!tree.GetValue(lookup_key, &rids)) {
+        throw bustub::Exception("a lookup missed its key");
+      }
+    }
+    lookups += lookup_keys.size();
+  }
+  auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  result.lookup_ns_ = elapsed / lookups;
+  bpm->UnpinPage(header_page_id, true);
+  return result;
+}
+
+auto ParseSizeList(const std::string &str) -> std::vector<size_t> {
+  std::vector<size_t> result;
+  std::stringstream ss(str);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    result.push_back(std::stoul(item));
+  }
+  return result;
+}
+
+// NOLINTNEXTLINE
+auto main(int argc, char **argv) -> int {
+  argparse::ArgumentParser program("bustub-btree-bench");
+  program.add_argument("--workload").help("insert, lookup, index-build, parallel-index-build or wide-keys");
+  program.add_argument("--rows").help("comma separated list of row counts for index-build, e.g. 1000000,10000000");
+  program.add_argument("--keys").help("number of keys to insert, in random order");
+  program.add_argument("--duration").help("run every lookup measurement for n milliseconds");
+  program.add_argument("--frames").help("number of frames in the buffer pool");
+  program.add_argument("--leaf-size").help("maximum size of a leaf page");
+  program.add_argument("--internal-size").help("maximum size of an internal page");
+  program.add_argument("--threads").help("comma separated list of thread counts, e.g. 1,2,4,8,16,32");
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::runtime_error &err) {
+    std::cerr << err.what() << std::endl;
+    std::cerr << program;
+    return 1;
+  }
+
+  BTreeBenchConfig config;
+  if (program.present("--workload")) {
+    config.workload_ = program.get("--workload");
+    if (config.workload_ != "insert" && config.workload_ != "lookup" && config.workload_ != "index-build" &&
+        config.workload_ != "parallel-index-build" && config.workload_ != "wide-keys") {
+      std::cerr << "unknown workload: " << config.workload_ << std::endl;
+      return 1;
+    }
+  }
+  if (program.present("--keys")) {
+    config.keys_ = std::stoul(program.get("--keys"));
+  }
+  if (program.present("--duration")) {
+    config.duration_ms_ = std::stoul(program.get("--duration"));
+  }
+  if (program.present("--frames")) {
+    config.frames_ = std::stoul(program.get("--frames"));
+  }
+  if (program.present("--leaf-size")) {
+    config.leaf_max_size_ = std::stoi(program.get("--leaf-size"));
+  }
+  if (program.present("--internal-size")) {
+    config.internal_max_size_ = std::stoi(program.get("--internal-size"));
+  }
+  if (program.present("--threads")) {
+    config.threads_ = ParseSizeList(program.get("--threads"));
+  }
+  if (program.present("--rows")) {
+    config.rows_ = ParseSizeList(program.get("--rows"));
+  }
+
+  std::cerr << fmt::format("x: workload={} keys={} frames={} leaf_size={} internal_size={} hardware_threads={}",
+                           config.workload_, config.keys_, config.frames_, config.leaf_max_size_,
+                           config.internal_max_size_, std::thread::hardware_concurrency())
+            << std::endl;
+
+  std::vector<int64_t> keys(config.keys_);
+  std::iota(keys.begin(), keys.end(), 0);
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(0));
+
+  fmt::print("<<< BEGIN\n");
+  if (config.workload_ == "insert") {
+    fmt::print("{:>8} {:>20} {:>20} {:>8}\n", "threads", "serialized (ops/s)", "crabbing (ops/s)", "speedup");
+    for (auto num_threads : config.threads_) {
+      double serialized = RunInserts(keys, config, num_threads, true);
+      double crabbing = RunInserts(keys, config, num_threads, false);
+      fmt::print("{:>8} {:>20.0f} {:>20.0f} {:>7.2f}x\n", num_threads, serialized, crabbing, crabbing / serialized);
+    }
+  } else if (config.workload_ == "index-build") {
+    fmt::print("{:>10} {:>16} {:>16} {:>8}\n", "rows", "bulk load (s)", "inserts (s)", "speedup");
+    for (auto num_rows : config.rows_) {
+      auto [bulk_load, inserts] = RunIndexBuild(config, num_rows);
+      fmt::print("{:>10} {:>16.2f} {:>16.2f} {:>7.2f}x\n", num_rows, bulk_load, inserts, inserts / bulk_load);
+    }
+  } else if (config.workload_ == "parallel-index-build") {
+    fmt::print("{:>10} {:>8} {:>16} {:>8}\n", "rows", "threads", "bulk load (s)", "speedup");
+    for (auto num_rows : config.rows_) {
+      double single = 0;
+      for (auto num_threads : config.threads_) {
+        double elapsed = RunParallelIndexBuild(config, num_rows, num_threads);
+        if (single == 0) {
+          single = elapsed;
+        }
+        fmt::print("{:>10} {:>8} {:>16.2f} {:>7.2f}x\n", num_rows, num_threads, elapsed, single / elapsed);
+      }
+    }
+  } else if (config.workload_ == "wide-keys") {
+    fmt::print("{:>10} {:>8} {:>16} {:>12}\n", "keys", "height", "internal pages", "lookup (ns)");
+    auto result = RunWideKeys(keys, config);
+    fmt::print("{:>10} {:>8} {:>16} {:>12.0f}\n", keys.size(), result.height_, result.internal_pages_,
+               result.lookup_ns_);
+  } else {
+    fmt::print("{:>8} {:>20} {:>20} {:>8}\n", "threads", "latched (ops/s)", "optimistic (ops/s)", "speedup");
+    for (auto num_threads : config.threads_) {
+      double latched = RunLookups(keys, config, num_threads, false);
+      double optimistic = RunLookups(keys, config, num_threads, true);
+      fmt::print("{:>8} {:>20.0f} {:>20.0f} {:>7.2f}x\n", num_threads, latched, optimistic, optimistic / latched);
+    }
+  }
+  fmt::print(">>> END\n");
+
+  return 0;
+}
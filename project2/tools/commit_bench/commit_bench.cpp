@@ -0,0 +1,186 @@
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "argparse/argparse.hpp"
+#include "catalog/schema.h"
+#include "concurrency/lock_manager.h"
+#include "concurrency/transaction_manager.h"
+#include "fmt/core.h"
+#include "recovery/log_manager.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/table/tuple.h"
+#include "type/value.h"
+
+struct CommitBenchConfig {
+  std::string db_file_{"commit_bench.db"};
+  uint64_t duration_ms_{2000};
+  std::vector<size_t> committers_{1, 2, 4, 8, 16, 32, 64};
+  std::vector<size_t> appenders_{1, 4, 16, 32, 64};
+  /** Length of the varchar in the tuple of every appended INSERT record. */
+  size_t tuple_size_{100};
+};
+
+struct CommitBenchResult {
+  uint64_t commits_;
+  int flushes_;
+};
+
+/**
+ * Begin and commit empty transactions from `committers` threads with logging enabled. Every commit waits for its
+ * COMMIT record to be on disk, so the throughput is bounded by how many commits share a log flush.
+ */
+auto RunCommits(const CommitBenchConfig &config, size_t committers) -> CommitBenchResult {
+  std::string log_file = config.db_file_.substr(0, config.db_file_.rfind('.')) + ".log";
+  std::remove(config.db_file_.c_str());
+  std::remove(log_file.c_str());
+
+  auto *disk_manager = new bustub::DiskManager(config.db_file_);
+  auto *log_manager = new bustub::LogManager(disk_manager);
+  auto *lock_manager = new bustub::LockManager();
+  auto *txn_manager = new bustub::TransactionManager(lock_manager, log_manager);
+  log_manager->RunFlushThread();
+
+  std::atomic<uint64_t> commits{0};
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(config.duration_ms_);
+  std::vector<std::thread> threads;
+  for (size_t thread_id = 0; thread_id < committers; thread_id++) {
+    threads.emplace_back([&] {
+      uint64_t local_commits = 0;
+      while (std::chrono::steady_clock::now() < deadline) {
+        bustub::Transaction *txn = txn_manager->Begin();
+        txn_manager->Commit(txn);
+        delete txn;
+        local_commits++;
+      }
+      commits += local_commits;
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  log_manager->StopFlushThread();
+  CommitBenchResult result{commits, disk_manager->GetNumFlushes()};
+  delete txn_manager;
+  delete lock_manager;
+  delete log_manager;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  std::remove(config.db_file_.c_str());
+  std::remove(log_file.c_str());
+  return result;
+}
+
+/**
+ * Append INSERT records from `appenders` threads with the flush thread running, without waiting for them to be flushed.
+ * This is the cost every write operation pays for logging.
+ * @return the number of appends per second
+ */
+auto RunAppends(const CommitBenchConfig &config, size_t appenders) -> double {
+  std::string log_file = config.db_file_.substr(0, config.db_file_.rfind('.')) + ".log";
+  std::remove(config.db_file_.c_str());
+  std::remove(log_file.c_str());
+
+  auto *disk_manager = new bustub::DiskManager(config.db_file_);
+  auto *log_manager = new bustub::LogManager(disk_manager);
+  log_manager->RunFlushThread();
+
+  bustub::Schema schema({bustub::Column("v", bustub::TypeId::VARCHAR, config.tuple_size_)});
+  bustub::Tuple tuple({bustub::Value(bustub::TypeId::VARCHAR, std::string(config.tuple_size_, 'x'))}, &schema);
+
+  std::atomic<uint64_t> appends{0};
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(config.duration_ms_);
+  std::vector<std::thread> threads;
+  for (size_t thread_id = 0; thread_id < appenders; thread_id++) {
+    threads.emplace_back([&, thread_id] {
+      bustub::LogRecord record(static_cast<bustub::txn_id_t>(thread_id), bustub::INVALID_LSN,
+                               bustub::LogRecordType::INSERT, bustub::RID(0, 0), tuple);
+      uint64_t local_appends = 0;
+      while (std::chrono::steady_clock::now() < deadline) {
+        log_manager->AppendLogRecord(&record);
+        local_appends++;
+      }
+      appends += local_appends;
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  log_manager->StopFlushThread();
+  delete log_manager;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  std::remove(config.db_file_.c_str());
+  std::remove(log_file.c_str());
+  return appends / (config.duration_ms_ / 1000.0);
+}
+
+auto ParseSizeList(const std::string &str) -> std::vector<size_t> {
+  std::vector<size_t> result;
+  std::stringstream ss(str);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    result.push_back(std::stoul(item));
+  }
+  return result;
+}
+
+// NOLINTNEXTLINE
+auto main(int argc, char **argv) -> int {
+  argparse::ArgumentParser program("bustub-commit-bench");
+  program.add_argument("--db").help("database file to create, it and its log are removed afterwards");
+  program.add_argument("--duration").help("run time of every measurement in milliseconds");
+  program.add_argument("--committers").help("comma separated list of committer counts, e.g. 1,8,64");
+  program.add_argument("--appenders").help("comma separated list of appender counts, e.g. 1,8,64");
+  program.add_argument("--tuple-size").help("size of the tuple in every appended record");
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::runtime_error &err) {
+    std::cerr << err.what() << std::endl;
+    std::cerr << program;
+    return 1;
+  }
+
+  CommitBenchConfig config;
+  if (program.present("--db")) {
+    config.db_file_ = program.get("--db");
+  }
+  if (program.present("--duration")) {
+    config.duration_ms_ = std::stoul(program.get("--duration"));
+  }
+  if (program.present("--committers")) {
+    config.committers_ = ParseSizeList(program.get("--committers"));
+  }
+  if (program.present("--appenders")) {
+    config.appenders_ = ParseSizeList(program.get("--appenders"));
+  }
+  if (program.present("--tuple-size")) {
+    config.tuple_size_ = std::stoul(program.get("--tuple-size"));
+  }
+
+  std::cerr << fmt::format("x: db={} duration={}ms", config.db_file_, config.duration_ms_) << std::endl;
+
+  fmt::print("<<< BEGIN\n");
+  fmt::print("{:>10} {:>12} {:>12} {:>16}\n", "committers", "commits/s", "flushes/s", "commits/flush");
+  for (auto committers : config.committers_) {
+    auto result = RunCommits(config, committers);
+    double seconds = config.duration_ms_ / 1000.0;
+    double commits_per_flush = result.flushes_ == 0 ? 0.0 : static_cast<double>(result.commits_) / result.flushes_;
+    fmt::print("{:>10} {:>12.0f} {:>12.0f} {:>16.1f}\n", committers, result.commits_ / seconds,
+               result.flushes_ / seconds, commits_per_flush);
+  }
+  fmt::print("{:>10} {:>12}\n", "appenders", "appends/s");
+  for (auto appenders : config.appenders_) {
+    fmt::print("{:>10} {:>12.0f}\n", appenders, RunAppends(config, appenders));
+  }
+  fmt::print(">>> END\n");
+  return 0;
+}
@@ -0,0 +1,182 @@
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "argparse/argparse.hpp"
+#include "buffer/buffer_pool_manager_instance.h"
+#include "catalog/catalog.h"
+#include "catalog/table_generator.h"
+#include "concurrency/transaction.h"
+#include "execution/executor_context.h"
+#include "fmt/core.h"
+#include "storage/disk/compressed_disk_manager.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/disk/page_codec.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct CompressionBenchConfig {
+  std::string db_file_{"compression_bench.db"};
+  /** Number of times the TableGenerator test tables are generated, each into its own catalog. */
+  size_t copies_{200};
+  size_t pool_size_{64};
+  size_t repeats_{3};
+  std::vector<std::string> codecs_{"none", "lz", "zlib"};
+};
+
+void DropFileCache(const std::string &db_file) {
+  int fd = open(db_file.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return;
+  }
+  posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  close(fd);
+}
+
+auto FileSize(const std::string &file_name) -> size_t {
+  struct stat stat_buf;
+  return stat(file_name.c_str(), &stat_buf) == 0 ? stat_buf.st_size : 0;
+}
+
+/**
+ * Fill the database with `copies` copies of the TableGenerator test tables and write them to disk.
+ * @return the number of pages of the database
+ */
+auto GenerateTables(bustub::DiskManager *disk_manager, const CompressionBenchConfig &config) -> bustub::page_id_t {
+  auto bpm = std::make_unique<bustub::BufferPoolManagerInstance>(config.pool_size_, disk_manager);
+  for (size_t i = 0; i < config.copies_; i++) {
+    bustub::Transaction txn(0);
+    bustub::Catalog catalog(bpm.get(), nullptr, nullptr);
+    bustub::ExecutorContext exec_ctx(&txn, &catalog, bpm.get(), nullptr, nullptr);
+    bustub::TableGenerator gen(&exec_ctx);
+    gen.GenerateTestTables();
+  }
+  // page ids are handed out in order, so the next one is the number of pages
+  bustub::page_id_t num_pages;
+  bpm->NewPage(&num_pages);
+  bpm->UnpinPage(num_pages, false);
+  bpm->FlushAllPages();
+  return num_pages;
+}
+
+/**
+ * Read every page once in random order, straight from the disk manager.
+ * @return the number of pages read per second
+ */
+auto RunReads(bustub::DiskManager *disk_manager, bustub::page_id_t num_pages, const CompressionBenchConfig &config,
+              bool cold) -> double {
+  std::vector<bustub::page_id_t> page_ids(num_pages);
+  for (bustub::page_id_t page_id = 0; page_id < num_pages; page_id++) {
+    page_ids[page_id] = page_id;
+  }
+  std::shuffle(page_ids.begin(), page_ids.end(), std::mt19937(0));
+  std::vector<char> page(bustub::BUSTUB_PAGE_SIZE);
+
+  double elapsed = 0;
+  for (size_t i = 0; i < config.repeats_; i++) {
+    if (cold) {
+      DropFileCache(config.db_file_);
+    }
+    auto start = std::chrono::steady_clock::now();
+    for (auto page_id : page_ids) {
+      disk_manager->ReadPage(page_id, page.data());
+    }
+    elapsed += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+  return config.repeats_ * num_pages / elapsed;
+}
+
+auto ParseStringList(const std::string &str) -> std::vector<std::string> {
+  std::vector<std::string> result;
+  std::stringstream ss(str);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    result.push_back(item);
+  }
+  return result;
+}
+
+// NOLINTNEXTLINE
+auto main(int argc, char **argv) -> int {
+  argparse::ArgumentParser program("bustub-compression-bench");
+  program.add_argument("--db").help("database file to create, it is removed afterwards");
+  program.add_argument("--copies").help("number of copies of the TableGenerator test tables");
+  program.add_argument("--pool-size").help("number of frames of the buffer pool the tables are generated through");
+  program.add_argument("--repeats").help("number of passes over the pages for every read measurement");
+  program.add_argument("--codecs").help("comma separated list of codecs, none for DiskManager, e.g. none,lz,zlib");
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::runtime_error &err) {
+    std::cerr << err.what() << std::endl;
+    std::cerr << program;
+    return 1;
+  }
+
+  CompressionBenchConfig config;
+  if (program.present("--db")) {
+    config.db_file_ = program.get("--db");
+  }
+  if (program.present("--copies")) {
+    config.copies_ = std::stoul(program.get("--copies"));
+  }
+  if (program.present("--pool-size")) {
+    config.pool_size_ = std::stoul(program.get("--pool-size"));
+  }
+  if (program.present("--repeats")) {
+    config.repeats_ = std::stoul(program.get("--repeats"));
+  }
+  if (program.present("--codecs")) {
+    config.codecs_ = ParseStringList(program.get("--codecs"));
+  }
+
+  std::cerr << fmt::format("x: db={} copies={} pool_size={} repeats={}", config.db_file_, config.copies_,
+                           config.pool_size_, config.repeats_)
+            << std::endl;
+
+  std::string base_name = config.db_file_.substr(0, config.db_file_.rfind('.'));
+  auto remove_files = [&] {
+    std::remove(config.db_file_.c_str());
+    std::remove((base_name + ".log").c_str());
+    std::remove((base_name + ".pagemap").c_str());
+  };
+
+  fmt::print("<<< BEGIN\n");
+  fmt::print("{:>6} {:>8} {:>12} {:>7} {:>12} {:>12}\n", "codec", "pages", "file_bytes", "ratio", "cold_reads/s",
+             "warm_reads/s");
+  for (const auto &codec_name : config.codecs_) {
+    std::unique_ptr<bustub::DiskManager> disk_manager;
+    remove_files();
+    if (codec_name == "none") {
+      disk_manager = std::make_unique<bustub::DiskManager>(config.db_file_);
+    } else {
+      auto codec = bustub::CreatePageCodec(codec_name);
+      if (codec == nullptr) {
+        std::cerr << fmt::format("codec {} is not available, skipping it", codec_name) << std::endl;
+        continue;
+      }
+      disk_manager = std::make_unique<bustub::CompressedDiskManager>(config.db_file_, std::move(codec));
+    }
+
+    auto num_pages = GenerateTables(disk_manager.get(), config);
+    size_t file_bytes = FileSize(config.db_file_);
+    double ratio = static_cast<double>(num_pages) * bustub::BUSTUB_PAGE_SIZE / file_bytes;
+    double cold_reads = RunReads(disk_manager.get(), num_pages, config, true);
+    double warm_reads = RunReads(disk_manager.get(), num_pages, config, false);
+    fmt::print("{:>6} {:>8} {:>12} {:>7.2f} {:>12.0f} {:>12.0f}\n", codec_name, num_pages, file_bytes, ratio,
+               cold_reads, warm_reads);
+    disk_manager->ShutDown();
+  }
+  fmt::print(">>> END\n");
+
+  remove_files();
+  return 0;
+}
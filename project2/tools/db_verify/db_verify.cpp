@@ -0,0 +1,67 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// db_verify.cpp
+//
+// Identification: tools/db_verify/db_verify.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "argparse/argparse.hpp"
+#include "common/config.h"
+#include "fmt/core.h"
+#include "storage/disk/checksum_disk_manager.h"
+
+#include <sys/stat.h>
+
+/**
+ * Check every page of a database file written by ChecksumDiskManager against its checksum, and list the pages that
+ * do not match. Exits with 1 if any page is damaged.
+ */
+// NOLINTNEXTLINE
+auto main(int argc, char **argv) -> int {
+  argparse::ArgumentParser program("bustub-db-verify");
+  program.add_argument("db").help("database file to verify, its checksums are read from the .crc file next to it");
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::runtime_error &err) {
+    std::cerr << err.what() << std::endl;
+    std::cerr << program;
+    return 1;
+  }
+
+  auto db_file = program.get("db");
+  struct stat stat_buf;
+  if (stat(db_file.c_str(), &stat_buf) != 0) {
+    // the disk manager would create an empty database
+    std::cerr << "no such database file: " << db_file << std::endl;
+    return 1;
+  }
+
+  bustub::ChecksumDiskManager disk_manager(db_file);
+  auto num_pages = disk_manager.GetNumPages();
+  size_t num_unchecked = 0;
+  std::vector<bustub::page_id_t> damaged;
+  std::vector<char> page(bustub::BUSTUB_PAGE_SIZE);
+  for (bustub::page_id_t page_id = 0; page_id < num_pages; page_id++) {
+    if (!disk_manager.VerifyPage(page_id, page.data())) {
+      damaged.push_back(page_id);
+      fmt::print("page {}: checksum mismatch\n", page_id);
+    } else if (!disk_manager.HasChecksum(page_id)) {
+      num_unchecked++;
+    }
+  }
+  disk_manager.ShutDown();
+
+  fmt::print("{}: {} pages, {} verified, {} without checksum, {} damaged\n", db_file, num_pages,
+             num_pages - num_unchecked - damaged.size(), num_unchecked, damaged.size());
+  return damaged.empty() ? 0 : 1;
+}
@@ -0,0 +1,196 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <deque>
+#include <future>  // NOLINT
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "argparse/argparse.hpp"
+#include "fmt/core.h"
+#include "storage/disk/async_disk_manager.h"
+#include "storage/disk/disk_manager.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+struct DiskBenchConfig {
+  std::string db_file_{"disk_bench.db"};
+  size_t pages_{65536};
+  uint64_t duration_ms_{2000};
+  std::vector<size_t> depths_{1, 4, 16, 64};
+  /** Drop the cached pages of the file before every run, so that the reads go to the device. */
+  bool cold_{true};
+};
+
+/**
+ * Ask the kernel to drop the cached pages of the database file.
+ */
+void DropFileCache(const std::string &db_file) {
+  int fd = open(db_file.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return;
+  }
+  posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  close(fd);
+}
+
+/**
+ * Random page reads with `depth` threads, each issuing one blocking ReadPage at a time (fio's psync engine with
+ * numjobs=depth). This is the only way to get several reads in flight out of DiskManager.
+ * @return the number of reads per second
+ */
+auto RunSyncReads(bustub::DiskManager *disk_manager, const DiskBenchConfig &config, size_t depth) -> double {
+  std::atomic<uint64_t> reads{0};
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(config.duration_ms_);
+  std::vector<std::thread> threads;
+  for (size_t thread_id = 0; thread_id < depth; thread_id++) {
+    threads.emplace_back([&, thread_id] {
+      std::mt19937 gen(thread_id);
+      std::uniform_int_distribution<bustub::page_id_t> page_dist(0, config.pages_ - 1);
+      std::vector<char> page(bustub::BUSTUB_PAGE_SIZE);
+      uint64_t local_reads = 0;
+      while (std::chrono::steady_clock::now() < deadline) {
+        disk_manager->ReadPage(page_dist(gen), page.data());
+        local_reads++;
+      }
+      reads += local_reads;
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  return reads / (config.duration_ms_ / 1000.0);
+}
+
+/**
+ * Random page reads from a single thread that keeps `depth` ReadPageAsync requests in flight (fio's io_uring engine
+ * with iodepth=depth).
+ * @return the number of reads per second
+ */
+auto RunAsyncReads(bustub::DiskManager *disk_manager, const DiskBenchConfig &config, size_t depth) -> double {
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<bustub::page_id_t> page_dist(0, config.pages_ - 1);
+  std::vector<std::vector<char>> pages(depth, std::vector<char>(bustub::BUSTUB_PAGE_SIZE));
+  std::deque<std::pair<size_t, std::future<void>>> inflight;
+  for (size_t slot = 0; slot < depth; slot++) {
+    inflight.emplace_back(slot, disk_manager->ReadPageAsync(page_dist(gen), pages[slot].data()));
+  }
+
+  uint64_t reads = 0;
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(config.duration_ms_);
+  while (std::chrono::steady_clock::now() < deadline) {
+    auto [slot, done] = std::move(inflight.front());
+    inflight.pop_front();
+    done.get();
+    reads++;
+    inflight.emplace_back(slot, disk_manager->ReadPageAsync(page_dist(gen), pages[slot].data()));
+  }
+  for (auto &[slot, done] : inflight) {
+    done.get();
+  }
+  return reads / (config.duration_ms_ / 1000.0);
+}
+
+auto ParseSizeList(const std::string &str) -> std::vector<size_t> {
+  std::vector<size_t> result;
+  std::stringstream ss(str);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    result.push_back(std::stoul(item));
+  }
+  return result;
+}
+
+// NOLINTNEXTLINE
+auto main(int argc, char **argv) -> int {
+  argparse::ArgumentParser program("bustub-disk-bench");
+  program.add_argument("--db").help("database file to create, it is removed afterwards");
+  program.add_argument("--pages").help("size of the database file in pages");
+  program.add_argument("--duration").help("run time of every measurement in milliseconds");
+  program.add_argument("--depths").help("comma separated list of queue depths, e.g. 1,4,16,64");
+  program.add_argument("--warm").default_value(false).implicit_value(true).help("keep the file in the page cache");
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::runtime_error &err) {
+    std::cerr << err.what() << std::endl;
+    std::cerr << program;
+    return 1;
+  }
+
+  DiskBenchConfig config;
+  if (program.present("--db")) {
+    config.db_file_ = program.get("--db");
+  }
+  if (program.present("--pages")) {
+    config.pages_ = std::stoul(program.get("--pages"));
+  }
+  if (program.present("--duration")) {
+    config.duration_ms_ = std::stoul(program.get("--duration"));
+  }
+  if (program.present("--depths")) {
+    config.depths_ = ParseSizeList(program.get("--depths"));
+  }
+  config.cold_ = !program.get<bool>("--warm");
+
+  std::cerr << fmt::format("x: db={} pages={} duration={}ms cold={}", config.db_file_, config.pages_,
+                           config.duration_ms_, config.cold_)
+            << std::endl;
+
+  // Write the whole file once, so that every random read hits a written page.
+  {
+    std::remove(config.db_file_.c_str());
+    bustub::AsyncDiskManager disk_manager(config.db_file_);
+    std::vector<char> page(bustub::BUSTUB_PAGE_SIZE, 'x');
+    std::deque<std::future<void>> writes;
+    for (size_t page_id = 0; page_id < config.pages_; page_id++) {
+      if (writes.size() == 64) {
+        writes.front().get();
+        writes.pop_front();
+      }
+      writes.push_back(disk_manager.WritePageAsync(static_cast<bustub::page_id_t>(page_id), page.data()));
+    }
+    for (auto &write : writes) {
+      write.get();
+    }
+    disk_manager.ShutDown();
+  }
+
+  fmt::print("<<< BEGIN\n");
+  fmt::print("{:>12} {:>6} {:>12}\n", "engine", "depth", "iops");
+  for (auto depth : config.depths_) {
+    {
+      if (config.cold_) {
+        DropFileCache(config.db_file_);
+      }
+      bustub::DiskManager disk_manager(config.db_file_);
+      fmt::print("{:>12} {:>6} {:>12.0f}\n", "fstream", depth, RunSyncReads(&disk_manager, config, depth));
+      disk_manager.ShutDown();
+    }
+    for (bool use_io_uring : {false, true}) {
+      if (config.cold_) {
+        DropFileCache(config.db_file_);
+      }
+      bustub::AsyncDiskManager disk_manager(config.db_file_, depth, use_io_uring);
+      if (use_io_uring && disk_manager.GetBackend() != bustub::AsyncDiskManager::Backend::IO_URING) {
+        std::cerr << "io_uring is not available, skipping it" << std::endl;
+        continue;
+      }
+      fmt::print("{:>12} {:>6} {:>12.0f}\n", use_io_uring ? "io_uring" : "threadpool", depth,
+                 RunAsyncReads(&disk_manager, config, depth));
+      disk_manager.ShutDown();
+    }
+  }
+  fmt::print(">>> END\n");
+
+  std::remove(config.db_file_.c_str());
+  std::remove((config.db_file_.substr(0, config.db_file_.rfind('.')) + ".log").c_str());
+  return 0;
+}
@@ -0,0 +1,177 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "argparse/argparse.hpp"
+#include "container/hash/extendible_hash_table.h"
+#include "fmt/core.h"
+
+#include <sys/time.h>
+
+auto ClockMs() -> uint64_t {
+  struct timeval tm;
+  gettimeofday(&tm, nullptr);
+  return static_cast<uint64_t>(tm.tv_sec * 1000) + static_cast<uint64_t>(tm.tv_usec / 1000);
+}
+
+struct HashTableBenchConfig {
+  uint64_t duration_ms_{2000};
+  size_t bucket_size_{4};
+  int keys_{100000};
+  /** Percentage of operations that are lookups, the rest is split evenly between inserts and removes. */
+  int read_percent_{80};
+  std::vector<size_t> threads_{1, 2, 4, 8, 16, 32};
+};
+
+/**
+ * Populate a fresh table with every key, then let `num_threads` threads run a mix of lookups, inserts and removes on
+ * uniformly random keys for the configured duration.
+ * @return the number of operations completed per second
+ */
+auto RunMixed(const HashTableBenchConfig &config, size_t num_threads) -> double {
+  auto table = std::make_unique<bustub::ExtendibleHashTable<int, int>>(config.bucket_size_);
+  for (int key = 0; key < config.keys_; key++) {
+    table->Insert(key, key);
+  }
+
+  std::atomic<bool> stop{false};
+  std::atomic<uint64_t> total_ops{0};
+  std::vector<std::thread> threads;
+  for (size_t thread_id = 0; thread_id < num_threads; thread_id++) {
+    threads.emplace_back([thread_id, &table, &config, &stop, &total_ops] {
+      std::default_random_engine gen(thread_id);
+      std::uniform_int_distribution<int> key_dist(0, config.keys_ - 1);
+      std::uniform_int_distribution<int> op_dist(0, 99);
+      uint64_t ops = 0;
+      int value;
+      while (!stop.load(std::memory_order_relaxed)) {
+        int key = key_dist(gen);
+        int op = op_dist(gen);
+        if (op < config.read_percent_) {
+          table->Find(key, value);
+        } else if ((op - config.read_percent_) % 2 == 0) {
+          table->Insert(key, key);
+        } else {
+          table->Remove(key);
+        }
+        ops++;
+      }
+      total_ops += ops;
+    });
+  }
+
+  auto start = ClockMs();
+  std::this_thread::sleep_for(std::chrono::milliseconds(config.duration_ms_));
+  stop = true;
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto elapsed = ClockMs() - start;
+  return total_ops.load() / static_cast<double>(elapsed) * 1000;
+}
+
+/**
+ * Insert every key into a fresh table from a single thread, then look up every key once in random order.
+ * @return average nanoseconds per insert and per lookup
+ */
+auto RunLatency(const HashTableBenchConfig &config) -> std::pair<double, double> {
+  std::default_random_engine gen(15445);
+  std::vector<int> keys(config.keys_);
+  for (int key = 0; key < config.keys_; key++) {
+    keys[key] = key;
+  }
+  std::shuffle(keys.begin(), keys.end(), gen);
+
+  auto table = std::make_unique<bustub::ExtendibleHashTable<int, int>>(config.bucket_size_);
+  auto start = std::chrono::steady_clock::now();
+  for (auto key : keys) {
+    table->Insert(key, key);
+  }
+  auto insert_elapsed = std::chrono::steady_clock::now() - start;
+
+  std::shuffle(keys.begin(), keys.end(), gen);
+  int value;
+  size_t found = 0;
+  start = std::chrono::steady_clock::now();
+  for (auto key : keys) {
+    found += table->Find(key, value) ? 1 : 0;
+  }
+  auto find_elapsed = std::chrono::steady_clock::now() - start;
+  if (found != keys.size()) {
+    std::cerr << fmt::format("only found {} of {} keys", found, keys.size()) << std::endl;
+  }
+
+  auto per_op = [&](auto elapsed) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / static_cast<double>(keys.size());
+  };
+  return {per_op(insert_elapsed), per_op(find_elapsed)};
+}
+
+auto ParseSizeList(const std::string &str) -> std::vector<size_t> {
+  std::vector<size_t> result;
+  std::stringstream ss(str);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    result.push_back(std::stoul(item));
+  }
+  return result;
+}
+
+// NOLINTNEXTLINE
+auto main(int argc, char **argv) -> int {
+  argparse::ArgumentParser program("bustub-hash-table-bench");
+  program.add_argument("--duration").help("run each configuration for n milliseconds");
+  program.add_argument("--bucket-size").help("bucket size of the extendible hash table");
+  program.add_argument("--keys").help("number of distinct keys accessed by the workload");
+  program.add_argument("--read-percent").help("percentage of operations that are lookups");
+  program.add_argument("--threads").help("comma separated list of thread counts, e.g. 1,2,4,8,16,32");
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::runtime_error &err) {
+    std::cerr << err.what() << std::endl;
+    std::cerr << program;
+    return 1;
+  }
+
+  HashTableBenchConfig config;
+  if (program.present("--duration")) {
+    config.duration_ms_ = std::stoi(program.get("--duration"));
+  }
+  if (program.present("--bucket-size")) {
+    config.bucket_size_ = std::stoi(program.get("--bucket-size"));
+  }
+  if (program.present("--keys")) {
+    config.keys_ = std::stoi(program.get("--keys"));
+  }
+  if (program.present("--read-percent")) {
+    config.read_percent_ = std::stoi(program.get("--read-percent"));
+  }
+  if (program.present("--threads")) {
+    config.threads_ = ParseSizeList(program.get("--threads"));
+  }
+
+  std::cerr << fmt::format("x: bucket_size={} keys={} read_percent={} duration={}ms", config.bucket_size_,
+                           config.keys_, config.read_percent_, config.duration_ms_)
+            << std::endl;
+
+  fmt::print("<<< BEGIN\n");
+  auto [insert_ns, find_ns] = RunLatency(config);
+  fmt::print("{:>16} {:>16}\n", "insert (ns/op)", "find (ns/op)");
+  fmt::print("{:>16.1f} {:>16.1f}\n", insert_ns, find_ns);
+  fmt::print("{:>8} {:>16}\n", "threads", "ops/s");
+  for (auto num_threads : config.threads_) {
+    fmt::print("{:>8} {:>16.0f}\n", num_threads, RunMixed(config, num_threads));
+  }
+  fmt::print(">>> END\n");
+
+  return 0;
+}
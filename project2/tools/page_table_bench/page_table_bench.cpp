@@ -0,0 +1,106 @@
+#include <chrono>  // NOLINT
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "argparse/argparse.hpp"
+#include "container/hash/extendible_hash_table.h"
+#include "container/hash/page_table.h"
+#include "fmt/core.h"
+
+struct PageTableBenchConfig {
+  size_t ops_{1000000};
+  size_t bucket_size_{4};
+  std::vector<size_t> frames_{1000, 100000, 1000000};
+};
+
+/**
+ * Map `num_frames` pages to frames, the way a full buffer pool does, then look up `ops` uniformly random resident
+ * pages.
+ * @return average nanoseconds per lookup
+ */
+template <typename TableType>
+auto RunLookup(TableType *table, size_t num_frames, const PageTableBenchConfig &config) -> double {
+  // page ids of a long running pool are not dense, spread them over a larger range
+  std::default_random_engine gen(15445);
+  std::vector<bustub::page_id_t> page_ids(num_frames);
+  for (size_t i = 0; i < num_frames; i++) {
+    page_ids[i] = static_cast<bustub::page_id_t>(i * 7 + gen() % 7);
+    table->Insert(page_ids[i], static_cast<bustub::frame_id_t>(i));
+  }
+
+  // pre-generate the workload so that the random number generator is not measured
+  std::uniform_int_distribution<size_t> index_dist(0, num_frames - 1);
+  std::vector<bustub::page_id_t> lookups(config.ops_);
+  for (auto &page_id : lookups) {
+    page_id = page_ids[index_dist(gen)];
+  }
+
+  bustub::frame_id_t frame_id;
+  size_t found = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (auto page_id : lookups) {
+    found += table->Find(page_id, frame_id) ? 1 : 0;
+  }
+  auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+  if (found != config.ops_) {
+    std::cerr << fmt::format("only found {} of {} pages", found, config.ops_) << std::endl;
+  }
+  return elapsed.count() / static_cast<double>(config.ops_);
+}
+
+auto ParseSizeList(const std::string &str) -> std::vector<size_t> {
+  std::vector<size_t> result;
+  std::stringstream ss(str);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    result.push_back(std::stoul(item));
+  }
+  return result;
+}
+
+// NOLINTNEXTLINE
+auto main(int argc, char **argv) -> int {
+  argparse::ArgumentParser program("bustub-page-table-bench");
+  program.add_argument("--ops").help("number of lookups to run for every configuration");
+  program.add_argument("--bucket-size").help("bucket size of the extendible hash table");
+  program.add_argument("--frames").help("comma separated list of pool sizes, e.g. 1000,100000,1000000");
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::runtime_error &err) {
+    std::cerr << err.what() << std::endl;
+    std::cerr << program;
+    return 1;
+  }
+
+  PageTableBenchConfig config;
+  if (program.present("--ops")) {
+    config.ops_ = std::stoul(program.get("--ops"));
+  }
+  if (program.present("--bucket-size")) {
+    config.bucket_size_ = std::stoul(program.get("--bucket-size"));
+  }
+  if (program.present("--frames")) {
+    config.frames_ = ParseSizeList(program.get("--frames"));
+  }
+
+  std::cerr << fmt::format("x: ops={} bucket_size={}", config.ops_, config.bucket_size_) << std::endl;
+
+  fmt::print("<<< BEGIN\n");
+  fmt::print("{:>10} {:>20} {:>20}\n", "frames", "extendible (ns/op)", "page table (ns/op)");
+  for (auto num_frames : config.frames_) {
+    auto extendible =
+        std::make_unique<bustub::ExtendibleHashTable<bustub::page_id_t, bustub::frame_id_t>>(config.bucket_size_);
+    auto extendible_ns = RunLookup(extendible.get(), num_frames, config);
+    auto page_table = std::make_unique<bustub::PageTable>(2 * num_frames);
+    auto page_table_ns = RunLookup(page_table.get(), num_frames, config);
+    fmt::print("{:>10} {:>20.1f} {:>20.1f}\n", num_frames, extendible_ns, page_table_ns);
+  }
+  fmt::print(">>> END\n");
+
+  return 0;
+}
@@ -0,0 +1,113 @@
+#include <chrono>  // NOLINT
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "argparse/argparse.hpp"
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
+#include "fmt/core.h"
+
+struct ReplacerBenchConfig {
+  size_t ops_{1000000};
+  size_t k_{bustub::LRUK_REPLACER_K};
+  double hit_ratio_{0.9};
+  std::vector<size_t> frames_{1000, 100000};
+};
+
+/**
+ * Replay the replacer calls made by the buffer pool for `ops` page accesses against a full pool of `num_frames`
+ * frames: a hit pins and unpins a resident frame, a miss evicts a victim and installs a new page in its frame.
+ * @return average nanoseconds per page access
+ */
+template <typename ReplacerType>
+auto RunReplacer(ReplacerType *replacer, size_t num_frames, const ReplacerBenchConfig &config) -> double {
+  // warm up: every frame is resident, unpinned and has a full access history
+  for (size_t round = 0; round < config.k_; round++) {
+    for (size_t i = 0; i < num_frames; i++) {
+      auto frame_id = static_cast<bustub::frame_id_t>(i);
+      replacer->RecordAccess(frame_id);
+      replacer->SetEvictable(frame_id, true);
+    }
+  }
+
+  std::default_random_engine gen(15445);
+  std::uniform_int_distribution<bustub::frame_id_t> frame_dist(0, num_frames - 1);
+  std::bernoulli_distribution hit_dist(config.hit_ratio_);
+  // pre-generate the workload so that the random number generator is not measured
+  std::vector<bustub::frame_id_t> frames(config.ops_);
+  for (auto &frame_id : frames) {
+    frame_id = hit_dist(gen) ? frame_dist(gen) : -1;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for (auto frame_id : frames) {
+    if (frame_id == -1 && !replacer->Evict(&frame_id)) {
+      continue;
+    }
+    replacer->RecordAccess(frame_id);
+    replacer->SetEvictable(frame_id, false);
+    replacer->SetEvictable(frame_id, true);
+  }
+  auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+  return elapsed.count() / static_cast<double>(config.ops_);
+}
+
+auto ParseSizeList(const std::string &str) -> std::vector<size_t> {
+  std::vector<size_t> result;
+  std::stringstream ss(str);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    result.push_back(std::stoul(item));
+  }
+  return result;
+}
+
+// NOLINTNEXTLINE
+auto main(int argc, char **argv) -> int {
+  argparse::ArgumentParser program("bustub-replacer-bench");
+  program.add_argument("--ops").help("number of page accesses to replay for every configuration");
+  program.add_argument("--k").help("lookback constant k for the lru-k replacer");
+  program.add_argument("--hit-ratio").help("fraction of page accesses that hit a resident frame");
+  program.add_argument("--frames").help("comma separated list of pool sizes, e.g. 1000,100000");
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::runtime_error &err) {
+    std::cerr << err.what() << std::endl;
+    std::cerr << program;
+    return 1;
+  }
+
+  ReplacerBenchConfig config;
+  if (program.present("--ops")) {
+    config.ops_ = std::stoul(program.get("--ops"));
+  }
+  if (program.present("--k")) {
+    config.k_ = std::stoul(program.get("--k"));
+  }
+  if (program.present("--hit-ratio")) {
+    config.hit_ratio_ = std::stod(program.get("--hit-ratio"));
+  }
+  if (program.present("--frames")) {
+    config.frames_ = ParseSizeList(program.get("--frames"));
+  }
+
+  std::cerr << fmt::format("x: ops={} k={} hit_ratio={}", config.ops_, config.k_, config.hit_ratio_) << std::endl;
+
+  fmt::print("<<< BEGIN\n");
+  fmt::print("{:>10} {:>16} {:>16}\n", "frames", "lru-k (ns/op)", "clock (ns/op)");
+  for (auto num_frames : config.frames_) {
+    auto lru_k_replacer = std::make_unique<bustub::LRUKReplacer>(num_frames, config.k_);
+    auto lru_k = RunReplacer(lru_k_replacer.get(), num_frames, config);
+    auto clock_replacer = std::make_unique<bustub::ClockReplacer>(num_frames);
+    auto clock = RunReplacer(clock_replacer.get(), num_frames, config);
+    fmt::print("{:>10} {:>16.1f} {:>16.1f}\n", num_frames, lru_k, clock);
+  }
+  fmt::print(">>> END\n");
+
+  return 0;
+}
@@ -0,0 +1,211 @@
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "argparse/argparse.hpp"
+#include "buffer/buffer_pool_manager_instance.h"
+#include "catalog/schema.h"
+#include "common/exception.h"
+#include "concurrency/transaction.h"
+#include "fmt/core.h"
+#include "storage/disk/checksum_disk_manager.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/disk/mmap_disk_manager.h"
+#include "storage/table/table_heap.h"
+#include "type/value_factory.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+struct ScanBenchConfig {
+  std::string db_file_{"scan_bench.db"};
+  size_t tuples_{200000};
+  size_t tuple_size_{256};
+  size_t pool_size_{256};
+  size_t repeats_{3};
+  /** Read-ahead window of the table scan, 0 disables read-ahead. */
+  std::vector<size_t> prefetch_{0, 8, 32};
+  /**
+   * How the scans read the pages: pread for DiskManager, checksum for ChecksumDiskManager, which verifies every page it
+   * reads, mmap for MmapDiskManager.
+   */
+  std::vector<std::string> disks_{"pread", "checksum", "mmap"};
+  /** Drop the cached pages of the file before every scan, so that the reads go to the device. */
+  bool cold_{true};
+};
+
+/**
+ * Ask the kernel to drop the cached pages of the database file, so that every scan starts cold.
+ */
+void DropFileCache(const std::string &db_file) {
+  int fd = open(db_file.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return;
+  }
+  posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  close(fd);
+}
+
+/**
+ * Create a table of `tuples` tuples in a fresh database file and write it to disk.
+ * @return the id of the first page of the table
+ */
+auto BuildTable(bustub::DiskManager *disk_manager, const bustub::Schema &schema, const ScanBenchConfig &config)
+    -> bustub::page_id_t {
+  auto bpm = std::make_unique<bustub::BufferPoolManagerInstance>(config.pool_size_, disk_manager);
+  bustub::Transaction txn(0);
+  bustub::TableHeap table(bpm.get(), nullptr, nullptr, &txn);
+  std::string payload(config.tuple_size_, 'x');
+  for (size_t i = 0; i < config.tuples_; i++) {
+    std::vector<bustub::Value> values{bustub::ValueFactory::GetIntegerValue(static_cast<int32_t>(i)),
+                                      bustub::ValueFactory::GetVarcharValue(payload)};
+    bustub::Tuple tuple(values, &schema);
+    bustub::RID rid;
+    if (!table.InsertTuple(tuple, &rid, &txn)) {
+      throw bustub::Exception(fmt::format("failed to insert tuple {}", i));
+    }
+    // the write set is only needed to abort, keep it from growing with the table
+    txn.GetWriteSet()->clear();
+  }
+  bpm->FlushAllPages();
+  return table.GetFirstPageId();
+}
+
+/**
+ * Scan the whole table through a cold buffer pool, with the given read-ahead window.
+ * @param disk the disk manager to read the pages with, see ScanBenchConfig::disks_
+ * @return the number of tuples scanned per second
+ */
+auto RunScan(const std::string &disk, bustub::page_id_t first_page_id, const ScanBenchConfig &config,
+             size_t prefetch_pages) -> double {
+  // the cache is dropped before mapping the file, the pages of a live mapping stay cached
+  if (config.cold_) {
+    DropFileCache(config.db_file_);
+  }
+  std::unique_ptr<bustub::DiskManager> disk_manager;
+  if (disk == "mmap") {
+    disk_manager = std::make_unique<bustub::MmapDiskManager>(config.db_file_);
+  } else if (disk == "checksum") {
+    disk_manager = std::make_unique<bustub::ChecksumDiskManager>(config.db_file_);
+  } else {
+    disk_manager = std::make_unique<bustub::DiskManager>(config.db_file_);
+  }
+  bustub::table_prefetch_pages = prefetch_pages;
+  auto bpm = std::make_unique<bustub::BufferPoolManagerInstance>(config.pool_size_, disk_manager.get());
+  bustub::Transaction txn(0);
+  bustub::TableHeap table(bpm.get(), nullptr, nullptr, first_page_id);
+
+  size_t scanned = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (auto iter = table.Begin(&txn); iter != table.End(); ++iter) {
+    scanned++;
+  }
+  auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  if (scanned != config.tuples_) {
+    std::cerr << fmt::format("only scanned {} of {} tuples", scanned, config.tuples_) << std::endl;
+  }
+  bpm.reset();
+  disk_manager->ShutDown();
+  return scanned / elapsed;
+}
+
+auto ParseSizeList(const std::string &str) -> std::vector<size_t> {
+  std::vector<size_t> result;
+  std::stringstream ss(str);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    result.push_back(std::stoul(item));
+  }
+  return result;
+}
+
+auto ParseStringList(const std::string &str) -> std::vector<std::string> {
+  std::vector<std::string> result;
+  std::stringstream ss(str);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    result.push_back(item);
+  }
+  return result;
+}
+
+// NOLINTNEXTLINE
+auto main(int argc, char **argv) -> int {
+  argparse::ArgumentParser program("bustub-scan-bench");
+  program.add_argument("--db").help("database file to create, it is removed afterwards");
+  program.add_argument("--tuples").help("number of tuples in the table");
+  program.add_argument("--tuple-size").help("size of the varchar payload of every tuple in bytes");
+  program.add_argument("--pool-size").help("number of frames of the buffer pool");
+  program.add_argument("--repeats").help("number of cold scans to run for every read-ahead window");
+  program.add_argument("--prefetch").help("comma separated list of read-ahead windows in pages, e.g. 0,8,32");
+  program.add_argument("--disks").help("comma separated list of disk managers to scan with, e.g. pread,checksum,mmap");
+  program.add_argument("--warm").default_value(false).implicit_value(true).help("keep the file in the page cache");
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::runtime_error &err) {
+    std::cerr << err.what() << std::endl;
+    std::cerr << program;
+    return 1;
+  }
+
+  ScanBenchConfig config;
+  if (program.present("--db")) {
+    config.db_file_ = program.get("--db");
+  }
+  if (program.present("--tuples")) {
+    config.tuples_ = std::stoul(program.get("--tuples"));
+  }
+  if (program.present("--tuple-size")) {
+    config.tuple_size_ = std::stoul(program.get("--tuple-size"));
+  }
+  if (program.present("--pool-size")) {
+    config.pool_size_ = std::stoul(program.get("--pool-size"));
+  }
+  if (program.present("--repeats")) {
+    config.repeats_ = std::stoul(program.get("--repeats"));
+  }
+  if (program.present("--prefetch")) {
+    config.prefetch_ = ParseSizeList(program.get("--prefetch"));
+  }
+  if (program.present("--disks")) {
+    config.disks_ = ParseStringList(program.get("--disks"));
+  }
+  config.cold_ = !program.get<bool>("--warm");
+
+  std::cerr << fmt::format("x: db={} tuples={} tuple_size={} pool_size={} repeats={} cold={}", config.db_file_,
+                           config.tuples_, config.tuple_size_, config.pool_size_, config.repeats_, config.cold_)
+            << std::endl;
+
+  bustub::Schema schema({bustub::Column("id", bustub::TypeId::INTEGER),
+                         bustub::Column("payload", bustub::TypeId::VARCHAR, config.tuple_size_)});
+  // written with checksums for the checksum scans, the other disk managers ignore them
+  auto disk_manager = std::make_unique<bustub::ChecksumDiskManager>(config.db_file_);
+  auto first_page_id = BuildTable(disk_manager.get(), schema, config);
+  disk_manager->ShutDown();
+
+  fmt::print("<<< BEGIN\n");
+  fmt::print("{:>6} {:>10} {:>16}\n", "disk", "prefetch", "tuples/s");
+  for (const auto &disk : config.disks_) {
+    for (auto prefetch_pages : config.prefetch_) {
+      double best = 0;
+      for (size_t i = 0; i < config.repeats_; i++) {
+        best = std::max(best, RunScan(disk, first_page_id, config, prefetch_pages));
+      }
+      fmt::print("{:>6} {:>10} {:>16.0f}\n", disk, prefetch_pages, best);
+    }
+  }
+  fmt::print(">>> END\n");
+
+  std::remove(config.db_file_.c_str());
+  auto stem = config.db_file_.substr(0, config.db_file_.rfind('.'));
+  for (const auto *extension : {".log", ".crc"}) {
+    std::remove((stem + extension).c_str());
+  }
+  return 0;
+}